@@ -47,6 +47,7 @@ namespace Falcor
             Dynamic     = 1, ///< Buffer will be updated using Buffer#updateData().
             MapRead     = 2, ///< Buffer will mapped for CPU read.
             MapWrite    = 4, ///< Buffer will mapped for CPU Write.
+            Persistent  = 8, ///< Buffer can stay mapped while the GPU uses it, and CPU writes are visible to the GPU without unmapping. Use with MapWrite. Only supported in OpenGL.
         };
 
         /** Buffer GPU access flags.
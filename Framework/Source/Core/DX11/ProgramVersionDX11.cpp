@@ -263,6 +263,23 @@ namespace Falcor
         UNSUPPORTED_IN_DX11("CProgramVersion::GetAttributeLocation");
         return 0;
     }
+
+    ProgramVersion::SharedConstPtr ProgramVersion::createFromBinary(uint32_t format, const std::vector<uint8_t>& binary, std::string& log, const std::string& name)
+    {
+        // DX11 doesn't have program binaries. The render context needs the shader objects, so the program is always created from its shaders.
+        log = "Program binaries are not supported in DX11";
+        return nullptr;
+    }
+
+    std::string ProgramVersion::getCompilerIdentity()
+    {
+        return "DX11";
+    }
+
+    bool ProgramVersion::getBinary(uint32_t& format, std::vector<uint8_t>& binary) const
+    {
+        return false;
+    }
 }
 
 #endif //#ifdef FALCOR_DX11
@@ -47,6 +47,7 @@ namespace Falcor
         SharedPtr pCtx = SharedPtr(new RenderContext(D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE));
         pCtx->mState.pUniformBuffers.assign(D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT, nullptr);
         pCtx->mState.pShaderStorageBuffers.assign(D3D11_1_UAV_SLOT_COUNT, nullptr);
+        pCtx->mState.pStorageBuffers.assign(D3D11_1_UAV_SLOT_COUNT, nullptr);
         return pCtx;
     }
 
@@ -167,6 +168,11 @@ namespace Falcor
         UNSUPPORTED_IN_DX11("RenderContext::ApplyShaderStorageBuffer()");
     }
 
+    void RenderContext::applyStorageBuffer(uint32_t index) const
+    {
+        UNSUPPORTED_IN_DX11("RenderContext::applyStorageBuffer()");
+    }
+
     void RenderContext::applyTopology() const
     {
         D3D11_PRIMITIVE_TOPOLOGY topology;
@@ -243,21 +249,18 @@ namespace Falcor
         }
     }
 
-    void RenderContext::draw(uint32_t vertexCount, uint32_t startVertexLocation)
+    void RenderContext::drawApi(uint32_t vertexCount, uint32_t startVertexLocation)
     {
-        prepareForDraw();
         getD3D11ImmediateContext()->Draw(vertexCount, startVertexLocation);
     }
 
-    void RenderContext::drawIndexed(uint32_t indexCount, uint32_t startIndexLocation, int baseVertexLocation)
+    void RenderContext::drawIndexedApi(uint32_t indexCount, uint32_t startIndexLocation, int baseVertexLocation)
     {
-        prepareForDraw();
         getD3D11ImmediateContext()->DrawIndexed(indexCount, startIndexLocation, baseVertexLocation);
     }
 
-    void RenderContext::drawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndexLocation, int baseVertexLocation, uint32_t startInstanceLocation)
+    void RenderContext::drawIndexedInstancedApi(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndexLocation, int baseVertexLocation, uint32_t startInstanceLocation)
     {
-        prepareForDraw();
         getD3D11ImmediateContext()->DrawIndexedInstanced(indexCount, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation);
     }
 
@@ -566,7 +566,10 @@ namespace Falcor
         pWindow->updateDefaultFBO(desc.swapChainDesc.width, desc.swapChainDesc.height, desc.swapChainDesc.sampleCount, getSwapChainColorFormat(desc.swapChainDesc.isSrgb), getSwapChainDepthFormat());
        
         // Show the window
-        ShowWindow(pWinData->hWnd, SW_SHOWNORMAL);
+        if(desc.isVisible)
+        {
+            ShowWindow(pWinData->hWnd, SW_SHOWNORMAL);
+        }
         return pWindow;
     }
 
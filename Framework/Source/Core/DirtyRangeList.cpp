@@ -0,0 +1,106 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "DirtyRangeList.h"
+#include <algorithm>
+
+namespace Falcor
+{
+    void DirtyRangeList::add(size_t offset, size_t size)
+    {
+        if(size == 0)
+        {
+            return;
+        }
+
+        // Find the first range which ends close enough to the new range to be merged with it. The ranges are disjoint, so their ends are sorted as well.
+        size_t end = offset + size;
+        const size_t mergeDistance = mMergeDistance;
+        auto first = std::lower_bound(mRanges.begin(), mRanges.end(), offset, [mergeDistance](const Range& r, size_t o) { return r.offset + r.size + mergeDistance < o; });
+
+        // Merge all the ranges which start close enough to its end
+        auto last = first;
+        while((last != mRanges.end()) && (last->offset <= end + mMergeDistance))
+        {
+            offset = std::min(offset, last->offset);
+            end = std::max(end, last->offset + last->size);
+            mDirtyBytes -= last->size;
+            last++;
+        }
+
+        mDirtyBytes += end - offset;
+        if(first == last)
+        {
+            Range range = { offset, end - offset };
+            mRanges.insert(first, range);
+        }
+        else
+        {
+            first->offset = offset;
+            first->size = end - offset;
+            mRanges.erase(first + 1, last);
+        }
+    }
+
+    void DirtyRangeList::remove(size_t offset, size_t size)
+    {
+        const size_t end = offset + size;
+        auto it = std::lower_bound(mRanges.begin(), mRanges.end(), offset, [](const Range& r, size_t o) { return r.offset + r.size <= o; });
+        while((it != mRanges.end()) && (it->offset < end))
+        {
+            const size_t rangeEnd = it->offset + it->size;
+            if((it->offset < offset) && (rangeEnd > end))
+            {
+                // The removed range is inside this one
+                mDirtyBytes -= size;
+                it->size = offset - it->offset;
+                Range tail = { end, rangeEnd - end };
+                mRanges.insert(it + 1, tail);
+                return;
+            }
+            else if(it->offset < offset)
+            {
+                mDirtyBytes -= rangeEnd - offset;
+                it->size = offset - it->offset;
+                it++;
+            }
+            else if(rangeEnd > end)
+            {
+                mDirtyBytes -= end - it->offset;
+                it->size = rangeEnd - end;
+                it->offset = end;
+                return;
+            }
+            else
+            {
+                mDirtyBytes -= it->size;
+                it = mRanges.erase(it);
+            }
+        }
+    }
+}
@@ -0,0 +1,78 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include <stdint.h>
+
+namespace Falcor
+{
+    /** A sorted list of disjoint byte ranges which were modified, used to upload only the modified parts of a buffer.
+        Ranges which overlap, or are separated by a gap of up to the merge distance, are merged. This trades a few extra bytes for fewer, larger copies.
+    */
+    class DirtyRangeList
+    {
+    public:
+        struct Range
+        {
+            size_t offset;
+            size_t size;
+        };
+
+        /** Constructor
+            \param[in] mergeDistance Ranges separated by a gap of up to this many bytes are merged into a single range
+        */
+        DirtyRangeList(size_t mergeDistance = 0) : mMergeDistance(mergeDistance) {}
+
+        /** Mark a range as modified
+        */
+        void add(size_t offset, size_t size);
+
+        /** Mark a range as clean. Ranges which overlap it are trimmed or split.
+        */
+        void remove(size_t offset, size_t size);
+
+        /** Mark everything as clean
+        */
+        void clear() { mRanges.clear(); mDirtyBytes = 0; }
+
+        bool isEmpty() const { return mRanges.empty(); }
+
+        /** Get the modified ranges, sorted by offset
+        */
+        const std::vector<Range>& getRanges() const { return mRanges; }
+
+        /** Get the total size of the modified ranges, including the gaps which were merged
+        */
+        size_t getDirtyBytes() const { return mDirtyBytes; }
+
+    private:
+        std::vector<Range> mRanges;
+        size_t mDirtyBytes = 0;
+        size_t mMergeDistance;
+    };
+}
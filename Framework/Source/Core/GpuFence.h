@@ -0,0 +1,71 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <memory>
+#include <deque>
+#include <stdint.h>
+
+namespace Falcor
+{
+    /** Abstracts GPU fences. \n
+        Every call to signal() inserts a fence into the GPU command stream and returns an increasing value. Once the GPU executed all the commands issued before the fence, the value is completed.
+    */
+    class GpuFence : public std::enable_shared_from_this<GpuFence>
+    {
+    public:
+        using SharedPtr = std::shared_ptr<GpuFence>;
+        using SharedConstPtr = std::shared_ptr<const GpuFence>;
+
+        /** create a new object
+        */
+        static SharedPtr create();
+
+        /** Destroy the object
+        */
+        ~GpuFence();
+
+        /** Insert a fence into the command stream
+            \return The fence value, which is larger than all the previous values
+        */
+        uint64_t signal();
+
+        /** Get the last value which completed. This doesn't block.
+        */
+        uint64_t getCompletedValue();
+
+        /** Block until a value completes. Values which weren't signaled yet are ignored.
+        */
+        void wait(uint64_t value);
+
+    private:
+        GpuFence() = default;
+        uint64_t mLastSignaled = 0;
+        uint64_t mLastCompleted = 0;
+        std::deque<std::pair<uint64_t, void*>> mPending;
+    };
+}
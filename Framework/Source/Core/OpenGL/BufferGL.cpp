@@ -38,6 +38,7 @@ namespace Falcor
         glFlags |= ((flags & Buffer::AccessFlags::Dynamic) != Buffer::AccessFlags::None) ? GL_DYNAMIC_STORAGE_BIT : 0;
         glFlags |= ((flags & Buffer::AccessFlags::MapRead) != Buffer::AccessFlags::None) ? GL_MAP_READ_BIT : 0;
         glFlags |= ((flags & Buffer::AccessFlags::MapWrite) != Buffer::AccessFlags::None) ? GL_MAP_WRITE_BIT : 0;
+        glFlags |= ((flags & Buffer::AccessFlags::Persistent) != Buffer::AccessFlags::None) ? (GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT) : 0;
 
         return glFlags;
     }
@@ -148,6 +149,11 @@ namespace Falcor
             return nullptr;
         }
 
+        if((mAccessFlags & AccessFlags::Persistent) != AccessFlags::None)
+        {
+            flags |= GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        }
+
         void* pData = gl_call(glMapNamedBufferRange(mApiHandle, 0, mSize, flags));
         mIsMapped = true;
         return pData;
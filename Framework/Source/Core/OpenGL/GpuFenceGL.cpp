@@ -0,0 +1,94 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#ifdef FALCOR_GL
+#include "Core/GpuFence.h"
+
+namespace Falcor
+{
+    GpuFence::SharedPtr GpuFence::create()
+    {
+        return SharedPtr(new GpuFence);
+    }
+
+    GpuFence::~GpuFence()
+    {
+        for(auto& pending : mPending)
+        {
+            glDeleteSync((GLsync)pending.second);
+        }
+    }
+
+    uint64_t GpuFence::signal()
+    {
+        GLsync sync = gl_call(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+        mLastSignaled++;
+        mPending.push_back(std::make_pair(mLastSignaled, (void*)sync));
+        return mLastSignaled;
+    }
+
+    uint64_t GpuFence::getCompletedValue()
+    {
+        while(mPending.empty() == false)
+        {
+            GLsync sync = (GLsync)mPending.front().second;
+            GLenum result = gl_call(glClientWaitSync(sync, 0, 0));
+            if(result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+            {
+                break;
+            }
+            mLastCompleted = mPending.front().first;
+            glDeleteSync(sync);
+            mPending.pop_front();
+        }
+        return mLastCompleted;
+    }
+
+    void GpuFence::wait(uint64_t value)
+    {
+        while(mPending.empty() == false && mPending.front().first <= value)
+        {
+            GLsync sync = (GLsync)mPending.front().second;
+            GLenum result;
+            do
+            {
+                // Flush the command stream, otherwise the fence might never be reached
+                result = gl_call(glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000));
+            } while(result == GL_TIMEOUT_EXPIRED);
+
+            if(result == GL_WAIT_FAILED)
+            {
+                Logger::log(Logger::Level::Error, "GpuFence::wait() - waiting for a fence failed");
+            }
+            mLastCompleted = mPending.front().first;
+            glDeleteSync(sync);
+            mPending.pop_front();
+        }
+    }
+}
+#endif //#ifdef FALCOR_GL
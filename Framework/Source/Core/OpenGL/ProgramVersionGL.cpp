@@ -55,6 +55,7 @@ namespace Falcor
         auto pProgram = SharedPtr(new ProgramVersion(pVS, pFS, pGS, pHS, pDS, name));
 
         pProgram->mApiHandle = gl_call(glCreateProgram());
+        gl_call(glProgramParameteri(pProgram->mApiHandle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
 
         // Attach all shaders
         for(uint32_t i = 0; i < arraysize(pProgram->mpShaders); i++)
@@ -89,6 +90,60 @@ namespace Falcor
         return pProgram;
     }
 
+    ProgramVersion::SharedConstPtr ProgramVersion::createFromBinary(uint32_t format, const std::vector<uint8_t>& binary, std::string& log, const std::string& name)
+    {
+        // The shaders are only needed to link the program. A program created from a binary doesn't have any.
+        Shader::SharedPtr pNull;
+        auto pProgram = SharedPtr(new ProgramVersion(pNull, pNull, pNull, pNull, pNull, name));
+
+        pProgram->mApiHandle = gl_call(glCreateProgram());
+        gl_call(glProgramBinary(pProgram->mApiHandle, format, binary.data(), (GLsizei)binary.size()));
+
+        // The driver can reject the binary, for example if it was updated since the binary was created
+        GLint success;
+        gl_call(glGetProgramiv(pProgram->mApiHandle, GL_LINK_STATUS, &success));
+        if(success == 0)
+        {
+            log = "The driver rejected the program binary";
+            return nullptr;
+        }
+
+        if(reflectBuffers(pProgram->mApiHandle, pProgram->mBuffersDesc, log) == false)
+        {
+            return nullptr;
+        }
+
+        return pProgram;
+    }
+
+    std::string ProgramVersion::getCompilerIdentity()
+    {
+        std::string identity;
+        const GLenum names[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+        for(GLenum name : names)
+        {
+            const GLubyte* pString = gl_call(glGetString(name));
+            identity += pString ? std::string((const char*)pString) : std::string();
+            identity += '\n';
+        }
+        return identity;
+    }
+
+    bool ProgramVersion::getBinary(uint32_t& format, std::vector<uint8_t>& binary) const
+    {
+        GLint size = 0;
+        gl_call(glGetProgramiv(mApiHandle, GL_PROGRAM_BINARY_LENGTH, &size));
+        if(size <= 0)
+        {
+            return false;
+        }
+        binary.resize(size);
+        GLenum binaryFormat;
+        gl_call(glGetProgramBinary(mApiHandle, size, nullptr, &binaryFormat, binary.data()));
+        format = binaryFormat;
+        return true;
+    }
+
     ProgramHandle ProgramVersion::getApiHandle() const
     {
         return mApiHandle;
@@ -57,6 +57,7 @@ namespace Falcor
         int shaderStorageBlockCount;
         gl_call(glGetIntegerv(GL_MAX_COMBINED_SHADER_STORAGE_BLOCKS, &shaderStorageBlockCount));
         pCtx->mState.pShaderStorageBuffers.assign(shaderStorageBlockCount, nullptr);
+        pCtx->mState.pStorageBuffers.assign(shaderStorageBlockCount, nullptr);
 
         // Enable some global settings
         gl_call(glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS));
@@ -461,6 +462,13 @@ namespace Falcor
         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, index, apiHandle);
     }
 
+    void RenderContext::applyStorageBuffer(uint32_t index) const
+    {
+        const auto& pBuffer = mState.pStorageBuffers[index];
+        uint32_t apiHandle = pBuffer ? pBuffer->getApiHandle() : 0;
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, index, apiHandle);
+    }
+
     void RenderContext::applyTopology() const
     {
     }
@@ -485,25 +493,22 @@ namespace Falcor
         }
     }
 
-    void RenderContext::draw(uint32_t vertexCount, uint32_t startVertexLocation)
+    void RenderContext::drawApi(uint32_t vertexCount, uint32_t startVertexLocation)
     {
-        prepareForDraw();
         GLenum glTopology = getGlTopology(mState.topology);
         gl_call(glDrawArrays(glTopology, startVertexLocation, vertexCount));
     }
 
-    void RenderContext::drawIndexed(uint32_t indexCount, uint32_t startIndexLocation, int baseVertexLocation)
+    void RenderContext::drawIndexedApi(uint32_t indexCount, uint32_t startIndexLocation, int baseVertexLocation)
     {
-        prepareForDraw();
         GLenum glTopology = getGlTopology(mState.topology);
         uint32_t offset = sizeof(uint32_t) * startIndexLocation;
 
         gl_call(glDrawElementsBaseVertex(glTopology, indexCount, GL_UNSIGNED_INT, (void*)(uintptr_t)offset, baseVertexLocation));
     }
 
-    void RenderContext::drawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndexLocation, int baseVertexLocation, uint32_t startInstanceLocation)
+    void RenderContext::drawIndexedInstancedApi(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndexLocation, int baseVertexLocation, uint32_t startInstanceLocation)
     {
-        prepareForDraw();
         GLenum glTopology = getGlTopology(mState.topology);
         uint32_t offset = sizeof(uint32_t) * startIndexLocation;
 
@@ -34,7 +34,7 @@
 namespace Falcor
 {
     using namespace ShaderReflection;
-    bool checkVariableByOffset(VariableDesc::Type callType, size_t offset, size_t count, const VariableDescMap& uniforms, const std::string& bufferName);
+    bool checkVariableByOffset(VariableDesc::Type callType, size_t offset, size_t count, const VariableOffsetIndex& uniforms, const std::string& bufferName);
     bool checkVariableType(VariableDesc::Type callType, VariableDesc::Type shaderType, const std::string& name, const std::string& bufferName);
 
     ShaderStorageBuffer::SharedPtr ShaderStorageBuffer::create(const ProgramVersion* pProgram, const std::string& bufferName, size_t overrideSize)
@@ -87,7 +87,7 @@ namespace Falcor
     #define get_uniform_offset(_var_type, _c_type) \
     template<> void ShaderStorageBuffer::getVariable(size_t offset, _c_type& value) const    \
     {                                                           \
-        if(checkVariableByOffset(VariableDesc::Type::_var_type, offset, 1, mVariables, mName)) \
+        if(checkVariableByOffset(VariableDesc::Type::_var_type, offset, 1, mVariableIndex, mName)) \
         {                                                       \
             readFromGPU();                                      \
             const uint8_t* pVar = mData.data() + offset;        \
@@ -180,7 +180,7 @@ namespace Falcor
 #define get_uniform_array_offset(_var_type, _c_type) \
     template<> void ShaderStorageBuffer::getVariableArray(size_t offset, size_t count, _c_type value[]) const   \
     {                                                               \
-        if(checkVariableByOffset(VariableDesc::Type::_var_type, offset, count, mVariables, mName))          \
+        if(checkVariableByOffset(VariableDesc::Type::_var_type, offset, count, mVariableIndex, mName))      \
         {                                                           \
             readFromGPU();                                          \
             const uint8_t* pVar = mData.data() + offset;            \
@@ -64,6 +64,19 @@ namespace Falcor
             std::string& log, 
             const std::string& name = "");
 
+        /** create a new program object from a binary previously returned by getBinary()
+            \param[in] format The API-specific binary format
+            \param[in] binary The program binary
+            \param[out] log In case of error, this will contain the error log string
+            \param[in] name Optional. A meaningful name to use with log messages
+            \return New object in case of success, otherwise nullptr. Drivers may reject binaries they didn't create, in which case the program has to be created from its shaders.
+            */
+        static SharedConstPtr createFromBinary(uint32_t format, const std::vector<uint8_t>& binary, std::string& log, const std::string& name = "");
+
+        /** Get a string identifying the driver which compiles programs. Program binaries can only be used with the driver which created them.
+        */
+        static std::string getCompilerIdentity();
+
         ~ProgramVersion();
 
         /** Get the API handle.
@@ -97,6 +110,13 @@ namespace Falcor
         /** Write the shader assembly to file
         */
         void dumpProgramBinaryToFile(const std::string& filename) const;
+
+        /** Get the program binary, which can be used to recreate the program with createFromBinary()
+            \param[out] format The API-specific binary format
+            \param[out] binary The program binary
+            \return false if the API doesn't support program binaries
+        */
+        bool getBinary(uint32_t& format, std::vector<uint8_t>& binary) const;
     private:
         ProgramVersion(const Shader::SharedPtr& pVS,
             const Shader::SharedPtr& pFS,
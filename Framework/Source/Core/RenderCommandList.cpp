@@ -0,0 +1,380 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "RenderCommandList.h"
+#include <cstring>
+
+namespace Falcor
+{
+    static const uint32_t kInvalidSlot = 0xFFFFFFFFu;
+
+    RenderCommandList::SharedPtr RenderCommandList::create()
+    {
+        return SharedPtr(new RenderCommandList);
+    }
+
+    void RenderCommandList::clear()
+    {
+        mCommands.clear();
+        mObjects.clear();
+        mData.clear();
+    }
+
+    uint32_t RenderCommandList::addObject(const std::shared_ptr<const void>& pObject)
+    {
+        mObjects.push_back(pObject);
+        return (uint32_t)mObjects.size() - 1;
+    }
+
+    RenderCommandList::Command& RenderCommandList::addCommand(Type type)
+    {
+        mCommands.emplace_back();
+        Command& cmd = mCommands.back();
+        cmd.type = type;
+        memset(cmd.args, 0, sizeof(cmd.args));
+        return cmd;
+    }
+
+    void RenderCommandList::setProgram(const ProgramVersion::SharedConstPtr& pProgram)
+    {
+        addCommand(Type::SetProgram).args[0] = addObject(pProgram);
+    }
+
+    void RenderCommandList::setVao(const Vao::SharedConstPtr& pVao)
+    {
+        addCommand(Type::SetVao).args[0] = addObject(pVao);
+    }
+
+    void RenderCommandList::setTopology(RenderContext::Topology topology)
+    {
+        addCommand(Type::SetTopology).args[0] = (uint32_t)topology;
+    }
+
+    void RenderCommandList::setRasterizerState(const RasterizerState::SharedConstPtr& pRastState)
+    {
+        addCommand(Type::SetRasterizerState).args[0] = addObject(pRastState);
+    }
+
+    void RenderCommandList::setDepthStencilState(const DepthStencilState::SharedConstPtr& pDepthStencil, uint32_t stencilRef)
+    {
+        Command& cmd = addCommand(Type::SetDepthStencilState);
+        cmd.args[0] = addObject(pDepthStencil);
+        cmd.args[1] = stencilRef;
+    }
+
+    void RenderCommandList::setBlendState(const BlendState::SharedConstPtr& pBlendState, uint32_t sampleMask)
+    {
+        Command& cmd = addCommand(Type::SetBlendState);
+        cmd.args[0] = addObject(pBlendState);
+        cmd.args[1] = sampleMask;
+    }
+
+    void RenderCommandList::setUniformBuffer(uint32_t index, const UniformBuffer::SharedConstPtr& pBuffer)
+    {
+        // Same as RenderContext, ignore invalid binding locations
+        if(index != kInvalidSlot)
+        {
+            Command& cmd = addCommand(Type::SetUniformBuffer);
+            cmd.args[0] = index;
+            cmd.args[1] = addObject(pBuffer);
+        }
+    }
+
+    void RenderCommandList::setShaderStorageBuffer(uint32_t index, const ShaderStorageBuffer::SharedConstPtr& pBuffer)
+    {
+        if(index != kInvalidSlot)
+        {
+            Command& cmd = addCommand(Type::SetShaderStorageBuffer);
+            cmd.args[0] = index;
+            cmd.args[1] = addObject(pBuffer);
+        }
+    }
+
+    void RenderCommandList::setStorageBuffer(uint32_t index, const Buffer::SharedConstPtr& pBuffer)
+    {
+        Command& cmd = addCommand(Type::SetStorageBuffer);
+        cmd.args[0] = index;
+        cmd.args[1] = addObject(pBuffer);
+    }
+
+    void RenderCommandList::setViewport(uint32_t index, const RenderContext::Viewport& vp)
+    {
+        static_assert(sizeof(vp) <= sizeof(Command::args) - sizeof(uint32_t), "Viewport doesn't fit in a command");
+        Command& cmd = addCommand(Type::SetViewport);
+        cmd.args[0] = index;
+        memcpy(&cmd.args[1], &vp, sizeof(vp));
+    }
+
+    void RenderCommandList::setScissor(uint32_t index, const RenderContext::Scissor& sc)
+    {
+        static_assert(sizeof(sc) <= sizeof(Command::args) - sizeof(uint32_t), "Scissor doesn't fit in a command");
+        Command& cmd = addCommand(Type::SetScissor);
+        cmd.args[0] = index;
+        memcpy(&cmd.args[1], &sc, sizeof(sc));
+    }
+
+    void RenderCommandList::setFbo(const Fbo::SharedPtr& pFbo)
+    {
+        addCommand(Type::SetFbo).args[0] = addObject(pFbo);
+    }
+
+    void RenderCommandList::updateUniformBuffer(const UniformBuffer::SharedPtr& pBuffer, const void* pSrc, size_t offset, size_t size)
+    {
+        Command& cmd = addCommand(Type::UpdateUniformBuffer);
+        cmd.args[0] = addObject(pBuffer);
+        cmd.args[1] = (uint32_t)mData.size();
+        cmd.args[2] = (uint32_t)offset;
+        cmd.args[3] = (uint32_t)size;
+        const uint8_t* pBytes = (const uint8_t*)pSrc;
+        mData.insert(mData.end(), pBytes, pBytes + size);
+    }
+
+    void RenderCommandList::updateBuffer(const Buffer::SharedPtr& pBuffer, const void* pSrc, size_t offset, size_t size)
+    {
+        Command& cmd = addCommand(Type::UpdateBuffer);
+        cmd.args[0] = addObject(pBuffer);
+        cmd.args[1] = (uint32_t)mData.size();
+        cmd.args[2] = (uint32_t)offset;
+        cmd.args[3] = (uint32_t)size;
+        const uint8_t* pBytes = (const uint8_t*)pSrc;
+        mData.insert(mData.end(), pBytes, pBytes + size);
+    }
+
+    void RenderCommandList::clearFbo(const Fbo::SharedPtr& pFbo, const glm::vec4& color, float depth, int32_t stencil, FboAttachmentType flags)
+    {
+        // The clear values don't fit in the command, they are stored with the uniform-buffer data
+        Command& cmd = addCommand(Type::ClearFbo);
+        cmd.args[0] = addObject(pFbo);
+        cmd.args[1] = (uint32_t)mData.size();
+        cmd.args[2] = (uint32_t)stencil;
+        cmd.args[3] = (uint32_t)flags;
+        const uint8_t* pColor = (const uint8_t*)&color;
+        const uint8_t* pDepth = (const uint8_t*)&depth;
+        mData.insert(mData.end(), pColor, pColor + sizeof(color));
+        mData.insert(mData.end(), pDepth, pDepth + sizeof(depth));
+    }
+
+    void RenderCommandList::generateMips(const Texture::SharedConstPtr& pTexture)
+    {
+        addCommand(Type::GenerateMips).args[0] = addObject(pTexture);
+    }
+
+    void RenderCommandList::draw(uint32_t vertexCount, uint32_t startVertexLocation)
+    {
+        Command& cmd = addCommand(Type::Draw);
+        cmd.args[0] = vertexCount;
+        cmd.args[1] = startVertexLocation;
+    }
+
+    void RenderCommandList::drawIndexed(uint32_t indexCount, uint32_t startIndexLocation, int baseVertexLocation)
+    {
+        Command& cmd = addCommand(Type::DrawIndexed);
+        cmd.args[0] = indexCount;
+        cmd.args[1] = startIndexLocation;
+        cmd.args[2] = (uint32_t)baseVertexLocation;
+    }
+
+    void RenderCommandList::drawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndexLocation, int baseVertexLocation, uint32_t startInstanceLocation)
+    {
+        Command& cmd = addCommand(Type::DrawIndexedInstanced);
+        cmd.args[0] = indexCount;
+        cmd.args[1] = instanceCount;
+        cmd.args[2] = startIndexLocation;
+        cmd.args[3] = (uint32_t)baseVertexLocation;
+        cmd.args[4] = startInstanceLocation;
+    }
+
+    bool RenderCommandList::isSameBind(const Command& a, const Command& b) const
+    {
+        switch(a.type)
+        {
+        case Type::SetProgram:
+        case Type::SetVao:
+        case Type::SetRasterizerState:
+        case Type::SetFbo:
+            return mObjects[a.args[0]] == mObjects[b.args[0]];
+        case Type::SetDepthStencilState:
+        case Type::SetBlendState:
+            return (mObjects[a.args[0]] == mObjects[b.args[0]]) && (a.args[1] == b.args[1]);
+        case Type::SetUniformBuffer:
+        case Type::SetShaderStorageBuffer:
+        case Type::SetStorageBuffer:
+            return mObjects[a.args[1]] == mObjects[b.args[1]];
+        default:
+            // Topology, viewports and scissors are stored by value
+            return memcmp(a.args, b.args, sizeof(a.args)) == 0;
+        }
+    }
+
+    RenderCommandList::Stats RenderCommandList::execute(RenderContext* pContext) const
+    {
+        Stats stats;
+        stats.commandCount = (uint32_t)mCommands.size();
+
+        // The last bind of every state. Indexed states have a slot per index.
+        const Command* pLastBind[(uint32_t)Type::Count] = {};
+        std::vector<const Command*> lastSlotBind[(uint32_t)Type::Count];
+
+        for(const Command& cmd : mCommands)
+        {
+            const Command** ppLast = nullptr;
+            switch(cmd.type)
+            {
+            case Type::SetUniformBuffer:
+            case Type::SetShaderStorageBuffer:
+            case Type::SetStorageBuffer:
+            case Type::SetViewport:
+            case Type::SetScissor:
+                {
+                    auto& slots = lastSlotBind[(uint32_t)cmd.type];
+                    if(slots.size() <= cmd.args[0])
+                    {
+                        slots.resize(cmd.args[0] + 1, nullptr);
+                    }
+                    ppLast = &slots[cmd.args[0]];
+                }
+                break;
+            case Type::UpdateUniformBuffer:
+            case Type::UpdateBuffer:
+            case Type::ClearFbo:
+            case Type::GenerateMips:
+            case Type::Draw:
+            case Type::DrawIndexed:
+            case Type::DrawIndexedInstanced:
+                break;
+            default:
+                ppLast = &pLastBind[(uint32_t)cmd.type];
+            }
+
+            if(ppLast)
+            {
+                if(*ppLast && isSameBind(**ppLast, cmd))
+                {
+                    stats.redundantBindCount++;
+                    continue;
+                }
+                *ppLast = &cmd;
+                stats.bindCount++;
+            }
+            else if((cmd.type == Type::Draw) || (cmd.type == Type::DrawIndexed) || (cmd.type == Type::DrawIndexedInstanced))
+            {
+                stats.drawCount++;
+            }
+
+            // The null backend stops here
+            if(pContext == nullptr)
+            {
+                continue;
+            }
+
+            switch(cmd.type)
+            {
+            case Type::SetProgram:
+                pContext->setProgram(getObject<ProgramVersion>(cmd.args[0]));
+                break;
+            case Type::SetVao:
+                pContext->setVao(getObject<Vao>(cmd.args[0]));
+                break;
+            case Type::SetTopology:
+                pContext->setTopology((RenderContext::Topology)cmd.args[0]);
+                break;
+            case Type::SetRasterizerState:
+                pContext->setRasterizerState(getObject<RasterizerState>(cmd.args[0]));
+                break;
+            case Type::SetDepthStencilState:
+                pContext->setDepthStencilState(getObject<DepthStencilState>(cmd.args[0]), cmd.args[1]);
+                break;
+            case Type::SetBlendState:
+                pContext->setBlendState(getObject<BlendState>(cmd.args[0]), cmd.args[1]);
+                break;
+            case Type::SetUniformBuffer:
+                pContext->setUniformBuffer(cmd.args[0], getObject<UniformBuffer>(cmd.args[1]));
+                break;
+            case Type::SetShaderStorageBuffer:
+                pContext->setShaderStorageBuffer(cmd.args[0], getObject<ShaderStorageBuffer>(cmd.args[1]));
+                break;
+            case Type::SetStorageBuffer:
+                pContext->setStorageBuffer(cmd.args[0], getObject<Buffer>(cmd.args[1]));
+                break;
+            case Type::SetViewport:
+                {
+                    RenderContext::Viewport vp;
+                    memcpy(&vp, &cmd.args[1], sizeof(vp));
+                    pContext->setViewport(cmd.args[0], vp);
+                }
+                break;
+            case Type::SetScissor:
+                {
+                    RenderContext::Scissor sc;
+                    memcpy(&sc, &cmd.args[1], sizeof(sc));
+                    pContext->setScissor(cmd.args[0], sc);
+                }
+                break;
+            case Type::SetFbo:
+                pContext->setFbo(std::const_pointer_cast<Fbo>(getObject<Fbo>(cmd.args[0])));
+                break;
+            case Type::UpdateUniformBuffer:
+                {
+                    auto pBuffer = std::const_pointer_cast<UniformBuffer>(getObject<UniformBuffer>(cmd.args[0]));
+                    pBuffer->setBlob(mData.data() + cmd.args[1], cmd.args[2], cmd.args[3]);
+                }
+                break;
+            case Type::UpdateBuffer:
+                {
+                    auto pBuffer = std::const_pointer_cast<Buffer>(getObject<Buffer>(cmd.args[0]));
+                    pContext->updateBuffer(pBuffer, mData.data() + cmd.args[1], cmd.args[2], cmd.args[3]);
+                }
+                break;
+            case Type::ClearFbo:
+                {
+                    glm::vec4 color;
+                    float depth;
+                    memcpy(&color, mData.data() + cmd.args[1], sizeof(color));
+                    memcpy(&depth, mData.data() + cmd.args[1] + sizeof(color), sizeof(depth));
+                    pContext->clearFbo(std::const_pointer_cast<Fbo>(getObject<Fbo>(cmd.args[0])), color, depth, (int32_t)cmd.args[2], (FboAttachmentType)cmd.args[3]);
+                }
+                break;
+            case Type::GenerateMips:
+                pContext->generateMips(getObject<Texture>(cmd.args[0]));
+                break;
+            case Type::Draw:
+                pContext->draw(cmd.args[0], cmd.args[1]);
+                break;
+            case Type::DrawIndexed:
+                pContext->drawIndexed(cmd.args[0], cmd.args[1], (int)cmd.args[2]);
+                break;
+            case Type::DrawIndexedInstanced:
+                pContext->drawIndexedInstanced(cmd.args[0], cmd.args[1], cmd.args[2], (int)cmd.args[3], cmd.args[4]);
+                break;
+            default:
+                should_not_get_here();
+            }
+        }
+        return stats;
+    }
+}
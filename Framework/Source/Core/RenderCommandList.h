@@ -0,0 +1,167 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include <memory>
+#include "Core/RenderContext.h"
+
+namespace Falcor
+{
+    /** Records rendering commands into a linear buffer, to be inspected and replayed later on a RenderContext.
+        The recording functions mirror the RenderContext functions. Commands have a fixed size and reference the objects they bind through a table, so recording doesn't touch the API and can be done without a GPU.
+        Renderers usually don't use the list directly. They render through a RenderContext which records into the list, see RenderContext::beginRecording().
+        Uniform-buffer data which changes between draws must be recorded with updateUniformBuffer(), which copies the data into the list.
+        During replay, a bind is dropped if the list already bound the same state. The first bind of every state is always issued, since the context's state is unknown when the list starts.
+    */
+    class RenderCommandList
+    {
+    public:
+        using SharedPtr = std::shared_ptr<RenderCommandList>;
+        using SharedConstPtr = std::shared_ptr<const RenderCommandList>;
+
+        enum class Type : uint32_t
+        {
+            SetProgram,
+            SetVao,
+            SetTopology,
+            SetRasterizerState,
+            SetDepthStencilState,
+            SetBlendState,
+            SetUniformBuffer,
+            SetShaderStorageBuffer,
+            SetStorageBuffer,
+            SetViewport,
+            SetScissor,
+            SetFbo,
+            UpdateUniformBuffer,
+            UpdateBuffer,
+            ClearFbo,
+            GenerateMips,
+            Draw,
+            DrawIndexed,
+            DrawIndexedInstanced,
+            Count
+        };
+
+        /** A recorded command. Objects are stored as indices into the object table, see getObject().
+        */
+        struct Command
+        {
+            Type type;
+            uint32_t args[7];
+        };
+
+        /** Replay statistics
+        */
+        struct Stats
+        {
+            uint32_t commandCount = 0;
+            uint32_t drawCount = 0;
+            uint32_t bindCount = 0;             // Binds sent to the context
+            uint32_t redundantBindCount = 0;    // Binds dropped because the state was already bound
+        };
+
+        /** create a new object
+        */
+        static SharedPtr create();
+
+        /** Remove all the commands and release the referenced objects
+        */
+        void clear();
+
+        void setProgram(const ProgramVersion::SharedConstPtr& pProgram);
+        void setVao(const Vao::SharedConstPtr& pVao);
+        void setTopology(RenderContext::Topology topology);
+        void setRasterizerState(const RasterizerState::SharedConstPtr& pRastState);
+        void setDepthStencilState(const DepthStencilState::SharedConstPtr& pDepthStencil, uint32_t stencilRef);
+        void setBlendState(const BlendState::SharedConstPtr& pBlendState, uint32_t sampleMask = RenderContext::kSampleMaskAll);
+        void setUniformBuffer(uint32_t index, const UniformBuffer::SharedConstPtr& pBuffer);
+        void setShaderStorageBuffer(uint32_t index, const ShaderStorageBuffer::SharedConstPtr& pBuffer);
+        void setStorageBuffer(uint32_t index, const Buffer::SharedConstPtr& pBuffer);
+        void setViewport(uint32_t index, const RenderContext::Viewport& vp);
+        void setScissor(uint32_t index, const RenderContext::Scissor& sc);
+        void setFbo(const Fbo::SharedPtr& pFbo);
+
+        /** Record an update of a uniform-buffer. The data is copied into the list, and set into the buffer with UniformBuffer::setBlob() during replay.
+            \param[in] pBuffer The buffer to update
+            \param[in] pSrc The source data
+            \param[in] offset Destination offset inside the buffer
+            \param[in] size Number of bytes to copy
+        */
+        void updateUniformBuffer(const UniformBuffer::SharedPtr& pBuffer, const void* pSrc, size_t offset, size_t size);
+
+        /** Record an update of a buffer. The data is copied into the list, and set into the buffer with Buffer::updateData() during replay, so the buffer must be created with Buffer::AccessFlags::Dynamic.
+        */
+        void updateBuffer(const Buffer::SharedPtr& pBuffer, const void* pSrc, size_t offset, size_t size);
+
+        /** Record a clear of an FBO, see Fbo::clear()
+        */
+        void clearFbo(const Fbo::SharedPtr& pFbo, const glm::vec4& color, float depth, int32_t stencil, FboAttachmentType flags);
+
+        /** Record the generation of a texture's mip-chain
+        */
+        void generateMips(const Texture::SharedConstPtr& pTexture);
+
+        void draw(uint32_t vertexCount, uint32_t startVertexLocation);
+        void drawIndexed(uint32_t indexCount, uint32_t startIndexLocation, int baseVertexLocation);
+        void drawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndexLocation, int baseVertexLocation, uint32_t startInstanceLocation);
+
+        /** Replay the commands
+            \param[in] pContext The context to replay the commands on. If this is nullptr, the commands are replayed on a null backend: redundant binds are filtered and counted, but no API calls are made and no buffer is updated.
+            \return Statistics of the replay
+        */
+        Stats execute(RenderContext* pContext) const;
+
+        /** Get the recorded commands
+        */
+        const std::vector<Command>& getCommands() const { return mCommands; }
+
+        /** Get an object referenced by a command
+            \param[in] index The object index stored in the command's arguments
+        */
+        template<typename T>
+        std::shared_ptr<const T> getObject(uint32_t index) const { return std::static_pointer_cast<const T>(mObjects[index]); }
+
+        /** Get the data copied into the list by the update and clear commands. The commands store their data's offset in args[1].
+        */
+        const uint8_t* getData() const { return mData.data(); }
+
+        /** Get the size of the data copied into the list, in bytes
+        */
+        size_t getDataSize() const { return mData.size(); }
+
+    private:
+        bool isSameBind(const Command& a, const Command& b) const;
+        uint32_t addObject(const std::shared_ptr<const void>& pObject);
+        Command& addCommand(Type type);
+
+        std::vector<Command> mCommands;
+        std::vector<std::shared_ptr<const void>> mObjects;
+        std::vector<uint8_t> mData;
+    };
+}
@@ -31,6 +31,7 @@
 #include "DepthStencilState.h"
 #include "BlendState.h"
 #include "FBO.h"
+#include "RenderCommandList.h"
 
 namespace Falcor
 {
@@ -102,22 +103,45 @@ namespace Falcor
         mState = mStateStack.top();
 
         // And set all state objects
-        applyFbo();
-        applyVao();
-        applyTopology();
-        applyRasterizerState();
-        applyDepthStencilState();
-        applyBlendState();
-        applyProgram();
-
-        for(uint32_t i = 0; i < mState.pUniformBuffers.size(); i++)
+        if(mpRecordingList)
         {
-            applyUniformBuffer(i);
-        }
+            mpRecordingList->setFbo(mState.pFbo);
+            mpRecordingList->setVao(mState.pVao);
+            mpRecordingList->setTopology(mState.topology);
+            mpRecordingList->setRasterizerState(mState.pRastState);
+            mpRecordingList->setDepthStencilState(mState.pDsState, mState.stencilRef);
+            mpRecordingList->setBlendState(mState.pBlendState, mState.sampleMask);
+            mpRecordingList->setProgram(mState.pProgram);
+
+            for(uint32_t i = 0; i < mState.pUniformBuffers.size(); i++)
+            {
+                mpRecordingList->setUniformBuffer(i, mState.pUniformBuffers[i]);
+            }
 
-        for(uint32_t i = 0; i < mState.viewports.size(); i++)
+            for(uint32_t i = 0; i < mState.viewports.size(); i++)
+            {
+                mpRecordingList->setViewport(i, mState.viewports[i]);
+            }
+        }
+        else
         {
-            applyViewport(i);
+            applyFbo();
+            applyVao();
+            applyTopology();
+            applyRasterizerState();
+            applyDepthStencilState();
+            applyBlendState();
+            applyProgram();
+
+            for(uint32_t i = 0; i < mState.pUniformBuffers.size(); i++)
+            {
+                applyUniformBuffer(i);
+            }
+
+            for(uint32_t i = 0; i < mState.viewports.size(); i++)
+            {
+                applyViewport(i);
+            }
         }
 
         mStateStack.pop();
@@ -183,12 +207,22 @@ namespace Falcor
         mState.pDsState = (pDepthStencil == nullptr) ? mpDefaultDepthStencilState : pDepthStencil;
         mState.stencilRef = stencilRef;
 
+        if(mpRecordingList)
+        {
+            mpRecordingList->setDepthStencilState(mState.pDsState, stencilRef);
+            return;
+        }
         applyDepthStencilState();
     }
 
     void RenderContext::setRasterizerState(const RasterizerState::SharedConstPtr& pRastState)
     {
         mState.pRastState = (pRastState == nullptr) ? mpDefaultRastState : pRastState;
+        if(mpRecordingList)
+        {
+            mpRecordingList->setRasterizerState(mState.pRastState);
+            return;
+        }
         applyRasterizerState();
     }
 
@@ -196,18 +230,33 @@ namespace Falcor
     {
         mState.pBlendState = (pBlendState == nullptr) ? mpDefaultBlendState : pBlendState;
         mState.sampleMask = sampleMask;
+        if(mpRecordingList)
+        {
+            mpRecordingList->setBlendState(mState.pBlendState, sampleMask);
+            return;
+        }
         applyBlendState();
     }
 
     void RenderContext::setProgram(const ProgramVersion::SharedConstPtr& pProgram)
     {
         mState.pProgram = pProgram;
+        if(mpRecordingList)
+        {
+            mpRecordingList->setProgram(pProgram);
+            return;
+        }
         applyProgram();
     }
 
     void RenderContext::setVao(const Vao::SharedConstPtr& pVao)
     {
         mState.pVao = pVao;
+        if(mpRecordingList)
+        {
+            mpRecordingList->setVao(pVao);
+            return;
+        }
         applyVao();
     }
 
@@ -222,6 +271,11 @@ namespace Falcor
         mState.pFbo = pTemp;
         if(pTemp->checkStatus())
         {
+            if(mpRecordingList)
+            {
+                mpRecordingList->setFbo(pTemp);
+                return;
+            }
             applyFbo();
         }
     }
@@ -231,6 +285,11 @@ namespace Falcor
         if ( index != 0xFFFFFFFFu )  // check that index isn't -1 (i.e., an invalid return from GL calls)
         {
             mState.pUniformBuffers[index] = pBuffer;
+            if(mpRecordingList)
+            {
+                mpRecordingList->setUniformBuffer(index, pBuffer);
+                return;
+            }
             applyUniformBuffer( index );
         }
     }
@@ -241,13 +300,39 @@ namespace Falcor
         {
             // Not checking if the state actually changed. Some of the externals libraries we use make raw API calls, bypassing the render-context, so checking if the state actually changed might lead to unexpected behavior.
             mState.pShaderStorageBuffers[index] = pBuffer;
+            if(mpRecordingList)
+            {
+                mpRecordingList->setShaderStorageBuffer(index, pBuffer);
+                return;
+            }
             applyShaderStorageBuffer( index );
         }
     }
 
+    void RenderContext::setStorageBuffer(uint32_t index, const Buffer::SharedConstPtr& pBuffer)
+    {
+        if(index >= mState.pStorageBuffers.size())
+        {
+            Logger::log(Logger::Level::Error, "RenderContext::setStorageBuffer() - index out of range. Max possible index is " + std::to_string(mState.pStorageBuffers.size()) + ", got " + std::to_string(index));
+            return;
+        }
+        mState.pStorageBuffers[index] = pBuffer;
+        if(mpRecordingList)
+        {
+            mpRecordingList->setStorageBuffer(index, pBuffer);
+            return;
+        }
+        applyStorageBuffer(index);
+    }
+
     void RenderContext::setTopology(Topology topology)
     {
         mState.topology = topology;
+        if(mpRecordingList)
+        {
+            mpRecordingList->setTopology(topology);
+            return;
+        }
         applyTopology();
     }
 
@@ -260,6 +345,11 @@ namespace Falcor
         }
 
         mState.viewports[index] = vp;
+        if(mpRecordingList)
+        {
+            mpRecordingList->setViewport(index, vp);
+            return;
+        }
         applyViewport(index);
     }
 
@@ -273,6 +363,11 @@ namespace Falcor
         }
 
         mState.scissors[index] = sc;
+        if(mpRecordingList)
+        {
+            mpRecordingList->setScissor(index, sc);
+            return;
+        }
         applyScissor(index);
     }
 
@@ -296,4 +391,128 @@ namespace Falcor
         }
         prepareForDrawApi();
     }
+
+    void RenderContext::draw(uint32_t vertexCount, uint32_t startVertexLocation)
+    {
+        if(mpRecordingList)
+        {
+            recordUniformBufferUpdates();
+            mpRecordingList->draw(vertexCount, startVertexLocation);
+            return;
+        }
+        prepareForDraw();
+        drawApi(vertexCount, startVertexLocation);
+    }
+
+    void RenderContext::drawIndexed(uint32_t indexCount, uint32_t startIndexLocation, int baseVertexLocation)
+    {
+        if(mpRecordingList)
+        {
+            recordUniformBufferUpdates();
+            mpRecordingList->drawIndexed(indexCount, startIndexLocation, baseVertexLocation);
+            return;
+        }
+        prepareForDraw();
+        drawIndexedApi(indexCount, startIndexLocation, baseVertexLocation);
+    }
+
+    void RenderContext::drawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndexLocation, int baseVertexLocation, uint32_t startInstanceLocation)
+    {
+        if(mpRecordingList)
+        {
+            recordUniformBufferUpdates();
+            mpRecordingList->drawIndexedInstanced(indexCount, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation);
+            return;
+        }
+        prepareForDraw();
+        drawIndexedInstancedApi(indexCount, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation);
+    }
+
+    void RenderContext::clearFbo(const Fbo::SharedPtr& pFbo, const glm::vec4& color, float depth, int32_t stencil, FboAttachmentType flags)
+    {
+        if(mpRecordingList)
+        {
+            mpRecordingList->clearFbo(pFbo, color, depth, stencil, flags);
+            return;
+        }
+        pFbo->clear(color, depth, stencil, flags);
+    }
+
+    void RenderContext::updateBuffer(const Buffer::SharedPtr& pBuffer, const void* pSrc, size_t offset, size_t size)
+    {
+        if(mpRecordingList)
+        {
+            mpRecordingList->updateBuffer(pBuffer, pSrc, offset, size);
+            return;
+        }
+        pBuffer->updateData(pSrc, offset, size);
+    }
+
+    void RenderContext::generateMips(const Texture::SharedConstPtr& pTexture)
+    {
+        if(mpRecordingList)
+        {
+            mpRecordingList->generateMips(pTexture);
+            return;
+        }
+        pTexture->generateMips();
+    }
+
+    void RenderContext::beginRecording(const std::shared_ptr<RenderCommandList>& pList)
+    {
+        if(mpRecordingList)
+        {
+            Logger::log(Logger::Level::Error, "RenderContext::beginRecording() - the context is already recording.");
+            return;
+        }
+        mpRecordingList = pList;
+        mRecordingStartState = mState;
+    }
+
+    void RenderContext::endRecording()
+    {
+        if(mpRecordingList == nullptr)
+        {
+            Logger::log(Logger::Level::Error, "RenderContext::endRecording() - the context isn't recording.");
+            return;
+        }
+
+        // Nothing was sent to the API, so it still has the state from when the recording started
+        mState = mRecordingStartState;
+        mRecordingStartState = State();
+        mpRecordingList = nullptr;
+
+        // The data of the recorded uniform-buffers was only copied into the list. Upload it the next time the buffers are used.
+        for(const auto& pBuffer : mRecordedUniformBuffers)
+        {
+            pBuffer->mDirtyRanges.add(0, pBuffer->mSize);
+        }
+        mRecordedUniformBuffers.clear();
+    }
+
+    void RenderContext::recordUniformBufferUpdates()
+    {
+        for(const auto& pUBO : mState.pUniformBuffers)
+        {
+            if((pUBO == nullptr) || (pUBO->mSize == 0))
+            {
+                continue;
+            }
+
+            // The first update copies the entire buffer, since the list can't rely on what the GPU copy contains when it is replayed. Later draws only copy what changed.
+            auto pBuffer = std::const_pointer_cast<UniformBuffer>(pUBO);
+            if(mRecordedUniformBuffers.insert(pUBO).second)
+            {
+                mpRecordingList->updateUniformBuffer(pBuffer, pBuffer->mData.data(), 0, pBuffer->mSize);
+            }
+            else
+            {
+                for(const auto& range : pBuffer->mDirtyRanges.getRanges())
+                {
+                    mpRecordingList->updateUniformBuffer(pBuffer, pBuffer->mData.data() + range.offset, range.offset, range.size);
+                }
+            }
+            pBuffer->mDirtyRanges.clear();
+        }
+    }
 }
@@ -26,6 +26,7 @@
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ***************************************************************************/
 #pragma once
+#include <set>
 #include <stack>
 #include <vector>
 #include "Core/Sampler.h"
@@ -42,6 +43,7 @@
 
 namespace Falcor
 {
+    class RenderCommandList;
 
     /** The rendering context. State object binding and drawing commands are issued through the rendering context. \n
         This class also helps with state management. Unlike the default API state objects, it is initialized with a renderable state. See state objects assigments functions for the defaults.
@@ -203,6 +205,13 @@ namespace Falcor
         */
         void setShaderStorageBuffer(uint32_t index, const ShaderStorageBuffer::SharedConstPtr& pBuffer);
 
+        /** Bind a raw buffer as a shader storage buffer. Unlike setShaderStorageBuffer(), the buffer has no CPU copy, so it is never uploaded by the context. Useful for buffers written through a persistent mapping.
+            Raw buffers share the binding slots with shader storage buffers, the last call wins.
+            \param[in] index The shader storage buffer slot index to set the buffer into.
+            \param[in] pBuffer The buffer to set. nullptr can be used to unbind a buffer from a slot.
+        */
+        void setStorageBuffer(uint32_t index, const Buffer::SharedConstPtr& pBuffer);
+
         /** Set a program object. By default, no program is bound.
             \param[in] pProgram The program object. nullptr can be used to unbind a program.
         */
@@ -245,6 +254,33 @@ namespace Falcor
         /** Pops the last Scissor from the stack and sets it
         */
         void popScissor(uint32_t index);
+
+        /** Clear an FBO. Same as Fbo::clear(), but recorded when the context is recording.
+        */
+        void clearFbo(const Fbo::SharedPtr& pFbo, const glm::vec4& color, float depth, int32_t stencil, FboAttachmentType flags);
+
+        /** Update a buffer created with Buffer::AccessFlags::Dynamic. Same as Buffer::updateData(), but when the context is recording the data is copied into the command list.
+        */
+        void updateBuffer(const Buffer::SharedPtr& pBuffer, const void* pSrc, size_t offset, size_t size);
+
+        /** Generate a texture's mip-chain. Same as Texture::generateMips(), but recorded when the context is recording.
+        */
+        void generateMips(const Texture::SharedConstPtr& pTexture);
+
+        /** Start recording into a command list. Until endRecording() is called, the state, clear and draw functions record commands instead of calling the API, so existing renderers can record a frame without changes.
+            The state is tracked as usual, so the getters and the push/pop functions work while recording. endRecording() restores the state the context had when the recording started.
+            Uniform-buffer data is copied into the list at every draw. Shader-storage buffers, storage buffers and textures are read when the list is executed, so they must not be modified before the list is replayed.
+            \param[in] pList The list to record into. Commands are appended to it.
+        */
+        void beginRecording(const std::shared_ptr<RenderCommandList>& pList);
+
+        /** Stop recording and restore the state the context had before beginRecording() was called
+        */
+        void endRecording();
+
+        /** Get the list the context is recording into, or nullptr if the context isn't recording
+        */
+        RenderCommandList* getRecordingList() const { return mpRecordingList.get(); }
     private:
         RenderContext(uint32_t viewportCount);
 
@@ -260,6 +296,7 @@ namespace Falcor
             uint32_t sampleMask = -1;
             std::vector<UniformBuffer::SharedConstPtr> pUniformBuffers;
             std::vector<ShaderStorageBuffer::SharedConstPtr> pShaderStorageBuffers;
+            std::vector<Buffer::SharedConstPtr> pStorageBuffers;
             std::vector<Viewport> viewports;
             std::vector<Scissor> scissors;
             ProgramVersion::SharedConstPtr pProgram = nullptr;
@@ -288,8 +325,18 @@ namespace Falcor
         void applyFbo() const;
         void applyUniformBuffer(uint32_t Index) const;
         void applyShaderStorageBuffer(uint32_t Index) const;
+        void applyStorageBuffer(uint32_t index) const;
         void applyTopology() const;
         void prepareForDraw() const;
         void prepareForDrawApi() const;
+        void drawApi(uint32_t vertexCount, uint32_t startVertexLocation);
+        void drawIndexedApi(uint32_t indexCount, uint32_t startIndexLocation, int baseVertexLocation);
+        void drawIndexedInstancedApi(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndexLocation, int baseVertexLocation, uint32_t startInstanceLocation);
+
+        // Recording
+        void recordUniformBufferUpdates();
+        std::shared_ptr<RenderCommandList> mpRecordingList;
+        State mRecordingStartState;
+        std::set<UniformBuffer::SharedConstPtr> mRecordedUniformBuffers;   // Uniform-buffers which were copied into the list at least once
     };
 }
\ No newline at end of file
@@ -31,11 +31,17 @@
 #include "buffer.h"
 #include "glm/glm.hpp"
 #include "texture.h"
+#include <algorithm>
 
 namespace Falcor
 {
     using namespace ShaderReflection;
 
+    UniformBuffer::UploadStats UniformBuffer::sUploadStats;
+
+    // Setting neighboring variables is uploaded with a single copy, even if there is some padding between them
+    static const size_t kDirtyRangeMergeDistance = 64;
+
     inline const std::string removeLastArrayIndex(const std::string& name)
     {
         size_t dot = name.find_last_of(".");
@@ -70,6 +76,7 @@ namespace Falcor
         {
             return false;
         }
+        mVariableIndex.build(mVariables);
 
         // create the internal data
         if(overrideSize != 0)
@@ -80,20 +87,20 @@ namespace Falcor
         if(mSize)
         {
             mData.assign(mSize, 0);
-            mpBuffer = Buffer::create(mSize, Buffer::BindFlags::Uniform, Buffer::AccessFlags::MapWrite, mData.data());
+            mpBuffer = Buffer::create(mSize, Buffer::BindFlags::Uniform, Buffer::AccessFlags::MapWrite | Buffer::AccessFlags::Dynamic, mData.data());
         }
         
         return true;
     }
     
-    UniformBuffer::UniformBuffer(const std::string& bufferName) : mName(bufferName)
+    UniformBuffer::UniformBuffer(const std::string& bufferName) : mName(bufferName), mDirtyRanges(kDirtyRangeMergeDistance)
     {
 
     }
 
     void UniformBuffer::uploadToGPU(size_t offset, size_t size) const
     {
-        if(mDirty == false)
+        if(mDirtyRanges.isEmpty())
         {
             return;
         }
@@ -114,17 +121,48 @@ namespace Falcor
             return;
         }
 
-        Buffer::MapType mapType = Buffer::MapType::Write;
-        if((offset == 0) && (size = mSize))
+#ifdef FALCOR_DX11
+        // Constant buffers can only be updated as a whole
+        const bool discard = true;
+#else
+        // Discarding lets the driver use new memory instead of waiting for the GPU to finish with the buffer, but the whole buffer has to be copied
+        const bool discard = (offset == 0) && (size == mSize) && (mDirtyRanges.getDirtyBytes() * 2 > mSize);
+#endif
+        if(discard)
         {
-            mapType = Buffer::MapType::WriteDiscard; // Updating the entire buffer
+            uint8_t* pData = (uint8_t*)mpBuffer->map(Buffer::MapType::WriteDiscard);
+            assert(pData);
+            memcpy(pData, mData.data(), mSize);
+            mpBuffer->unmap();
+            mDirtyRanges.clear();
+            sUploadStats.discardCount++;
+            sUploadStats.bytesUploaded += mSize;
         }
+        else
+        {
+            // Update the modified parts of the range. Mapping the buffer would wait for the GPU to finish reading it, sub-data updates are queued by the driver instead.
+            const size_t end = offset + size;
+            bool isUpdated = false;
+            for(const auto& range : mDirtyRanges.getRanges())
+            {
+                size_t copyStart = std::max(range.offset, offset);
+                size_t copyEnd = std::min(range.offset + range.size, end);
+                if(copyStart < copyEnd)
+                {
+                    mpBuffer->updateData(mData.data() + copyStart, copyStart, copyEnd - copyStart);
+                    isUpdated = true;
+                    sUploadStats.rangeCount++;
+                    sUploadStats.bytesUploaded += copyEnd - copyStart;
+                }
+            }
 
-        uint8_t* pData = (uint8_t*)mpBuffer->map(mapType);
-        assert(pData);
-        memcpy(pData + offset, mData.data() + offset, size);
-        mpBuffer->unmap();
-        mDirty = false;
+            if(isUpdated == false)
+            {
+                return;
+            }
+            mDirtyRanges.remove(offset, size);
+        }
+        sUploadStats.uploadCount++;
     }
 
     template<bool ExpectArrayIndex>
@@ -209,55 +247,38 @@ namespace Falcor
         return true;
     }
 
-    bool checkVariableByOffset(VariableDesc::Type callType, size_t offset, size_t count, const VariableDescMap& uniforms, const std::string& bufferName)
+    bool checkVariableByOffset(VariableDesc::Type callType, size_t offset, size_t count, const VariableOffsetIndex& uniforms, const std::string& bufferName)
     {
 #if _LOG_ENABLED
         // Find the uniform
-        for(const auto& a : uniforms)
+        uint32_t arrayIndex;
+        const VariableOffsetIndex::Entry* pUniform = uniforms.find(offset, arrayIndex);
+        if(pUniform == nullptr)
         {
-            const auto& Data = a.second;
-            size_t ArrayIndex = 0;
-            bool bCheck = (Data.offset == offset);
-
-            // If this is an array, check if we set an element inside it
-            if(Data.arrayStride > 0 && offset > Data.offset)
-            {
-                size_t Stride = offset - Data.offset;
-                if((Stride % Data.arrayStride) == 0)
-                {
-                    ArrayIndex = Stride / Data.arrayStride;
-                    if(ArrayIndex < Data.arraySize)
-                    {
-                        bCheck = true;
-                    }
-                }
-            }
+            std::string msg("Error when setting uniform by offset. No uniform found at offset ");
+            msg += std::to_string(offset) + ". Ignoring call";
+            Logger::log(Logger::Level::Error, msg);
+            return false;
+        }
 
-            if(bCheck)
+        const auto& Data = pUniform->desc;
+        if(Data.arraySize == 0)
+        {
+            if(count > 1)
             {
-                if(Data.arraySize == 0)
-                {
-                    if(count > 1)
-                    {
-                        std::string Msg("Error when setting uniform by offset. Found uniform \"" + a.first + "\" which is not an array, but trying to set more than 1 element");
-                        Logger::log(Logger::Level::Error, Msg);
-                        return false;
-                    }
-                }
-                else if(ArrayIndex + count > Data.arraySize)
-                {
-                    std::string Msg("Error when setting uniform by offset. Found uniform \"" + a.first + "\" with array size " + std::to_string(a.second.arraySize));
-                    Msg += ". Trying to set " + std::to_string(count) + " elements, starting at index " + std::to_string(ArrayIndex) + ", which will cause out-of-bound access. Ignoring call.";
-                    Logger::log(Logger::Level::Error, Msg);
-                    return false;
-                }
-                return checkVariableType(callType, a.second.type, a.first + "(Set by offset)", bufferName);
+                std::string Msg("Error when setting uniform by offset. Found uniform \"" + pUniform->name + "\" which is not an array, but trying to set more than 1 element");
+                Logger::log(Logger::Level::Error, Msg);
+                return false;
             }
         }
-        std::string msg("Error when setting uniform by offset. No uniform found at offset ");
-        msg += std::to_string(offset) + ". Ignoring call";
-        Logger::log(Logger::Level::Error, msg);
-        return false;
+        else if(arrayIndex + count > Data.arraySize)
+        {
+            std::string Msg("Error when setting uniform by offset. Found uniform \"" + pUniform->name + "\" with array size " + std::to_string(Data.arraySize));
+            Msg += ". Trying to set " + std::to_string(count) + " elements, starting at index " + std::to_string(arrayIndex) + ", which will cause out-of-bound access. Ignoring call.";
+            Logger::log(Logger::Level::Error, Msg);
+            return false;
+        }
+        return checkVariableType(callType, Data.type, pUniform->name + "(Set by offset)", bufferName);
 #else
         return true;
 #endif
@@ -266,11 +287,11 @@ namespace Falcor
 #define set_uniform_offset(_var_type, _c_type) \
     template<> void UniformBuffer::setVariable(size_t offset, const _c_type& value)    \
     {                                                           \
-        if(checkVariableByOffset(VariableDesc::Type::_var_type, offset, 1, mVariables, mName)) \
+        if(checkVariableByOffset(VariableDesc::Type::_var_type, offset, 1, mVariableIndex, mName)) \
         {                                                       \
             const uint8_t* pVar = mData.data() + offset;        \
             *(_c_type*)pVar = value;                            \
-            mDirty = true;                                      \
+            markDirty(offset, sizeof(_c_type));                 \
         }                                                       \
     }
 
@@ -360,7 +381,7 @@ namespace Falcor
 #define set_uniform_array_offset(_var_type, _c_type) \
     template<> void UniformBuffer::setVariableArray(size_t offset, const _c_type* pValue, size_t count)             \
     {                                                                                                               \
-        if(checkVariableByOffset(VariableDesc::Type::_var_type, offset, count, mVariables, mName))                  \
+        if(checkVariableByOffset(VariableDesc::Type::_var_type, offset, count, mVariableIndex, mName))              \
         {                                                                                                           \
             const uint8_t* pVar = mData.data() + offset;                                                            \
             _c_type* pData = (_c_type*)pVar;                                                                        \
@@ -368,7 +389,7 @@ namespace Falcor
             {                                                                                                       \
                 pData[i] = pValue[i];                                                                               \
             }                                                                                                       \
-            mDirty = true;                                                                                          \
+            markDirty(offset, count * sizeof(_c_type));                                                             \
         }                                                                                                           \
     }
 
@@ -474,7 +495,7 @@ namespace Falcor
             return;
         }
         memcpy(mData.data() + offset, pSrc, size);
-        mDirty = true;
+        markDirty(offset, size);
     }
 
     bool checkResourceDimension(const Texture* pTexture, const ShaderResourceDesc& shaderDesc, bool bindAsImage, const std::string& name, const std::string& bufferName)
@@ -578,39 +599,22 @@ namespace Falcor
         // Debug checks
         if(pTexture)
         {
-            for(const auto& a : mVariables)
+            // Samplers can share an offset with their texture
+            uint32_t arrayIndex;
+            const VariableOffsetIndex::Entry* pResource = mVariableIndex.find(offset, arrayIndex, [this](const VariableOffsetIndex::Entry& entry)
             {
-                if(a.second.type == VariableDesc::Type::Resource)
+                if(entry.desc.type != VariableDesc::Type::Resource)
                 {
-                    size_t ArrayIndex = 0;
-                    bool bCheck = (a.second.offset == offset);
-
-                    // Check arrays
-                    if(a.second.arrayStride > 0 && offset > a.second.offset)
-                    {
-                        size_t Stride = offset - a.second.offset;
-                        if((Stride % a.second.arrayStride) == 0)
-                        {
-                            ArrayIndex = Stride / a.second.arrayStride;
-                            if(ArrayIndex < a.second.arraySize)
-                            {
-                                bCheck = true;
-                            }
-                        }
-                    }
-
-                    if(bCheck)
-                    {
-                        const auto& it = mResources.find(a.first);
-                        assert(it != mResources.end());
-                        const auto& desc = it->second;                      
-                        if(desc.type != ShaderResourceDesc::ResourceType::Sampler)
-                        {
-                            bOK = checkResourceDimension(pTexture, desc, bindAsImage, a.first, mName);
-                            break;
-                        }
-                    }
+                    return false;
                 }
+                const auto& it = mResources.find(entry.name);
+                assert(it != mResources.end());
+                return it->second.type != ShaderResourceDesc::ResourceType::Sampler;
+            });
+
+            if(pResource)
+            {
+                bOK = checkResourceDimension(pTexture, mResources.find(pResource->name)->second, bindAsImage, pResource->name, mName);
             }
 
             if(bOK == false)
@@ -624,7 +628,6 @@ namespace Falcor
 
         if(bOK)
         {
-            mDirty = true;
             setTextureInternal(offset, pTexture, pSampler);
         }
     }
@@ -28,6 +28,8 @@
 #pragma once
 #include <string>
 #include "ShaderReflection.h"
+#include "VariableOffsetIndex.h"
+#include "DirtyRangeList.h"
 #include "Texture.h"
 #include "Buffer.h"
 
@@ -145,13 +147,31 @@ namespace Falcor
         */
         void setTexture(size_t Offset, const Texture* pTexture, const Sampler* pSampler, bool bindAsImage = false);
 
-        /** Apply the changes to the actual GPU buffer.
-            Note that it is possible to use this function to update only part of the GPU copy of the buffer. This might lead to inconsistencies between the GPU and CPU buffer, so make sure you know what you are doing.
+        /** Apply the changes to the actual GPU buffer. Only the ranges which were modified since the last upload are copied, unless most of the buffer was modified. In that case the whole buffer is discarded and copied, which avoids waiting for the GPU to finish using it.
+            Note that it is possible to use this function to update only part of the GPU copy of the buffer. The modified ranges outside of it are uploaded by a later call.
             \param[in] offset Offset into the buffer to write to
             \param[in] size   Number of bytes to upload. If this value is -1, will update the [Offset, EndOfBuffer] range.
         */
         void uploadToGPU(size_t offset = 0, size_t size = -1) const;
 
+        /** Upload counters, accumulated over all the buffers
+        */
+        struct UploadStats
+        {
+            uint32_t uploadCount = 0;       ///< Number of uploadToGPU() calls which wrote to the GPU buffer
+            uint32_t discardCount = 0;      ///< Number of uploads which discarded and copied the whole buffer
+            uint32_t rangeCount = 0;        ///< Number of modified ranges updated by the other uploads, each with its own Buffer::updateData() call
+            size_t bytesUploaded = 0;       ///< Total number of bytes copied
+        };
+
+        /** Get the upload counters since the last call to resetUploadStats(). Sample resets them at the beginning of every frame, so they count the uploads of the current frame.
+        */
+        static const UploadStats& getUploadStats() { return sUploadStats; }
+
+        /** Reset the upload counters
+        */
+        static void resetUploadStats() { sUploadStats = UploadStats(); }
+
         /** Get the internal buffer object
         */
         Buffer::SharedPtr getBuffer() const { return mpBuffer; }
@@ -173,22 +193,25 @@ namespace Falcor
         bool init(const ProgramVersion* pProgram, const std::string& bufferName, size_t overrideSize, bool isUniformBuffer);
         bool apiInit(const ProgramVersion* pProgram, const std::string& bufferName, bool isUniformBuffer);
         void setTextureInternal(size_t offset, const Texture* pTexture, const Sampler* pSampler);
+        void markDirty(size_t offset, size_t size) { mDirtyRanges.add(offset, size); }
 
         UniformBuffer(const std::string& bufferName);
         Buffer::SharedPtr mpBuffer = nullptr;
         const std::string mName;
         std::vector<uint8_t> mData;
         size_t mSize = 0;
-        mutable bool mDirty = true;
+        mutable DirtyRangeList mDirtyRanges;    // The ranges of mData which weren't uploaded yet
+        static UploadStats sUploadStats;
 
         ShaderReflection::VariableDescMap mVariables;
         ShaderReflection::ShaderResourceDescMap mResources;
+        VariableOffsetIndex mVariableIndex;     // Validates the setters which take an offset
 
         template<bool ExpectArrayIndex>
         const ShaderReflection::VariableDesc* getVariableData(const std::string& name, size_t& offset) const;
 
-#ifdef FALCOR_DX11
         friend class RenderContext;
+#ifdef FALCOR_DX11
         std::map<uint32_t, ID3D11ShaderResourceViewPtr>* mAssignedResourcesMap;
         std::map<uint32_t, ID3D11SamplerStatePtr>* mAssignedSamplersMap;
         const std::map<uint32_t, ID3D11ShaderResourceViewPtr>& getAssignedResourcesMap() const { return *mAssignedResourcesMap; }
@@ -0,0 +1,67 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "VariableOffsetIndex.h"
+
+namespace Falcor
+{
+    void VariableOffsetIndex::build(const ShaderReflection::VariableDescMap& variables)
+    {
+        mEntries.clear();
+        mEntries.reserve(variables.size());
+        for(const auto& var : variables)
+        {
+            Entry entry;
+            entry.name = var.first;
+            entry.desc = var.second;
+            mEntries.push_back(entry);
+        }
+
+        // Variables which share an offset are ordered by name, so the lookup result doesn't depend on the hash map's order
+        std::sort(mEntries.begin(), mEntries.end(), [](const Entry& a, const Entry& b)
+        {
+            return (a.desc.offset != b.desc.offset) ? (a.desc.offset < b.desc.offset) : (a.name < b.name);
+        });
+
+        mOffsets.resize(mEntries.size());
+        mMaxEnds.resize(mEntries.size());
+        size_t maxEnd = 0;
+        for(size_t i = 0; i < mEntries.size(); i++)
+        {
+            const ShaderReflection::VariableDesc& desc = mEntries[i].desc;
+            size_t end = desc.offset + 1;
+            if(desc.arrayStride > 0)
+            {
+                end = std::max(end, desc.offset + (size_t)desc.arrayStride * desc.arraySize);
+            }
+            maxEnd = std::max(maxEnd, end);
+            mOffsets[i] = desc.offset;
+            mMaxEnds[i] = maxEnd;
+        }
+    }
+}
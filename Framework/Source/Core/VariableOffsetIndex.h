@@ -0,0 +1,110 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "ShaderReflection.h"
+
+namespace Falcor
+{
+    /** Finds the variable of a buffer at a byte offset. The index is built once from the reflected variables, then a lookup is a binary search over the variables sorted by offset.
+        An offset matches a variable if it is the variable's offset, or the offset of one of its array elements.
+    */
+    class VariableOffsetIndex
+    {
+    public:
+        struct Entry
+        {
+            std::string name;
+            ShaderReflection::VariableDesc desc;
+        };
+
+        /** Build the index from a buffer's variables. Replaces the previous content of the index.
+        */
+        void build(const ShaderReflection::VariableDescMap& variables);
+
+        /** Find the variable at an offset.
+            \param[in] offset The byte offset inside the buffer
+            \param[out] arrayIndex The index of the array element at the offset, 0 if the variable isn't an array
+            \return The variable, or nullptr if there is no variable at the offset
+        */
+        const Entry* find(size_t offset, uint32_t& arrayIndex) const { return find(offset, arrayIndex, [](const Entry&) { return true; }); }
+
+        /** Find the variable at an offset which satisfies a predicate. Variables which share an offset are tested starting from the last one in name order.
+            \param[in] offset The byte offset inside the buffer
+            \param[out] arrayIndex The index of the array element at the offset, 0 if the variable isn't an array
+            \param[in] pred A function taking a const Entry&, which returns true if the entry can be returned
+            \return The variable, or nullptr if there is no matching variable at the offset
+        */
+        template<typename Pred>
+        const Entry* find(size_t offset, uint32_t& arrayIndex, Pred pred) const;
+
+        /** Get the number of variables in the index
+        */
+        size_t getVariableCount() const { return mEntries.size(); }
+
+    private:
+        std::vector<size_t> mOffsets;   // Sorted. Kept apart from the entries, so the search touches less memory.
+        std::vector<size_t> mMaxEnds;   // mMaxEnds[i] is the largest end offset of the entries [0, i]
+        std::vector<Entry> mEntries;
+    };
+
+    template<typename Pred>
+    const VariableOffsetIndex::Entry* VariableOffsetIndex::find(size_t offset, uint32_t& arrayIndex, Pred pred) const
+    {
+        // Only entries which start at or before the offset can contain it. They are visited from the closest one, until none of the remaining entries ends after the offset.
+        size_t i = std::upper_bound(mOffsets.begin(), mOffsets.end(), offset) - mOffsets.begin();
+        while((i > 0) && (mMaxEnds[i - 1] > offset))
+        {
+            i--;
+            const Entry& entry = mEntries[i];
+            const ShaderReflection::VariableDesc& desc = entry.desc;
+            size_t index = 0;
+            bool match = (desc.offset == offset);
+
+            // If this is an array, check if the offset is an element inside it
+            if((match == false) && (desc.arrayStride > 0))
+            {
+                size_t stride = offset - desc.offset;
+                if((stride % desc.arrayStride) == 0)
+                {
+                    index = stride / desc.arrayStride;
+                    match = (index < desc.arraySize);
+                }
+            }
+
+            if(match && pred(entry))
+            {
+                arrayIndex = (uint32_t)index;
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+}
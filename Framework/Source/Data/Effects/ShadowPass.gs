@@ -31,7 +31,12 @@
 #include "ShaderCommon.h"
 #include "csmdata.h"
 
+#ifdef _SINGLE_CASCADE
+// Every cascade is rendered in its own pass
+layout (triangles, invocations = 1) in;
+#else
 layout (triangles, invocations = _CASCADE_COUNT) in;
+#endif
 layout (triangle_strip, max_vertices = 3) out;
 in int gl_InvocationID;
 out int gl_Layer;
@@ -43,18 +48,30 @@ UNIFORM_BUFFER(PerLightCB, 0)
     CsmData gCsmData;
 };
 
+#ifdef _SINGLE_CASCADE
+UNIFORM_BUFFER(PerCascadeCB, 2)
+{
+    int gCascadeIndex;
+};
+#endif
+
 void main()
 {
+#ifdef _SINGLE_CASCADE
+    int cascade = gCascadeIndex;
+#else
+    int cascade = gl_InvocationID;
+#endif
     for(int i = 0 ; i < 3 ; i++)
     {
         gl_Position = gCsmData.globalMat * gl_in[i].gl_Position;
 
         gl_Position.xyz /= gl_Position.w;
-        gl_Position.xyz *= gCsmData.cascadeScale[gl_InvocationID].xyz;
-        gl_Position.xyz += gCsmData.cascadeOffset[gl_InvocationID].xyz;
+        gl_Position.xyz *= gCsmData.cascadeScale[cascade].xyz;
+        gl_Position.xyz += gCsmData.cascadeOffset[cascade].xyz;
         gl_Position.xyz *= gl_Position.w;
 
-        gl_Layer = gl_InvocationID;
+        gl_Layer = cascade;
         texC = texCin[i];
         EmitVertex();
     }
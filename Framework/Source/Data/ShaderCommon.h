@@ -46,6 +46,9 @@ layout(binding = 51)uniform InternalPerStaticMeshCB
 {
     mat4 gWorldMat[64];
     uint32_t gMeshId;
+    uint32_t gOctahedralAttribs;    // Bit mask of the shader locations whose unit vectors are octahedral-encoded. See Mesh::VertexEncoding
+    vec4 gPositionOffset;           // The object-space position is gPositionOffset + gPositionScale * vPos
+    vec4 gPositionScale;
 };
 
 layout(binding = 52)uniform InternalPerSkinnedMeshCB
@@ -40,6 +40,8 @@
 #define VERTEX_USER_ELEM_COUNT       4
 #define VERTEX_USER0_LOC            (VERTEX_LOCATION_COUNT)
 
+#define INSTANCE_BUFFER_BINDING      7
+
 #define VERTEX_POSITION_NAME 	 	"POSITION"
 #define VERTEX_NORMAL_NAME    	 	"NORMAL"
 #define VERTEX_TANGENT_NAME       	"TANGENT"
@@ -71,6 +73,26 @@ layout(location = VERTEX_BONE_ID_LOC)      in uvec4 vBoneIds;
 layout(secondary_view_offset=1) out int gl_Layer;
 #endif
 
+#ifdef _INSTANCE_BUFFER
+// The world matrices are read from the scene renderer's instance buffer. The draws select their matrices with the base instance.
+#extension GL_ARB_shader_draw_parameters : require
+layout(std430, binding = INSTANCE_BUFFER_BINDING) readonly buffer InternalInstanceDataSB
+{
+    mat4 gInstanceData[];
+};
+
+#ifdef _INSTANCE_PREV_WORLD_MAT
+#define INSTANCE_DATA_STRIDE 2
+#else
+#define INSTANCE_DATA_STRIDE 1
+#endif
+
+int getInstanceDataIndex()
+{
+    return (gl_BaseInstanceARB + gl_InstanceID) * INSTANCE_DATA_STRIDE;
+}
+#endif
+
 out vec3 normalW;
 out vec3 tangentW;
 out vec3 bitangentW;
@@ -82,22 +104,62 @@ mat4 getWorldMat()
 {
 #ifdef _VERTEX_BLENDING
     mat4 worldMat = blendVertices(vBoneWeights, vBoneIds);
+#elif defined(_INSTANCE_BUFFER)
+    mat4 worldMat = gInstanceData[getInstanceDataIndex()];
 #else
     mat4 worldMat = gWorldMat[gl_InstanceID];
 #endif
     return worldMat;
 }
 
+/** Get the object-space position. Compressed positions are stored relative to the mesh's bounding-box.
+*/
+vec4 getPosition()
+{
+    return vec4(gPositionOffset.xyz + gPositionScale.xyz * vPos.xyz, vPos.w);
+}
+
+/** Decode a unit vector. Octahedral-encoded vectors are read from an RG16Snorm buffer, so they are stored in the xy components.
+*/
+vec3 decodeUnitVector(vec3 v, uint shaderLocation)
+{
+    if((gOctahedralAttribs & (1u << shaderLocation)) == 0)
+    {
+        return v;
+    }
+
+    vec3 n = vec3(v.xy, 1.0 - abs(v.x) - abs(v.y));
+    if(n.z < 0)
+    {
+        n.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0 ? 1.0 : -1.0, v.y >= 0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
+
+#ifdef _INSTANCE_PREV_WORLD_MAT
+/** Get the world matrix of the previous frame. Skinned meshes return the current matrix.
+*/
+mat4 getPrevWorldMat()
+{
+#ifdef _VERTEX_BLENDING
+    return getWorldMat();
+#else
+    return gInstanceData[getInstanceDataIndex() + 1];
+#endif
+}
+#endif
+
 void defaultVS()
 {
     mat4 worldMat = getWorldMat();
-    posW = (worldMat * vPos).xyz;
-    gl_Position = gCam.viewProjMat * worldMat * vPos;
+    vec4 pos = getPosition();
+    posW = (worldMat * pos).xyz;
+    gl_Position = gCam.viewProjMat * worldMat * pos;
     texC = vTexC;
     colorV = vColor;
-    normalW = (mat3x3(worldMat) * vNormal).xyz;
-    tangentW = (mat3x3(worldMat) * vTangent).xyz;
-    bitangentW = (mat3x3(worldMat) * vBitangent).xyz;
+    normalW = (mat3x3(worldMat) * decodeUnitVector(vNormal, VERTEX_NORMAL_LOC)).xyz;
+    tangentW = (mat3x3(worldMat) * decodeUnitVector(vTangent, VERTEX_TANGENT_LOC)).xyz;
+    bitangentW = (mat3x3(worldMat) * decodeUnitVector(vBitangent, VERTEX_BITANGENT_LOC)).xyz;
 
 #ifdef _SINGLE_PASS_STEREO
   gl_SecondaryPositionNV.x = (gCam.rightEyeViewProjMat * vec4(posW, 1)).x;
@@ -240,6 +240,7 @@ namespace Falcor
         mShadowPass.pProg = Program::createFromFile(kDepthPassVSFile, kDepthPassFsFile, kDepthPassGsFile, "", "", progDef);
         mShadowPass.pLightUbo = UniformBuffer::create(mShadowPass.pProg->getActiveProgramVersion().get(), "PerLightCB");
         mShadowPass.pAlphaUbo = UniformBuffer::create(mShadowPass.pProg->getActiveProgramVersion().get(), "AlphaMapCB");
+        mShadowPass.pCascadeUbo = nullptr;
 
         mpSceneRenderer = CsmSceneRenderer::create(mpScene, mShadowPass.pAlphaUbo);
     }
@@ -288,6 +289,7 @@ namespace Falcor
         pGui->addCheckBox("Depth Clamp", &mControls.depthClamp, manualSettingsGroup);
         pGui->addCheckBox("Stabilize Cascades", &mControls.stabilizeCascades, manualSettingsGroup);
         pGui->addCheckBox("Concentric Cascades", &mControls.concentricCascades, manualSettingsGroup);
+        pGui->addCheckBox("Per-Cascade Culling", &mControls.cullPerCascade, manualSettingsGroup);
         pGui->addFloatVar("Cascade Blend Threshold", &mCsmData.cascadeBlendThreshold, manualSettingsGroup, 0, 1.0f);
         pGui->nestGroups(uiGroup, manualSettingsGroup);
 
@@ -362,7 +364,7 @@ namespace Falcor
         return distance;
     }
 
-    void getCascadeCropParams(const glm::vec3 crd[8], const glm::mat4& lightVP, glm::vec4& scale, glm::vec4& offset)
+    void CascadedShadowMaps::getCascadeCropParams(const glm::vec3 crd[8], const glm::mat4& lightVP, glm::vec4& scale, glm::vec4& offset)
     {
         // Transform the frustum into light clip-space and calculate min-max
         glm::vec4 maxCS(-1, -1, 0, 1);
@@ -386,6 +388,33 @@ namespace Falcor
         offset.w = 0;
     }
 
+    glm::mat4 CascadedShadowMaps::calcCascadeCullMatrix(const glm::mat4& lightVP, const glm::vec4& scale, const glm::vec4& offset, const BoundingBox& sceneBox)
+    {
+        // The shadow pass GS crops the light's clip-space position with xyz * scale + offset * w, which is linear
+        glm::mat4 crop;
+        crop[0][0] = scale.x;
+        crop[1][1] = scale.y;
+        crop[2][2] = scale.z;
+        crop[3] = glm::vec4(glm::vec3(offset), 1);
+        glm::mat4 cascadeVP = crop * lightVP;
+
+        // The receivers are in [0, 1] along z. Casters beyond them can't cast into the cascade, but casters between the cascade and the light can, and are depth-clamped.
+        // Move the near plane to the closest point of the scene, with a margin so that casters touching the bounds aren't culled.
+        float nearZ = 0;
+        for(uint32_t i = 0; i < 8; i++)
+        {
+            glm::vec3 corner = sceneBox.center + sceneBox.extent * glm::vec3((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f);
+            nearZ = min(nearZ, (cascadeVP * glm::vec4(corner, 1)).z);
+        }
+        nearZ -= 1;
+
+        // Map [nearZ, 1] to [-1, 1]. The light is orthographic, so w is 1.
+        glm::mat4 depthRemap;
+        depthRemap[2][2] = 2 / (1 - nearZ);
+        depthRemap[3][2] = 1 - depthRemap[2][2];
+        return depthRemap * cascadeVP;
+    }
+
     void CascadedShadowMaps::partitionCascades(const Camera* pCamera, const glm::vec2& distanceRange)
     {
         struct
@@ -458,7 +487,46 @@ namespace Falcor
         pCtx->setUniformBuffer(0, mShadowPass.pLightUbo);
         pCtx->setUniformBuffer(1, mShadowPass.pAlphaUbo);
         mShadowPass.pAlphaUbo->setVariable("evsmExp", mCsmData.evsmExponents);
-        mpSceneRenderer->renderScene(pCtx, mShadowPass.pProg.get(), mpLightCamera.get());
+
+        if((mControls.cullPerCascade == false) || (mpLight->getType() != LightDirectional))
+        {
+            // A single pass, the GS sends every triangle to all the cascades
+            mShadowPass.pProg->removeDefine("_SINGLE_CASCADE");
+            mpSceneRenderer->renderScene(pCtx, mShadowPass.pProg.get(), mpLightCamera.get());
+            for(int32_t c = 0; c < mCsmData.cascadeCount; c++)
+            {
+                mCascadeDrawCount[c] = mpSceneRenderer->getDrawStats().drawCount;
+            }
+            return;
+        }
+
+        // A pass per cascade. The GS reads the cascade index from PerCascadeCB.
+        mShadowPass.pProg->addDefine("_SINGLE_CASCADE");
+        if(mShadowPass.pCascadeUbo == nullptr)
+        {
+            mShadowPass.pCascadeUbo = UniformBuffer::create(mShadowPass.pProg->getActiveProgramVersion().get(), "PerCascadeCB");
+        }
+        pCtx->setUniformBuffer(2, mShadowPass.pCascadeUbo);
+
+        // Cull all the cascades in a single traversal. Every pass then uses the light camera with its cascade's matrix, which selects the cascade's culling results.
+        glm::mat4 cullMatrices[CSM_MAX_CASCADES];
+        const BoundingBox sceneBox = mpScene->getBvh().getBoundingBox();
+        for(int32_t c = 0; c < mCsmData.cascadeCount; c++)
+        {
+            cullMatrices[c] = calcCascadeCullMatrix(mCsmData.globalMat, mCsmData.cascadeScale[c], mCsmData.cascadeOffset[c], sceneBox);
+        }
+        mpSceneRenderer->cullViews(cullMatrices, (uint32_t)mCsmData.cascadeCount);
+
+        mpSceneRenderer->setObjectCullState(true);
+        mpLightCamera->setViewMatrix(glm::mat4());
+        for(int32_t c = 0; c < mCsmData.cascadeCount; c++)
+        {
+            mShadowPass.pCascadeUbo->setVariable("gCascadeIndex", c);
+            mpLightCamera->setProjectionMatrix(cullMatrices[c]);
+            mpSceneRenderer->renderScene(pCtx, mShadowPass.pProg.get(), mpLightCamera.get());
+            mCascadeDrawCount[c] = mpSceneRenderer->getDrawStats().drawCount;
+        }
+        mpSceneRenderer->setObjectCullState(false);
     }
 
     void CascadedShadowMaps::executeDepthPass(RenderContext* pCtx, const Camera* pCamera)
@@ -472,7 +540,7 @@ namespace Falcor
             mDepthPass.pFbo = FboHelper::createDepthOnly(width, height, mShadowPass.pFbo->getDepthStencilTexture()->getFormat());
         }
 
-        mDepthPass.pFbo->clearDepthStencil(1, 0, true, false);
+        pCtx->clearFbo(mDepthPass.pFbo, glm::vec4(0), 1, 0, FboAttachmentType::Depth);
         pCtx->pushFbo(mDepthPass.pFbo);
 
         mpSceneRenderer->setObjectCullState(true);
@@ -527,7 +595,8 @@ namespace Falcor
 
     void CascadedShadowMaps::calcDistanceRange(RenderContext* pRenderCtx, const Camera* pCamera, const Texture* pDepthBuffer, glm::vec2& distanceRange)
     {
-        if(mControls.useMinMaxSdsm)
+        // The reduction's result is read back on the CPU, which can't be recorded
+        if(mControls.useMinMaxSdsm && (pRenderCtx->getRecordingList() == nullptr))
         {
             reduceDepthSdsmMinMax(pRenderCtx, pCamera, pDepthBuffer, distanceRange);
         }
@@ -540,7 +609,7 @@ namespace Falcor
     void CascadedShadowMaps::setup(RenderContext* pRenderCtx, const Camera* pCamera, const Texture* pDepthBuffer)
     {
         const glm::vec4 clearColor(1);
-        mShadowPass.pFbo->clear(clearColor, 1.0f, 0, FboAttachmentType::All);
+        pRenderCtx->clearFbo(mShadowPass.pFbo, clearColor, 1.0f, 0, FboAttachmentType::All);
 
         // Calc the bounds
         glm::vec2 distanceRange;
@@ -569,7 +638,7 @@ namespace Falcor
         if(mCsmData.filterMode == CsmFilterVsm || mCsmData.filterMode == CsmFilterEvsm2 || mCsmData.filterMode == CsmFilterEvsm4)
         {
             mpGaussianBlur->execute(pRenderCtx, mShadowPass.pFbo->getColorTexture(0).get(), mShadowPass.pFbo);
-            mShadowPass.pFbo->getColorTexture(0)->generateMips();
+            pRenderCtx->generateMips(mShadowPass.pFbo->getColorTexture(0));
         }
 
         pRenderCtx->popViewport(0);
@@ -68,6 +68,7 @@ namespace Falcor
         \params[in] pScene The scene to render
         \params[in] pCamera The camera that will be used to render the scene
         \params[in] pSceneDepthBuffer Valid only when SDSM is enabled. The depth map to run SDSM analysis on. If this is nullptr, SDSM will run a depth pass
+        When the context is recording (see RenderContext#beginRecording()), SDSM is skipped and the range set with setDistanceRange() is used, since the reduction reads its result back to the CPU.
         */
         void setup(RenderContext* pRenderCtx, const Camera* pCamera, const Texture* pSceneDepthBuffer);
 
@@ -85,6 +86,31 @@ namespace Falcor
         void setVsmMaxAnisotropy(uint32_t maxAniso) { setVsmAnisotropyCB(&maxAniso, this); }
         void setVsmLightBleedReduction(float reduction) { mCsmData.lightBleedingReduction = reduction; }
         void setDepthBias(float depthBias) { mCsmData.depthBias = depthBias; }
+
+        /** Enable/disable per-cascade culling. When enabled, every cascade is rendered in its own pass, which only draws the shadow casters inside the cascade's crop region or between it and the light.
+            When disabled, the whole scene is rendered once and every triangle is rasterized into all the cascades. Only directional lights are culled.
+        */
+        void setCascadeCullState(bool enable) { mControls.cullPerCascade = enable; }
+
+        /** Get the number of draws which rendered into a cascade in the last setup() call
+        */
+        uint32_t getCascadeDrawCount(uint32_t cascade) const { return mCascadeDrawCount[cascade]; }
+
+        /** Calculate the crop parameters of a cascade, which map the cascade's part of the view frustum onto the shadow map
+            \param[in] crd The world-space corners of the cascade's part of the view frustum
+            \param[in] lightVP The light's global shadow matrix
+            \param[out] scale The scale applied to the light's clip-space coordinates
+            \param[out] offset The offset added to the scaled coordinates
+        */
+        static void getCascadeCropParams(const glm::vec3 crd[8], const glm::mat4& lightVP, glm::vec4& scale, glm::vec4& offset);
+
+        /** Calculate the matrix used to cull the shadow casters of a directional light's cascade. Its frustum is the cascade's crop region, extended toward the light up to the scene bounds, so it contains every caster which can cast into the cascade.
+            \param[in] lightVP The light's global shadow matrix
+            \param[in] scale The cascade's crop scale
+            \param[in] offset The cascade's crop offset
+            \param[in] sceneBox The world-space bounding-box of all the casters
+        */
+        static glm::mat4 calcCascadeCullMatrix(const glm::mat4& lightVP, const glm::vec4& scale, const glm::vec4& offset, const BoundingBox& sceneBox);
     private:
         CascadedShadowMaps(uint32_t mapWidth, uint32_t mapHeight, Light::SharedConstPtr pLight, Scene::SharedPtr pScene, uint32_t cascadeCount, ResourceFormat shadowMapFormat);
         Light::SharedConstPtr mpLight;
@@ -108,6 +134,7 @@ namespace Falcor
             Program::SharedPtr pProg;
             UniformBuffer::SharedPtr pLightUbo;
             UniformBuffer::SharedPtr pAlphaUbo;
+            UniformBuffer::SharedPtr pCascadeUbo;
             RasterizerState::SharedPtr pDepthClampRS;
             glm::vec2 mapSize;
         } mShadowPass;
@@ -145,11 +172,13 @@ namespace Falcor
             PartitionMode partitionMode = PartitionMode::PSSM;
             bool stabilizeCascades = true;
             bool concentricCascades = false;
+            bool cullPerCascade = true;
         };
 
         int32_t renderCascade = 0;
         Controls mControls;
         CsmData mCsmData;
+        uint32_t mCascadeDrawCount[CSM_MAX_CASCADES] = {};
 
         static void GUI_CALL getSdsmReadbackLatency(void* pData, void* pThis);
         static void GUI_CALL setSdsmReadbackLatency(const void* pData, void* pThis);
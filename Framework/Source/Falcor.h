@@ -51,10 +51,12 @@
 #include "Core/VAO.h"
 #include "Core/FBO.h"
 #include "Core/GpuTimer.h"
+#include "Core/GpuFence.h"
 #include "Core/UniformBuffer.h"
 #include "Core/VertexLayout.h"
 #include "Core/ShaderStorageBuffer.h"
 #include "Core/Window.h"
+#include "Core/RenderCommandList.h"
 
 #include "Graphics/Camera/Camera.h"
 #include "Graphics/Camera/CameraController.h"
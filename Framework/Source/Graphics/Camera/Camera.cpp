@@ -30,6 +30,7 @@
 #include "glm/gtx/quaternion.hpp"
 #include "utils/AABB.h"
 #include "Utils/math/FalcorMath.h"
+#include "Utils/Math/FrustumCulling.h"
 #include "Core/UniformBuffer.h"
 
 namespace Falcor
@@ -190,6 +191,11 @@ namespace Falcor
         return !isInside;
     }
 
+    void Camera::cullBoundingBoxes(const BoundingBoxSoA& boxes, std::vector<uint32_t>& visibleBoxes) const
+    {
+        Falcor::cullBoundingBoxes(FrustumPlanes(getViewProjMatrix()), boxes, visibleBoxes);
+    }
+
     void Camera::setRightEyePrevViewProjMatrix(const glm::mat4& prevViewProj)
     {
         mData.rightEyePrevViewProjMat = prevViewProj;
@@ -37,6 +37,7 @@
 namespace Falcor
 {
     struct BoundingBox;
+    class BoundingBoxSoA;
     class UniformBuffer;
 
    /** Camera class
@@ -154,6 +155,12 @@ namespace Falcor
         */
         bool isObjectCulled(const BoundingBox& box) const;
 
+        /** Cull a list of bounding-boxes using SIMD. The results are identical to calling isObjectCulled() for every box.
+            \param[in] boxes The bounding-boxes to test
+            \param[out] visibleBoxes The indices of the boxes which are not culled, in increasing order
+        */
+        void cullBoundingBoxes(const BoundingBoxSoA& boxes, std::vector<uint32_t>& visibleBoxes) const;
+
         void setIntoUniformBuffer(UniformBuffer* pBuffer, const std::string& varName) const;
         void setIntoUniformBuffer(UniformBuffer* pBuffer, const std::size_t& offset) const;
 
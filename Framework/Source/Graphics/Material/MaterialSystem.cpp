@@ -83,6 +83,7 @@ namespace Falcor
         {
             // Get the active program version
             const ProgramVersion* pProgVersion = pProgram->getActiveProgramVersion().get();
+            bool isFallback = pProgram->isUsingFallbackVersion();
 
             // Get the material's program map
             ProgramVersionMap& programMap = getMaterialProgramMap(pMaterial);
@@ -99,7 +100,13 @@ namespace Falcor
                
                 // Get the program version and set it into the map
                 pMaterialProg = pProgram->getActiveProgramVersion();
-                programMap[pProgVersion] = pMaterialProg;
+
+                // A fallback stands in for a version which is still compiling, so it can't be cached
+                isFallback = isFallback || pProgram->isUsingFallbackVersion();
+                if(isFallback == false)
+                {
+                    programMap[pProgVersion] = pMaterialProg;
+                }
 
                 // Restore the previous define string
                 pProgram->removeDefine("_MS_STATIC_MATERIAL_DESC");
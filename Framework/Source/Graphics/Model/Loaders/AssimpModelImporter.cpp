@@ -44,20 +44,13 @@
 #include "Core/VertexLayout.h"
 #include "Data/VertexAttrib.h"
 #include "Utils/StringUtils.h"
+#include "Graphics/Model/MeshOptimizer.h"
+#include "Graphics/Model/TangentSpace.h"
+#include "Graphics/Model/MeshSimplifier.h"
+#include "Graphics/ResourceCache.h"
 
 namespace Falcor
 {
-    template<typename posType>
-    void generateSubmeshTangentData(
-        const std::vector<uint32_t>& indices,
-        const posType* vertexPosData,
-        const glm::vec3* vertexNormalData,
-        const glm::vec2* texCrdData,
-        uint32_t texCrdCount,
-        glm::vec3* tangentData,
-        glm::vec3* bitangentData);
-
-
     std::vector<uint32_t> createIndexBufferData(const aiMesh* pAiMesh)
     {
         uint32_t indexCount = pAiMesh->mNumFaces * pAiMesh->mFaces[0].mNumIndices;
@@ -79,20 +72,100 @@ namespace Falcor
 
     void genTangentSpace(const aiMesh* pAiMesh)
     {
-        if(pAiMesh->mFaces[0].mNumIndices == 3)
+        if(pAiMesh->mFaces[0].mNumIndices == 3 && pAiMesh->HasNormals())
         {
             aiMesh* pMesh = const_cast<aiMesh*>(pAiMesh);
             pMesh->mTangents = new aiVector3D[pMesh->mNumVertices];
             pMesh->mBitangents = new aiVector3D[pMesh->mNumVertices];
-
-            const glm::vec3* pPos = (glm::vec3*)pMesh->mVertices;
-            glm::vec3* pTan = (glm::vec3*)pMesh->mTangents;
-            glm::vec3* pBi = (glm::vec3*)pMesh->mBitangents;
-            glm::vec3* pNormals = (glm::vec3*)pMesh->mNormals;
             std::vector<uint32_t> indices = createIndexBufferData(pAiMesh);
 
-            generateSubmeshTangentData<glm::vec3>(indices, pPos, pNormals, nullptr, 0, pTan, pBi);
+            TangentSpaceInput input;
+            input.pPositions = pMesh->mVertices;
+            input.positionStride = sizeof(aiVector3D);
+            input.pNormals = pMesh->mNormals;
+            input.normalStride = sizeof(aiVector3D);
+            if(pMesh->HasTextureCoords(0))
+            {
+                input.pTexCrds = pMesh->mTextureCoords[0];
+                input.texCrdStride = sizeof(aiVector3D);
+            }
+            input.pIndices = indices.data();
+            input.indexCount = (uint32_t)indices.size();
+            input.vertexCount = pMesh->mNumVertices;
+            generateTangentSpace(input, (glm::vec3*)pMesh->mTangents, (glm::vec3*)pMesh->mBitangents);
+        }
+    }
+
+    template<typename T>
+    void remapAiArray(T*& pArray, uint32_t vertexCount, const uint32_t* remap)
+    {
+        if(pArray)
+        {
+            T* pRemapped = new T[vertexCount];
+            remapVertexBuffer(pRemapped, pArray, vertexCount, sizeof(T), remap);
+            delete[] pArray;
+            pArray = pRemapped;
+        }
+    }
+
+    /** Reorder the triangles of a mesh for the post-transform cache and overdraw, and then reorder the vertices by their first use.
+        The aiMesh is modified in place, so everything created from it afterwards uses the optimized order.
+    */
+    void optimizeAiMesh(const aiMesh* pAiMesh)
+    {
+        if(pAiMesh->mFaces[0].mNumIndices != 3)
+        {
+            return;
+        }
+
+        aiMesh* pMesh = const_cast<aiMesh*>(pAiMesh);
+        uint32_t vertexCount = pMesh->mNumVertices;
+        std::vector<uint32_t> indices = createIndexBufferData(pAiMesh);
+        uint32_t indexCount = (uint32_t)indices.size();
+        VertexCacheStats before = analyzeVertexCache(indices.data(), indexCount, vertexCount);
+
+        std::vector<uint32_t> cacheOptimized(indexCount);
+        optimizeVertexCache(cacheOptimized.data(), indices.data(), indexCount, vertexCount);
+        optimizeOverdraw(indices.data(), cacheOptimized.data(), indexCount, pMesh->mVertices, sizeof(aiVector3D), vertexCount);
+
+        std::vector<uint32_t> remap(vertexCount);
+        optimizeVertexFetchRemap(remap.data(), indices.data(), indexCount, vertexCount);
+        remapIndexBuffer(indices.data(), indexCount, remap.data());
+
+        remapAiArray(pMesh->mVertices, vertexCount, remap.data());
+        remapAiArray(pMesh->mNormals, vertexCount, remap.data());
+        remapAiArray(pMesh->mTangents, vertexCount, remap.data());
+        remapAiArray(pMesh->mBitangents, vertexCount, remap.data());
+        for(uint32_t i = 0; i < AI_MAX_NUMBER_OF_COLOR_SETS; i++)
+        {
+            remapAiArray(pMesh->mColors[i], vertexCount, remap.data());
+        }
+        for(uint32_t i = 0; i < AI_MAX_NUMBER_OF_TEXTURECOORDS; i++)
+        {
+            remapAiArray(pMesh->mTextureCoords[i], vertexCount, remap.data());
+        }
+        for(uint32_t i = 0; i < pMesh->mNumBones; i++)
+        {
+            aiBone* pBone = pMesh->mBones[i];
+            for(uint32_t j = 0; j < pBone->mNumWeights; j++)
+            {
+                pBone->mWeights[j].mVertexId = remap[pBone->mWeights[j].mVertexId];
+            }
+        }
+
+        for(uint32_t i = 0; i < pMesh->mNumFaces; i++)
+        {
+            for(uint32_t j = 0; j < 3; j++)
+            {
+                pMesh->mFaces[i].mIndices[j] = indices[i * 3 + j];
+            }
         }
+
+        VertexCacheStats after = analyzeVertexCache(indices.data(), indexCount, vertexCount);
+        std::string msg = "Optimized mesh '" + std::string(pMesh->mName.C_Str()) + "'. ";
+        msg += "ACMR " + std::to_string(before.acmr) + " -> " + std::to_string(after.acmr);
+        msg += ", ATVR " + std::to_string(before.atvr) + " -> " + std::to_string(after.atvr);
+        Logger::log(Logger::Level::Info, msg);
     }
 
     struct layoutsData
@@ -440,6 +513,11 @@ namespace Falcor
         {
             AssimpFlags &= ~(aiProcess_CalcTangentSpace);
         }
+        // Our own optimizer replaces Assimp's cache locality pass
+        if((mFlags & Model::OptimizeVertexCache) != 0)
+        {
+            AssimpFlags &= ~aiProcess_ImproveCacheLocality;
+        }
 
         Assimp::Importer importer;
         const aiScene* pScene = importer.ReadFile(fullpath, AssimpFlags);
@@ -642,9 +720,15 @@ namespace Falcor
 
     Mesh::SharedPtr AssimpModelImporter::createMesh(const aiMesh* pAiMesh)
     {
+        if(mFlags & Model::OptimizeVertexCache)
+        {
+            optimizeAiMesh(pAiMesh);
+        }
+
         uint32_t vertexCount = pAiMesh->mNumVertices;
         uint32_t indexCount = pAiMesh->mNumFaces * pAiMesh->mFaces[0].mNumIndices;
-        auto pIB = createIndexBuffer(pAiMesh);
+        std::vector<Mesh::Lod> lods;
+        auto pIB = createIndexBuffer(pAiMesh, lods);
         BoundingBox boundingBox;
 
         bool manualTangentGen = pAiMesh->HasTangentsAndBitangents() == false && (mFlags & Model::GenerateTangentSpace);
@@ -687,6 +771,7 @@ namespace Falcor
         assert(pMaterial);
 
         Mesh::SharedPtr pMesh = Mesh::create(vbDescVec, vertexCount, pIB, indexCount, topology, pMaterial, boundingBox, pAiMesh->HasBones());
+        pMesh->setLods(lods);
 
         if(manualTangentGen)
         {
@@ -698,10 +783,34 @@ namespace Falcor
         return pMesh;
     }
 
-    Buffer::SharedPtr AssimpModelImporter::createIndexBuffer(const aiMesh* pAiMesh)
+    Buffer::SharedPtr AssimpModelImporter::createIndexBuffer(const aiMesh* pAiMesh, std::vector<Mesh::Lod>& lods)
     {
         std::vector<uint32_t> indices = createIndexBufferData(pAiMesh);
-        auto pBuffer = Buffer::create(uint32_t(sizeof(uint32_t)*indices.size()), Buffer::BindFlags::Index, Buffer::AccessFlags::None, indices.data());
+
+        // The LODs are stored in the same index buffer, after the full resolution mesh
+        if((mFlags & Model::GenerateLods) && pAiMesh->mFaces[0].mNumIndices == 3)
+        {
+            uint32_t indexCount = (uint32_t)indices.size();
+            std::vector<MeshLodData> lodData = generateLodChain(indices.data(), indexCount, pAiMesh->mVertices, sizeof(aiVector3D), pAiMesh->mNumVertices);
+            for(auto& data : lodData)
+            {
+                Mesh::Lod lod;
+                lod.firstIndex = (uint32_t)indices.size();
+                lod.indexCount = (uint32_t)data.indices.size();
+                lod.error = data.error;
+                lods.push_back(lod);
+
+                if(mFlags & Model::OptimizeVertexCache)
+                {
+                    std::vector<uint32_t> optimized(data.indices.size());
+                    optimizeVertexCache(optimized.data(), data.indices.data(), lod.indexCount, pAiMesh->mNumVertices);
+                    data.indices.swap(optimized);
+                }
+                indices.insert(indices.end(), data.indices.begin(), data.indices.end());
+            }
+        }
+
+        auto pBuffer = ResourceCache::createBuffer(uint32_t(sizeof(uint32_t)*indices.size()), Buffer::BindFlags::Index, Buffer::AccessFlags::None, indices.data());
         mpModel->addBuffer(pBuffer);
         return pBuffer;
     }
@@ -840,7 +949,7 @@ namespace Falcor
             loadBones(pAiMesh, initData.get(), vertexCount, vertexStride);
         }
 
-        auto pBuffer = Buffer::create(vertexStride * vertexCount, Buffer::BindFlags::Vertex, Buffer::AccessFlags::None, initData.get());
+        auto pBuffer = ResourceCache::createBuffer(vertexStride * vertexCount, Buffer::BindFlags::Vertex, Buffer::AccessFlags::None, initData.get());
         mpModel->addBuffer(pBuffer);
         return pBuffer;
     }
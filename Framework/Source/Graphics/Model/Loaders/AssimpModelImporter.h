@@ -74,7 +74,7 @@ namespace Falcor
 
         Mesh::SharedPtr createMesh(const aiMesh* pAiMesh);
         bool createVertexLayouts(const aiMesh* pAiMesh, Vao::VertexBufferDescVector& layouts);
-        Buffer::SharedPtr createIndexBuffer(const aiMesh* pAiMesh);
+        Buffer::SharedPtr createIndexBuffer(const aiMesh* pAiMesh, std::vector<Mesh::Lod>& lods);
         Buffer::SharedPtr createVertexBuffer(const aiMesh* pAiMesh, uint32_t vertexCount, BoundingBox& boundingBox, const VertexLayout* pLayout);
         void loadBones(const aiMesh* pAiMesh, uint8_t* pVertexData, uint32_t vertexCount, uint32_t vertexStride);
         void loadTextures(const aiMaterial* pAiMaterial, const std::string& folder, BasicMaterial* pMaterial, bool isObjFile, bool useSrgb);
@@ -35,6 +35,9 @@
 #include "core/Texture.h"
 #include "BinaryImage.hpp"
 #include "Data/VertexAttrib.h"
+#include "Utils/Compression.h"
+#include "Utils/Hash.h"
+#include "Graphics/Model/VertexQuantization.h"
 
 namespace Falcor
 {
@@ -145,21 +148,33 @@ namespace Falcor
         case ResourceFormat::RGB32Float:
         case ResourceFormat::RGBA32Float:
             return AttribFormat_F32;
+        case ResourceFormat::R16Float:
+        case ResourceFormat::RG16Float:
+        case ResourceFormat::RGBA16Float:
+            return AttribFormat_F16;
+        case ResourceFormat::R16Snorm:
+        case ResourceFormat::RG16Snorm:
+            return AttribFormat_S16N;
+        case ResourceFormat::R16Unorm:
+        case ResourceFormat::RG16Unorm:
+        case ResourceFormat::RGBA16Unorm:
+            return AttribFormat_U16N;
         default:
             should_not_get_here(); // Format not supported by the binary file
             return AttribFormat_Max;
         }
     }
 
-    void writeString(BinaryFileStream& stream, const std::string& str)
+    template<typename StreamType>
+    void writeString(StreamType& stream, const std::string& str)
     {
         stream << (int32_t)str.size();
         stream.write(str.c_str(), str.size());;
     }
 
-    void BinaryModelExporter::exportToFile(const std::string& filename, const Model* pModel)
+    void BinaryModelExporter::exportToFile(const std::string& filename, const Model* pModel, bool compress, bool quantize)
     {
-        BinaryModelExporter(filename, pModel);
+        BinaryModelExporter(filename, pModel, compress, quantize);
     }
 
     void BinaryModelExporter::error(const std::string& msg)
@@ -173,7 +188,7 @@ namespace Falcor
         Logger::log(Logger::Level::Error, "Warning when exporting model \"" + mFilename + "\".\n" + Msg);
     }
 
-    BinaryModelExporter::BinaryModelExporter(const std::string& filename, const Model* pModel) : mFilename(filename)
+    BinaryModelExporter::BinaryModelExporter(const std::string& filename, const Model* pModel, bool compress, bool quantize) : mFilename(filename), mCompress(compress), mQuantize(quantize)
     {
         mStream.open(filename.c_str(), BinaryFileStream::Mode::Write);
         mpModel = pModel;
@@ -195,6 +210,8 @@ namespace Falcor
         if(writeTextures()    == false) return;
         if(writeMeshes()      == false) return;
         if(writeInstances()   == false) return;
+        if(writeBounds()      == false) return;
+        if(writeTableOfContents() == false) return;
     }
 
     bool BinaryModelExporter::prepareSubmeshes()
@@ -226,8 +243,80 @@ namespace Falcor
 
     bool BinaryModelExporter::writeHeader()
     {
+        // The file contains a chunk per texture and per mesh, a single chunk for the instances and a single chunk for the mesh bounds
+        mChunkCount = mpModel->getTextureCount() + (uint32_t)mMeshes.size() + 2;
+
         mStream.write("BinScene", 8);
-        mStream << (int32_t)8 << (int32_t)mpModel->getTextureCount() << (int32_t)mMeshes.size() << (int32_t)mInstanceCount;
+        mStream << (int32_t)12 << (int32_t)mpModel->getTextureCount() << (int32_t)mMeshes.size() << (int32_t)mInstanceCount << (int32_t)mChunkCount;
+        mFileOffset = 8 + 5 * sizeof(int32_t);
+
+        // Reserve space for the table of contents. It is written after all the chunks
+        std::vector<uint8_t> toc(mChunkCount * sizeof(ChunkDesc), 0);
+        mStream.write(toc.data(), toc.size());
+        mFileOffset += toc.size();
+        return true;
+    }
+
+    bool BinaryModelExporter::writeTableOfContents()
+    {
+        if(mChunks.size() != mChunkCount)
+        {
+            error("Chunk count doesn't match the table of contents.");
+            return false;
+        }
+
+        mStream.seek(8 + 5 * sizeof(int32_t));
+        for(const auto& chunk : mChunks)
+        {
+            mStream << chunk.type << chunk.compression << chunk.offset << chunk.storedSize << chunk.size << chunk.hash;
+        }
+
+        if(mStream.isFail())
+        {
+            error("Failed to write the file.");
+            return false;
+        }
+        return true;
+    }
+
+    bool BinaryModelExporter::writeChunk(ChunkType type, const MemoryWriteStream& chunk)
+    {
+        ChunkDesc desc;
+        desc.type = type;
+        desc.compression = ChunkCompression_None;
+        desc.size = chunk.getSize();
+        desc.storedSize = chunk.getSize();
+        desc.hash = calculateHash64(chunk.getData(), chunk.getSize());
+
+        const uint8_t* pData = chunk.getData();
+        std::vector<uint8_t> compressed;
+        if(mCompress)
+        {
+            compressLz4(chunk.getData(), chunk.getSize(), compressed);
+            if(compressed.size() < chunk.getSize())
+            {
+                desc.compression = ChunkCompression_LZ4;
+                desc.storedSize = compressed.size();
+                pData = compressed.data();
+            }
+        }
+
+        // Chunks start on a 16-byte boundary
+        uint32_t padding = uint32_t((kBinSceneChunkAlignment - (mFileOffset % kBinSceneChunkAlignment)) % kBinSceneChunkAlignment);
+        const uint8_t zeros[kBinSceneChunkAlignment] = {};
+        mStream.write(zeros, padding);
+        mFileOffset += padding;
+
+        desc.offset = mFileOffset;
+        mStream.write(pData, (size_t)desc.storedSize);
+        mFileOffset += desc.storedSize;
+        mChunks.push_back(desc);
+
+        if(mStream.isFail())
+        {
+            error("Failed to write the file.");
+            return false;
+        }
         return true;
     }
 
@@ -239,7 +328,13 @@ namespace Falcor
         {
             auto pTex = mpModel->getTexture(i).get();
             mTextureHash[pTex] = i;
-            if(exportBinaryImage(pTex) == false)
+
+            MemoryWriteStream chunk;
+            if(exportBinaryImage(chunk, pTex) == false)
+            {
+                return false;
+            }
+            if(writeChunk(ChunkType_Texture, chunk) == false)
             {
                 return false;
             }
@@ -247,73 +342,243 @@ namespace Falcor
         return true;
     }
 
-    bool BinaryModelExporter::writeCommonMeshData(const Mesh::SharedPtr& pMesh, uint32_t submeshCount)
+    bool BinaryModelExporter::readVertexStreams(const Mesh::SharedPtr& pMesh, std::vector<VertexStream>& streams)
     {
         auto pVao = pMesh->getVao();
-		const uint32_t vertexBufferCount = pMesh->getVao()->getVertexBuffersCount();
-		mStream << (int32_t)vertexBufferCount << (int32_t)pMesh->getVertexCount() << (int32_t)submeshCount;
+        const uint32_t vertexBufferCount = pVao->getVertexBuffersCount();
+        streams.resize(vertexBufferCount);
 
-        struct vertexBufferInfo 
+        for(uint32_t i = 0; i < vertexBufferCount; i++)
         {
-            Buffer::SharedPtr pBuffer;
-            size_t            pData; //this had the p flag because it represents the pointer to the vertex buffers data
-            uint32_t          stride;
-        };
-            
-        std::vector<vertexBufferInfo> vbInfo(vertexBufferCount);
-
-		for (uint32_t i = 0; i < vertexBufferCount; i++)
-        {
-			const VertexLayout* pLayout = pVao->getVertexBufferLayout(i).get();
+            const VertexLayout* pLayout = pVao->getVertexBufferLayout(i).get();
             assert(pLayout->getElementCount() == 1);
-            AttribType type = getBinaryAttribType(pLayout->getElementName(0));
-            AttribFormat format = GetBinaryAttribFormat(pLayout->getElementFormat(0));
-            uint32_t channels = getFormatChannelCount(pLayout->getElementFormat(0));
+            VertexStream& stream = streams[i];
+            stream.type = getBinaryAttribType(pLayout->getElementName(0));
+            stream.format = GetBinaryAttribFormat(pLayout->getElementFormat(0));
+            stream.length = (int32_t)getFormatChannelCount(pLayout->getElementFormat(0));
+            stream.offset = glm::vec4(0);
+            stream.scale = glm::vec4(0);
+            for(int32_t c = 0; c < stream.length; c++)
+            {
+                stream.scale[c] = 1;
+            }
+
+            // Compressed vertices (Model::CompressVertices) are written in the matching file encodings
+            const Mesh::VertexEncoding& encoding = pMesh->getVertexEncoding();
+            const uint32_t shaderLocation = pLayout->getElementShaderLocation(0);
+            if(shaderLocation == VERTEX_POSITION_LOC && encoding.compressedPositions)
+            {
+                for(int32_t c = 0; c < 3; c++)
+                {
+                    stream.offset[c] = encoding.positionOffset[c];
+                    stream.scale[c] = encoding.positionScale[c];
+                }
+            }
+            else if(encoding.octahedralAttribs & (1 << shaderLocation))
+            {
+                stream.format = AttribFormat_Oct16;
+                stream.length = 3;
+            }
 
-            if(type == AttribType_Max)
+            if(stream.type == AttribType_Max)
             {
                 error("Unsupported attribute Type");
                 return false;
             }
 
-            if(format == AttribFormat_Max)
+            if(stream.format == AttribFormat_Max)
             {
                 error("Unsupported attribute format");
                 return false;
             }
-            mStream << (int32_t)type << (int32_t)format << (int32_t)channels;
 
             // Most of the buffers we use were created without any access flags, so can't be mapped.
             // We create a temporary staging buffer to overcome this.
-			const Buffer* pVB = pVao->getVertexBuffer(i).get();
-			vbInfo[i].pBuffer = Buffer::create(pVB->getSize(), Buffer::BindFlags::None, Buffer::AccessFlags::MapRead, nullptr);
-            pVB->copy(vbInfo[i].pBuffer.get());
+            size_t streamSize = size_t(pLayout->getTotalStride()) * pMesh->getVertexCount();
+            const Buffer* pVB = pVao->getVertexBuffer(i).get();
+            auto pStaging = Buffer::create(pVB->getSize(), Buffer::BindFlags::None, Buffer::AccessFlags::MapRead, nullptr);
+            pVB->copy(pStaging.get());
 
-            vbInfo[i].pData = (size_t)vbInfo[i].pBuffer->map(Buffer::MapType::Read);
+            const uint8_t* pData = (const uint8_t*)pStaging->map(Buffer::MapType::Read);
+            stream.data.assign(pData, pData + streamSize);
+            pStaging->unmap();
 
+            if(mQuantize && stream.format == AttribFormat_F32)
+            {
+                quantizeVertexStream(stream, pMesh->getVertexCount());
+            }
+        }
+
+        return true;
+    }
+
+    void BinaryModelExporter::quantizeVertexStream(VertexStream& stream, uint32_t vertexCount)
+    {
+        const float* pSrc = (const float*)stream.data.data();
+        const int32_t length = stream.length;
+        const size_t valueCount = size_t(vertexCount) * length;
 
-            vbInfo[i].stride = pLayout->getTotalStride();
+        glm::vec4 minValue(FLT_MAX);
+        glm::vec4 maxValue(-FLT_MAX);
+        for(size_t i = 0; i < valueCount; i++)
+        {
+            int32_t c = int32_t(i % length);
+            minValue[c] = std::min(minValue[c], pSrc[i]);
+            maxValue[c] = std::max(maxValue[c], pSrc[i]);
         }
 
-        // Write the vertex buffer
-		for (uint32_t i = 0; i < pMesh->getVertexCount(); ++i)
-		{
-            for (auto& a : vbInfo)
-			{ 			
-				mStream.write((void*)a.pData, a.stride);
-				a.pData += a.stride;
-			}
-		}
-
-        for (auto& a : vbInfo)
-		{
-			a.pBuffer->unmap();
-		}
+        std::vector<uint8_t> encoded;
+        switch(stream.type)
+        {
+        case AttribType_Position:
+            // 16-bit positions, relative to the mesh's bounding box
+            if(length == 3 && vertexCount > 0)
+            {
+                encoded.resize(valueCount * sizeof(int16_t));
+                int16_t* pDst = (int16_t*)encoded.data();
+                for(int32_t c = 0; c < length; c++)
+                {
+                    stream.offset[c] = (minValue[c] + maxValue[c]) * 0.5f;
+                    stream.scale[c] = (maxValue[c] - minValue[c]) * 0.5f;
+                }
+                for(size_t i = 0; i < valueCount; i++)
+                {
+                    int32_t c = int32_t(i % length);
+                    pDst[i] = (stream.scale[c] > 0) ? encodeSnorm16((pSrc[i] - stream.offset[c]) / stream.scale[c]) : 0;
+                }
+                stream.format = AttribFormat_S16N;
+            }
+            break;
+        case AttribType_Normal:
+        case AttribType_Tangent:
+        case AttribType_Bitangent:
+            // Octahedral encoding only works for unit vectors. Anything else (e.g. unnormalized tangents) is kept as-is
+            if(length == 3)
+            {
+                bool isUnit = true;
+                for(uint32_t v = 0; v < vertexCount && isUnit; v++)
+                {
+                    float len = glm::length(glm::vec3(pSrc[v * 3], pSrc[v * 3 + 1], pSrc[v * 3 + 2]));
+                    isUnit = std::abs(len - 1) < 1e-3f;
+                }
+
+                if(isUnit)
+                {
+                    encoded.resize(size_t(vertexCount) * 2 * sizeof(int16_t));
+                    int16_t* pDst = (int16_t*)encoded.data();
+                    for(uint32_t v = 0; v < vertexCount; v++)
+                    {
+                        encodeOctahedral(glm::vec3(pSrc[v * 3], pSrc[v * 3 + 1], pSrc[v * 3 + 2]), pDst + v * 2);
+                    }
+                    stream.format = AttribFormat_Oct16;
+                }
+            }
+            break;
+        case AttribType_TexCoord:
+            {
+                // Shaders only read 2 texture coordinate channels. Drop the third channel if it isn't used
+                int32_t dstLength = length;
+                if(length == 3 && minValue[2] == 0 && maxValue[2] == 0)
+                {
+                    dstLength = 2;
+                    stream.scale[2] = 0;
+                }
+
+                // Coordinates in [0, 1] can be uploaded as UNORM16. Repeating coordinates are stored relative to their range, as long as the precision is reasonable
+                bool canQuantize = (vertexCount > 0);
+                for(int32_t c = 0; c < dstLength; c++)
+                {
+                    if(minValue[c] < 0 || maxValue[c] > 1)
+                    {
+                        stream.offset[c] = minValue[c];
+                        stream.scale[c] = maxValue[c] - minValue[c];
+                        canQuantize = canQuantize && (stream.scale[c] <= 8);
+                    }
+                }
+
+                if(canQuantize)
+                {
+                    encoded.resize(size_t(vertexCount) * dstLength * sizeof(uint16_t));
+                    uint16_t* pDst = (uint16_t*)encoded.data();
+                    for(uint32_t v = 0; v < vertexCount; v++)
+                    {
+                        for(int32_t c = 0; c < dstLength; c++)
+                        {
+                            float value = pSrc[v * length + c];
+                            pDst[v * dstLength + c] = (stream.scale[c] > 0) ? encodeUnorm16((value - stream.offset[c]) / stream.scale[c]) : 0;
+                        }
+                    }
+                    stream.format = AttribFormat_U16N;
+                    stream.length = dstLength;
+                }
+                else if(dstLength != length)
+                {
+                    encoded.resize(size_t(vertexCount) * dstLength * sizeof(float));
+                    float* pDst = (float*)encoded.data();
+                    for(uint32_t v = 0; v < vertexCount; v++)
+                    {
+                        pDst[v * 2 + 0] = pSrc[v * 3 + 0];
+                        pDst[v * 2 + 1] = pSrc[v * 3 + 1];
+                    }
+                    stream.length = dstLength;
+                }
+
+                if(stream.format != AttribFormat_U16N)
+                {
+                    stream.offset = glm::vec4(0);
+                    stream.scale = glm::vec4(0);
+                    for(int32_t c = 0; c < stream.length; c++)
+                    {
+                        stream.scale[c] = 1;
+                    }
+                }
+            }
+            break;
+        case AttribType_Color:
+            encoded.resize(valueCount * sizeof(uint16_t));
+            for(size_t i = 0; i < valueCount; i++)
+            {
+                ((uint16_t*)encoded.data())[i] = floatToHalf(pSrc[i]);
+            }
+            stream.format = AttribFormat_F16;
+            break;
+        default:
+            break;
+        }
+
+        if(encoded.size())
+        {
+            stream.data.swap(encoded);
+        }
+    }
+
+    bool BinaryModelExporter::writeCommonMeshData(MemoryWriteStream& chunk, const Mesh::SharedPtr& pMesh, uint32_t submeshCount, const std::vector<VertexStream>& streams)
+    {
+        chunk << (int32_t)streams.size() << (int32_t)pMesh->getVertexCount() << (int32_t)submeshCount;
+
+        for(const auto& stream : streams)
+        {
+            // The data offset is patched in writeVertexData()
+            chunk << (int32_t)stream.type << (int32_t)stream.format << (int32_t)stream.length << (int32_t)0 << stream.offset << stream.scale;
+        }
+
+        return true;
+    }
+
+    bool BinaryModelExporter::writeVertexData(MemoryWriteStream& chunk, const std::vector<VertexStream>& streams)
+    {
+        // Every attribute is stored in its own 16-byte aligned stream, so the loader can use the data without de-interleaving it
+        for(size_t i = 0; i < streams.size(); i++)
+        {
+            chunk.align(kBinSceneChunkAlignment);
+            chunk.writeAt(kBinSceneMeshHeaderSize + i * kBinSceneAttribSpecSize + 3 * sizeof(int32_t), (int32_t)chunk.getSize());
+            chunk.write(streams[i].data.data(), streams[i].data.size());
+        }
 
         return true;
     }
 
-    bool BinaryModelExporter::writeSubmesh(const Mesh::SharedPtr& pMesh)
+    bool BinaryModelExporter::writeSubmesh(MemoryWriteStream& chunk, const Mesh::SharedPtr& pMesh)
     {
         const auto pMaterial = pMesh->getMaterial();
 
@@ -325,12 +590,12 @@ namespace Falcor
         glm::vec3 specular = basicMaterial.specularColor;
         float glossiness = basicMaterial.shininess;
 
-        mStream << ambient << diffuse << specular << glossiness;
+        chunk << ambient << diffuse << specular << glossiness;
 
         float displacementCoeff = basicMaterial.bumpScale;
         float displacementBias = basicMaterial.bumpOffset;
 
-        mStream << displacementCoeff << displacementBias;
+        chunk << displacementCoeff << displacementBias;
         
         for(uint32_t i = 0; i < TextureType_Max; i++)
         {
@@ -341,52 +606,105 @@ namespace Falcor
                 index = mTextureHash[basicMaterial.pTextures[falcorType].get()];
             }
 
-            mStream << index;
+            chunk << index;
         }
 
         uint32_t indexCount = pMesh->getIndexCount();
         assert(indexCount % 3 == 0);
         uint32_t primCount = indexCount / 3;
 
-        mStream << (int32_t)primCount;
+        // The index offset and the LOD table offset are patched in writeIndexData()
+        chunk << (int32_t)primCount << (int32_t)0 << (int32_t)(pMesh->getLodCount() - 1) << (int32_t)0;
+
+        return true;
+    }
+
+    bool BinaryModelExporter::writeIndexData(MemoryWriteStream& chunk, const std::vector<Mesh::SharedPtr>& submeshes, uint32_t attribCount)
+    {
+        for(size_t i = 0; i < submeshes.size(); i++)
+        {
+            const auto& pMesh = submeshes[i];
+            chunk.align(kBinSceneChunkAlignment);
+            size_t submeshDescOffset = kBinSceneMeshHeaderSize + attribCount * kBinSceneAttribSpecSize + i * kBinSceneSubmeshSize;
+            chunk.writeAt(submeshDescOffset + kBinSceneSubmeshIndexOffset, (int32_t)chunk.getSize());
 
-        // Output the index buffer
-        // Most of the buffers we use were created without any access flags, so can't be mapped.
-        // We create a temporary staging buffer to overcome this.
-        auto pStaging = Buffer::create(pMesh->getVao()->getIndexBuffer()->getSize(), Buffer::BindFlags::None, Buffer::AccessFlags::MapRead, nullptr);
-        pMesh->getVao()->getIndexBuffer()->copy(pStaging.get());
+            // Output the index buffer
+            // Most of the buffers we use were created without any access flags, so can't be mapped.
+            // We create a temporary staging buffer to overcome this.
+            auto pStaging = Buffer::create(pMesh->getVao()->getIndexBuffer()->getSize(), Buffer::BindFlags::None, Buffer::AccessFlags::MapRead, nullptr);
+            pMesh->getVao()->getIndexBuffer()->copy(pStaging.get());
 
-        const void* pIndices = pStaging->map(Buffer::MapType::Read);
-        mStream.write(pIndices, indexCount * sizeof(uint32_t));
+            const uint32_t* pIndices = (const uint32_t*)pStaging->map(Buffer::MapType::Read);
+            chunk.write(pIndices, pMesh->getIndexCount() * sizeof(uint32_t));
 
-        pStaging->unmap();
+            // The LOD table, followed by the LODs' indices. The index offsets in the table are patched when the indices are written.
+            uint32_t lodCount = pMesh->getLodCount() - 1;
+            if(lodCount)
+            {
+                chunk.align(kBinSceneChunkAlignment);
+                size_t tableOffset = chunk.getSize();
+                chunk.writeAt(submeshDescOffset + kBinSceneSubmeshIndexOffset + 2 * sizeof(int32_t), (int32_t)tableOffset);
+                for(uint32_t lod = 1; lod <= lodCount; lod++)
+                {
+                    chunk << pMesh->getLod(lod).error << (int32_t)(pMesh->getLod(lod).indexCount / 3) << (int32_t)0;
+                }
+
+                for(uint32_t lod = 1; lod <= lodCount; lod++)
+                {
+                    const Mesh::Lod& meshLod = pMesh->getLod(lod);
+                    chunk.align(kBinSceneChunkAlignment);
+                    chunk.writeAt(tableOffset + (lod - 1) * kBinSceneSubmeshLodSize + 2 * sizeof(int32_t), (int32_t)chunk.getSize());
+                    chunk.write(pIndices + meshLod.firstIndex, meshLod.indexCount * sizeof(uint32_t));
+                }
+            }
+
+            pStaging->unmap();
+        }
 
         return true;
     }
 
     bool BinaryModelExporter::writeMeshes()
     {
-        uint32_t inst = 0;
         for(const auto& mesh : mMeshes)
         {
             const auto& submeshes = mesh.second;
+            MemoryWriteStream chunk;
 
-            for(const Mesh::SharedPtr& pMesh : submeshes)
+            // All submeshes share the same VB and same layout. We use the first submesh for that.
+            const auto& pFirst = submeshes[0];
+            std::vector<VertexStream> streams;
+            if(readVertexStreams(pFirst, streams) == false)
             {
-                if(pMesh == submeshes[0])
-                {
-                    // All submeshes share the same VB and same layout. We use the first submesh for that.
-                    if(writeCommonMeshData(pMesh, (uint32_t)submeshes.size()) == false)
-                    {
-                        return false;
-                    }
-                }
+                return false;
+            }
+
+            if(writeCommonMeshData(chunk, pFirst, (uint32_t)submeshes.size(), streams) == false)
+            {
+                return false;
+            }
 
-                if(writeSubmesh(pMesh) == false)
+            for(const Mesh::SharedPtr& pMesh : submeshes)
+            {
+                if(writeSubmesh(chunk, pMesh) == false)
                 {
                     return false;
                 }
-                inst += pMesh->getInstanceCount();
+            }
+
+            if(writeVertexData(chunk, streams) == false)
+            {
+                return false;
+            }
+
+            if(writeIndexData(chunk, submeshes, pFirst->getVao()->getVertexBuffersCount()) == false)
+            {
+                return false;
+            }
+
+            if(writeChunk(ChunkType_Mesh, chunk) == false)
+            {
+                return false;
             }
         }
 
@@ -395,6 +713,7 @@ namespace Falcor
 
     bool BinaryModelExporter::writeInstances()
     {
+        MemoryWriteStream chunk;
         int32_t meshIdx = 0;
         int32_t enabled = 1;
         for(const auto& mesh : mMeshes)
@@ -404,17 +723,36 @@ namespace Falcor
             for(uint32_t i = 0; i < pMesh->getInstanceCount(); i++)
             {
                 glm::mat4 transformation = pMesh->getInstanceMatrix(i);
-                mStream << meshIdx << enabled << transformation;
-                writeString(mStream, "");   // Name
-                writeString(mStream, "");   // Meta-data
+                chunk << meshIdx << enabled << transformation;
+                writeString(chunk, "");   // Name
+                writeString(chunk, "");   // Meta-data
             }
 
             meshIdx++;
         }
-        return true;
+        return writeChunk(ChunkType_Instances, chunk);
+    }
+
+    bool BinaryModelExporter::writeBounds()
+    {
+        // The bounds are stored separately from the mesh chunks, so that the loader can decide which meshes to load without reading them
+        MemoryWriteStream chunk;
+        for(const auto& mesh : mMeshes)
+        {
+            glm::vec3 min(FLT_MAX);
+            glm::vec3 max(-FLT_MAX);
+            for(const Mesh::SharedPtr& pMesh : mesh.second)
+            {
+                const BoundingBox& box = pMesh->getObjectSpaceBoundingBox();
+                min = glm::min(min, box.center - box.extent);
+                max = glm::max(max, box.center + box.extent);
+            }
+            chunk << min << max;
+        }
+        return writeChunk(ChunkType_Bounds, chunk);
     }
 
-    bool BinaryModelExporter::exportBinaryImage(const Texture* pTexture)
+    bool BinaryModelExporter::exportBinaryImage(MemoryWriteStream& stream, const Texture* pTexture)
     {
         if(pTexture->getArraySize() > 1)
         {
@@ -436,15 +774,15 @@ namespace Falcor
         uint32_t dataSize = pTexture->getMipLevelDataSize(0);
         int32_t formatID = getBinaryFormatID(pTexture->getFormat());
 
-        writeString(mStream, pTexture->getSourceFilename());
-        mStream.write("BinImage", 8);
+        writeString(stream, pTexture->getSourceFilename());
+        stream.write("BinImage", 8);
         // Version, width, height, bytes-per-pixel, channel count, FormatID, DataSize
-        mStream << (int32_t)2 << (int32_t)width << (int32_t)height << bpp << (int32_t)0 << formatID << (int32_t)dataSize;
+        stream << (int32_t)2 << (int32_t)width << (int32_t)height << bpp << (int32_t)0 << formatID << (int32_t)dataSize;
 
         // Write the data
         std::vector<uint8_t> data(dataSize);
         pTexture->readSubresourceData(data.data(), dataSize, 0, 0);
-        mStream.write(data.data(), dataSize);
+        stream.write(data.data(), dataSize);
         return true;
     }
 }
\ No newline at end of file
@@ -28,9 +28,11 @@
 #pragma once
 #include <string>
 #include "Utils/BinaryFileStream.h"
+#include "Utils/MemoryStream.h"
 #include <map>
 #include <vector>
 #include "Graphics/Model/Mesh.h"
+#include "BinaryModelSpec.h"
 
 namespace Falcor
 {
@@ -45,24 +47,45 @@ namespace Falcor
         /** Export a model into a binary file
             \param[in] filename Model's filename. Loader will look for it in the data directories.
             \param[in] pModel The model to export
+            \param[in] compress Compress the file's chunks using LZ4. Chunks which don't shrink are stored uncompressed.
+            \param[in] quantize Store the vertex attributes using compact encodings (16-bit positions, octahedral normals, half colors, UNORM16 texture coordinates).
             returns nullptr if loading failed, otherwise a new Model object
         */
-        static void exportToFile(const std::string& filename, const Model* pModel);
+        static void exportToFile(const std::string& filename, const Model* pModel, bool compress = false, bool quantize = false);
 
     private:
-        BinaryModelExporter(const std::string& filename, const Model* pModel);
+        BinaryModelExporter(const std::string& filename, const Model* pModel, bool compress, bool quantize);
         const Model* mpModel = nullptr;
         BinaryFileStream mStream;
         const std::string& mFilename;
+        bool mCompress = false;
+        bool mQuantize = false;
+
+        struct VertexStream
+        {
+            AttribType type = AttribType_Max;
+            AttribFormat format = AttribFormat_Max;
+            int32_t length = 0;
+            glm::vec4 offset;
+            glm::vec4 scale;
+            std::vector<uint8_t> data;
+        };
 
         bool writeHeader();
         bool writeTextures();
         bool writeMeshes();
-        bool writeCommonMeshData(const Mesh::SharedPtr& pMesh, uint32_t submeshCount);
-        bool writeSubmesh(const Mesh::SharedPtr& pMesh);
+        bool readVertexStreams(const Mesh::SharedPtr& pMesh, std::vector<VertexStream>& streams);
+        void quantizeVertexStream(VertexStream& stream, uint32_t vertexCount);
+        bool writeCommonMeshData(MemoryWriteStream& chunk, const Mesh::SharedPtr& pMesh, uint32_t submeshCount, const std::vector<VertexStream>& streams);
+        bool writeSubmesh(MemoryWriteStream& chunk, const Mesh::SharedPtr& pMesh);
+        bool writeVertexData(MemoryWriteStream& chunk, const std::vector<VertexStream>& streams);
+        bool writeIndexData(MemoryWriteStream& chunk, const std::vector<Mesh::SharedPtr>& submeshes, uint32_t attribCount);
         bool writeInstances();
+        bool writeBounds();
+        bool writeChunk(ChunkType type, const MemoryWriteStream& chunk);
+        bool writeTableOfContents();
         
-        bool exportBinaryImage(const Texture* pTexture);
+        bool exportBinaryImage(MemoryWriteStream& stream, const Texture* pTexture);
 
         void error(const std::string& Msg);
         void warning(const std::string& Msg);
@@ -71,5 +94,9 @@ namespace Falcor
         std::map<const Vao*, std::vector<Mesh::SharedPtr>> mMeshes;
         std::map<const Texture*, int32_t> mTextureHash;
         uint32_t mInstanceCount = 0;   // Not the same as Model::Instance count. Model keeps the total instance count, while the binary format has a concept of meshes and submeshes, and the instance count there is the mesh instance count.
+
+        std::vector<ChunkDesc> mChunks;
+        uint32_t mChunkCount = 0;
+        uint64_t mFileOffset = 0;
     };
 }
@@ -40,6 +40,18 @@
 #include "Core/Texture.h"
 #include "Graphics/Material/Material.h"
 #include "glm/geometric.hpp"
+#include "Utils/ThreadPool.h"
+#include "Utils/MemoryStream.h"
+#include "Utils/Compression.h"
+#include "Utils/Hash.h"
+#include "Graphics/Camera/Camera.h"
+#include "Graphics/Model/MeshOptimizer.h"
+#include "Graphics/Model/VertexQuantization.h"
+#include "Graphics/Model/TangentSpace.h"
+#include "Graphics/Model/MeshSimplifier.h"
+#include "Graphics/ResourceCache.h"
+#include <algorithm>
+#include <set>
 
 namespace Falcor
 {
@@ -48,123 +60,91 @@ namespace Falcor
         uint32_t width  = 0;
         uint32_t height = 0;
         ResourceFormat format = ResourceFormat::Unknown;
+        const uint8_t* pData = nullptr;    // Points either into 'data' or directly into a memory-mapped file
         std::vector<uint8_t> data;
         std::string name;
+        bool isRgb = false;                // 3-channel data which still needs to be converted to RGBX
     };
 
-    bool isSpecialFloat(float f)
+    struct SubmeshLodData
     {
-        uint32_t d = *(uint32_t*)&f;
-        // Check the exponent
-        d = (d >> 23) & 0xff;
-        return d == 0xff;
-    }
+        float error = 0;
+        uint32_t numIndices = 0;
+        const uint32_t* pIndices = nullptr;
+        std::vector<uint8_t> indexStorage;
+    };
 
-    template<typename posType>
-    void generateSubmeshTangentData(
-        const std::vector<uint32_t>& indices,
-        const posType* vertexPosData,
-        const glm::vec3* vertexNormalData,
-        const glm::vec2* texCrdData,
-        uint32_t texCrdCount,
-        glm::vec3* tangentData,
-        glm::vec3* bitangentData)
+    struct SubmeshData
     {
-        // calculate the tangent and bitangent for every face
-        size_t primCount = indices.size() / 3;
-        for(size_t primID = 0; primID < primCount; primID++)
-        {
-            struct Data
-            {
-                posType position;
-                glm::vec3 normal;
-                glm::vec2 uv;
-            };
-            Data V[3];
-
-            // Get the data
-            for(uint32_t i = 0; i < 3; i++)
-            {
-                uint32_t index = indices[primID * 3 + i];
-                V[i].position = vertexPosData[index];
-                V[i].normal = vertexNormalData[index];
-
-                if(texCrdData)
-                {
-                    V[i].uv = texCrdData[index * texCrdCount];
-                }
-                else
-                {
-                    V[i].uv = glm::vec2(0.f, 0.f);
-                }
-            }
-
-            // Position delta
-            posType posDelta[2];
-            posDelta[0] = V[1].position - V[0].position;
-            posDelta[1] = V[2].position - V[0].position;
-
-            // Texture offset
-            glm::vec2 s = V[1].uv - V[0].uv;
-            glm::vec2 t = V[2].uv - V[0].uv;
-            s.y = -s.y;
-            t.y = -t.y;
-
-            float dirCorrection = (t.x * s.y - t.y * s.x) < 0.0f ? -1.0f : 1.0f;
-            // when t1, t2, t3 in same position in UV space, just use default UV direction.
-            if((s == glm::vec2(0, 0)) && (t == glm::vec2(0, 0)))
-            {
-                s.x = 0.0;
-                s.y = 1.0;
-                t.x = 1.0;
-                t.y = 0.0;
-            }
-
-            // tangent points in the direction where to positive X axis of the texture coord's would point in model space
-            // bitangent's points along the positive Y axis of the texture coord's, respectively
-            glm::vec3 tangent;
-            glm::vec3 bitangent;
-            tangent.x = (posDelta[1].x * s.y - posDelta[0].x * t.y) * dirCorrection;
-            tangent.y = (posDelta[1].y * s.y - posDelta[0].y * t.y) * dirCorrection;
-            tangent.z = (posDelta[1].z * s.y - posDelta[0].z * t.y) * dirCorrection;
-
-            bitangent.x = (posDelta[1].x * s.x - posDelta[0].x * t.x) * dirCorrection;
-            bitangent.y = (posDelta[1].y * s.x - posDelta[0].y * t.x) * dirCorrection;
-            bitangent.z = (posDelta[1].z * s.x - posDelta[0].z * t.x) * dirCorrection;
+        BasicMaterial material;
+        std::vector<int32_t> textureIDs;
+        uint32_t numIndices = 0;
+        const uint32_t* pIndices = nullptr;
+        std::vector<uint8_t> indexStorage;
+        std::vector<SubmeshLodData> lods;   // LOD 1 and up (v12+, or generated when loading)
+        BoundingBox boundingBox;
+        VertexCacheStats cacheStatsBefore;  // Only calculated when optimizing the mesh
+        VertexCacheStats cacheStatsAfter;
+    };
 
-            // store for every vertex of that face
-            for(uint32_t i = 0; i < 3; i++)
-            {
-                // project tangent and bitangent into the plane formed by the vertex' normal
-                glm::vec3 localTangent = tangent - V[i].normal * (glm::dot(tangent, V[i].normal));
-                localTangent = glm::normalize(localTangent);
-                glm::vec3 localBitangent = bitangent - V[i].normal * (glm::dot(bitangent, V[i].normal));
-                localBitangent = glm::normalize(localBitangent);
+    struct AttribEncoding
+    {
+        AttribFormat format = AttribFormat_F32;
+        int32_t length = 0;
+        uint32_t storedStride = 0;
+        glm::vec4 offset;
+        glm::vec4 scale;
+        bool decode = false;        // The data is converted to floats when loading. Otherwise it's uploaded as-is
+    };
 
-                // reconstruct tangent/bitangent according to normal and bitangent/tangent when it's infinite or NaN.
-                bool isInvalidTangent = isSpecialFloat(localTangent.x) || isSpecialFloat(localTangent.y) || isSpecialFloat(localTangent.z);
-                bool isInvalidBitangent = isSpecialFloat(localBitangent.x) || isSpecialFloat(localBitangent.y) || isSpecialFloat(localBitangent.z);
+    struct MeshData
+    {
+        static const uint32_t kInvalidBufferIndex = (uint32_t)-1;
+
+        Vao::VertexBufferDescVector vbDescs;
+        std::vector<std::vector<uint8_t>> buffers;
+        int32_t numAttribs = 0;
+        int32_t numVertices = 0;
+        uint32_t vertexSize = 0;
+        const uint8_t* pVertexData = nullptr;         // Interleaved vertices (v1-v8)
+        std::vector<uint8_t> vertexStorage;
+        std::vector<const uint8_t*> attribData;       // A separate stream per attribute (v9+)
+        std::vector<AttribEncoding> attribEncodings;
+        uint32_t positionBufferIndex = kInvalidBufferIndex;
+        uint32_t normalBufferIndex = kInvalidBufferIndex;
+        uint32_t tangentBufferIndex = kInvalidBufferIndex;
+        uint32_t bitangentBufferIndex = kInvalidBufferIndex;
+        uint32_t texCoordBufferIndex = kInvalidBufferIndex;
+        bool genTangents = false;
+        Mesh::VertexEncoding vertexEncoding;    // Set when the vertices are compressed for the GPU
+        std::vector<SubmeshData> submeshes;
+    };
 
-                if(isInvalidTangent != isInvalidBitangent)
-                {
-                    if(isInvalidTangent)
-                    {
-                        localTangent = glm::cross(V[i].normal, localBitangent);
-                        localTangent = glm::normalize(localTangent);
-                    }
-                    else
-                    {
-                        localBitangent = glm::cross(localTangent, V[i].normal);
-                        localBitangent = glm::normalize(localBitangent);
-                    }
-                }
+    struct InstanceData
+    {
+        int32_t meshIdx = 0;
+        int32_t enabled = 1;
+        glm::mat4 transformation;
+    };
 
-                // and write it into the mesh
-                uint32_t index = indices[primID * 3 + i];
-                tangentData[index] = localTangent;
-                bitangentData[index] = localBitangent;
-            }
+    /** Get a pointer to the next block of data in the stream. The file-stream version reads the block into 'storage', the memory-mapped version returns a pointer into the mapping.
+        \return false if the stream doesn't contain enough data, otherwise true
+    */
+    static bool readBlock(BinaryFileStream& stream, size_t size, std::vector<uint8_t>& storage, const uint8_t*& pData)
+    {
+        storage.resize(size);
+        if(size)
+        {
+            stream.read(storage.data(), size);
         }
+        pData = storage.data();
+        return stream.isFail() == false;
+    }
+
+    static bool readBlock(MemoryReadStream& stream, size_t size, std::vector<uint8_t>& storage, const uint8_t*& pData)
+    {
+        pData = stream.consume(size);
+        return pData != nullptr;
     }
 
     static BasicMaterial::MapType getFalcorMapType(TextureType map)
@@ -253,6 +233,37 @@ namespace Falcor
                 return ResourceFormat::RGBA32Float;
             }
             break;
+        case AttribFormat_F16:
+            switch(components)
+            {
+            case 1:
+                return ResourceFormat::R16Float;
+            case 2:
+                return ResourceFormat::RG16Float;
+            case 4:
+                return ResourceFormat::RGBA16Float;
+            }
+            break;
+        case AttribFormat_S16N:
+            switch(components)
+            {
+            case 1:
+                return ResourceFormat::R16Snorm;
+            case 2:
+                return ResourceFormat::RG16Snorm;
+            }
+            break;
+        case AttribFormat_U16N:
+            switch(components)
+            {
+            case 1:
+                return ResourceFormat::R16Unorm;
+            case 2:
+                return ResourceFormat::RG16Unorm;
+            case 4:
+                return ResourceFormat::RGBA16Unorm;
+            }
+            break;
         }
         should_not_get_here();
         return ResourceFormat::Unknown;
@@ -289,6 +300,11 @@ namespace Falcor
         case AttribFormat_S32:
         case AttribFormat_F32:
             return 4;
+        case AttribFormat_F16:
+        case AttribFormat_S16N:
+        case AttribFormat_U16N:
+        case AttribFormat_Oct16:
+            return 2;
         default:
             should_not_get_here();
             return 0;
@@ -347,7 +363,8 @@ namespace Falcor
         }
     }
 
-    std::string readString(BinaryFileStream& stream)
+    template<typename StreamType>
+    std::string readString(StreamType& stream)
     {
         int32_t length;
         stream >> length;
@@ -357,7 +374,8 @@ namespace Falcor
         return std::string(charVec.data());
     }
 
-    bool loadBinaryTextureData(BinaryFileStream& stream, const std::string& modelName, TextureData& data)
+    template<typename StreamType>
+    bool loadBinaryTextureData(StreamType& stream, const std::string& modelName, TextureData& data)
     {
         // ImageHeader.
         char tag[9];
@@ -443,67 +461,449 @@ namespace Falcor
         {
             dataSize = bpp * texelCount;
         }
-        size_t storageSize = dataSize;
-        if(bpp == 3)
-            storageSize = 4 * texelCount;
+        const uint8_t* pSrc;
+        if(readBlock(stream, dataSize, data.data, pSrc) == false)
+        {
+            std::string msg = "Error when loading model " + modelName + ".\nBinary image data is truncated.";
+            Logger::log(Logger::Level::Error, msg);
+            return false;
+        }
 
-        data.data.resize(storageSize);
-        stream.read(data.data.data(), dataSize);
+        // 3-channel data is converted in decodeTextureData()
+        data.pData = pSrc;
+        data.isRgb = (bpp == 3);
+        return true;
+    }
 
+    static void decodeTextureData(TextureData& data)
+    {
         // Convert 3-channel 8-bits RGB formats to 4-channel RGBX by adding padding
-        if(bpp == 3)
+        if(data.isRgb)
         {
+            const int32_t texelCount = data.width * data.height;
+            const uint8_t* pSrc = data.pData;
+
+            // If the data was read into the local storage, the conversion is done in-place. Iterating backwards makes sure we don't overwrite texels we still need.
+            bool inPlace = (pSrc == data.data.data());
+            data.data.resize(4 * texelCount);
+            if(inPlace)
+            {
+                pSrc = data.data.data();
+            }
+
+            uint8_t* pDst = data.data.data();
             for(int32_t i=texelCount-1;i>=0;--i)
             {
-                data.data[i * 4 + 0] = data.data[i * 3 + 0];
-                data.data[i * 4 + 1] = data.data[i * 3 + 1];
-                data.data[i * 4 + 2] = data.data[i * 3 + 2];
-                data.data[i * 4 + 3] = 0xff;
+                pDst[i * 4 + 0] = pSrc[i * 3 + 0];
+                pDst[i * 4 + 1] = pSrc[i * 3 + 1];
+                pDst[i * 4 + 2] = pSrc[i * 3 + 2];
+                pDst[i * 4 + 3] = 0xff;
             }
+            data.pData = pDst;
+            data.isRgb = false;
         }
+    }
 
-        return true;
+    /** Reorder the triangles of every submesh for the post-transform cache and overdraw, and then reorder the vertices by their first use.
+        The vertices are shared by all submeshes, so the remap is created from the concatenated index lists.
+    */
+    static void optimizeMeshData(MeshData& mesh)
+    {
+        const uint8_t* pPositions = mesh.buffers[mesh.positionBufferIndex].data();
+        uint32_t positionStride = mesh.vbDescs[mesh.positionBufferIndex].stride;
+        uint32_t vertexCount = (uint32_t)mesh.numVertices;
+
+        std::vector<uint32_t> allIndices;
+        std::vector<uint32_t> cacheOptimized;
+        for(auto& submesh : mesh.submeshes)
+        {
+            submesh.cacheStatsBefore = analyzeVertexCache(submesh.pIndices, submesh.numIndices, vertexCount);
+
+            // The index data can point into the file, so the result is always written into the submesh's own storage
+            cacheOptimized.resize(submesh.numIndices);
+            optimizeVertexCache(cacheOptimized.data(), submesh.pIndices, submesh.numIndices, vertexCount);
+            submesh.indexStorage.resize(submesh.numIndices * sizeof(uint32_t));
+            optimizeOverdraw((uint32_t*)submesh.indexStorage.data(), cacheOptimized.data(), submesh.numIndices, pPositions, positionStride, vertexCount);
+            submesh.pIndices = (const uint32_t*)submesh.indexStorage.data();
+
+            allIndices.insert(allIndices.end(), submesh.pIndices, submesh.pIndices + submesh.numIndices);
+
+            // The LODs use a subset of the vertices. Their triangles are only reordered for the cache, they are too small to benefit from the overdraw optimization.
+            for(auto& lod : submesh.lods)
+            {
+                cacheOptimized.resize(lod.numIndices);
+                optimizeVertexCache(cacheOptimized.data(), lod.pIndices, lod.numIndices, vertexCount);
+                lod.indexStorage.resize(lod.numIndices * sizeof(uint32_t));
+                std::memcpy(lod.indexStorage.data(), cacheOptimized.data(), lod.indexStorage.size());
+                lod.pIndices = (const uint32_t*)lod.indexStorage.data();
+            }
+        }
+
+        std::vector<uint32_t> remap(vertexCount);
+        optimizeVertexFetchRemap(remap.data(), allIndices.data(), (uint32_t)allIndices.size(), vertexCount);
+
+        std::vector<uint8_t> remapped;
+        for(int32_t i = 0; i < mesh.numAttribs; i++)
+        {
+            remapped.resize(mesh.buffers[i].size());
+            remapVertexBuffer(remapped.data(), mesh.buffers[i].data(), vertexCount, mesh.vbDescs[i].stride, remap.data());
+            mesh.buffers[i].swap(remapped);
+        }
+
+        for(auto& submesh : mesh.submeshes)
+        {
+            remapIndexBuffer((uint32_t*)submesh.indexStorage.data(), submesh.numIndices, remap.data());
+            for(auto& lod : submesh.lods)
+            {
+                remapIndexBuffer((uint32_t*)lod.indexStorage.data(), lod.numIndices, remap.data());
+            }
+            submesh.cacheStatsAfter = analyzeVertexCache(submesh.pIndices, submesh.numIndices, vertexCount);
+        }
     }
 
-    bool importTextures(std::vector<TextureData>& textures, uint32_t textureCount, BinaryFileStream& stream, const std::string& modelName)
+    /** Check if the GPU can consume an attribute as it is stored in the file. Otherwise it's converted to floats when loading.
+    */
+    static bool canUploadDirectly(AttribFormat format, int32_t length, const glm::vec4& offset, const glm::vec4& scale)
     {
-        textures.assign(textureCount, TextureData());
+        // Normalized formats can only be used directly if they don't need a scale and bias
+        bool isIdentity = true;
+        for(int32_t i = 0; i < length; i++)
+        {
+            isIdentity = isIdentity && (offset[i] == 0) && (scale[i] == 1);
+        }
 
-        for(uint32_t i = 0; i < textureCount; i++)
+        switch(format)
         {
-            textures[i].name = readString(stream);
-            if(loadBinaryTextureData(stream, modelName, textures[i]) == false)
+        case AttribFormat_U8:
+        case AttribFormat_S32:
+        case AttribFormat_F32:
+            return true;
+        case AttribFormat_F16:
+            return length != 3;
+        case AttribFormat_S16N:
+            return isIdentity && length <= 2;
+        case AttribFormat_U16N:
+            return isIdentity && length != 3;
+        default:
+            return false;
+        }
+    }
+
+    static void decodeAttribute(const AttribEncoding& encoding, const uint8_t* pSrc, int32_t vertexCount, float* pDst)
+    {
+        const int32_t length = encoding.length;
+        switch(encoding.format)
+        {
+        case AttribFormat_F16:
+            for(int32_t i = 0; i < vertexCount * length; i++)
             {
-                return false;
+                pDst[i] = halfToFloat(((const uint16_t*)pSrc)[i]);
+            }
+            break;
+        case AttribFormat_S16N:
+            for(int32_t i = 0; i < vertexCount * length; i++)
+            {
+                int32_t c = i % length;
+                pDst[i] = encoding.offset[c] + encoding.scale[c] * decodeSnorm16(((const int16_t*)pSrc)[i]);
+            }
+            break;
+        case AttribFormat_U16N:
+            for(int32_t i = 0; i < vertexCount * length; i++)
+            {
+                int32_t c = i % length;
+                pDst[i] = encoding.offset[c] + encoding.scale[c] * decodeUnorm16(((const uint16_t*)pSrc)[i]);
+            }
+            break;
+        case AttribFormat_Oct16:
+            for(int32_t i = 0; i < vertexCount; i++)
+            {
+                glm::vec3 v = decodeOctahedral((const int16_t*)pSrc + i * 2);
+                pDst[i * 3 + 0] = v.x;
+                pDst[i * 3 + 1] = v.y;
+                pDst[i * 3 + 2] = v.z;
+            }
+            break;
+        default:
+            should_not_get_here();
+        }
+    }
+
+    static bool isFloatFormat(ResourceFormat format)
+    {
+        return format == ResourceFormat::RG32Float || format == ResourceFormat::RGB32Float || format == ResourceFormat::RGBA32Float;
+    }
+
+    /** Generate the tangent space for the entire mesh. The submeshes share the vertices, so their triangles are processed together.
+        \return false if the mesh's positions or normals can't be used to generate the tangent space, otherwise true
+    */
+    static bool generateMeshTangents(MeshData& mesh)
+    {
+        const ResourceFormat positionFormat = mesh.vbDescs[mesh.positionBufferIndex].pLayout->getElementFormat(0);
+        const ResourceFormat normalFormat = mesh.vbDescs[mesh.normalBufferIndex].pLayout->getElementFormat(0);
+        if(isFloatFormat(positionFormat) == false || isFloatFormat(normalFormat) == false)
+        {
+            return false;
+        }
+
+        TangentSpaceInput input;
+        input.pPositions = mesh.buffers[mesh.positionBufferIndex].data();
+        input.positionStride = mesh.vbDescs[mesh.positionBufferIndex].stride;
+        input.pNormals = mesh.buffers[mesh.normalBufferIndex].data();
+        input.normalStride = mesh.vbDescs[mesh.normalBufferIndex].stride;
+        input.vertexCount = mesh.numVertices;
+
+        // Texture coordinates which are uploaded in a quantized format are decoded into a temporary buffer
+        std::vector<float> decodedTexCrds;
+        if(mesh.texCoordBufferIndex != MeshData::kInvalidBufferIndex)
+        {
+            input.pTexCrds = mesh.buffers[mesh.texCoordBufferIndex].data();
+            input.texCrdStride = mesh.vbDescs[mesh.texCoordBufferIndex].stride;
+            if(isFloatFormat(mesh.vbDescs[mesh.texCoordBufferIndex].pLayout->getElementFormat(0)) == false)
+            {
+                const AttribEncoding& encoding = mesh.attribEncodings[mesh.texCoordBufferIndex];
+                decodedTexCrds.resize(size_t(mesh.numVertices) * encoding.length);
+                decodeAttribute(encoding, mesh.buffers[mesh.texCoordBufferIndex].data(), mesh.numVertices, decodedTexCrds.data());
+                input.pTexCrds = decodedTexCrds.data();
+                input.texCrdStride = encoding.length * sizeof(float);
             }
         }
 
+        std::vector<uint32_t> indices;
+        for(const auto& submesh : mesh.submeshes)
+        {
+            indices.insert(indices.end(), submesh.pIndices, submesh.pIndices + submesh.numIndices);
+        }
+        input.pIndices = indices.data();
+        input.indexCount = (uint32_t)indices.size();
+
+        generateTangentSpace(input, (glm::vec3*)mesh.buffers[mesh.tangentBufferIndex].data(), (glm::vec3*)mesh.buffers[mesh.bitangentBufferIndex].data());
         return true;
     }
 
-    BinaryModelImporter::BinaryModelImporter(const std::string& fullpath) : mModelName(fullpath), mStream(fullpath.c_str(), BinaryFileStream::Mode::Read)
+    /** Generate LODs for the submeshes, unless the file already contains them
+    */
+    static void generateMeshLods(MeshData& mesh)
+    {
+        const ResourceFormat positionFormat = mesh.vbDescs[mesh.positionBufferIndex].pLayout->getElementFormat(0);
+        if(positionFormat != ResourceFormat::RGB32Float && positionFormat != ResourceFormat::RGBA32Float)
+        {
+            return;
+        }
+
+        const uint8_t* pPositions = mesh.buffers[mesh.positionBufferIndex].data();
+        uint32_t positionStride = mesh.vbDescs[mesh.positionBufferIndex].stride;
+        for(auto& submesh : mesh.submeshes)
+        {
+            if(submesh.lods.size())
+            {
+                continue;
+            }
+
+            std::vector<MeshLodData> lodData = generateLodChain(submesh.pIndices, submesh.numIndices, pPositions, positionStride, mesh.numVertices);
+            for(const auto& data : lodData)
+            {
+                SubmeshLodData lod;
+                lod.error = data.error;
+                lod.numIndices = (uint32_t)data.indices.size();
+                lod.indexStorage.resize(lod.numIndices * sizeof(uint32_t));
+                std::memcpy(lod.indexStorage.data(), data.indices.data(), lod.indexStorage.size());
+                lod.pIndices = (const uint32_t*)lod.indexStorage.data();
+                submesh.lods.push_back(std::move(lod));
+            }
+        }
+    }
+
+    /** Replace the format of a vertex buffer which contains a single attribute
+    */
+    static void setVertexBufferFormat(MeshData& mesh, uint32_t bufferIndex, ResourceFormat format)
     {
+        auto& pLayout = mesh.vbDescs[bufferIndex].pLayout;
+        const std::string name = pLayout->getElementName(0);
+        const uint32_t shaderLocation = pLayout->getElementShaderLocation(0);
+        pLayout = VertexLayout::create();
+        pLayout->addElement(name, 0, format, 1, shaderLocation);
+        mesh.vbDescs[bufferIndex].stride = getFormatBytesPerBlock(format);
     }
 
-    Model::SharedPtr BinaryModelImporter::createFromFile(const std::string& filename, uint32_t flags)
+    /** Compress the decoded vertices into the formats which the vertex shaders decode, see Model::CompressVertices.
+        This runs after all the other processing, which needs float data. Attributes which can't be compressed are kept as floats.
+    */
+    static void compressMeshVertices(MeshData& mesh)
     {
-        std::string fullpath;
-        if(findFileInDataDirectories(filename, fullpath) == false)
+        const uint32_t vertexCount = (uint32_t)mesh.numVertices;
+        for(uint32_t i = 0; (i < (uint32_t)mesh.vbDescs.size()) && (vertexCount > 0); i++)
         {
-            Logger::log(Logger::Level::Error, std::string("Can't find model file ") + filename);
-            return nullptr;
+            const ResourceFormat format = mesh.vbDescs[i].pLayout->getElementFormat(0);
+            const uint32_t shaderLocation = mesh.vbDescs[i].pLayout->getElementShaderLocation(0);
+            const uint32_t stride = mesh.vbDescs[i].stride;
+            const uint8_t* pSrc = mesh.buffers[i].data();
+            std::vector<uint8_t> encoded;
+
+            if(shaderLocation == VERTEX_POSITION_LOC && (format == ResourceFormat::RGB32Float || format == ResourceFormat::RGBA32Float))
+            {
+                // 16 bits per channel, relative to the bounding-box of the vertices. W is always 1, so 4-channel positions must have w == 1.
+                glm::vec3 minPos = *(const glm::vec3*)pSrc;
+                glm::vec3 maxPos = minPos;
+                bool canCompress = true;
+                for(uint32_t v = 0; v < vertexCount; v++)
+                {
+                    const float* pPos = (const float*)(pSrc + size_t(stride) * v);
+                    minPos = glm::min(minPos, glm::vec3(pPos[0], pPos[1], pPos[2]));
+                    maxPos = glm::max(maxPos, glm::vec3(pPos[0], pPos[1], pPos[2]));
+                    canCompress = canCompress && ((format == ResourceFormat::RGB32Float) || (pPos[3] == 1.0f));
+                }
+
+                if(canCompress)
+                {
+                    const glm::vec3 scale = maxPos - minPos;
+                    encoded.resize(size_t(vertexCount) * 4 * sizeof(uint16_t));
+                    uint16_t* pDst = (uint16_t*)encoded.data();
+                    for(uint32_t v = 0; v < vertexCount; v++)
+                    {
+                        const float* pPos = (const float*)(pSrc + size_t(stride) * v);
+                        for(uint32_t c = 0; c < 3; c++)
+                        {
+                            pDst[v * 4 + c] = (scale[c] > 0) ? encodeUnorm16((pPos[c] - minPos[c]) / scale[c]) : 0;
+                        }
+                        pDst[v * 4 + 3] = 0xffff;
+                    }
+
+                    mesh.vertexEncoding.compressedPositions = true;
+                    mesh.vertexEncoding.positionOffset = minPos;
+                    mesh.vertexEncoding.positionScale = scale;
+                    setVertexBufferFormat(mesh, i, ResourceFormat::RGBA16Unorm);
+                }
+            }
+            else if((shaderLocation == VERTEX_NORMAL_LOC || shaderLocation == VERTEX_TANGENT_LOC || shaderLocation == VERTEX_BITANGENT_LOC) && format == ResourceFormat::RGB32Float)
+            {
+                // Octahedral encoding only works for unit vectors. Anything else (e.g. unnormalized tangents) is kept as-is
+                const glm::vec3* pVectors = (const glm::vec3*)pSrc;
+                bool isUnit = true;
+                for(uint32_t v = 0; v < vertexCount && isUnit; v++)
+                {
+                    isUnit = std::abs(glm::length(pVectors[v]) - 1) < 1e-3f;
+                }
+
+                if(isUnit)
+                {
+                    encoded.resize(size_t(vertexCount) * 2 * sizeof(int16_t));
+                    int16_t* pDst = (int16_t*)encoded.data();
+                    for(uint32_t v = 0; v < vertexCount; v++)
+                    {
+                        encodeOctahedral(pVectors[v], pDst + v * 2);
+                    }
+
+                    mesh.vertexEncoding.octahedralAttribs |= (1 << shaderLocation);
+                    setVertexBufferFormat(mesh, i, ResourceFormat::RG16Snorm);
+                }
+            }
+
+            if(encoded.size())
+            {
+                mesh.buffers[i].swap(encoded);
+            }
+        }
+    }
+
+    /** Decode a mesh. This runs on the thread pool, so warnings are returned to the caller instead of being logged.
+        \param[in] modelFlags The Model::LoadFlags which affect the mesh data
+        \param[out] warning Receives a warning message, or an empty string
+    */
+    static void decodeMeshData(MeshData& mesh, uint32_t modelFlags, std::string& warning)
+    {
+        if(mesh.attribData.size())
+        {
+            for(int32_t attributes = 0; attributes < mesh.numAttribs; ++attributes)
+            {
+                const AttribEncoding& encoding = mesh.attribEncodings[attributes];
+                if(encoding.decode)
+                {
+                    decodeAttribute(encoding, mesh.attribData[attributes], mesh.numVertices, (float*)mesh.buffers[attributes].data());
+                }
+                else
+                {
+                    std::memcpy(mesh.buffers[attributes].data(), mesh.attribData[attributes], mesh.buffers[attributes].size());
+                }
+            }
+        }
+
+        // The vertices are stored interleaved. Split them into a buffer per attribute.
+        for(int32_t i = 0; mesh.pVertexData && (i < mesh.numVertices); i++)
+        {
+            const uint8_t* pSrc = mesh.pVertexData + size_t(mesh.vertexSize) * i;
+            for(int32_t attributes = 0; attributes < mesh.numAttribs; ++attributes)
+            {
+                uint32_t stride = mesh.vbDescs[attributes].stride;
+                uint8_t* pDest = mesh.buffers[attributes].data() + stride * i;
+                std::memcpy(pDest, pSrc, stride);
+                pSrc += stride;
+            }
+        }
+        mesh.vertexStorage.clear();
+        mesh.vertexStorage.shrink_to_fit();
+
+        if((modelFlags & Model::GenerateLods) && mesh.positionBufferIndex != MeshData::kInvalidBufferIndex)
+        {
+            generateMeshLods(mesh);
+        }
+
+        if((modelFlags & Model::OptimizeVertexCache) && mesh.positionBufferIndex != MeshData::kInvalidBufferIndex)
+        {
+            optimizeMeshData(mesh);
+        }
+
+        if(mesh.genTangents && (generateMeshTangents(mesh) == false))
+        {
+            warning = "Can't generate tangent space for a mesh with quantized positions or normals.";
+        }
+
+        for(auto& submesh : mesh.submeshes)
+        {
+            // Calculate the bounding-box
+            glm::vec3 max, min;
+            for(uint32_t i = 0; i < submesh.numIndices; i++)
+            {
+                uint32_t vertexID = submesh.pIndices[i];
+                uint8_t* pVertex = (mesh.vbDescs[mesh.positionBufferIndex].stride * vertexID) + mesh.buffers[mesh.positionBufferIndex].data();
+
+                float* pPosition = (float*)pVertex;
+
+                glm::vec3 xyz(pPosition[0], pPosition[1], pPosition[2]);
+                min = glm::min(min, xyz);
+                max = glm::max(max, xyz);
+            }
+
+            submesh.boundingBox = BoundingBox::fromMinMax(min, max);
+        }
+
+        if(modelFlags & Model::CompressVertices)
+        {
+            compressMeshVertices(mesh);
+        }
+    }
+
+    template<typename StreamType>
+    bool importTextures(std::vector<TextureData>& textures, uint32_t textureCount, StreamType& stream, const std::string& modelName)
+    {
+        textures.assign(textureCount, TextureData());
+
+        for(uint32_t i = 0; i < textureCount; i++)
+        {
+            textures[i].name = readString(stream);
+            if(loadBinaryTextureData(stream, modelName, textures[i]) == false)
+            {
+                return false;
+            }
         }
 
-        BinaryModelImporter loader(fullpath);
-        Model::SharedPtr pModel = loader.createModel(flags);
-        return pModel;
+        return true;
     }
 
     static bool checkVersion(const std::string& formatID, uint32_t version, const std::string& modelName)
     {
         if(std::string(formatID) == "BinScene")
         {
-            if(version < 6 || version > 8)
+            if(version < 6 || version > 12)
             {
                 std::string Msg = "Error when loading model " + modelName + ".\nUnsupported binary scene version " + std::to_string(version);
                 Logger::log(Logger::Level::Error, Msg);
@@ -576,301 +976,898 @@ namespace Falcor
         }
     }
     
-    Model::SharedPtr BinaryModelImporter::createModel(uint32_t flags)
+    struct ModelHeader
     {
-        // Format ID and version.
-        char formatID[9];
-        mStream.read(formatID, 8);
-        formatID[8] = '\0';
+        uint32_t version = 0;
+        int numTextureSlots = 0;
+        int numAttributesType = 0;
+        int numAttribFormats = AttribFormat_F32 + 1;
+        int32_t numTextures = 0;
+        int32_t numMeshes = 0;
+        int32_t numInstances = 0;
+        int32_t numAttribs_v5 = 0;
+        int32_t numVertices_v5 = 0;
+        int32_t numSubmeshes_v5 = 0;
+        bool generateTangents = false;
+    };
 
-        uint32_t version;
-        mStream >> version;
+    struct ModelData
+    {
+        std::vector<TextureData> texData;
+        std::vector<MeshData> meshes;
+        std::vector<InstanceData> instances;
+        std::vector<std::vector<uint8_t>> chunkStorage;    // v9 chunks which had to be read or decompressed into memory
+    };
 
-        // Check if the version matches
-        if(checkVersion(formatID, version, mModelName) == false)
+    static bool addMeshAttribute(MeshData& mesh, int32_t attribIdx, int32_t type, int32_t format, int32_t length, const glm::vec4& offset, const glm::vec4& scale, const ModelHeader& header, const std::string& modelName)
+    {
+        auto& pLayout = mesh.vbDescs[attribIdx].pLayout;
+        pLayout = VertexLayout::create();
+        if(type < 0 || type >= header.numAttributesType || format < 0 || format >= header.numAttribFormats || length < 1 || length > 4 || (format == AttribFormat_Oct16 && length != 3))
         {
-            return nullptr;
+            std::string msg = "Error when loading model " + modelName + ".\nCorrupted data.!";
+            Logger::log(Logger::Level::Error, msg);
+            return false;
         }
 
-        int numTextureSlots;
-        int numAttributesType = AttribType_AORadius + 1;
-
-        switch(version)
+        // Quantized attributes which the GPU can't consume directly are converted to floats
+        AttribEncoding& encoding = mesh.attribEncodings[attribIdx];
+        encoding.format = AttribFormat(format);
+        encoding.length = length;
+        encoding.storedStride = getFormatByteSize(AttribFormat(format)) * ((format == AttribFormat_Oct16) ? 2 : length);
+        encoding.offset = offset;
+        encoding.scale = scale;
+        encoding.decode = (canUploadDirectly(AttribFormat(format), length, offset, scale) == false);
+
+        // Positions and the tangent frame are also read on the CPU (bounds, tangent generation, vertex compression), so quantized ones are always decoded to floats
+        uint32_t shaderLocation = getShaderLocation(AttribType(type));
+        bool isCpuAttrib = (shaderLocation == VERTEX_POSITION_LOC) || (shaderLocation == VERTEX_NORMAL_LOC) || (shaderLocation == VERTEX_TANGENT_LOC) || (shaderLocation == VERTEX_BITANGENT_LOC);
+        if(isCpuAttrib && (format != AttribFormat_F32) && (format != AttribFormat_U8) && (format != AttribFormat_S32))
         {
-        case 1:     numTextureSlots = 0; break;
-        case 2:     numTextureSlots = TextureType_Alpha + 1; break;
-        case 3:     numTextureSlots = TextureType_Displacement + 1; break;
-        case 4:     numTextureSlots = TextureType_Environment + 1; break;
-        case 5:     numTextureSlots = TextureType_Specular + 1; break;
-        case 6:     numTextureSlots = TextureType_Specular + 1; break;
-        case 7:     numTextureSlots = TextureType_Glossiness + 1; break;
-        case 8:     numTextureSlots = TextureType_Glossiness + 1; numAttributesType = AttribType_Max; break;
-        default:
-            should_not_get_here();
-            return nullptr;
+            encoding.decode = true;
         }
+        AttribFormat uploadFormat = encoding.decode ? AttribFormat_F32 : AttribFormat(format);
 
+        const std::string falcorName = getSemanticName(AttribType(type));
+        ResourceFormat falcorFormat = getFalcorFormat(uploadFormat, length);
 
-        // File header
-        int32_t numTextures = 0;
-        int32_t numMeshes = 0;
-        int32_t numInstances = 0;
-        int32_t numAttribs_v5 = 0;
-        int32_t numVertices_v5 = 0;
-        int32_t numSubmeshes_v5 = 0;
+        mesh.vbDescs[attribIdx].stride = getFormatByteSize(uploadFormat) * length;
 
-        if(version >= 6)
+        bool isFormatSupported = true;
+        switch(shaderLocation)
         {
-            mStream >> numTextures >> numMeshes >> numInstances;
+        case VERTEX_POSITION_LOC:
+            mesh.positionBufferIndex = attribIdx;
+            isFormatSupported = (falcorFormat == ResourceFormat::RGB32Float || falcorFormat == ResourceFormat::RGBA32Float);
+            break;
+        case VERTEX_NORMAL_LOC:
+            mesh.normalBufferIndex = attribIdx;
+            isFormatSupported = (falcorFormat == ResourceFormat::RGB32Float);
+            break;
+        case VERTEX_TANGENT_LOC:
+            mesh.tangentBufferIndex = attribIdx;
+            isFormatSupported = (falcorFormat == ResourceFormat::RGB32Float);
+            break;
+        case VERTEX_BITANGENT_LOC:
+            mesh.bitangentBufferIndex = attribIdx;
+            isFormatSupported = (falcorFormat == ResourceFormat::RGB32Float);
+            break;
+        case VERTEX_TEXCOORD_LOC:
+            mesh.texCoordBufferIndex = attribIdx;
+            break;
         }
-        else
+
+        if(isFormatSupported == false)
         {
-            numMeshes = 1;
-            numInstances = 1;
-            mStream >> numAttribs_v5 >> numVertices_v5 >> numSubmeshes_v5;
-            if(version >= 2)
+            std::string msg = "Error when loading model " + modelName + ".\nUnsupported format for the " + falcorName + " attribute (format " + std::to_string(format) + ", length " + std::to_string(length) + ").";
+            Logger::log(Logger::Level::Error, msg);
+            return false;
+        }
+
+        pLayout->addElement(falcorName, 0, falcorFormat, 1, shaderLocation);
+        mesh.buffers[attribIdx].resize(mesh.vbDescs[attribIdx].stride * mesh.numVertices);
+        mesh.vertexSize += mesh.vbDescs[attribIdx].stride;
+        return true;
+    }
+
+    static void initTangentGeneration(MeshData& mesh, int meshIdx, const ModelHeader& header, const std::string& modelName)
+    {
+        // Check if we need to generate tangents
+        if(header.generateTangents && (mesh.tangentBufferIndex == MeshData::kInvalidBufferIndex) && (mesh.bitangentBufferIndex == MeshData::kInvalidBufferIndex))
+        {
+            if(mesh.normalBufferIndex == MeshData::kInvalidBufferIndex)
             {
-                mStream >> numTextures;
+                Logger::log(Logger::Level::Warning, "Can't generate tangent space for mesh " + std::to_string(meshIdx) + " when loading model " + modelName + ".\nMesh doesn't contain normals or texture coordinates\n");
+                mesh.genTangents = false;
+            }
+            else
+            {
+                if(mesh.texCoordBufferIndex == MeshData::kInvalidBufferIndex)
+                {
+                    Logger::log(Logger::Level::Warning, "No uv mapping is provided to generate tangent space for mesh " + std::to_string(meshIdx) + " when loading model " + modelName + ".\nMesh doesn't contain normals or texture coordinates\n");
+                }
+                auto& vbDescs = mesh.vbDescs;
+                auto& buffers = mesh.buffers;
+
+                // Set the offsets
+                mesh.genTangents = true;
+                mesh.tangentBufferIndex = (uint32_t)vbDescs.size();
+                mesh.bitangentBufferIndex = (uint32_t)vbDescs.size() + 1;
+                vbDescs.resize(mesh.bitangentBufferIndex + 1);
+                buffers.resize(mesh.bitangentBufferIndex + 1);
+
+                Vao::VertexBufferDesc& vbTangentDesc = vbDescs[mesh.tangentBufferIndex];
+                auto& pTangentLayout = vbTangentDesc.pLayout;
+                pTangentLayout = VertexLayout::create();
+                vbDescs[mesh.tangentBufferIndex].stride = sizeof(glm::vec3);
+                pTangentLayout->addElement(VERTEX_TANGENT_NAME, 0, ResourceFormat::RGB32Float, 1, VERTEX_TANGENT_LOC);
+                buffers[mesh.tangentBufferIndex].resize(sizeof(glm::vec3) * mesh.numVertices);
+
+                Vao::VertexBufferDesc& vbBitangentDesc = vbDescs[mesh.bitangentBufferIndex];
+                auto& pBitangentLayout = vbBitangentDesc.pLayout;
+                pBitangentLayout = VertexLayout::create();
+                vbDescs[mesh.bitangentBufferIndex].stride = sizeof(glm::vec3);
+                pBitangentLayout->addElement(VERTEX_BITANGENT_NAME, 0, ResourceFormat::RGB32Float, 1, VERTEX_BITANGENT_LOC);
+                buffers[mesh.bitangentBufferIndex].resize(sizeof(glm::vec3) * mesh.numVertices);
             }
         }
+    }
+
+    /** Read the submesh material and the triangle count. The indices themselves are read by the caller, since their location depends on the file version.
+    */
+    template<typename StreamType>
+    static bool parseSubmesh(StreamType& stream, const ModelHeader& header, SubmeshData& submesh, const std::string& modelName)
+    {
+        BasicMaterial& basicMaterial = submesh.material;
 
-        if(numTextures < 0 || numMeshes < 0 || numInstances < 0)
+        glm::vec3 ambient;
+        glm::vec4 diffuse;
+        glm::vec3 specular;
+        float glossiness;
+
+        stream >> ambient >> diffuse >> specular >> glossiness;
+        basicMaterial.diffuseColor = glm::vec3(diffuse);
+        basicMaterial.opacity = 1 - diffuse.w;
+        basicMaterial.specularColor = specular;
+        basicMaterial.shininess = glossiness;
+
+        if(header.version >= 3)
         {
-            std::string msg = "Error when loading model " + mModelName + ".\nFile is corrupted.";
-            Logger::log(Logger::Level::Error, msg);
-            return nullptr;
+            float displacementCoeff;
+            float displacementBias;
+            stream >> displacementCoeff >> displacementBias;
+            basicMaterial.bumpScale = displacementCoeff;
+            basicMaterial.bumpOffset = displacementBias;
         }
 
-        // create objects
-        auto pModel = Model::SharedPtr(new Model());
-        bool shouldGenerateTangents = (flags & Model::GenerateTangentSpace) != 0;
-
-        std::vector<TextureData> texData;
+        submesh.textureIDs.resize(header.numTextureSlots);
+        for(int i = 0; i < header.numTextureSlots; i++)
+        {
+            int32_t texID;
+            stream >> texID;
+            if(texID < -1 || texID >= header.numTextures)
+            {
+                std::string msg = "Error when loading model " + modelName + ".\nCorrupt binary mesh data!";
+                Logger::log(Logger::Level::Error, msg);
+                return false;
+            }
+            submesh.textureIDs[i] = texID;
+        }
 
-        if(version >= 6)
+        int32_t numTriangles;
+        stream >> numTriangles;
+        if(numTriangles < 0)
         {
-            importTextures(texData, numTextures, mStream, mModelName);
+            std::string Msg = "Error when loading model " + modelName + ".\nMesh has negative number of triangles!";
+            Logger::log(Logger::Level::Error, Msg);
+            return false;
         }
+        submesh.numIndices = numTriangles * 3;
+        return true;
+    }
 
-        // This file format has a concept of sub-meshes, which Falcor model doesn't have - Falcor creates a new mesh for each sub-mesh
-        // When creating instances of meshes, it means we need to translate the original mesh index to all it's submeshes Falcor IDs. This is what the next 2 variables are for.
-        std::vector<std::vector<uint32_t>> meshToSubmeshesID(numMeshes);
+    template<typename StreamType>
+    static bool parseInstances(StreamType& stream, const ModelHeader& header, std::vector<InstanceData>& instances, const std::string& modelName)
+    {
+        instances.resize(header.numInstances);
+        for(auto& instance : instances)
+        {
+            stream >> instance.meshIdx >> instance.enabled >> instance.transformation;
+            //m_Stream >> inst.name >> inst.metadata;
+            readString(stream);   // Name
+            readString(stream);   // Meta-data
 
-        struct TexSignature
+            if(instance.meshIdx < 0 || instance.meshIdx >= header.numMeshes || stream.isFail())
+            {
+                std::string msg = "Error when loading model " + modelName + ".\nFile is corrupted.";
+                Logger::log(Logger::Level::Error, msg);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /** Parse a v1-v8 file. These files are sequential - textures, meshes and instances follow each other, and the vertices are interleaved.
+    */
+    template<typename StreamType>
+    static bool parseSequentialFile(StreamType& stream, const ModelHeader& header, ModelData& data, const std::string& modelName)
+    {
+        if(header.version >= 6)
         {
-            const uint8_t* pData;
-            ResourceFormat format;
-            bool operator<(const TexSignature& other) const 
-            { 
-                if(pData < other.pData) return true;
-                if(pData == other.pData) return format < other.format;
+            if(importTextures(data.texData, header.numTextures, stream, modelName) == false)
+            {
                 return false;
             }
-            bool operator==(const TexSignature& other) const { return pData == other.pData || format == other.format; }
-        };
-        std::map<TexSignature, Texture::SharedPtr> textures;
-        bool loadTexAsSrgb = (flags & Model::AssumeLinearSpaceTextures) ? false : true;
+        }
 
-        // Load the meshes
-        for(int meshIdx = 0; meshIdx < numMeshes; meshIdx++)
+        for(int meshIdx = 0; meshIdx < header.numMeshes; meshIdx++)
         {
+            MeshData& mesh = data.meshes[meshIdx];
+
             // Mesh header
-            int32_t numAttribs = 0;
-            int32_t numVertices = 0;
             int32_t numSubmeshes = 0;
 
-            if(version >= 6)
+            if(header.version >= 6)
             {
-                mStream >> numAttribs >> numVertices >> numSubmeshes;
+                stream >> mesh.numAttribs >> mesh.numVertices >> numSubmeshes;
             }
             else
             {
-                numAttribs = numAttribs_v5;
-                numVertices = numVertices_v5;
-                numSubmeshes = numSubmeshes_v5;
+                mesh.numAttribs = header.numAttribs_v5;
+                mesh.numVertices = header.numVertices_v5;
+                numSubmeshes = header.numSubmeshes_v5;
             }
 
-            if(numAttribs < 0 || numVertices < 0 || numSubmeshes < 0)
+            if(mesh.numAttribs < 0 || mesh.numVertices < 0 || numSubmeshes < 0)
             {
-                std::string Msg = "Error when loading model " + mModelName + ".\nCorrupted data.!";
+                std::string Msg = "Error when loading model " + modelName + ".\nCorrupted data.!";
                 Logger::log(Logger::Level::Error, Msg);
-                return nullptr;
+                return false;
             }
 
-			Vao::VertexBufferDescVector vbDescs;
-			std::vector<std::vector<uint8_t> > buffers;
-            vbDescs.resize(numAttribs);
-			buffers.resize(numAttribs);
-
-            const uint32_t kInvalidBufferIndex = (uint32_t)-1;
-            uint32_t positionBufferIndex = kInvalidBufferIndex;
-            uint32_t normalBufferIndex = kInvalidBufferIndex;
-            uint32_t tangentBufferIndex = kInvalidBufferIndex;
-            uint32_t bitangentBufferIndex = kInvalidBufferIndex;
-            uint32_t texCoordBufferIndex = kInvalidBufferIndex;
+            mesh.vbDescs.resize(mesh.numAttribs);
+            mesh.buffers.resize(mesh.numAttribs);
+            mesh.attribEncodings.resize(mesh.numAttribs);
 
-            for(int i = 0; i < numAttribs; i++)
+            for(int i = 0; i < mesh.numAttribs; i++)
             {
-                auto& pLayout = vbDescs[i].pLayout;
-				pLayout = VertexLayout::create();
                 int32_t type, format, length;
-                mStream >> type >> format >> length;
-                if(type < 0 || type >= numAttributesType || format < 0 || format >= AttribFormat::AttribFormat_Max || length < 1 || length > 4)
+                stream >> type >> format >> length;
+                if(addMeshAttribute(mesh, i, type, format, length, glm::vec4(0), glm::vec4(1), header, modelName) == false)
                 {
-                    std::string msg = "Error when loading model " + mModelName + ".\nCorrupted data.!";
-                    Logger::log(Logger::Level::Error, msg);
-                    return nullptr;
+                    return false;
                 }
-                else
+            }
+
+            initTangentGeneration(mesh, meshIdx, header, modelName);
+
+            // Vertex data
+            if(readBlock(stream, size_t(mesh.vertexSize) * mesh.numVertices, mesh.vertexStorage, mesh.pVertexData) == false)
+            {
+                std::string msg = "Error when loading model " + modelName + ".\nVertex data is truncated.";
+                Logger::log(Logger::Level::Error, msg);
+                return false;
+            }
+
+            if(header.version <= 5)
+            {
+                if(importTextures(data.texData, header.numTextures, stream, modelName) == false)
                 {
-                    const std::string falcorName = getSemanticName(AttribType(type));
-                    ResourceFormat falcorFormat = getFalcorFormat(AttribFormat(format), length);
-                    uint32_t shaderLocation = getShaderLocation(AttribType(type));
-
-                    vbDescs[i].stride = getFormatByteSize(AttribFormat(format)) * length;
-
-					switch (shaderLocation)
-					{
-					case VERTEX_POSITION_LOC:
-						positionBufferIndex = i;
-                        assert(falcorFormat == ResourceFormat::RGB32Float || falcorFormat == ResourceFormat::RGBA32Float);
-						break;
-					case VERTEX_NORMAL_LOC:
-						normalBufferIndex = i;
-                        assert(falcorFormat == ResourceFormat::RGB32Float);
-						break;
-					case VERTEX_TANGENT_LOC:
-						tangentBufferIndex = i;
-                        assert(falcorFormat == ResourceFormat::RGB32Float);
-						break;
-					case VERTEX_BITANGENT_LOC:
-						bitangentBufferIndex = i;
-                        assert(falcorFormat == ResourceFormat::RGB32Float);
-						break;
-					case VERTEX_TEXCOORD_LOC:
-						texCoordBufferIndex = i;
-						break;
-					}
-
-					pLayout->addElement(falcorName, 0, falcorFormat, 1, shaderLocation);
-                    buffers[i].resize(vbDescs[i].stride * numVertices);
+                    return false;
                 }
             }
 
-			
-            // Check if we need to generate tangents  
-            bool genTangentForMesh = false;
-            if(shouldGenerateTangents && (tangentBufferIndex == kInvalidBufferIndex) && (bitangentBufferIndex == kInvalidBufferIndex))
+            // Array of Submesh.
+            mesh.submeshes.resize(numSubmeshes);
+            for(auto& submesh : mesh.submeshes)
             {
-                if(normalBufferIndex == kInvalidBufferIndex)
+                if(parseSubmesh(stream, header, submesh, modelName) == false)
                 {
-                    Logger::log(Logger::Level::Warning, "Can't generate tangent space for mesh " + std::to_string(meshIdx) + " when loading model " + mModelName + ".\nMesh doesn't contain normals or texture coordinates\n");
-                    genTangentForMesh = false;
+                    return false;
                 }
-                else
+
+                const uint8_t* pIndexData;
+                if(readBlock(stream, submesh.numIndices * sizeof(uint32_t), submesh.indexStorage, pIndexData) == false)
                 {
-                    if(texCoordBufferIndex == kInvalidBufferIndex)
-					{
-						Logger::log(Logger::Level::Warning, "No uv mapping is provided to generate tangent space for mesh " + std::to_string(meshIdx) + " when loading model " + mModelName + ".\nMesh doesn't contain normals or texture coordinates\n");
-					}
-                    // Set the offsets
-                    genTangentForMesh = true;
-                    tangentBufferIndex = (uint32_t)vbDescs.size();
-                    bitangentBufferIndex = (uint32_t)vbDescs.size() + 1;
-                    vbDescs.resize(bitangentBufferIndex + 1);
-					buffers.resize(bitangentBufferIndex + 1);
-                   
-                    Vao::VertexBufferDesc& vbTangentDesc = vbDescs[tangentBufferIndex];
-					auto& pTangentLayout = vbTangentDesc.pLayout;
-					pTangentLayout = VertexLayout::create();
-                    vbDescs[tangentBufferIndex].stride = sizeof(glm::vec3);
-					pTangentLayout->addElement(VERTEX_TANGENT_NAME, 0, ResourceFormat::RGB32Float, 1, VERTEX_TANGENT_LOC);
-					buffers[tangentBufferIndex].resize(sizeof(glm::vec3) * numVertices);
-
-                    Vao::VertexBufferDesc& vbBitangentDesc = vbDescs[bitangentBufferIndex];
-					auto& pBitangentLayout = vbBitangentDesc.pLayout;
-					pBitangentLayout = VertexLayout::create();
-                    vbDescs[tangentBufferIndex].stride = sizeof(glm::vec3);
-					pBitangentLayout->addElement(VERTEX_BITANGENT_NAME, 0, ResourceFormat::RGB32Float, 1, VERTEX_BITANGENT_LOC);
-					buffers[bitangentBufferIndex].resize(sizeof(glm::vec3) * numVertices);
+                    std::string Msg = "Error when loading model " + modelName + ".\nIndex data is truncated.";
+                    Logger::log(Logger::Level::Error, Msg);
+                    return false;
                 }
+                submesh.pIndices = (const uint32_t*)pIndexData;
             }
-			
+        }
 
-            // Read the data
-            // Read one vertex at a time
-            for(int32_t i = 0; i < numVertices; i++)
+        if(header.version >= 6)
+        {
+            return parseInstances(stream, header, data.instances, modelName);
+        }
+        return true;
+    }
+
+    static bool parseMeshChunk(MemoryReadStream& chunk, MeshData& mesh, int meshIdx, const ModelHeader& header, const std::string& modelName)
+    {
+        int32_t numSubmeshes = 0;
+        chunk >> mesh.numAttribs >> mesh.numVertices >> numSubmeshes;
+        if(mesh.numAttribs < 0 || mesh.numVertices < 0 || numSubmeshes < 0 || chunk.isFail())
+        {
+            std::string Msg = "Error when loading model " + modelName + ".\nCorrupted data.!";
+            Logger::log(Logger::Level::Error, Msg);
+            return false;
+        }
+
+        mesh.vbDescs.resize(mesh.numAttribs);
+        mesh.buffers.resize(mesh.numAttribs);
+        mesh.attribEncodings.resize(mesh.numAttribs);
+        mesh.attribData.resize(mesh.numAttribs);
+
+        std::vector<int32_t> dataOffsets(mesh.numAttribs);
+        for(int i = 0; i < mesh.numAttribs; i++)
+        {
+            int32_t type, format, length;
+            glm::vec4 offset(0);
+            glm::vec4 scale(1);
+            chunk >> type >> format >> length >> dataOffsets[i];
+            if(header.version >= 11)
             {
-				for (int32_t attributes = 0; attributes < numAttribs; ++attributes)
-				{
-                    uint32_t stride = vbDescs[attributes].stride;
-					uint8_t* pDest = buffers[attributes].data() + stride * i;
-					mStream.read(pDest, stride);
-				}
+                chunk >> offset >> scale;
             }
 
-			for (int32_t i = 0; i < numAttribs; ++i)
-			{
-                vbDescs[i].pBuffer = Buffer::create(buffers[i].size(), Buffer::BindFlags::Vertex, Buffer::AccessFlags::None, buffers[i].data());
-                pModel->addBuffer(vbDescs[i].pBuffer);
-			}
+            if(addMeshAttribute(mesh, i, type, format, length, offset, scale, header, modelName) == false)
+            {
+                return false;
+            }
+        }
 
-            if(version <= 5)
+        initTangentGeneration(mesh, meshIdx, header, modelName);
+
+        std::vector<int32_t> indexOffsets(numSubmeshes);
+        std::vector<int32_t> lodCounts(numSubmeshes, 0);
+        std::vector<int32_t> lodOffsets(numSubmeshes, 0);
+        mesh.submeshes.resize(numSubmeshes);
+        for(int i = 0; i < numSubmeshes; i++)
+        {
+            if(parseSubmesh(chunk, header, mesh.submeshes[i], modelName) == false)
             {
-                importTextures(texData, numTextures, mStream, mModelName);
-                textures.clear();
+                return false;
             }
+            chunk >> indexOffsets[i];
+            if(header.version >= 12)
+            {
+                chunk >> lodCounts[i] >> lodOffsets[i];
+            }
+        }
 
-            // Array of Submesh.
-            // Falcor doesn't have a concept of submeshes, just create a new mesh for each submesh
-            for(int submesh = 0; submesh < numSubmeshes; submesh++)
+        // Resolve the attribute streams and the index arrays. They are used directly from the chunk.
+        bool isValid = chunk.isGood();
+        for(int i = 0; i < mesh.numAttribs; i++)
+        {
+            size_t streamSize = size_t(mesh.attribEncodings[i].storedStride) * mesh.numVertices;
+            isValid = isValid && (dataOffsets[i] >= 0) && (size_t(dataOffsets[i]) + streamSize <= chunk.getSize());
+            mesh.attribData[i] = chunk.getData() + dataOffsets[i];
+        }
+
+        for(int i = 0; i < numSubmeshes; i++)
+        {
+            auto& submesh = mesh.submeshes[i];
+            size_t indexSize = submesh.numIndices * sizeof(uint32_t);
+            isValid = isValid && (indexOffsets[i] >= 0) && (size_t(indexOffsets[i]) + indexSize <= chunk.getSize());
+            submesh.pIndices = (const uint32_t*)(chunk.getData() + indexOffsets[i]);
+
+            // v12 LOD table. Every entry is (error, numTriangles, indexOffset).
+            isValid = isValid && (lodCounts[i] >= 0) && (lodOffsets[i] >= 0) && (size_t(lodOffsets[i]) + lodCounts[i] * kBinSceneSubmeshLodSize <= chunk.getSize());
+            for(int32_t lodIdx = 0; isValid && (lodIdx < lodCounts[i]); lodIdx++)
             {
-                // create the material
-                BasicMaterial basicMaterial;
+                int32_t desc[3];
+                std::memcpy(desc, chunk.getData() + lodOffsets[i] + lodIdx * kBinSceneSubmeshLodSize, kBinSceneSubmeshLodSize);
+
+                SubmeshLodData lod;
+                std::memcpy(&lod.error, &desc[0], sizeof(float));
+                lod.numIndices = uint32_t(desc[1]) * 3;
+                isValid = (desc[1] >= 0) && (desc[2] >= 0) && (size_t(desc[2]) + size_t(lod.numIndices) * sizeof(uint32_t) <= chunk.getSize());
+                lod.pIndices = (const uint32_t*)(chunk.getData() + desc[2]);
+                submesh.lods.push_back(std::move(lod));
+            }
+        }
+
+        if(isValid == false)
+        {
+            std::string Msg = "Error when loading model " + modelName + ".\nMesh data is out of the chunk's bounds.";
+            Logger::log(Logger::Level::Error, Msg);
+            return false;
+        }
+        return true;
+    }
+
+    static ChunkType getChunkType(const ModelHeader& header, int32_t chunkID)
+    {
+        if(chunkID < header.numTextures) return ChunkType_Texture;
+        if(chunkID < header.numTextures + header.numMeshes) return ChunkType_Mesh;
+        if(chunkID == header.numTextures + header.numMeshes) return ChunkType_Instances;
+        return ChunkType_Bounds;
+    }
+
+    static void seekStream(BinaryFileStream& stream, uint64_t offset)
+    {
+        stream.seek(offset);
+    }
+
+    static void seekStream(MemoryReadStream& stream, uint64_t offset)
+    {
+        stream.setPosition(size_t(offset));
+    }
+
+    static bool intersectsRegion(const BinaryModelImporter::Region& region, const BoundingBox& box)
+    {
+        for(const auto& regionBox : region.boxes)
+        {
+            glm::vec3 distance = glm::abs(regionBox.center - box.center);
+            glm::vec3 extent = regionBox.extent + box.extent;
+            if(distance.x <= extent.x && distance.y <= extent.y && distance.z <= extent.z)
+            {
+                return true;
+            }
+        }
+
+        for(const Camera* pCamera : region.cameras)
+        {
+            if(pCamera->isObjectCulled(box) == false)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    struct TexSignature
+    {
+        const uint8_t* pData;
+        ResourceFormat format;
+        bool operator<(const TexSignature& other) const 
+        { 
+            if(pData < other.pData) return true;
+            if(pData == other.pData) return format < other.format;
+            return false;
+        }
+        bool operator==(const TexSignature& other) const { return pData == other.pData || format == other.format; }
+    };
+
+    struct BinaryModelImporter::LoaderState
+    {
+        ModelHeader header;
+        ModelData data;
+
+        // v9+ files
+        std::vector<ChunkDesc> chunks;
+        std::vector<const uint8_t*> chunkData;       // The uncompressed chunk data. Points either into ModelData::chunkStorage or into the memory-mapped file
+        std::vector<bool> isChunkLoaded;
+        std::vector<BoundingBox> meshBounds;         // v10 object-space mesh bounding-boxes
+
+        // This file format has a concept of sub-meshes, which Falcor model doesn't have - Falcor creates a new mesh for each sub-mesh
+        // When creating instances of meshes, it means we need to translate the original mesh index to all it's submeshes Falcor IDs. This is what the next variable is for.
+        std::vector<std::vector<uint32_t>> meshToSubmeshesID;
+        std::vector<bool> isInstanceLoaded;
+        std::map<TexSignature, Texture::SharedPtr> textures;
+        std::set<const void*> modelResources;        // Buffers and textures already added to the model. The resource cache returns the same object for identical data.
+    };
+
+    BinaryModelImporter::BinaryModelImporter(const std::string& fullpath, uint32_t flags) : mModelName(fullpath), mFlags(flags), mpState(new LoaderState)
+    {
+    }
+
+    BinaryModelImporter::~BinaryModelImporter() = default;
+
+    void BinaryModelImporter::openFile()
+    {
+        // Prefer mapping the file. Vertex, index and texture data are then read directly from the OS page cache instead of being copied through the stream buffers
+        if(((mFlags & Model::DontMemoryMapFiles) == 0) && mMappedFile.open(mModelName))
+        {
+            mFileSize = mMappedFile.getSize();
+        }
+        else
+        {
+            mStream.open(mModelName, BinaryFileStream::Mode::Read);
+            mFileSize = mStream.getRemainingStreamSize();
+        }
+    }
+
+    Model::SharedPtr BinaryModelImporter::createFromFile(const std::string& filename, uint32_t flags)
+    {
+        std::string fullpath;
+        if(findFileInDataDirectories(filename, fullpath) == false)
+        {
+            Logger::log(Logger::Level::Error, std::string("Can't find model file ") + filename);
+            return nullptr;
+        }
+
+        BinaryModelImporter loader(fullpath, flags);
+        loader.openFile();
+        if(loader.mMappedFile.isOpen())
+        {
+            return loader.createModel(loader.mMappedFile);
+        }
+        else
+        {
+            return loader.createModel(loader.mStream);
+        }
+    }
+
+    BinaryModelImporter::UniquePtr BinaryModelImporter::createStreaming(const std::string& filename, uint32_t flags)
+    {
+        std::string fullpath;
+        if(findFileInDataDirectories(filename, fullpath) == false)
+        {
+            Logger::log(Logger::Level::Error, std::string("Can't find model file ") + filename);
+            return nullptr;
+        }
+
+        UniquePtr pLoader = UniquePtr(new BinaryModelImporter(fullpath, flags));
+        pLoader->openFile();
+        bool success = pLoader->mMappedFile.isOpen() ? pLoader->openStreaming(pLoader->mMappedFile) : pLoader->openStreaming(pLoader->mStream);
+        if(success == false)
+        {
+            return nullptr;
+        }
+        return pLoader;
+    }
+
+    template<typename StreamType>
+    bool BinaryModelImporter::readHeader(StreamType& stream)
+    {
+        ModelHeader& header = mpState->header;
+
+        // Format ID and version.
+        char formatID[9];
+        stream.read(formatID, 8);
+        formatID[8] = '\0';
+
+        stream >> header.version;
+
+        // Check if the version matches
+        if(checkVersion(formatID, header.version, mModelName) == false)
+        {
+            return false;
+        }
+
+        header.numAttributesType = AttribType_AORadius + 1;
+
+        switch(header.version)
+        {
+        case 1:     header.numTextureSlots = 0; break;
+        case 2:     header.numTextureSlots = TextureType_Alpha + 1; break;
+        case 3:     header.numTextureSlots = TextureType_Displacement + 1; break;
+        case 4:     header.numTextureSlots = TextureType_Environment + 1; break;
+        case 5:     header.numTextureSlots = TextureType_Specular + 1; break;
+        case 6:     header.numTextureSlots = TextureType_Specular + 1; break;
+        case 7:     header.numTextureSlots = TextureType_Glossiness + 1; break;
+        case 8:
+        case 9:
+        case 10:
+        case 11:
+        case 12:    header.numTextureSlots = TextureType_Glossiness + 1; header.numAttributesType = AttribType_Max; break;
+        default:
+            should_not_get_here();
+            return false;
+        }
+
+
+        // File header
+        if(header.version >= 6)
+        {
+            stream >> header.numTextures >> header.numMeshes >> header.numInstances;
+        }
+        else
+        {
+            header.numMeshes = 1;
+            header.numInstances = 1;
+            stream >> header.numAttribs_v5 >> header.numVertices_v5 >> header.numSubmeshes_v5;
+            if(header.version >= 2)
+            {
+                stream >> header.numTextures;
+            }
+        }
+
+        if(header.numTextures < 0 || header.numMeshes < 0 || header.numInstances < 0)
+        {
+            std::string msg = "Error when loading model " + mModelName + ".\nFile is corrupted.";
+            Logger::log(Logger::Level::Error, msg);
+            return false;
+        }
+
+        header.generateTangents = (mFlags & Model::GenerateTangentSpace) != 0;
+        if(header.version >= 11)
+        {
+            header.numAttribFormats = AttribFormat_Max;
+        }
+
+        mpState->data.meshes.resize(header.numMeshes);
+        mpState->meshToSubmeshesID.resize(header.numMeshes);
+        return true;
+    }
+
+    /** Read the table of contents of a v9+ file. The file starts with a table of contents, followed by a chunk for every texture and mesh and a chunk for the instances. v10 adds a chunk with the mesh bounding-boxes.
+    */
+    template<typename StreamType>
+    bool BinaryModelImporter::readTableOfContents(StreamType& stream)
+    {
+        const ModelHeader& header = mpState->header;
+        int32_t numChunks;
+        stream >> numChunks;
+        int32_t expectedChunks = header.numTextures + header.numMeshes + ((header.version >= 10) ? 2 : 1);
+        if(numChunks != expectedChunks)
+        {
+            std::string msg = "Error when loading model " + mModelName + ".\nFile is corrupted.";
+            Logger::log(Logger::Level::Error, msg);
+            return false;
+        }
+
+        auto& chunks = mpState->chunks;
+        chunks.resize(numChunks);
+        for(auto& chunk : chunks)
+        {
+            stream >> chunk.type >> chunk.compression >> chunk.offset >> chunk.storedSize >> chunk.size >> chunk.hash;
+        }
+        mBytesRead = 8 + 5 * sizeof(int32_t) + numChunks * sizeof(ChunkDesc);
+
+        // The chunks are stored in order and don't overlap
+        uint64_t position = mBytesRead;
+        for(int32_t i = 0; i < numChunks; i++)
+        {
+            const ChunkDesc& chunk = chunks[i];
+            if(chunk.type != getChunkType(header, i) || chunk.offset < position || chunk.offset > mFileSize || chunk.storedSize > mFileSize - chunk.offset || chunk.compression < 0 || chunk.compression >= ChunkCompression_Max)
+            {
+                std::string msg = "Error when loading model " + mModelName + ".\nCorrupted table of contents.";
+                Logger::log(Logger::Level::Error, msg);
+                return false;
+            }
+
+            if(chunk.compression == ChunkCompression_Zstd)
+            {
+                std::string msg = "Error when loading model " + mModelName + ".\nZstd-compressed chunks are not supported.";
+                Logger::log(Logger::Level::Error, msg);
+                return false;
+            }
+            position = chunk.offset + chunk.storedSize;
+        }
+
+        mpState->data.chunkStorage.resize(numChunks);
+        mpState->chunkData.resize(numChunks);
+        mpState->isChunkLoaded.assign(numChunks, false);
+        mpState->data.texData.assign(header.numTextures, TextureData());
+        return stream.isFail() == false;
+    }
+
+    template<typename StreamType>
+    bool BinaryModelImporter::readChunksFromStream(StreamType& stream, const std::vector<uint32_t>& chunkIDs)
+    {
+        auto& chunks = mpState->chunks;
+        auto& chunkData = mpState->chunkData;
+        auto& chunkStorage = mpState->data.chunkStorage;
+
+        for(uint32_t i : chunkIDs)
+        {
+            seekStream(stream, chunks[i].offset);
+            if(readBlock(stream, size_t(chunks[i].storedSize), chunkStorage[i], chunkData[i]) == false)
+            {
+                std::string msg = "Error when loading model " + mModelName + ".\nFile is truncated.";
+                Logger::log(Logger::Level::Error, msg);
+                return false;
+            }
+            mBytesRead += chunks[i].storedSize;
+        }
+
+        // Decompress and validate
+        std::vector<uint8_t> isChunkValid(chunkIDs.size());
+        auto validateFunc = [&](uint32_t j)
+        {
+            uint32_t i = chunkIDs[j];
+            const ChunkDesc& chunk = chunks[i];
+            bool isValid = true;
+            if(chunk.compression == ChunkCompression_LZ4)
+            {
+                std::vector<uint8_t> uncompressed(size_t(chunk.size));
+                isValid = decompressLz4(chunkData[i], size_t(chunk.storedSize), uncompressed.data(), size_t(chunk.size));
+                chunkStorage[i].swap(uncompressed);
+                chunkData[i] = chunkStorage[i].data();
+            }
+            else
+            {
+                isValid = (chunk.size == chunk.storedSize);
+            }
+
+            isChunkValid[j] = isValid && (calculateHash64(chunkData[i], size_t(chunk.size)) == chunk.hash);
+        };
 
-                glm::vec3 ambient;
-                glm::vec4 diffuse;
-                glm::vec3 specular;
-                float glossiness;
+        if((mFlags & Model::DontLoadInParallel) == 0)
+        {
+            ThreadPool::getDefaultPool()->parallelFor((uint32_t)chunkIDs.size(), validateFunc);
+        }
+        else
+        {
+            for(uint32_t j = 0; j < chunkIDs.size(); j++)
+            {
+                validateFunc(j);
+            }
+        }
 
-                mStream >> ambient >> diffuse >> specular >> glossiness;
-                basicMaterial.diffuseColor = glm::vec3(diffuse);
-                basicMaterial.opacity = 1 - diffuse.w;
-                basicMaterial.specularColor = specular;
-                basicMaterial.shininess = glossiness;
+        for(uint32_t j = 0; j < chunkIDs.size(); j++)
+        {
+            if(isChunkValid[j] == 0)
+            {
+                std::string msg = "Error when loading model " + mModelName + ".\nChunk " + std::to_string(chunkIDs[j]) + " is corrupted (content hash mismatch).";
+                Logger::log(Logger::Level::Error, msg);
+                return false;
+            }
+            mpState->isChunkLoaded[chunkIDs[j]] = true;
+        }
+
+        return true;
+    }
+
+    bool BinaryModelImporter::readChunks(const std::vector<uint32_t>& chunkIDs)
+    {
+        if(mMappedFile.isOpen())
+        {
+            return readChunksFromStream(mMappedFile, chunkIDs);
+        }
+        else
+        {
+            return readChunksFromStream(mStream, chunkIDs);
+        }
+    }
+
+    bool BinaryModelImporter::parseChunks(const std::vector<uint32_t>& chunkIDs)
+    {
+        const ModelHeader& header = mpState->header;
+        ModelData& data = mpState->data;
 
-                if(version >= 3)
+        for(uint32_t i : chunkIDs)
+        {
+            MemoryReadStream chunk(mpState->chunkData[i], size_t(mpState->chunks[i].size));
+            switch(mpState->chunks[i].type)
+            {
+            case ChunkType_Texture:
+                data.texData[i].name = readString(chunk);
+                if(loadBinaryTextureData(chunk, mModelName, data.texData[i]) == false)
+                {
+                    return false;
+                }
+                break;
+            case ChunkType_Mesh:
+            {
+                int32_t meshIdx = i - header.numTextures;
+                if(parseMeshChunk(chunk, data.meshes[meshIdx], meshIdx, header, mModelName) == false)
+                {
+                    return false;
+                }
+                break;
+            }
+            case ChunkType_Instances:
+                if(parseInstances(chunk, header, data.instances, mModelName) == false)
                 {
-                    float displacementCoeff;
-                    float displacementBias;
-                    mStream >> displacementCoeff >> displacementBias;
-                    basicMaterial.bumpScale = displacementCoeff;
-                    basicMaterial.bumpOffset = displacementBias;
+                    return false;
+                }
+                break;
+            case ChunkType_Bounds:
+                mpState->meshBounds.resize(header.numMeshes);
+                for(auto& box : mpState->meshBounds)
+                {
+                    glm::vec3 min, max;
+                    chunk >> min >> max;
+                    box = BoundingBox::fromMinMax(min, max);
                 }
 
-                for(int i = 0; i < numTextureSlots; i++)
+                if(chunk.isFail())
                 {
-                    int32_t texID;
-                    mStream >> texID;
-                    if(texID < -1 || texID >= numTextures)
-                    {
-                        std::string msg = "Error when loading model " + mModelName + ".\nCorrupt binary mesh data!";
-                        Logger::log(Logger::Level::Error, msg);
-                        return nullptr;
-                    }
-                    else if(texID != -1)
+                    std::string msg = "Error when loading model " + mModelName + ".\nMesh bounds are truncated.";
+                    Logger::log(Logger::Level::Error, msg);
+                    return false;
+                }
+                break;
+            default:
+                should_not_get_here();
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void BinaryModelImporter::decodeData(const std::vector<uint32_t>& textureIDs, const std::vector<uint32_t>& meshIDs)
+    {
+        // The result doesn't depend on the execution order, so the parallel and the serial paths produce the same data.
+        ModelData& data = mpState->data;
+        uint32_t textureCount = (uint32_t)textureIDs.size();
+
+        // Logger isn't thread-safe, so the warnings are logged after all the tasks are done
+        std::vector<std::string> meshWarnings(meshIDs.size());
+        auto decodeFunc = [&](uint32_t i)
+        {
+            if(i < textureCount)
+            {
+                decodeTextureData(data.texData[textureIDs[i]]);
+            }
+            else
+            {
+                uint32_t j = i - textureCount;
+                decodeMeshData(data.meshes[meshIDs[j]], mFlags, meshWarnings[j]);
+            }
+        };
+
+        uint32_t decodeTaskCount = textureCount + (uint32_t)meshIDs.size();
+        if((mFlags & Model::DontLoadInParallel) == 0)
+        {
+            ThreadPool::getDefaultPool()->parallelFor(decodeTaskCount, decodeFunc);
+        }
+        else
+        {
+            for(uint32_t i = 0; i < decodeTaskCount; i++)
+            {
+                decodeFunc(i);
+            }
+        }
+
+        for(size_t j = 0; j < meshIDs.size(); j++)
+        {
+            if(meshWarnings[j].size())
+            {
+                Logger::log(Logger::Level::Warning, "Mesh " + std::to_string(meshIDs[j]) + " of model " + mModelName + ": " + meshWarnings[j]);
+            }
+        }
+    }
+
+    void BinaryModelImporter::createMeshes(const std::vector<uint32_t>& meshIDs)
+    {
+        const ModelHeader& header = mpState->header;
+        std::vector<TextureData>& texData = mpState->data.texData;
+        auto& textures = mpState->textures;
+        bool loadTexAsSrgb = (mFlags & Model::AssumeLinearSpaceTextures) ? false : true;
+
+        auto addBuffer = [this](const Buffer::SharedPtr& pBuffer)
+        {
+            if(mpState->modelResources.insert(pBuffer.get()).second)
+            {
+                mpModel->addBuffer(pBuffer);
+            }
+        };
+
+        for(uint32_t meshIdx : meshIDs)
+        {
+            MeshData& mesh = mpState->data.meshes[meshIdx];
+            auto& vbDescs = mesh.vbDescs;
+
+            // Includes the generated tangent space buffers
+            for(size_t i = 0; i < mesh.buffers.size(); ++i)
+            {
+                vbDescs[i].pBuffer = ResourceCache::createBuffer(mesh.buffers[i].size(), Buffer::BindFlags::Vertex, Buffer::AccessFlags::None, mesh.buffers[i].data());
+                addBuffer(vbDescs[i].pBuffer);
+            }
+
+            if(header.version <= 5)
+            {
+                textures.clear();
+            }
+
+            // Falcor doesn't have a concept of submeshes, just create a new mesh for each submesh
+            for(auto& submesh : mesh.submeshes)
+            {
+                // create the material
+                BasicMaterial& basicMaterial = submesh.material;
+                for(int i = 0; i < header.numTextureSlots; i++)
+                {
+                    int32_t texID = submesh.textureIDs[i];
+                    if(texID != -1)
                     {
                         BasicMaterial::MapType falcorType = getFalcorMapType(TextureType(i));
-						if(BasicMaterial::MapType::Count == falcorType)
-						{
-							Logger::log(Logger::Level::Warning, "Texture of Type " + std::to_string(i) + " is not supported by the material system (model " + mModelName + ")");
-							continue;
-						}
+                        if(BasicMaterial::MapType::Count == falcorType)
+                        {
+                            Logger::log(Logger::Level::Warning, "Texture of Type " + std::to_string(i) + " is not supported by the material system (model " + mModelName + ")");
+                            continue;
+                        }
 
                         // Load the texture
                         TexSignature texSig;
                         texSig.format = getFormatFromMapType(loadTexAsSrgb, texData[texID].format, falcorType);
-                        texSig.pData = texData[texID].data.data();
+                        texSig.pData = texData[texID].pData;
                         // Check if we already created a matching texture
                         auto existingTex = textures.find(texSig);
                         if(existingTex != textures.end())
@@ -879,17 +1876,20 @@ namespace Falcor
                         }
                         else
                         {
-                            auto pTexture = Texture::create2D(texData[texID].width, texData[texID].height, texSig.format, 1, Texture::kEntireMipChain, texSig.pData);
-                            pTexture->setSourceFilename(texData[texID].name);
+                            auto pTexture = ResourceCache::createTexture2D(texData[texID].width, texData[texID].height, texSig.format, 1, Texture::kEntireMipChain, texSig.pData);
                             textures[texSig] = pTexture;
-                            pModel->addTexture(pTexture);
+                            if(mpState->modelResources.insert(pTexture.get()).second)
+                            {
+                                pTexture->setSourceFilename(texData[texID].name);
+                                mpModel->addTexture(pTexture);
+                            }
                             basicMaterial.pTextures[falcorType] = pTexture;
                         }
                     }
                 }
 
                 auto pMaterial = basicMaterial.convertToMaterial();
-                auto pAddedMaterial = pModel->getOrAddMaterial(pMaterial);
+                auto pAddedMaterial = mpModel->getOrAddMaterial(pMaterial);
 
                 // Check it the material already existed in the model
                 if(pAddedMaterial != pMaterial)
@@ -897,113 +1897,269 @@ namespace Falcor
                     pMaterial = pAddedMaterial;
                 }
 
-                int32_t numTriangles;
-                mStream >> numTriangles;
-                if(numTriangles < 0)
+                // create the index buffer. The LODs are stored after the full resolution mesh.
+                std::vector<Mesh::Lod> lods;
+                const uint32_t* pIndices = submesh.pIndices;
+                std::vector<uint32_t> combinedIndices;
+                if(submesh.lods.size())
                 {
-                    std::string Msg = "Error when loading model " + mModelName + ".\nMesh has negative number of triangles!";
-                    Logger::log(Logger::Level::Error, Msg);
-                    return nullptr;
+                    combinedIndices.assign(submesh.pIndices, submesh.pIndices + submesh.numIndices);
+                    for(const auto& lodData : submesh.lods)
+                    {
+                        Mesh::Lod lod;
+                        lod.firstIndex = (uint32_t)combinedIndices.size();
+                        lod.indexCount = lodData.numIndices;
+                        lod.error = lodData.error;
+                        lods.push_back(lod);
+                        combinedIndices.insert(combinedIndices.end(), lodData.pIndices, lodData.pIndices + lodData.numIndices);
+                    }
+                    pIndices = combinedIndices.data();
                 }
 
-                // create the index buffer
-                uint32_t numIndices = numTriangles * 3;
-                std::vector<uint32_t> indices(numIndices);
-                uint32_t ibSize = 3 * numTriangles * sizeof(uint32_t);
-                mStream.read(&indices[0], ibSize);
+                uint32_t ibSize = (uint32_t)(combinedIndices.size() ? combinedIndices.size() : submesh.numIndices) * sizeof(uint32_t);
+                auto pIB = ResourceCache::createBuffer(ibSize, Buffer::BindFlags::Index, Buffer::AccessFlags::MapRead, pIndices);
+                addBuffer(pIB);
 
-                auto pIB = Buffer::create(ibSize, Buffer::BindFlags::Index, Buffer::AccessFlags::MapRead, indices.data());
-                pModel->addBuffer(pIB);
+                // create the mesh
+                auto pMesh = Mesh::create(vbDescs, mesh.numVertices, pIB, submesh.numIndices, RenderContext::Topology::TriangleList, pMaterial, submesh.boundingBox, false);
+                pMesh->setLods(lods);
+                pMesh->setVertexEncoding(mesh.vertexEncoding);
+                mpModel->addMesh(std::move(pMesh));
+                mpState->meshToSubmeshesID[meshIdx].push_back(mpModel->getMeshCount() - 1);
 
-                
-                // Generate tangent space data if needed
-                if(genTangentForMesh)
+                if(mFlags & Model::OptimizeVertexCache)
                 {
-                    if(texCoordBufferIndex != kInvalidBufferIndex)
-                    {
-                        Logger::log(Logger::Level::Error, "Model " + mModelName + " asked to generate tangents w/o texture coordinates");
-                    }
-                    uint32_t texCrdCount = 0;
-                    glm::vec2* texCrd = nullptr;
-                    if(texCoordBufferIndex != kInvalidBufferIndex)
-                    {
-                        texCrdCount = vbDescs[texCoordBufferIndex].stride / sizeof(glm::vec2);
-                        texCrd = (glm::vec2*)buffers[texCoordBufferIndex].data();
-                    }
+                    std::string msg = "Optimized mesh " + std::to_string(mpModel->getMeshCount() - 1) + " of model " + mModelName + ". ";
+                    msg += "ACMR " + std::to_string(submesh.cacheStatsBefore.acmr) + " -> " + std::to_string(submesh.cacheStatsAfter.acmr);
+                    msg += ", ATVR " + std::to_string(submesh.cacheStatsBefore.atvr) + " -> " + std::to_string(submesh.cacheStatsAfter.atvr);
+                    Logger::log(Logger::Level::Info, msg);
+                }
+            }
+        }
+    }
 
-                    if (vbDescs[positionBufferIndex].pLayout->getElementFormat(0) == ResourceFormat::RGB32Float)
-                    {
-                        generateSubmeshTangentData<glm::vec3>(indices, (glm::vec3*)buffers[positionBufferIndex].data(), (glm::vec3*)buffers[normalBufferIndex].data(), texCrd, texCrdCount, (glm::vec3*)buffers[tangentBufferIndex].data(), (glm::vec3*)buffers[bitangentBufferIndex].data());
-                    }
-                    else if (vbDescs[positionBufferIndex].pLayout->getElementFormat(0) == ResourceFormat::RGBA32Float)
-                    {
-                        generateSubmeshTangentData<glm::vec4>(indices, (glm::vec4*)buffers[positionBufferIndex].data(), (glm::vec3*)buffers[normalBufferIndex].data(), texCrd, texCrdCount, (glm::vec3*)buffers[tangentBufferIndex].data(), (glm::vec3*)buffers[bitangentBufferIndex].data());
-                    }
+    void BinaryModelImporter::addInstances(const std::vector<uint32_t>& instanceIDs)
+    {
+        for(uint32_t instanceID : instanceIDs)
+        {
+            const auto& instance = mpState->data.instances[instanceID];
+            if(instance.enabled)
+            {
+                for(uint32_t i : mpState->meshToSubmeshesID[instance.meshIdx])
+                {
+                    auto pMesh = mpModel->getMesh(i);
+                    pMesh->addInstance(instance.transformation);
+                }
+            }
+        }
+    }
 
-                    vbDescs[tangentBufferIndex].pBuffer = Buffer::create(buffers[tangentBufferIndex].size(), Buffer::BindFlags::Vertex, Buffer::AccessFlags::None, buffers[tangentBufferIndex].data());
-                    pModel->addBuffer(vbDescs[tangentBufferIndex].pBuffer);
+    template<typename StreamType>
+    Model::SharedPtr BinaryModelImporter::createModel(StreamType& stream)
+    {
+        if(readHeader(stream) == false)
+        {
+            return nullptr;
+        }
 
-                    vbDescs[bitangentBufferIndex].pBuffer = Buffer::create(buffers[bitangentBufferIndex].size(), Buffer::BindFlags::Vertex, Buffer::AccessFlags::None, buffers[bitangentBufferIndex].data());
-                    pModel->addBuffer(vbDescs[bitangentBufferIndex].pBuffer);
-                }
-				
+        const ModelHeader& header = mpState->header;
+        ModelData& data = mpState->data;
 
-                // Calculate the bounding-box
-                glm::vec3 max, min;
-                for(uint32_t i = 0; i < numIndices; i++)
-                {
-                    uint32_t vertexID = indices[i];
-                    uint8_t* pVertex = (vbDescs[positionBufferIndex].stride * vertexID) + buffers[positionBufferIndex].data();
+        // The model is loaded in 3 phases:
+        // 1. Parse the file. Only the headers are interpreted, for the large data blocks we just record where they are.
+        // 2. Decode the vertex, index and texture data. Every mesh and texture is independent, so this runs on the thread pool.
+        // 3. Create the GPU resources, materials and meshes on the calling thread, in the same order as they appear in the file.
 
-                    float* pPosition = (float*)pVertex;
+        // Phase 1 - parse
+        if(header.version >= 9)
+        {
+            if(readTableOfContents(stream) == false)
+            {
+                return nullptr;
+            }
 
-                    glm::vec3 xyz(pPosition[0], pPosition[1], pPosition[2]);
-                    min = glm::min(min, xyz);
-                    max = glm::max(max, xyz);
-                }
+            std::vector<uint32_t> chunkIDs(mpState->chunks.size());
+            for(uint32_t i = 0; i < chunkIDs.size(); i++)
+            {
+                chunkIDs[i] = i;
+            }
+
+            if(readChunksFromStream(stream, chunkIDs) == false || parseChunks(chunkIDs) == false)
+            {
+                return nullptr;
+            }
+        }
+        else if(parseSequentialFile(stream, header, data, mModelName) == false)
+        {
+            return nullptr;
+        }
 
-                BoundingBox box = BoundingBox::fromMinMax(min, max);
+        std::vector<uint32_t> textureIDs(data.texData.size());
+        for(uint32_t i = 0; i < textureIDs.size(); i++)
+        {
+            textureIDs[i] = i;
+        }
 
-                // create the mesh                
-                auto pMesh = Mesh::create(vbDescs, numVertices, pIB, numIndices, RenderContext::Topology::TriangleList, pMaterial, box, false);
-                pModel->addMesh(std::move(pMesh));
-                meshToSubmeshesID[meshIdx].push_back(pModel->getMeshCount() - 1);
+        std::vector<uint32_t> meshIDs(header.numMeshes);
+        for(uint32_t i = 0; i < meshIDs.size(); i++)
+        {
+            meshIDs[i] = i;
+        }
+
+        // Phase 2 - decode
+        decodeData(textureIDs, meshIDs);
+
+        // Phase 3 - create the model
+        mpModel = Model::SharedPtr(new Model());
+        createMeshes(meshIDs);
+
+        if(header.version >= 6)
+        {
+            std::vector<uint32_t> instanceIDs(data.instances.size());
+            for(uint32_t i = 0; i < instanceIDs.size(); i++)
+            {
+                instanceIDs[i] = i;
+            }
+            addInstances(instanceIDs);
+        }
+        else
+        {
+            glm::mat4 identity;
+            for(uint32_t MeshID = 0; MeshID < mpModel->getMeshCount(); MeshID++)
+            {
+                auto pMesh = mpModel->getMesh(MeshID);
+                pMesh->addInstance(identity);
             }
         }
 
-        if(version >= 6)
+        return mpModel;
+    }
+
+    template<typename StreamType>
+    bool BinaryModelImporter::openStreaming(StreamType& stream)
+    {
+        if(readHeader(stream) == false)
+        {
+            return false;
+        }
+
+        const ModelHeader& header = mpState->header;
+        if(header.version < 10)
         {
-            for(int32_t instanceID = 0; instanceID < numInstances; instanceID++)
+            std::string msg = "Error when loading model " + mModelName + ".\nPartial loading requires a binary scene version 10 file, found version " + std::to_string(header.version) + ". Re-export the model.";
+            Logger::log(Logger::Level::Error, msg);
+            return false;
+        }
+
+        if(readTableOfContents(stream) == false)
+        {
+            return false;
+        }
+
+        // Only the instances and the mesh bounds are needed to decide what to load
+        uint32_t instancesChunk = header.numTextures + header.numMeshes;
+        std::vector<uint32_t> chunkIDs = {instancesChunk, instancesChunk + 1};
+        if(readChunksFromStream(stream, chunkIDs) == false || parseChunks(chunkIDs) == false)
+        {
+            return false;
+        }
+
+        mpState->isInstanceLoaded.assign(header.numInstances, false);
+        mpModel = Model::SharedPtr(new Model());
+        return true;
+    }
+
+    bool BinaryModelImporter::loadRegion(const Region& region)
+    {
+        const ModelHeader& header = mpState->header;
+        ModelData& data = mpState->data;
+
+        // Select the instances
+        std::vector<uint32_t> instanceIDs;
+        std::vector<uint32_t> meshIDs;
+        std::vector<uint32_t> meshChunkIDs;
+        std::vector<bool> isMeshSelected(header.numMeshes, false);
+        for(int32_t i = 0; i < header.numInstances; i++)
+        {
+            const InstanceData& instance = data.instances[i];
+            if(mpState->isInstanceLoaded[i] || instance.enabled == 0)
             {
-                int32_t meshIdx = 0;
-                int32_t enabled = 1;
-                glm::mat4 transformation;
+                continue;
+            }
 
-                mStream >> meshIdx >> enabled >> transformation;
-                //m_Stream >> inst.name >> inst.metadata;
-                readString(mStream);   // Name
-                readString(mStream);   // Meta-data
+            BoundingBox box = mpState->meshBounds[instance.meshIdx].transform(instance.transformation);
+            if(intersectsRegion(region, box))
+            {
+                instanceIDs.push_back(i);
+                mpState->isInstanceLoaded[i] = true;
 
-                if(enabled)
+                uint32_t meshChunk = header.numTextures + instance.meshIdx;
+                if(isMeshSelected[instance.meshIdx] == false && mpState->isChunkLoaded[meshChunk] == false)
                 {
-                    for(uint32_t i : meshToSubmeshesID[meshIdx])
+                    isMeshSelected[instance.meshIdx] = true;
+                    meshChunkIDs.push_back(meshChunk);
+                }
+            }
+        }
+
+        if(instanceIDs.empty())
+        {
+            return true;
+        }
+
+        std::sort(meshChunkIDs.begin(), meshChunkIDs.end());
+        for(uint32_t chunkID : meshChunkIDs)
+        {
+            meshIDs.push_back(chunkID - header.numTextures);
+        }
+
+        if(readChunks(meshChunkIDs) == false || parseChunks(meshChunkIDs) == false)
+        {
+            return false;
+        }
+
+        // Select the textures used by the new meshes. Texture chunks come first, so the chunk ID is the texture ID
+        std::vector<bool> isTextureSelected(header.numTextures, false);
+        for(uint32_t meshIdx : meshIDs)
+        {
+            for(const auto& submesh : data.meshes[meshIdx].submeshes)
+            {
+                for(int32_t texID : submesh.textureIDs)
+                {
+                    if(texID != -1 && mpState->isChunkLoaded[texID] == false)
                     {
-                        auto pMesh = pModel->getMesh(i);
-                        pMesh->addInstance(transformation);
+                        isTextureSelected[texID] = true;
                     }
                 }
             }
         }
-        else
+
+        std::vector<uint32_t> textureIDs;
+        for(int32_t i = 0; i < header.numTextures; i++)
         {
-            glm::mat4 identity;
-            for(uint32_t MeshID = 0; MeshID < pModel->getMeshCount(); MeshID++)
+            if(isTextureSelected[i])
             {
-                auto pMesh = pModel->getMesh(MeshID);
-                pMesh->addInstance(identity);
+                textureIDs.push_back(i);
             }
         }
 
-        return pModel;
+        if(readChunks(textureIDs) == false || parseChunks(textureIDs) == false)
+        {
+            return false;
+        }
+
+        decodeData(textureIDs, meshIDs);
+        createMeshes(meshIDs);
+        addInstances(instanceIDs);
+
+        // The mesh data is on the GPU now. Texture data is kept, since it is used to identify textures which were already created.
+        for(uint32_t meshIdx : meshIDs)
+        {
+            data.meshes[meshIdx] = MeshData();
+            std::vector<uint8_t>().swap(data.chunkStorage[header.numTextures + meshIdx]);
+        }
+
+        mpModel->calculateModelProperties();
+        return true;
     }
 }
@@ -27,17 +27,31 @@
 ***************************************************************************/
 #pragma once
 #include <string>
+#include <vector>
 #include "Utils/BinaryFileStream.h"
+#include "Utils/MemoryMappedFile.h"
+#include "Utils/AABB.h"
 #include "glm/vec3.hpp"
 #include "../Model.h"
 
 namespace Falcor
 {
     class Texture;
+    class Camera;
 
     class BinaryModelImporter
     {
     public:
+        using UniquePtr = std::unique_ptr<BinaryModelImporter>;
+
+        /** A world-space region used when partially loading a model. A mesh instance is loaded if its bounding-box intersects one of the boxes or one of the cameras' frustums.
+        */
+        struct Region
+        {
+            std::vector<BoundingBox> boxes;
+            std::vector<const Camera*> cameras;
+        };
+
         /** create a new model from internal binary format
             \param[in] filename Model's filename. Loader will look for it in the data directories.
             \param[in] flags Flags controlling model creation
@@ -45,19 +59,74 @@ namespace Falcor
         */
         static Model::SharedPtr createFromFile(const std::string& filename, uint32_t flags);
 
+        /** Open a model for partial loading. Only the file header, the instances and the mesh bounding-boxes are read. Use loadRegion() to load the meshes.
+            Requires a BinScene v10 file. The file stays open until the importer is destroyed.
+            \param[in] filename Model's filename. Loader will look for it in the data directories.
+            \param[in] flags Flags controlling model creation
+            \return nullptr if the file can't be opened, otherwise a new importer object with an empty model
+        */
+        static UniquePtr createStreaming(const std::string& filename, uint32_t flags);
+
+        ~BinaryModelImporter();
+
+        /** Load the mesh instances which intersect a region, together with the meshes and textures they reference. Instances which were already loaded are skipped, so this can be called repeatedly to stream in more of the model.
+            Nothing is created for parts of the file outside the region, and their chunks are never read.
+            \return false if the file is corrupted, otherwise true
+        */
+        bool loadRegion(const Region& region);
+
+        /** Get the model. Contains everything loaded so far.
+        */
+        const Model::SharedPtr& getModel() const { return mpModel; }
+
+        /** Get the number of bytes read from a BinScene v9+ file so far, including the header and the table of contents
+        */
+        uint64_t getBytesRead() const { return mBytesRead; }
+
+        /** Get the size of the file in bytes
+        */
+        uint64_t getFileSize() const { return mFileSize; }
+
     private:
-        BinaryModelImporter(const std::string& fullpath);
-        Model::SharedPtr createModel(uint32_t flags);
+        BinaryModelImporter(const std::string& fullpath, uint32_t flags);
+        void openFile();
+
+        /** Parse the file. StreamType is either BinaryFileStream or MemoryMappedFile.
+            When reading from a memory-mapped file, index and texture data are passed to the GPU straight from the mapping.
+        */
+        template<typename StreamType>
+        Model::SharedPtr createModel(StreamType& stream);
+
+        template<typename StreamType>
+        bool openStreaming(StreamType& stream);
+
+        template<typename StreamType>
+        bool readHeader(StreamType& stream);
+
+        template<typename StreamType>
+        bool readTableOfContents(StreamType& stream);
+
+        /** Read, decompress and validate chunks of a v9+ file. The chunk IDs must be sorted.
+        */
+        template<typename StreamType>
+        bool readChunksFromStream(StreamType& stream, const std::vector<uint32_t>& chunkIDs);
+        bool readChunks(const std::vector<uint32_t>& chunkIDs);
+        bool parseChunks(const std::vector<uint32_t>& chunkIDs);
+
+        void decodeData(const std::vector<uint32_t>& textureIDs, const std::vector<uint32_t>& meshIDs);
+        void createMeshes(const std::vector<uint32_t>& meshIDs);
+        void addInstances(const std::vector<uint32_t>& instanceIDs);
 
         std::string mModelName;
+        uint32_t mFlags = 0;
         BinaryFileStream mStream;
+        MemoryMappedFile mMappedFile;
+        Model::SharedPtr mpModel;
+        uint64_t mBytesRead = 0;
+        uint64_t mFileSize = 0;
 
-        struct TangentSpace
-        {
-            glm::vec3 tangent;
-            glm::vec3 bitangent;
-        };
-
-        static const uint32_t kInvalidOffset = uint32_t(-1);
+        // The parsed file data. Kept between loadRegion() calls.
+        struct LoaderState;
+        std::unique_ptr<LoaderState> mpState;
     };
 }
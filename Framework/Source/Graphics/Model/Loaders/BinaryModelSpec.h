@@ -30,7 +30,7 @@
 //------------------------------------------------------------------------
 /*
 
-Binary scene file format v8
+Binary scene file format v12
 ---------------------------
 
 - The basic units of data are 32-bit little-endian ints and floats.
@@ -40,13 +40,25 @@ Binary scene file format v8
 - Each line describes: <ofs_dwords> <size_dwords> <Type> <version> <name> (<comments>)
 
 File
+0       2       string8 v9  formatID            ("BinScene")
+2       1       int     v9  formatVersion       (9 .. 12)
+3       1       int     v9  numTextures
+4       1       int     v9  numMeshes
+5       1       int     v9  numInstances
+6       1       int     v9  numChunks           (numTextures + numMeshes + 1. v10: numTextures + numMeshes + 2)
+7       n*10    array   v9  ChunkDesc           (numChunks)
+?       ?       bytes   v9  padding             (up to a multiple of 16 bytes)
+?       n*?     array   v9  chunk data          (each chunk starts at a multiple of 16 bytes, in the same order as the ChunkDescs)
+?
+
+File_v8
 0       2       string8 v6  formatID            ("BinScene")
-2       1       int     v6  formatVersion       (6)
+2       1       int     v6  formatVersion       (6 .. 8)
 3       1       int     v6  numTextures
 4       1       int     v6  numMeshes
 5       1       int     v6  numInstances
 6       n*?     array   v6  Texture             (numTextures)
-?       n*?     array   v6  Mesh                (numMeshes)
+?       n*?     array   v6  Mesh_v8             (numMeshes)
 ?       n*?     array   v6  Instance            (numInstances)
 ?
 
@@ -60,9 +72,35 @@ File_v5
 7       n*3     array   v1  AttribSpec          (numAttribs)
 ?       n*?     array   v1  Vertex              (numVertices)
 ?       n*?     array   v2  Texture             (numTextures)
-?       n*?     array   v1  Submesh             (numSubmeshes)
+?       n*?     array   v1  Submesh_v8          (numSubmeshes)
 ?
 
+ChunkDesc
+0       1       int     v9  type                (see ChunkType. The chunks are ordered: textures, meshes, instances, bounds)
+1       1       int     v9  compression         (see ChunkCompression)
+2       2       int64   v9  offset              (from the start of the file, multiple of 16)
+4       2       int64   v9  storedSize          (bytes stored in the file)
+6       2       int64   v9  size                (bytes after decompression)
+8       2       int64   v9  hash                (xxHash64 of the uncompressed chunk data)
+10
+
+Texture chunk
+0       ?       struct  v9  Texture
+
+Mesh chunk
+0       ?       struct  v9  Mesh
+
+Instance chunk
+0       n*?     array   v9  Instance            (numInstances)
+
+Bounds chunk
+0       n*6     array   v10 MeshBounds          (numMeshes)
+
+MeshBounds
+0       3       float   v10 min                 (object space, union of the submeshes' bounding-boxes)
+3       3       float   v10 max
+6
+
 Texture
 0       1       int     v2  idLength
 1       ?       string  v2  idString
@@ -70,22 +108,47 @@ Texture
 ?
 
 Mesh
+0       1       int     v9  numAttribs
+1       1       int     v9  numVertices
+2       1       int     v9  numSubmeshes
+3       n*?     array   v9  AttribSpec          (numAttribs. v9 .. v10: AttribSpec_v10)
+?       n*?     array   v9  Submesh             (numSubmeshes. 24 dwords each, v9 .. v11: 22 dwords)
+?       ?       bytes   v9  attribute streams, index arrays and LOD tables (located by AttribSpec::dataOffset, Submesh::indexOffset, Submesh::lodOffset and SubmeshLod::indexOffset)
+?
+
+Mesh_v8
 0       1       int     v6  numAttribs
 1       1       int     v6  numVertices
 2       1       int     v6  numSubmeshes
-3       n*3     array   v6  AttribSpec          (numAttribs)
+3       n*3     array   v6  AttribSpec_v8       (numAttribs)
 ?       n*?     array   v6  Vertex              (numVertices)
-?       n*?     array   v6  Submesh             (numSubmeshes)
+?       n*?     array   v6  Submesh_v8          (numSubmeshes)
 ?
 
 AttribSpec
 0       1       int     v1  Type                (see MeshBase::AttribType)
 1       1       int     v1  format              (see MeshBase::AttribFormat)
 2       1       int     v1  length
+3       1       int     v9  dataOffset          (from the start of the chunk, multiple of 16. numVertices * attribute size bytes, not interleaved)
+4       4       float   v11 offset              (S16N/U16N: value = offset + scale * x. Unused channels are 0)
+8       4       float   v11 scale               (S16N/U16N. Unused channels are 0)
+12
+
+AttribSpec_v10
+0       1       int     v1  Type                (see MeshBase::AttribType)
+1       1       int     v1  format              (see MeshBase::AttribFormat)
+2       1       int     v1  length
+3       1       int     v9  dataOffset
+4
+
+AttribSpec_v8
+0       1       int     v1  Type                (see MeshBase::AttribType)
+1       1       int     v1  format              (see MeshBase::AttribFormat)
+2       1       int     v1  length
 3
 
 Vertex
-0       ?       bytes   v1  vertex data         (dictated by the AttribSpecs)
+0       ?       bytes   v1  vertex data         (dictated by the AttribSpecs, interleaved)
 ?
 
 Submesh
@@ -95,14 +158,35 @@ Submesh
 10      1       float   v1  glossiness
 11      1       float   v3  displacementCoef
 12      1       float   v3  displacementBias
+13      7       int     v7  textures            (one per TextureType, -1 if none)
+20      1       int     v1  numTriangles
+21      1       int     v9  indexOffset         (from the start of the chunk, multiple of 16. numTriangles * 3 ints)
+22      1       int     v12 numLods             (simplified versions of the submesh, not including the full resolution one. 0 if none)
+23      1       int     v12 lodOffset           (from the start of the chunk, multiple of 16. An array of numLods SubmeshLods, ordered from the most detailed to the coarsest)
+24
+
+SubmeshLod
+0       1       float   v12 error               (approximation error in object-space units)
+1       1       int     v12 numTriangles
+2       1       int     v12 indexOffset         (from the start of the chunk, multiple of 16. numTriangles * 3 ints, referencing the mesh's vertices)
+3
+
+Submesh_v8
+0       3       float   v1  ambient             (ignored)
+3       4       float   v1  diffuse
+7       3       float   v1  specular
+10      1       float   v1  glossiness
+11      1       float   v3  displacementCoef
+12      1       float   v3  displacementBias
 13      1       int     v2  diffuseTexture      (-1 if none)
 14      1       int     v2  alphaTexture        (-1 if none)
 15      1       int     v3  displacementTexture (-1 if none)
 16      1       int     v4  normalTexture       (-1 if none)
 17      1       int     v4  environmentTexture  (-1 if none)
 18      1       int     v5  specularTexture     (-1 if none)
-19      1       int     v1  numTriangles
-20      n*3     int     v1  indices             (numTriangles * 3)
+19      1       int     v7  glossinessTexture   (-1 if none)
+20      1       int     v1  numTriangles
+21      n*3     int     v1  indices             (numTriangles * 3)
 ?
 
 Instance
@@ -134,11 +218,34 @@ enum AttribType // allows arbitrary values
     AttribType_Max
 };
 
+enum ChunkType
+{
+    ChunkType_Texture = 0,
+    ChunkType_Mesh,
+    ChunkType_Instances,
+    ChunkType_Bounds,           // v10
+
+    ChunkType_Max
+};
+
+enum ChunkCompression
+{
+    ChunkCompression_None = 0,
+    ChunkCompression_LZ4,       // LZ4 block format
+    ChunkCompression_Zstd,      // Reserved. Not supported by the loader.
+
+    ChunkCompression_Max
+};
+
 enum AttribFormat
 {
     AttribFormat_U8 = 0,
     AttribFormat_S32,
     AttribFormat_F32,
+    AttribFormat_F16,           // v11. Half floats
+    AttribFormat_S16N,          // v11. 16-bit signed normalized, decoded as offset + scale * x
+    AttribFormat_U16N,          // v11. 16-bit unsigned normalized, decoded as offset + scale * x
+    AttribFormat_Oct16,         // v11. Unit vector, octahedral-encoded as 2 x S16N. length is the decoded channel count (3)
 
     AttribFormat_Max
 };
@@ -154,3 +261,20 @@ enum TextureType
     TextureType_Glossiness,     // Glossiness map.
     TextureType_Max
 };
+
+struct ChunkDesc
+{
+    int32_t type;               // ChunkType
+    int32_t compression;        // ChunkCompression
+    uint64_t offset;
+    uint64_t storedSize;
+    uint64_t size;
+    uint64_t hash;
+};
+
+static const uint32_t kBinSceneChunkAlignment = 16;
+static const uint32_t kBinSceneMeshHeaderSize = 3 * sizeof(int32_t);        // numAttribs, numVertices, numSubmeshes
+static const uint32_t kBinSceneAttribSpecSize = 12 * sizeof(int32_t);       // AttribSpec
+static const uint32_t kBinSceneSubmeshSize = 24 * sizeof(int32_t);          // Submesh
+static const uint32_t kBinSceneSubmeshIndexOffset = 21 * sizeof(int32_t);   // Submesh::indexOffset
+static const uint32_t kBinSceneSubmeshLodSize = 3 * sizeof(int32_t);        // SubmeshLod
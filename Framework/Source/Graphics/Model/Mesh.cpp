@@ -88,10 +88,75 @@ namespace Falcor
         mHasBones = hasBones;
 
         mpVao = Vao::create(vertexBuffers, pIndexBuffer);
+
+        Lod lod0;
+        lod0.indexCount = indexCount;
+        mLods.push_back(lod0);
+    }
+
+    void Mesh::setLods(const std::vector<Lod>& lods)
+    {
+        mLods.resize(1);
+        mLods.insert(mLods.end(), lods.begin(), lods.end());
+    }
+
+    uint32_t Mesh::selectLod(const Lod* pLods, uint32_t lodCount, float worldScale, float distance, float projectionScale, float maxPixelError)
+    {
+        if(distance <= 0)
+        {
+            // The camera is inside the bounding-box
+            return 0;
+        }
+
+        // The LODs are ordered by increasing error, so pick the last one which is still accurate enough
+        float pixelsPerObjectUnit = worldScale * projectionScale / distance;
+        uint32_t selected = 0;
+        for(uint32_t lod = 1; lod < lodCount; lod++)
+        {
+            if(pLods[lod].error * pixelsPerObjectUnit > maxPixelError)
+            {
+                break;
+            }
+            selected = lod;
+        }
+        return selected;
+    }
+
+    float Mesh::calculateLodProjectionScale(float fovY, float viewportHeight)
+    {
+        return viewportHeight / (2 * tanf(fovY * 0.5f));
+    }
+
+    uint32_t Mesh::selectInstanceLod(uint32_t instanceID, const glm::mat4& transform, const glm::vec3& cameraPosition, float projectionScale, float maxPixelError) const
+    {
+        if(mLods.size() == 1)
+        {
+            return 0;
+        }
+
+        BoundingBox box = mInstanceBoundingBox[instanceID].transform(transform);
+        return selectLod(mLods.data(), (uint32_t)mLods.size(), box, transform * mInstanceMatrices[instanceID], cameraPosition, projectionScale, maxPixelError);
+    }
+
+    uint32_t Mesh::selectLod(const Lod* pLods, uint32_t lodCount, const BoundingBox& worldBox, const glm::mat4& world, const glm::vec3& cameraPosition, float projectionScale, float maxPixelError)
+    {
+        // The distance to the closest point of the bounding-box, so that large meshes don't lose detail near the camera
+        glm::vec3 delta = glm::max(glm::abs(cameraPosition - worldBox.center) - worldBox.extent, glm::vec3(0));
+        float distance = glm::length(delta);
+
+        // Use the largest scale of the transform's axes, so the error is never underestimated
+        float worldScale = std::max(glm::length(glm::vec3(world[0])), std::max(glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2]))));
+        return selectLod(pLods, lodCount, worldScale, distance, projectionScale, maxPixelError);
     }
 
     void Mesh::applyTransform(const glm::mat4& Transform) 
     {
+        if(hasCompressedVertices())
+        {
+            Logger::log(Logger::Level::Error, "Mesh::applyTransform() doesn't support meshes with compressed vertices. Load the model without Model::CompressVertices.");
+            return;
+        }
+
         // Transform geometry, keeping track of min/max
         glm::vec3 posMin(std::numeric_limits<float>::max(),std::numeric_limits<float>::max(),std::numeric_limits<float>::max());
         glm::vec3 posMax(std::numeric_limits<float>::min(),std::numeric_limits<float>::min(),std::numeric_limits<float>::min());
@@ -179,10 +244,12 @@ namespace Falcor
 
         // Update instances
         mInstanceBoundingBox.clear();
+        mInstanceBoundingBoxSoA.clear();
         for(auto const& matrix : mInstanceMatrices) 
         {
             BoundingBox box = mBoundingBox.transform(matrix);
             mInstanceBoundingBox.push_back(box);
+            mInstanceBoundingBoxSoA.push_back(box);
         }
     }
 
@@ -193,33 +260,27 @@ namespace Falcor
         mInstanceMatrices.push_back(transform);
         BoundingBox Bbox = mBoundingBox.transform(transform);
         mInstanceBoundingBox.push_back(Bbox);
+        mInstanceBoundingBoxSoA.push_back(Bbox);
     }
 
     void Mesh::deleteCulledInstances(const Camera* pCamera)
     {
-        const glm::mat4 zeroMat(0);
-        const BoundingBox zeroBbox = {glm::vec3(0, 0, 0), glm::vec3(0,0,0)};
+        std::vector<uint32_t> visible;
+        pCamera->cullBoundingBoxes(mInstanceBoundingBoxSoA, visible);
 
-        // Mark culled instances
-        for(uint32_t i = 0; i < mOriginalInstanceMatrices.size(); i++)
+        std::vector<glm::mat4> matrices;
+        matrices.reserve(visible.size());
+        mInstanceBoundingBoxSoA.clear();
+        for(uint32_t i = 0; i < (uint32_t)visible.size(); i++)
         {
-            if(pCamera->isObjectCulled(mInstanceBoundingBox[i]))
-            {
-                mInstanceBoundingBox[i] = zeroBbox;
-                mOriginalInstanceMatrices[i] = zeroMat;
-            }
+            matrices.push_back(mOriginalInstanceMatrices[visible[i]]);
+            mInstanceBoundingBox[i] = mInstanceBoundingBox[visible[i]];
+            mInstanceBoundingBoxSoA.push_back(mInstanceBoundingBox[i]);
         }
-
-        // Remove culled instances
-        auto matPred = [&zeroMat](glm::mat4& m) {return m == zeroMat; };
-        auto& matEnd = std::remove_if(mOriginalInstanceMatrices.begin(), mOriginalInstanceMatrices.end(), matPred);
-        mOriginalInstanceMatrices.erase(matEnd, mOriginalInstanceMatrices.end());
+        mInstanceBoundingBox.resize(visible.size());
+        mOriginalInstanceMatrices = matrices;
         mInstanceMatrices = mOriginalInstanceMatrices;
 
-        auto boxPred = [&zeroBbox](BoundingBox& b) {return b == zeroBbox; };
-        auto& boxEnd = std::remove_if(mInstanceBoundingBox.begin(), mInstanceBoundingBox.end(), boxPred);
-        mInstanceBoundingBox.erase(boxEnd, mInstanceBoundingBox.end());
-
         assert(mInstanceBoundingBox.size() == mInstanceMatrices.size());
     }
 
@@ -56,6 +56,27 @@ namespace Falcor
         using SharedPtr = std::shared_ptr<Mesh>;
         using SharedConstPtr = std::shared_ptr<const Mesh>;
 
+        /** A level of detail. All the LODs share the mesh's vertex buffers, and each LOD is a range in the mesh's index buffer.
+            LOD 0 is the full resolution mesh.
+        */
+        struct Lod
+        {
+            uint32_t firstIndex = 0;    ///< The location of the LOD's first index in the index buffer
+            uint32_t indexCount = 0;    ///< The number of indices to draw
+            float error = 0;            ///< The approximation error in object-space units
+        };
+
+        /** Describes how the vertex attributes are stored in the vertex buffers. The default values describe float vertices.
+            See Model::CompressVertices.
+        */
+        struct VertexEncoding
+        {
+            bool compressedPositions = false;           ///< Positions are stored as RGBA16Unorm values, relative to positionOffset and positionScale
+            glm::vec3 positionOffset = glm::vec3(0);    ///< The object-space position is positionOffset + positionScale * stored position
+            glm::vec3 positionScale = glm::vec3(1);
+            uint32_t octahedralAttribs = 0;             ///< Bit mask of the shader locations (1 << VERTEX_NORMAL_LOC etc.) whose unit vectors are octahedral-encoded as RG16Snorm values
+        };
+
         /** create a new mesh
             \param[in] VertexBuffers Vector of vertex buffer descriptors
             \param[in] VertexCount Number of vertices in the vertex buffer
@@ -93,10 +114,56 @@ namespace Falcor
         /** Get the number of primitives.
         */
         uint32_t getPrimitiveCount() const { return mPrimitiveCount; }
-        /** Get the number of indices in the index buffer. Use this value when drawing the mesh.
+        /** Get the number of indices of the full resolution mesh. Use this value when drawing the mesh without LODs.
         */
         uint32_t getIndexCount() const { return mIndexCount; }
 
+        /** Get the number of LODs, including the full resolution mesh. Always at least 1.
+        */
+        uint32_t getLodCount() const { return (uint32_t)mLods.size(); }
+
+        /** Get a LOD. LOD 0 is the full resolution mesh, higher LODs are coarser.
+        */
+        const Lod& getLod(uint32_t lod) const { return mLods[lod]; }
+
+        /** Select the coarsest LOD whose error, projected onto the screen, doesn't exceed a threshold.
+            This only depends on its arguments, so it can be used on the CPU without a rendering context.
+            \param[in] pLods The LODs, ordered from the full resolution mesh to the coarsest
+            \param[in] lodCount The number of LODs
+            \param[in] worldScale The scale of the instance transform. Converts the LODs' object-space errors to world space.
+            \param[in] distance The distance between the camera and the instance's bounding-box, in world space
+            \param[in] projectionScale The number of pixels covered by a world-space unit at a distance of 1. See calculateLodProjectionScale().
+            \param[in] maxPixelError The largest allowed error, in pixels
+            \return The index of the selected LOD
+        */
+        static uint32_t selectLod(const Lod* pLods, uint32_t lodCount, float worldScale, float distance, float projectionScale, float maxPixelError);
+
+        /** Calculate the projectionScale argument of selectLod() for a perspective camera
+            \param[in] fovY The vertical field-of-view, in radians
+            \param[in] viewportHeight The height of the render-target, in pixels
+        */
+        static float calculateLodProjectionScale(float fovY, float viewportHeight);
+
+        /** Select the LOD of an instance from its world-space bounding-box and transform. Like selectLod(), this can be used without a rendering context.
+            \param[in] pLods The LODs, ordered from the full resolution mesh to the coarsest
+            \param[in] lodCount The number of LODs
+            \param[in] worldBox The instance's bounding-box in world space
+            \param[in] world The instance's object-to-world transform
+            \param[in] cameraPosition The camera position in world space
+            \param[in] projectionScale See calculateLodProjectionScale()
+            \param[in] maxPixelError The largest allowed error, in pixels
+        */
+        static uint32_t selectLod(const Lod* pLods, uint32_t lodCount, const BoundingBox& worldBox, const glm::mat4& world, const glm::vec3& cameraPosition, float projectionScale, float maxPixelError);
+
+        /** Select the LOD of one of the instances
+            \param[in] instanceID The instance
+            \param[in] transform An additional transform applied to the instance, like the model instance's transform
+            \param[in] cameraPosition The camera position in world space
+            \param[in] projectionScale See calculateLodProjectionScale()
+            \param[in] maxPixelError The largest allowed error, in pixels
+        */
+        uint32_t selectInstanceLod(uint32_t instanceID, const glm::mat4& transform, const glm::vec3& cameraPosition, float projectionScale, float maxPixelError) const;
+
         /** Get a pointer to the mesh's material
         */
         const Material::SharedPtr& getMaterial() const { return mpMaterial; }
@@ -117,6 +184,14 @@ namespace Falcor
         */
         const Vao::SharedPtr getVao() const { return mpVao; }
 
+        /** Get the encoding of the vertex attributes. The vertex shader uses it to decode compressed vertices.
+        */
+        const VertexEncoding& getVertexEncoding() const { return mVertexEncoding; }
+
+        /** Check if some of the vertex attributes aren't stored as floats. Code which reads the vertex buffers on the CPU or in a compute API has to decode them, or doesn't support these meshes.
+        */
+        bool hasCompressedVertices() const { return mVertexEncoding.compressedPositions || (mVertexEncoding.octahedralAttribs != 0); }
+
         /** Get the number of instance
         */
         uint32_t getInstanceCount() const { return (uint32_t)mInstanceMatrices.size(); }
@@ -133,6 +208,10 @@ namespace Falcor
         */
         const BoundingBox& getInstanceBoundingBox(uint32_t instanceID) const { return mInstanceBoundingBox[instanceID]; }
 
+        /** Get the bounding-boxes of all the instances, in structure-of-arrays layout for batched culling
+        */
+        const BoundingBoxSoA& getInstanceBoundingBoxes() const { return mInstanceBoundingBoxSoA; }
+
         /** Get a pointer to the instance matrices array. Can be used to set a batch of instances at ones.
         */
         const glm::mat4* getInstanceMatrices() const {  return mInstanceMatrices.data(); }
@@ -155,6 +234,15 @@ namespace Falcor
         friend BinaryModelImporter;
         friend SimpleModelImporter;
         void addInstance(const glm::mat4& transform);
+
+        /** Set the LODs stored in the index buffer after the full resolution mesh. LOD 0 is always created by the constructor.
+        */
+        void setLods(const std::vector<Lod>& lods);
+
+        /** Set the encoding of the vertex buffers passed to create()
+        */
+        void setVertexEncoding(const VertexEncoding& encoding) { mVertexEncoding = encoding; }
+
         static const uint32_t kMaxBonesPerVertex = 4;              ///> Max supported bones per vertex
 
     private:
@@ -177,11 +265,14 @@ namespace Falcor
         Material::SharedPtr mpMaterial;
         RenderContext::Topology mTopology;
         BoundingBox mBoundingBox;
+        std::vector<Lod> mLods;
+        VertexEncoding mVertexEncoding;
 
         Vao::SharedPtr mpVao;
         std::vector<glm::mat4> mInstanceMatrices;
         std::vector<glm::mat4> mOriginalInstanceMatrices;
         bool mDirty = true;
         std::vector<BoundingBox> mInstanceBoundingBox;
+        BoundingBoxSoA mInstanceBoundingBoxSoA;     // Same as mInstanceBoundingBox
     };
 }
\ No newline at end of file
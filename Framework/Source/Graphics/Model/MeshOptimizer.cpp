@@ -0,0 +1,448 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "glm/vec3.hpp"
+#include "glm/geometric.hpp"
+
+namespace Falcor
+{
+    static const uint32_t kInvalidIndex = uint32_t(-1);
+
+    // Forsyth's scoring constants. The scoring cache is larger than the simulated FIFO cache, as recommended in the paper.
+    // See https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+    static const uint32_t kScoringCacheSize = 32;
+    static const float kCacheDecayPower = 1.5f;
+    static const float kLastTriangleScore = 0.75f;
+    static const float kValenceBoostScale = 2.0f;
+    static const float kValenceBoostPower = 0.5f;
+
+    static float calculateVertexScore(int32_t cachePosition, uint32_t liveTriangles)
+    {
+        if(liveTriangles == 0)
+        {
+            // No triangles left to use this vertex
+            return -1.0f;
+        }
+
+        float score = 0;
+        if(cachePosition >= 0)
+        {
+            if(cachePosition < 3)
+            {
+                // The vertex was used by the last triangle. Its score is fixed, to avoid favoring one of the last triangle's edges
+                score = kLastTriangleScore;
+            }
+            else
+            {
+                float scaler = 1.0f / float(kScoringCacheSize - 3);
+                score = std::pow(1.0f - float(cachePosition - 3) * scaler, kCacheDecayPower);
+            }
+        }
+
+        // Boost vertices with few triangles left, so that they are finished and don't remain as lone triangles at the end
+        score += kValenceBoostScale * std::pow(float(liveTriangles), -kValenceBoostPower);
+        return score;
+    }
+
+    /** Simulates a FIFO cache. A vertex is in the cache if less than cacheSize misses happened since it was last loaded.
+    */
+    class FifoCache
+    {
+    public:
+        FifoCache(uint32_t vertexCount, uint32_t cacheSize) : mTimestamps(vertexCount, 0), mCacheSize(cacheSize), mTime(cacheSize + 1) {}
+
+        /** Returns 1 on a cache miss, otherwise 0
+        */
+        uint32_t access(uint32_t vertex)
+        {
+            if(mTime - mTimestamps[vertex] > mCacheSize)
+            {
+                mTimestamps[vertex] = mTime++;
+                return 1;
+            }
+            return 0;
+        }
+
+        void flush()
+        {
+            mTime += mCacheSize + 1;
+        }
+
+    private:
+        std::vector<uint32_t> mTimestamps;
+        uint32_t mCacheSize;
+        uint32_t mTime;
+    };
+
+    VertexCacheStats analyzeVertexCache(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize)
+    {
+        VertexCacheStats stats;
+        if(indexCount < 3)
+        {
+            return stats;
+        }
+
+        FifoCache cache(vertexCount, cacheSize);
+        std::vector<bool> isReferenced(vertexCount, false);
+        uint32_t misses = 0;
+        uint32_t referencedCount = 0;
+        for(uint32_t i = 0; i < indexCount; i++)
+        {
+            uint32_t v = indices[i];
+            assert(v < vertexCount);
+            misses += cache.access(v);
+            if(isReferenced[v] == false)
+            {
+                isReferenced[v] = true;
+                referencedCount++;
+            }
+        }
+
+        stats.acmr = float(misses) / float(indexCount / 3);
+        stats.atvr = float(misses) / float(referencedCount);
+        return stats;
+    }
+
+    void optimizeVertexCache(uint32_t* destination, const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount)
+    {
+        assert(destination != indices);
+        uint32_t triangleCount = indexCount / 3;
+        if(triangleCount == 0)
+        {
+            return;
+        }
+
+        // Build the vertex-to-triangle adjacency. For every vertex, the triangles not emitted yet are kept at the beginning of its list.
+        std::vector<uint32_t> liveTriangles(vertexCount, 0);
+        for(uint32_t i = 0; i < triangleCount * 3; i++)
+        {
+            assert(indices[i] < vertexCount);
+            liveTriangles[indices[i]]++;
+        }
+
+        std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+        for(uint32_t v = 0; v < vertexCount; v++)
+        {
+            adjacencyOffset[v + 1] = adjacencyOffset[v] + liveTriangles[v];
+        }
+
+        std::vector<uint32_t> adjacency(triangleCount * 3);
+        {
+            std::vector<uint32_t> fillCount(vertexCount, 0);
+            for(uint32_t i = 0; i < triangleCount * 3; i++)
+            {
+                uint32_t v = indices[i];
+                adjacency[adjacencyOffset[v] + fillCount[v]++] = i / 3;
+            }
+        }
+
+        // Initial scores
+        std::vector<int32_t> cachePosition(vertexCount, -1);
+        std::vector<float> vertexScore(vertexCount);
+        for(uint32_t v = 0; v < vertexCount; v++)
+        {
+            vertexScore[v] = calculateVertexScore(-1, liveTriangles[v]);
+        }
+
+        std::vector<float> triangleScore(triangleCount);
+        std::vector<bool> isEmitted(triangleCount, false);
+        uint32_t bestTriangle = kInvalidIndex;
+        float bestScore = -1;
+        for(uint32_t t = 0; t < triangleCount; t++)
+        {
+            const uint32_t* tri = indices + t * 3;
+            triangleScore[t] = vertexScore[tri[0]] + vertexScore[tri[1]] + vertexScore[tri[2]];
+            if(triangleScore[t] > bestScore)
+            {
+                bestScore = triangleScore[t];
+                bestTriangle = t;
+            }
+        }
+
+        std::vector<uint32_t> cache;
+        std::vector<uint32_t> newCache;
+        cache.reserve(kScoringCacheSize + 3);
+        newCache.reserve(kScoringCacheSize + 3);
+        uint32_t inputCursor = 0;
+
+        for(uint32_t output = 0; output < triangleCount; output++)
+        {
+            if(bestTriangle == kInvalidIndex)
+            {
+                // None of the cached vertices has triangles left. Continue with the next triangle in the input order.
+                while(isEmitted[inputCursor])
+                {
+                    inputCursor++;
+                }
+                bestTriangle = inputCursor;
+            }
+
+            const uint32_t* tri = indices + bestTriangle * 3;
+            destination[output * 3 + 0] = tri[0];
+            destination[output * 3 + 1] = tri[1];
+            destination[output * 3 + 2] = tri[2];
+            isEmitted[bestTriangle] = true;
+
+            // Remove the triangle from the adjacency lists of its vertices
+            for(uint32_t i = 0; i < 3; i++)
+            {
+                uint32_t v = tri[i];
+                uint32_t* pList = adjacency.data() + adjacencyOffset[v];
+                uint32_t count = liveTriangles[v];
+                for(uint32_t j = 0; j < count; j++)
+                {
+                    if(pList[j] == bestTriangle)
+                    {
+                        std::swap(pList[j], pList[count - 1]);
+                        break;
+                    }
+                }
+                liveTriangles[v]--;
+            }
+
+            // Move the triangle's vertices to the front of the LRU cache
+            newCache.clear();
+            newCache.push_back(tri[0]);
+            newCache.push_back(tri[1]);
+            newCache.push_back(tri[2]);
+            for(uint32_t v : cache)
+            {
+                if(v != tri[0] && v != tri[1] && v != tri[2])
+                {
+                    newCache.push_back(v);
+                }
+            }
+
+            // Update the scores of the vertices in the cache, including the ones that were just evicted
+            for(uint32_t i = 0; i < newCache.size(); i++)
+            {
+                uint32_t v = newCache[i];
+                cachePosition[v] = (i < kScoringCacheSize) ? int32_t(i) : -1;
+                vertexScore[v] = calculateVertexScore(cachePosition[v], liveTriangles[v]);
+            }
+
+            // Update the scores of the triangles touching these vertices and find the next best triangle
+            bestTriangle = kInvalidIndex;
+            bestScore = -1;
+            for(uint32_t v : newCache)
+            {
+                const uint32_t* pList = adjacency.data() + adjacencyOffset[v];
+                for(uint32_t j = 0; j < liveTriangles[v]; j++)
+                {
+                    uint32_t t = pList[j];
+                    const uint32_t* adjacentTri = indices + t * 3;
+                    triangleScore[t] = vertexScore[adjacentTri[0]] + vertexScore[adjacentTri[1]] + vertexScore[adjacentTri[2]];
+                    if(triangleScore[t] > bestScore || (triangleScore[t] == bestScore && t < bestTriangle))
+                    {
+                        bestScore = triangleScore[t];
+                        bestTriangle = t;
+                    }
+                }
+            }
+
+            if(newCache.size() > kScoringCacheSize)
+            {
+                newCache.resize(kScoringCacheSize);
+            }
+            cache.swap(newCache);
+        }
+    }
+
+    void optimizeOverdraw(uint32_t* destination, const uint32_t* indices, uint32_t indexCount, const void* pPositions, uint32_t positionStride, uint32_t vertexCount, float threshold)
+    {
+        assert(destination != indices);
+        uint32_t triangleCount = indexCount / 3;
+        if(triangleCount == 0)
+        {
+            return;
+        }
+
+        auto getPosition = [pPositions, positionStride](uint32_t v)
+        {
+            const float* p = (const float*)((const uint8_t*)pPositions + size_t(positionStride) * v);
+            return glm::vec3(p[0], p[1], p[2]);
+        };
+
+        // Hard boundaries - triangles which miss the cache on all 3 vertices. The order before such a triangle doesn't affect the cache efficiency after it.
+        std::vector<uint32_t> hardClusters;
+        {
+            FifoCache cache(vertexCount, kVertexCacheSize);
+            for(uint32_t t = 0; t < triangleCount; t++)
+            {
+                uint32_t misses = cache.access(indices[t * 3 + 0]) + cache.access(indices[t * 3 + 1]) + cache.access(indices[t * 3 + 2]);
+                if(t == 0 || misses == 3)
+                {
+                    hardClusters.push_back(t);
+                }
+            }
+        }
+        hardClusters.push_back(triangleCount);
+
+        // Soft boundaries - split the hard clusters further once the ACMR of the current piece is close to the cluster's ACMR
+        std::vector<uint32_t> clusters;
+        {
+            FifoCache cache(vertexCount, kVertexCacheSize);
+            for(size_t c = 0; c + 1 < hardClusters.size(); c++)
+            {
+                uint32_t start = hardClusters[c];
+                uint32_t end = hardClusters[c + 1];
+
+                cache.flush();
+                uint32_t clusterMisses = 0;
+                for(uint32_t i = start * 3; i < end * 3; i++)
+                {
+                    clusterMisses += cache.access(indices[i]);
+                }
+                float clusterAcmr = float(clusterMisses) / float(end - start);
+
+                cache.flush();
+                clusters.push_back(start);
+                uint32_t pieceStart = start;
+                uint32_t pieceMisses = 0;
+                for(uint32_t t = start; t < end; t++)
+                {
+                    pieceMisses += cache.access(indices[t * 3 + 0]) + cache.access(indices[t * 3 + 1]) + cache.access(indices[t * 3 + 2]);
+                    float pieceAcmr = float(pieceMisses) / float(t + 1 - pieceStart);
+                    if(t + 1 < end && pieceAcmr <= clusterAcmr * threshold)
+                    {
+                        clusters.push_back(t + 1);
+                        pieceStart = t + 1;
+                        pieceMisses = 0;
+                        cache.flush();
+                    }
+                }
+            }
+        }
+        clusters.push_back(triangleCount);
+
+        // Calculate the area-weighted centroid of the mesh and the area-weighted centroid and normal of every cluster
+        struct ClusterInfo
+        {
+            uint32_t start;
+            uint32_t end;
+            glm::vec3 centroid;
+            glm::vec3 normal;
+            float sortKey;
+        };
+
+        std::vector<ClusterInfo> clusterInfo(clusters.size() - 1);
+        glm::vec3 meshCentroid(0, 0, 0);
+        float meshArea = 0;
+        for(size_t c = 0; c < clusterInfo.size(); c++)
+        {
+            ClusterInfo& info = clusterInfo[c];
+            info.start = clusters[c];
+            info.end = clusters[c + 1];
+
+            glm::vec3 centroid(0, 0, 0);
+            glm::vec3 normal(0, 0, 0);
+            float area = 0;
+            for(uint32_t t = info.start; t < info.end; t++)
+            {
+                glm::vec3 p0 = getPosition(indices[t * 3 + 0]);
+                glm::vec3 p1 = getPosition(indices[t * 3 + 1]);
+                glm::vec3 p2 = getPosition(indices[t * 3 + 2]);
+                glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+                float triangleArea = glm::length(n);
+
+                centroid += (p0 + p1 + p2) * (triangleArea / 3.0f);
+                normal += n;
+                area += triangleArea;
+            }
+
+            meshCentroid += centroid;
+            meshArea += area;
+            info.centroid = (area > 0) ? centroid / area : centroid;
+            float normalLength = glm::length(normal);
+            info.normal = (normalLength > 0) ? normal / normalLength : normal;
+        }
+        meshCentroid = (meshArea > 0) ? meshCentroid / meshArea : meshCentroid;
+
+        // Draw the clusters facing away from the center first. They are more likely to occlude the rest of the mesh.
+        for(auto& info : clusterInfo)
+        {
+            info.sortKey = glm::dot(info.centroid - meshCentroid, info.normal);
+        }
+        std::stable_sort(clusterInfo.begin(), clusterInfo.end(), [](const ClusterInfo& a, const ClusterInfo& b) { return a.sortKey > b.sortKey; });
+
+        uint32_t output = 0;
+        for(const auto& info : clusterInfo)
+        {
+            size_t count = (info.end - info.start) * 3;
+            std::memcpy(destination + output, indices + info.start * 3, count * sizeof(uint32_t));
+            output += uint32_t(count);
+        }
+    }
+
+    void optimizeVertexFetchRemap(uint32_t* remap, const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount)
+    {
+        std::fill(remap, remap + vertexCount, kInvalidIndex);
+
+        uint32_t next = 0;
+        for(uint32_t i = 0; i < indexCount; i++)
+        {
+            uint32_t v = indices[i];
+            assert(v < vertexCount);
+            if(remap[v] == kInvalidIndex)
+            {
+                remap[v] = next++;
+            }
+        }
+
+        for(uint32_t v = 0; v < vertexCount; v++)
+        {
+            if(remap[v] == kInvalidIndex)
+            {
+                remap[v] = next++;
+            }
+        }
+    }
+
+    void remapIndexBuffer(uint32_t* indices, uint32_t indexCount, const uint32_t* remap)
+    {
+        for(uint32_t i = 0; i < indexCount; i++)
+        {
+            indices[i] = remap[indices[i]];
+        }
+    }
+
+    void remapVertexBuffer(void* pDestination, const void* pVertices, uint32_t vertexCount, uint32_t vertexStride, const uint32_t* remap)
+    {
+        assert(pDestination != pVertices);
+        const uint8_t* pSrc = (const uint8_t*)pVertices;
+        uint8_t* pDst = (uint8_t*)pDestination;
+        for(uint32_t v = 0; v < vertexCount; v++)
+        {
+            std::memcpy(pDst + size_t(remap[v]) * vertexStride, pSrc + size_t(v) * vertexStride, vertexStride);
+        }
+    }
+}
@@ -0,0 +1,97 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+namespace Falcor
+{
+    /** CPU optimization passes for indexed triangle lists.
+        The passes don't use the GPU or any global state, and produce the same output for the same input, so they can run on loader threads or offline.
+    */
+
+    /** Size of the FIFO post-transform cache used by the optimizer and the statistics
+    */
+    static const uint32_t kVertexCacheSize = 16;
+
+    struct VertexCacheStats
+    {
+        float acmr = 0;         ///< Average cache miss ratio - transformed vertices per triangle. 0.5 is the optimum for regular grids, 3 is the worst case.
+        float atvr = 0;         ///< Average transformed vertex ratio - transformed vertices per referenced vertex. 1 is the optimum.
+    };
+
+    /** Simulate a FIFO post-transform cache
+        \param[in] indices The triangle list
+        \param[in] indexCount The number of indices
+        \param[in] vertexCount The number of vertices in the vertex buffer
+        \param[in] cacheSize The number of entries in the simulated cache
+    */
+    VertexCacheStats analyzeVertexCache(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize = kVertexCacheSize);
+
+    /** Reorder triangles to improve the post-transform cache hit-rate, using Tom Forsyth's linear-speed vertex cache optimization.
+        \param[out] destination Receives the reordered indices. Can't be the same array as 'indices'.
+        \param[in] indices The triangle list
+        \param[in] indexCount The number of indices
+        \param[in] vertexCount The number of vertices in the vertex buffer
+    */
+    void optimizeVertexCache(uint32_t* destination, const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount);
+
+    /** Reorder clusters of a cache-optimized triangle list to reduce overdraw. The list is split into clusters where the simulated cache is flushed, and the clusters facing away from the mesh center are drawn first.
+        Triangles are never reordered inside a cluster, so the cache efficiency is at most 'threshold' times worse than the input.
+        \param[out] destination Receives the reordered indices. Can't be the same array as 'indices'.
+        \param[in] indices A cache-optimized triangle list
+        \param[in] indexCount The number of indices
+        \param[in] pPositions The first vertex position. Positions are read as 3 floats.
+        \param[in] positionStride The distance in bytes between consecutive positions
+        \param[in] vertexCount The number of vertices in the vertex buffer
+        \param[in] threshold The allowed ACMR degradation. Clusters are only split further while their ACMR is within this factor of the input's ACMR.
+    */
+    void optimizeOverdraw(uint32_t* destination, const uint32_t* indices, uint32_t indexCount, const void* pPositions, uint32_t positionStride, uint32_t vertexCount, float threshold = 1.05f);
+
+    /** Create a vertex remap table which orders the vertices by their first use in the index list, to improve the vertex fetch locality.
+        Vertices which are not referenced keep their relative order and are moved to the end, so the vertex count doesn't change.
+        \param[out] remap Receives the new location of every vertex. Must have room for vertexCount entries.
+        \param[in] indices The triangle list. Can be the concatenation of several lists sharing the same vertices.
+        \param[in] indexCount The number of indices
+        \param[in] vertexCount The number of vertices in the vertex buffer
+    */
+    void optimizeVertexFetchRemap(uint32_t* remap, const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount);
+
+    /** Apply a remap table created by optimizeVertexFetchRemap() to an index list, in place
+    */
+    void remapIndexBuffer(uint32_t* indices, uint32_t indexCount, const uint32_t* remap);
+
+    /** Apply a remap table created by optimizeVertexFetchRemap() to a vertex buffer
+        \param[out] pDestination Receives the reordered vertices. Can't be the same buffer as 'pVertices'.
+        \param[in] pVertices The vertices
+        \param[in] vertexCount The number of vertices
+        \param[in] vertexStride The size of a vertex in bytes
+        \param[in] remap The remap table
+    */
+    void remapVertexBuffer(void* pDestination, const void* pVertices, uint32_t vertexCount, uint32_t vertexStride, const uint32_t* remap);
+}
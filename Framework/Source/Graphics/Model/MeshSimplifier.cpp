@@ -0,0 +1,549 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cmath>
+#include "glm/vec3.hpp"
+#include "glm/geometric.hpp"
+
+namespace Falcor
+{
+    static const uint32_t kInvalidIndex = uint32_t(-1);
+
+    // Border edges get a constraint plane perpendicular to the surface, scaled by the edge's squared length. The large weight keeps the border in place.
+    static const double kBorderWeight = 10.0;
+
+    // Collapses which rotate a triangle's normal by more than ~78 degrees are rejected, since they fold the surface
+    static const float kMinNormalCos = 0.2f;
+
+    // A LOD is only added to the chain if it removes at least this fraction of the previous LOD's triangles
+    static const float kMinLodReduction = 0.1f;
+
+    /** Symmetric 4x4 matrix measuring the weighted sum of squared distances to a set of planes
+    */
+    struct Quadric
+    {
+        double a00 = 0, a11 = 0, a22 = 0, a01 = 0, a02 = 0, a12 = 0;
+        double b0 = 0, b1 = 0, b2 = 0;
+        double c = 0;
+        double weight = 0;
+
+        /** Add the plane dot(n, p) + d = 0. n must be normalized.
+        */
+        void addPlane(const glm::dvec3& n, double d, double w)
+        {
+            a00 += w * n.x * n.x;
+            a11 += w * n.y * n.y;
+            a22 += w * n.z * n.z;
+            a01 += w * n.x * n.y;
+            a02 += w * n.x * n.z;
+            a12 += w * n.y * n.z;
+            b0 += w * n.x * d;
+            b1 += w * n.y * d;
+            b2 += w * n.z * d;
+            c += w * d * d;
+            weight += w;
+        }
+
+        void add(const Quadric& q)
+        {
+            a00 += q.a00; a11 += q.a11; a22 += q.a22;
+            a01 += q.a01; a02 += q.a02; a12 += q.a12;
+            b0 += q.b0; b1 += q.b1; b2 += q.b2;
+            c += q.c;
+            weight += q.weight;
+        }
+
+        /** Get the weighted sum of squared distances from p to the planes
+        */
+        double evaluate(const glm::dvec3& p) const
+        {
+            double r = a00 * p.x * p.x + a11 * p.y * p.y + a22 * p.z * p.z;
+            r += 2 * (a01 * p.x * p.y + a02 * p.x * p.z + a12 * p.y * p.z);
+            r += 2 * (b0 * p.x + b1 * p.y + b2 * p.z);
+            r += c;
+            return std::max(r, 0.0);
+        }
+    };
+
+    static uint64_t makeEdgeKey(uint32_t a, uint32_t b)
+    {
+        return (a < b) ? ((uint64_t(a) << 32) | b) : ((uint64_t(b) << 32) | a);
+    }
+
+    /** Half-edge collapse simplifier. Keeps its state between simplify() calls, so a LOD chain can be created in a single run.
+    */
+    class Simplifier
+    {
+    public:
+        Simplifier(const uint32_t* indices, uint32_t indexCount, const void* pPositions, uint32_t positionStride, uint32_t vertexCount);
+
+        /** Collapse edges until the index count or the error reaches the limits, or until no edge can be collapsed
+        */
+        void simplify(uint32_t targetIndexCount, float maxError);
+
+        const std::vector<uint32_t>& getIndices() const { return mIndices; }
+        float getError() const { return (float)std::sqrt(mMaxCost); }
+
+    private:
+        enum class VertexKind : uint8_t
+        {
+            Manifold,   // Can collapse along any edge
+            Border,     // Can only collapse along a border edge
+            Locked,     // Can't be removed. Seams, non-manifold vertices and complex borders.
+        };
+
+        struct Collapse
+        {
+            uint32_t vertex;
+            uint32_t target;
+            double cost;
+
+            bool operator<(const Collapse& other) const
+            {
+                if(cost != other.cost) return cost < other.cost;
+                if(vertex != other.vertex) return vertex < other.vertex;
+                return target < other.target;
+            }
+        };
+
+        void findCanonicalVertices();
+        void initQuadrics();
+        void classifyVertices(std::vector<uint64_t>& borderEdges);
+        void buildAdjacency();
+        bool isFolding(uint32_t vertex, uint32_t target) const;
+        uint32_t performPass(uint32_t targetIndexCount, double maxCost);
+        void removeDegenerateTriangles();
+
+        std::vector<uint32_t> mIndices;
+        std::vector<glm::vec3> mPositions;
+        std::vector<uint32_t> mCanonical;       // The lowest index of a vertex with the same position
+        std::vector<bool> mIsSeam;              // The position is shared by several vertices
+        std::vector<Quadric> mQuadrics;         // Indexed by canonical vertex
+        std::vector<VertexKind> mKinds;         // Indexed by canonical vertex
+        std::vector<uint32_t> mTriangleOffsets; // Vertex to triangles adjacency
+        std::vector<uint32_t> mTriangles;
+        double mMaxCost = 0;
+    };
+
+    Simplifier::Simplifier(const uint32_t* indices, uint32_t indexCount, const void* pPositions, uint32_t positionStride, uint32_t vertexCount) : mIndices(indices, indices + indexCount - indexCount % 3)
+    {
+        mPositions.resize(vertexCount);
+        for(uint32_t i = 0; i < vertexCount; i++)
+        {
+            const float* pPos = (const float*)((const uint8_t*)pPositions + size_t(positionStride) * i);
+            mPositions[i] = glm::vec3(pPos[0], pPos[1], pPos[2]);
+        }
+
+        findCanonicalVertices();
+        removeDegenerateTriangles();
+        initQuadrics();
+    }
+
+    void Simplifier::findCanonicalVertices()
+    {
+        const uint32_t vertexCount = (uint32_t)mPositions.size();
+        std::vector<uint32_t> order(vertexCount);
+        for(uint32_t i = 0; i < vertexCount; i++)
+        {
+            order[i] = i;
+        }
+
+        // Sorting is stable with respect to the vertex index, so the first vertex of each group is the canonical one
+        const auto& positions = mPositions;
+        std::sort(order.begin(), order.end(), [&positions](uint32_t a, uint32_t b)
+        {
+            const glm::vec3& pa = positions[a];
+            const glm::vec3& pb = positions[b];
+            if(pa.x != pb.x) return pa.x < pb.x;
+            if(pa.y != pb.y) return pa.y < pb.y;
+            if(pa.z != pb.z) return pa.z < pb.z;
+            return a < b;
+        });
+
+        mCanonical.resize(vertexCount);
+        mIsSeam.assign(vertexCount, false);
+        for(uint32_t i = 0; i < vertexCount;)
+        {
+            uint32_t groupEnd = i + 1;
+            while(groupEnd < vertexCount && mPositions[order[groupEnd]] == mPositions[order[i]])
+            {
+                groupEnd++;
+            }
+
+            for(uint32_t j = i; j < groupEnd; j++)
+            {
+                mCanonical[order[j]] = order[i];
+                mIsSeam[order[j]] = (groupEnd - i > 1);
+            }
+            i = groupEnd;
+        }
+    }
+
+    void Simplifier::initQuadrics()
+    {
+        mQuadrics.assign(mPositions.size(), Quadric());
+        std::vector<uint64_t> edges;
+        edges.reserve(mIndices.size());
+
+        for(size_t i = 0; i < mIndices.size(); i += 3)
+        {
+            uint32_t v[3] = {mCanonical[mIndices[i]], mCanonical[mIndices[i + 1]], mCanonical[mIndices[i + 2]]};
+            glm::dvec3 p0(mPositions[v[0]]);
+            glm::dvec3 n = glm::cross(glm::dvec3(mPositions[v[1]]) - p0, glm::dvec3(mPositions[v[2]]) - p0);
+            double length = glm::length(n);
+            if(length > 0)
+            {
+                n /= length;
+                double d = -glm::dot(n, p0);
+                for(uint32_t j = 0; j < 3; j++)
+                {
+                    mQuadrics[v[j]].addPlane(n, d, length * 0.5);
+                }
+            }
+
+            for(uint32_t j = 0; j < 3; j++)
+            {
+                edges.push_back(makeEdgeKey(v[j], v[(j + 1) % 3]));
+            }
+        }
+
+        // Border edges are the ones used by a single triangle. Add a plane perpendicular to the triangle through the edge, so that the border doesn't shrink.
+        std::sort(edges.begin(), edges.end());
+        for(size_t i = 0; i < mIndices.size(); i += 3)
+        {
+            uint32_t v[3] = {mCanonical[mIndices[i]], mCanonical[mIndices[i + 1]], mCanonical[mIndices[i + 2]]};
+            glm::dvec3 p0(mPositions[v[0]]);
+            glm::dvec3 n = glm::cross(glm::dvec3(mPositions[v[1]]) - p0, glm::dvec3(mPositions[v[2]]) - p0);
+            for(uint32_t j = 0; j < 3; j++)
+            {
+                uint64_t key = makeEdgeKey(v[j], v[(j + 1) % 3]);
+                auto range = std::equal_range(edges.begin(), edges.end(), key);
+                if(range.second - range.first == 1)
+                {
+                    glm::dvec3 a(mPositions[v[j]]);
+                    glm::dvec3 edge = glm::dvec3(mPositions[v[(j + 1) % 3]]) - a;
+                    glm::dvec3 m = glm::cross(edge, n);
+                    double length = glm::length(m);
+                    if(length > 0)
+                    {
+                        m /= length;
+                        double d = -glm::dot(m, a);
+                        double w = kBorderWeight * glm::dot(edge, edge);
+                        mQuadrics[v[j]].addPlane(m, d, w);
+                        mQuadrics[v[(j + 1) % 3]].addPlane(m, d, w);
+                    }
+                }
+            }
+        }
+    }
+
+    void Simplifier::classifyVertices(std::vector<uint64_t>& borderEdges)
+    {
+        std::vector<uint64_t> edges;
+        edges.reserve(mIndices.size());
+        for(size_t i = 0; i < mIndices.size(); i += 3)
+        {
+            for(uint32_t j = 0; j < 3; j++)
+            {
+                edges.push_back(makeEdgeKey(mCanonical[mIndices[i + j]], mCanonical[mIndices[i + (j + 1) % 3]]));
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+
+        mKinds.assign(mPositions.size(), VertexKind::Manifold);
+        std::vector<uint8_t> borderEdgeCount(mPositions.size(), 0);
+        borderEdges.clear();
+        for(size_t i = 0; i < edges.size();)
+        {
+            size_t end = i + 1;
+            while(end < edges.size() && edges[end] == edges[i])
+            {
+                end++;
+            }
+
+            uint32_t a = uint32_t(edges[i] >> 32);
+            uint32_t b = uint32_t(edges[i] & 0xFFFFFFFF);
+            if(end - i == 1)
+            {
+                borderEdges.push_back(edges[i]);
+                borderEdgeCount[a] = (uint8_t)std::min(borderEdgeCount[a] + 1, 255);
+                borderEdgeCount[b] = (uint8_t)std::min(borderEdgeCount[b] + 1, 255);
+            }
+            else if(end - i > 2)
+            {
+                mKinds[a] = VertexKind::Locked;
+                mKinds[b] = VertexKind::Locked;
+            }
+            i = end;
+        }
+
+        for(size_t v = 0; v < mPositions.size(); v++)
+        {
+            if(mIsSeam[v] || borderEdgeCount[v] > 2 || borderEdgeCount[v] == 1)
+            {
+                mKinds[v] = VertexKind::Locked;
+            }
+            else if(borderEdgeCount[v] == 2 && mKinds[v] != VertexKind::Locked)
+            {
+                mKinds[v] = VertexKind::Border;
+            }
+        }
+    }
+
+    void Simplifier::buildAdjacency()
+    {
+        const uint32_t triangleCount = (uint32_t)mIndices.size() / 3;
+        mTriangleOffsets.assign(mPositions.size() + 1, 0);
+        for(uint32_t index : mIndices)
+        {
+            mTriangleOffsets[index + 1]++;
+        }
+        for(size_t v = 0; v < mPositions.size(); v++)
+        {
+            mTriangleOffsets[v + 1] += mTriangleOffsets[v];
+        }
+
+        mTriangles.resize(mIndices.size());
+        std::vector<uint32_t> next(mTriangleOffsets.begin(), mTriangleOffsets.end() - 1);
+        for(uint32_t t = 0; t < triangleCount; t++)
+        {
+            for(uint32_t j = 0; j < 3; j++)
+            {
+                mTriangles[next[mIndices[t * 3 + j]]++] = t;
+            }
+        }
+    }
+
+    bool Simplifier::isFolding(uint32_t vertex, uint32_t target) const
+    {
+        const glm::vec3& newPosition = mPositions[target];
+        for(uint32_t i = mTriangleOffsets[vertex]; i < mTriangleOffsets[vertex + 1]; i++)
+        {
+            const uint32_t* pTriangle = &mIndices[mTriangles[i] * 3];
+
+            // Triangles using the collapsed edge are removed
+            bool usesTarget = false;
+            glm::vec3 p[3];
+            glm::vec3 q[3];
+            for(uint32_t j = 0; j < 3; j++)
+            {
+                usesTarget = usesTarget || (mCanonical[pTriangle[j]] == mCanonical[target]);
+                p[j] = mPositions[pTriangle[j]];
+                q[j] = (pTriangle[j] == vertex) ? newPosition : p[j];
+            }
+            if(usesTarget)
+            {
+                continue;
+            }
+
+            glm::vec3 oldNormal = glm::cross(p[1] - p[0], p[2] - p[0]);
+            glm::vec3 newNormal = glm::cross(q[1] - q[0], q[2] - q[0]);
+            float oldLength = glm::length(oldNormal);
+            float newLength = glm::length(newNormal);
+            if(oldLength > 0 && glm::dot(oldNormal, newNormal) <= kMinNormalCos * oldLength * newLength)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint32_t Simplifier::performPass(uint32_t targetIndexCount, double maxCost)
+    {
+        std::vector<uint64_t> borderEdges;
+        classifyVertices(borderEdges);
+        buildAdjacency();
+
+        // Find the cheapest collapse of every vertex. Each triangle edge is a candidate in both directions.
+        // Seams and locked vertices can still be the target of a collapse, since they don't move.
+        Collapse invalid;
+        invalid.vertex = kInvalidIndex;
+        invalid.target = kInvalidIndex;
+        invalid.cost = 0;
+        std::vector<Collapse> bestCollapses(mPositions.size(), invalid);
+        for(size_t i = 0; i < mIndices.size(); i += 3)
+        {
+            for(uint32_t j = 0; j < 3; j++)
+            {
+                uint32_t a = mIndices[i + j];
+                uint32_t b = mIndices[i + (j + 1) % 3];
+                uint32_t pair[2][2] = {{a, b}, {b, a}};
+                for(uint32_t k = 0; k < 2; k++)
+                {
+                    uint32_t vertex = pair[k][0];
+                    uint32_t target = pair[k][1];
+                    VertexKind kind = mKinds[mCanonical[vertex]];
+                    if(kind == VertexKind::Locked)
+                    {
+                        continue;
+                    }
+                    if(kind == VertexKind::Border && std::binary_search(borderEdges.begin(), borderEdges.end(), makeEdgeKey(mCanonical[vertex], mCanonical[target])) == false)
+                    {
+                        continue;
+                    }
+
+                    Quadric q = mQuadrics[mCanonical[vertex]];
+                    q.add(mQuadrics[mCanonical[target]]);
+                    Collapse collapse;
+                    collapse.vertex = vertex;
+                    collapse.target = target;
+                    collapse.cost = (q.weight > 0) ? q.evaluate(glm::dvec3(mPositions[target])) / q.weight : 0;
+
+                    Collapse& best = bestCollapses[vertex];
+                    if(best.vertex == kInvalidIndex || collapse < best)
+                    {
+                        best = collapse;
+                    }
+                }
+            }
+        }
+
+        std::vector<Collapse> collapses;
+        for(const Collapse& collapse : bestCollapses)
+        {
+            if(collapse.vertex != kInvalidIndex)
+            {
+                collapses.push_back(collapse);
+            }
+        }
+        std::sort(collapses.begin(), collapses.end());
+
+        // Perform the cheapest collapses. The neighborhood of a collapsed vertex is frozen for the rest of the pass, so the fold test stays valid.
+        std::vector<bool> isFrozen(mPositions.size(), false);
+        std::vector<uint32_t> remap(mPositions.size(), kInvalidIndex);
+        uint32_t trianglesToRemove = uint32_t(mIndices.size() - targetIndexCount) / 3;
+        uint32_t removedTriangles = 0;
+        uint32_t collapseCount = 0;
+        for(const Collapse& collapse : collapses)
+        {
+            if(removedTriangles >= trianglesToRemove || collapse.cost > maxCost)
+            {
+                break;
+            }
+
+            uint32_t vertex = collapse.vertex;
+            if(isFrozen[mCanonical[vertex]] || isFrozen[mCanonical[collapse.target]] || isFolding(vertex, collapse.target))
+            {
+                continue;
+            }
+
+            for(uint32_t i = mTriangleOffsets[vertex]; i < mTriangleOffsets[vertex + 1]; i++)
+            {
+                const uint32_t* pTriangle = &mIndices[mTriangles[i] * 3];
+                for(uint32_t j = 0; j < 3; j++)
+                {
+                    isFrozen[mCanonical[pTriangle[j]]] = true;
+                }
+            }
+
+            remap[vertex] = collapse.target;
+            mQuadrics[mCanonical[collapse.target]].add(mQuadrics[mCanonical[vertex]]);
+            mMaxCost = std::max(mMaxCost, collapse.cost);
+            removedTriangles += (mKinds[mCanonical[vertex]] == VertexKind::Border) ? 1 : 2;
+            collapseCount++;
+        }
+
+        for(uint32_t& index : mIndices)
+        {
+            if(remap[index] != kInvalidIndex)
+            {
+                index = remap[index];
+            }
+        }
+        removeDegenerateTriangles();
+        return collapseCount;
+    }
+
+    void Simplifier::removeDegenerateTriangles()
+    {
+        size_t writeOffset = 0;
+        for(size_t i = 0; i < mIndices.size(); i += 3)
+        {
+            uint32_t a = mCanonical[mIndices[i]];
+            uint32_t b = mCanonical[mIndices[i + 1]];
+            uint32_t c = mCanonical[mIndices[i + 2]];
+            if(a != b && b != c && a != c)
+            {
+                mIndices[writeOffset++] = mIndices[i];
+                mIndices[writeOffset++] = mIndices[i + 1];
+                mIndices[writeOffset++] = mIndices[i + 2];
+            }
+        }
+        mIndices.resize(writeOffset);
+    }
+
+    void Simplifier::simplify(uint32_t targetIndexCount, float maxError)
+    {
+        const double maxCost = double(maxError) * double(maxError);
+        while(mIndices.size() > targetIndexCount)
+        {
+            if(performPass(targetIndexCount, maxCost) == 0)
+            {
+                // Every candidate either exceeds the error limit or folds the surface
+                break;
+            }
+        }
+    }
+
+    float simplifyMesh(std::vector<uint32_t>& destination, const uint32_t* indices, uint32_t indexCount, const void* pPositions, uint32_t positionStride, uint32_t vertexCount, uint32_t targetIndexCount, float maxError)
+    {
+        Simplifier simplifier(indices, indexCount, pPositions, positionStride, vertexCount);
+        simplifier.simplify(targetIndexCount, maxError);
+        destination = simplifier.getIndices();
+        return simplifier.getError();
+    }
+
+    std::vector<MeshLodData> generateLodChain(const uint32_t* indices, uint32_t indexCount, const void* pPositions, uint32_t positionStride, uint32_t vertexCount, uint32_t maxLodCount, float reduction)
+    {
+        std::vector<MeshLodData> lods;
+        Simplifier simplifier(indices, indexCount, pPositions, positionStride, vertexCount);
+
+        uint32_t previousIndexCount = indexCount;
+        for(uint32_t lod = 1; lod < maxLodCount; lod++)
+        {
+            uint32_t targetIndexCount = uint32_t(float(previousIndexCount / 3) * reduction) * 3;
+            simplifier.simplify(targetIndexCount, 1e30f);
+
+            const auto& simplified = simplifier.getIndices();
+            if(simplified.empty() || float(simplified.size()) > float(previousIndexCount) * (1 - kMinLodReduction))
+            {
+                break;
+            }
+
+            MeshLodData data;
+            data.indices = simplified;
+            data.error = simplifier.getError();
+            lods.push_back(std::move(data));
+            previousIndexCount = (uint32_t)simplified.size();
+        }
+
+        return lods;
+    }
+}
@@ -0,0 +1,77 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+namespace Falcor
+{
+    /** Quadric-error mesh simplification, used to create the index buffers of mesh LODs.
+        Simplification only removes vertices - the remaining triangles reference a subset of the input vertices. This way all the LODs of a mesh share its vertex buffer, and a LOD is just another range in the index buffer.
+        Like the other mesh optimization passes, the simplifier doesn't use the GPU or any global state, so it can run on loader threads or offline.
+    */
+
+    /** Default maximal number of LODs generated per mesh, including the full resolution mesh
+    */
+    static const uint32_t kDefaultMaxLodCount = 6;
+
+    struct MeshLodData
+    {
+        std::vector<uint32_t> indices;  ///< Triangle list referencing the vertices of the source mesh
+        float error = 0;                ///< Approximation error in object-space units. Roughly the distance between the simplified surface and the original one.
+    };
+
+    /** Simplify a triangle list using half-edge collapses ordered by their quadric error (Garland and Heckbert, "Surface Simplification Using Quadric Error Metrics").
+        Vertices which share a position with another vertex (UV or normal seams) are never removed, so the simplified mesh has no cracks along the seams. Border edges are preserved as much as possible.
+        The simplification stops when either the index count or the error reaches the limit, or when no more edges can be collapsed.
+        \param[out] destination Receives the simplified triangle list
+        \param[in] indices The triangle list
+        \param[in] indexCount The number of indices
+        \param[in] pPositions The first vertex position. Positions are read as 3 floats.
+        \param[in] positionStride The distance in bytes between consecutive positions
+        \param[in] vertexCount The number of vertices in the vertex buffer
+        \param[in] targetIndexCount The number of indices to aim for
+        \param[in] maxError The largest allowed error, in object-space units
+        \return The error of the simplified mesh, in object-space units
+    */
+    float simplifyMesh(std::vector<uint32_t>& destination, const uint32_t* indices, uint32_t indexCount, const void* pPositions, uint32_t positionStride, uint32_t vertexCount, uint32_t targetIndexCount, float maxError = 1e30f);
+
+    /** Generate a chain of LODs. Each LOD has roughly 'reduction' times the triangles of the previous one.
+        All LODs come from a single simplification run, so the errors grow monotonically and are measured against the full resolution mesh.
+        The chain ends early when the mesh can't be simplified any further, so the result can contain less than maxLodCount - 1 LODs.
+        \param[in] indices The triangle list of the full resolution mesh (LOD 0), which isn't part of the result
+        \param[in] indexCount The number of indices
+        \param[in] pPositions The first vertex position. Positions are read as 3 floats.
+        \param[in] positionStride The distance in bytes between consecutive positions
+        \param[in] vertexCount The number of vertices in the vertex buffer
+        \param[in] maxLodCount The maximal number of LODs, including LOD 0
+        \param[in] reduction The ratio between the triangle counts of consecutive LODs
+        \return LODs 1 and up, from the most detailed to the coarsest
+    */
+    std::vector<MeshLodData> generateLodChain(const uint32_t* indices, uint32_t indexCount, const void* pPositions, uint32_t positionStride, uint32_t vertexCount, uint32_t maxLodCount = kDefaultMaxLodCount, float reduction = 0.5f);
+}
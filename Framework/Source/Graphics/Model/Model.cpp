@@ -100,18 +100,20 @@ namespace Falcor
         return pModel;
     }
 
-    void Model::exportToBinaryFile(const std::string& filename)
+    void Model::exportToBinaryFile(const std::string& filename, bool compress, bool quantizeAttributes)
     {
         if(hasSuffix(filename, ".bin", false) == false)
         {
             Logger::log(Logger::Level::Warning, "Exporting model to binary file, but extension is not '.bin'. This will cause error when loading the file");
         }
 
-        BinaryModelExporter::exportToFile(filename, this);
+        BinaryModelExporter::exportToFile(filename, this, compress, quantizeAttributes);
     }
 
     void Model::calculateModelProperties()
     {
+        // The importers call this after adding mesh instances, and so do the functions which remove them
+        mStructureGeneration++;
         mVertexCount = 0;
         mPrimitiveCount = 0;
         mInstanceCount = 0;
@@ -225,6 +227,7 @@ namespace Falcor
     void Model::addMesh(Mesh::SharedPtr pMesh)
     {
         mpMeshes.push_back(std::move(pMesh));
+        mStructureGeneration++;
     }
 
     Material::SharedPtr Model::getOrAddMaterial(const Material::SharedPtr& pMaterial)
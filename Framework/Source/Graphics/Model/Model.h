@@ -60,6 +60,11 @@ namespace Falcor
             FindDegeneratePrimitives    = 4,    ///< Replace degenerate triangles/lines with lines/points. This can create a meshes with topology that wasn't present in the original model.
             AssumeLinearSpaceTextures   = 8,    ///< By default, textures representing colors (diffuse/specular) are interpreted as sRGB data. Use this flag to force linear space for color textures.
             DontMergeMeshes             = 16,   ///< Preserve the original list of meshes in the scene, don't merge meshes with the same material
+            DontMemoryMapFiles          = 32,   ///< Read binary model files through a file stream instead of mapping them into memory
+            DontLoadInParallel          = 64,   ///< Decode binary model data on the calling thread instead of using the thread pool
+            OptimizeVertexCache         = 128,  ///< Reorder triangles for the post-transform cache and overdraw, and vertices for fetch locality. The ACMR/ATVR of every mesh is logged before and after.
+            GenerateLods                = 256,  ///< Generate a chain of simplified index buffers for triangle meshes which don't have LODs. Binary models exported from such a model store the LODs, so they don't need to be generated again.
+            CompressVertices            = 512,  ///< Binary models only. Store positions as RGBA16Unorm relative to each mesh's bounding-box, and unit normals and tangents octahedral-encoded as RG16Snorm. The scene renderer's vertex shaders decode them. Code which reads the vertex buffers as floats (ray-tracing, mesh lights, Mesh::applyTransform()) doesn't support these meshes.
         };
 
         /** create a new model from file
@@ -76,8 +81,11 @@ namespace Falcor
         void applyTransform(const glm::mat4& transform);
 
         /** Export the model to a binary file
+            \param[in] filename The output file
+            \param[in] compress Compress the file's chunks using LZ4
+            \param[in] quantizeAttributes Store the vertex attributes using 16-bit encodings
         */
-        void exportToBinaryFile(const std::string& filename);
+        void exportToBinaryFile(const std::string& filename, bool compress = false, bool quantizeAttributes = false);
 
         /** Get the model radius
         */
@@ -99,6 +107,11 @@ namespace Falcor
         */
         uint32_t getInstanceCount() const { return mInstanceCount; }
 
+        /** Get the structure generation. It changes whenever meshes or mesh instances are added or removed, for example when streaming a region of a binary model or by deleteCulledMeshes().
+            Code which caches the layout of the mesh instances, like the scene's BVH, compares it with the value it stored to detect these changes.
+        */
+        uint32_t getStructureGeneration() const { return mStructureGeneration; }
+
         /** Get the number of unique textures in the model
         */
         uint32_t getTextureCount() const { return (uint32_t)mpTextures.size(); }
@@ -212,6 +225,7 @@ namespace Falcor
         std::string mName;
 
 		static uint32_t sModelCounter;
+        uint32_t mStructureGeneration = 0;
 
         void calculateModelProperties();
         void deleteUnusedMaterials(std::map<const Material*, bool> usedMaterials);
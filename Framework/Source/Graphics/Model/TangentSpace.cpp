@@ -0,0 +1,303 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "TangentSpace.h"
+#include "Utils/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <xmmintrin.h>
+#include "glm/vec2.hpp"
+#include "glm/geometric.hpp"
+
+namespace Falcor
+{
+    static const uint32_t kTrianglesPerTask = 8192;
+    static const uint32_t kVerticesPerTask = 8192;
+
+    // Normalized UV derivatives of a triangle. Both are zero for triangles without a valid UV mapping.
+    struct TriangleFrame
+    {
+        glm::vec3 os;   // Direction of +U
+        glm::vec3 ot;   // Direction of +V
+    };
+
+    static inline const glm::vec3& getVec3(const void* pData, uint32_t stride, uint32_t index)
+    {
+        return *(const glm::vec3*)((const uint8_t*)pData + size_t(stride) * index);
+    }
+
+    static inline const glm::vec2& getVec2(const void* pData, uint32_t stride, uint32_t index)
+    {
+        return *(const glm::vec2*)((const uint8_t*)pData + size_t(stride) * index);
+    }
+
+    static inline glm::vec3 normalizeSafe(const glm::vec3& v)
+    {
+        float length = glm::length(v);
+        return (length > 0) ? v * (1 / length) : glm::vec3(0);
+    }
+
+    static void calculateTriangleFrame(const TangentSpaceInput& input, uint32_t triangle, TriangleFrame& frame)
+    {
+        const uint32_t* pIndices = input.pIndices + triangle * 3;
+        const glm::vec3& p0 = getVec3(input.pPositions, input.positionStride, pIndices[0]);
+        const glm::vec2& t0 = getVec2(input.pTexCrds, input.texCrdStride, pIndices[0]);
+
+        glm::vec3 d1 = getVec3(input.pPositions, input.positionStride, pIndices[1]) - p0;
+        glm::vec3 d2 = getVec3(input.pPositions, input.positionStride, pIndices[2]) - p0;
+        glm::vec2 st1 = getVec2(input.pTexCrds, input.texCrdStride, pIndices[1]) - t0;
+        glm::vec2 st2 = getVec2(input.pTexCrds, input.texCrdStride, pIndices[2]) - t0;
+
+        float signedArea = st1.x * st2.y - st1.y * st2.x;
+        glm::vec3 os = st2.y * d1 - st1.y * d2;
+        glm::vec3 ot = st1.x * d2 - st2.x * d1;
+        float lengthOs = std::sqrt(glm::dot(os, os));
+        float lengthOt = std::sqrt(glm::dot(ot, ot));
+
+        // Mirrored triangles have a negative UV area. Flipping the derivatives keeps them pointing along +U and +V.
+        float sign = (signedArea < 0) ? -1.0f : 1.0f;
+        bool isValid = (signedArea != 0) && (lengthOs > 0) && (lengthOt > 0);
+        frame.os = isValid ? os * (sign / lengthOs) : glm::vec3(0);
+        frame.ot = isValid ? ot * (sign / lengthOt) : glm::vec3(0);
+    }
+
+    /** SSE version of calculateTriangleFrame(), which handles 4 consecutive triangles
+    */
+    static void calculateTriangleFrames4(const TangentSpaceInput& input, uint32_t firstTriangle, TriangleFrame* pFrames)
+    {
+        // Gather the vertices into SoA registers. The attributes are strided, so there's no way around scalar loads.
+        __m128 px[3], py[3], pz[3], u[3], v[3];
+        for(uint32_t corner = 0; corner < 3; corner++)
+        {
+            const uint32_t* pIndices = input.pIndices + firstTriangle * 3 + corner;
+            const glm::vec3& p0 = getVec3(input.pPositions, input.positionStride, pIndices[0]);
+            const glm::vec3& p1 = getVec3(input.pPositions, input.positionStride, pIndices[3]);
+            const glm::vec3& p2 = getVec3(input.pPositions, input.positionStride, pIndices[6]);
+            const glm::vec3& p3 = getVec3(input.pPositions, input.positionStride, pIndices[9]);
+            const glm::vec2& t0 = getVec2(input.pTexCrds, input.texCrdStride, pIndices[0]);
+            const glm::vec2& t1 = getVec2(input.pTexCrds, input.texCrdStride, pIndices[3]);
+            const glm::vec2& t2 = getVec2(input.pTexCrds, input.texCrdStride, pIndices[6]);
+            const glm::vec2& t3 = getVec2(input.pTexCrds, input.texCrdStride, pIndices[9]);
+
+            px[corner] = _mm_setr_ps(p0.x, p1.x, p2.x, p3.x);
+            py[corner] = _mm_setr_ps(p0.y, p1.y, p2.y, p3.y);
+            pz[corner] = _mm_setr_ps(p0.z, p1.z, p2.z, p3.z);
+            u[corner] = _mm_setr_ps(t0.x, t1.x, t2.x, t3.x);
+            v[corner] = _mm_setr_ps(t0.y, t1.y, t2.y, t3.y);
+        }
+
+        __m128 d1x = _mm_sub_ps(px[1], px[0]);
+        __m128 d1y = _mm_sub_ps(py[1], py[0]);
+        __m128 d1z = _mm_sub_ps(pz[1], pz[0]);
+        __m128 d2x = _mm_sub_ps(px[2], px[0]);
+        __m128 d2y = _mm_sub_ps(py[2], py[0]);
+        __m128 d2z = _mm_sub_ps(pz[2], pz[0]);
+        __m128 st1x = _mm_sub_ps(u[1], u[0]);
+        __m128 st1y = _mm_sub_ps(v[1], v[0]);
+        __m128 st2x = _mm_sub_ps(u[2], u[0]);
+        __m128 st2y = _mm_sub_ps(v[2], v[0]);
+
+        __m128 signedArea = _mm_sub_ps(_mm_mul_ps(st1x, st2y), _mm_mul_ps(st1y, st2x));
+
+        // os = st2.y * d1 - st1.y * d2, ot = st1.x * d2 - st2.x * d1
+        __m128 osx = _mm_sub_ps(_mm_mul_ps(st2y, d1x), _mm_mul_ps(st1y, d2x));
+        __m128 osy = _mm_sub_ps(_mm_mul_ps(st2y, d1y), _mm_mul_ps(st1y, d2y));
+        __m128 osz = _mm_sub_ps(_mm_mul_ps(st2y, d1z), _mm_mul_ps(st1y, d2z));
+        __m128 otx = _mm_sub_ps(_mm_mul_ps(st1x, d2x), _mm_mul_ps(st2x, d1x));
+        __m128 oty = _mm_sub_ps(_mm_mul_ps(st1x, d2y), _mm_mul_ps(st2x, d1y));
+        __m128 otz = _mm_sub_ps(_mm_mul_ps(st1x, d2z), _mm_mul_ps(st2x, d1z));
+
+        __m128 zero = _mm_setzero_ps();
+        __m128 lengthOs = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(osx, osx), _mm_mul_ps(osy, osy)), _mm_mul_ps(osz, osz)));
+        __m128 lengthOt = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(otx, otx), _mm_mul_ps(oty, oty)), _mm_mul_ps(otz, otz)));
+        __m128 isValid = _mm_and_ps(_mm_cmpneq_ps(signedArea, zero), _mm_and_ps(_mm_cmpgt_ps(lengthOs, zero), _mm_cmpgt_ps(lengthOt, zero)));
+
+        // sign = (signedArea < 0) ? -1 : 1. Invalid lanes get a scale of zero.
+        __m128 sign = _mm_or_ps(_mm_and_ps(_mm_cmplt_ps(signedArea, zero), _mm_set1_ps(-1.0f)), _mm_andnot_ps(_mm_cmplt_ps(signedArea, zero), _mm_set1_ps(1.0f)));
+        __m128 scaleOs = _mm_and_ps(isValid, _mm_div_ps(sign, lengthOs));
+        __m128 scaleOt = _mm_and_ps(isValid, _mm_div_ps(sign, lengthOt));
+
+        float out[6][4];
+        _mm_storeu_ps(out[0], _mm_mul_ps(osx, scaleOs));
+        _mm_storeu_ps(out[1], _mm_mul_ps(osy, scaleOs));
+        _mm_storeu_ps(out[2], _mm_mul_ps(osz, scaleOs));
+        _mm_storeu_ps(out[3], _mm_mul_ps(otx, scaleOt));
+        _mm_storeu_ps(out[4], _mm_mul_ps(oty, scaleOt));
+        _mm_storeu_ps(out[5], _mm_mul_ps(otz, scaleOt));
+
+        for(uint32_t i = 0; i < 4; i++)
+        {
+            pFrames[i].os = glm::vec3(out[0][i], out[1][i], out[2][i]);
+            pFrames[i].ot = glm::vec3(out[3][i], out[4][i], out[5][i]);
+        }
+    }
+
+    /** Build an arbitrary orthonormal basis around a normal (Duff et al., "Building an Orthonormal Basis, Revisited")
+    */
+    static void buildBasis(const glm::vec3& n, glm::vec3& tangent, glm::vec3& bitangent)
+    {
+        if(glm::dot(n, n) == 0)
+        {
+            tangent = glm::vec3(1, 0, 0);
+            bitangent = glm::vec3(0, 1, 0);
+            return;
+        }
+
+        float sign = (n.z < 0) ? -1.0f : 1.0f;
+        float a = -1.0f / (sign + n.z);
+        float b = n.x * n.y * a;
+        tangent = glm::vec3(1.0f + sign * n.x * n.x * a, sign * b, -sign * n.x);
+        bitangent = glm::vec3(b, sign + n.y * n.y * a, -n.y);
+    }
+
+    /** Accumulate the frames of all the triangles around a vertex and orthonormalize the result
+    */
+    static void calculateVertexFrame(const TangentSpaceInput& input, uint32_t vertex, const uint32_t* pCorners, uint32_t cornerCount, const TriangleFrame* pFrames, glm::vec3& tangent, glm::vec3& bitangent)
+    {
+        const glm::vec3 n = normalizeSafe(getVec3(input.pNormals, input.normalStride, vertex));
+        const glm::vec3& p = getVec3(input.pPositions, input.positionStride, vertex);
+
+        glm::vec3 t(0);
+        glm::vec3 b(0);
+        for(uint32_t i = 0; i < cornerCount; i++)
+        {
+            uint32_t triangle = pCorners[i] / 3;
+            uint32_t corner = pCorners[i] % 3;
+            const TriangleFrame& frame = pFrames[triangle];
+            if(frame.os == glm::vec3(0))
+            {
+                continue;
+            }
+
+            // MikkTSpace weights each triangle by its angle at the vertex, measured in the tangent plane
+            const uint32_t* pIndices = input.pIndices + triangle * 3;
+            glm::vec3 e1 = getVec3(input.pPositions, input.positionStride, pIndices[(corner + 1) % 3]) - p;
+            glm::vec3 e2 = getVec3(input.pPositions, input.positionStride, pIndices[(corner + 2) % 3]) - p;
+            e1 = normalizeSafe(e1 - n * glm::dot(n, e1));
+            e2 = normalizeSafe(e2 - n * glm::dot(n, e2));
+            float angle = std::acos(glm::clamp(glm::dot(e1, e2), -1.0f, 1.0f));
+
+            t += angle * normalizeSafe(frame.os - n * glm::dot(n, frame.os));
+            b += angle * normalizeSafe(frame.ot - n * glm::dot(n, frame.ot));
+        }
+
+        t = normalizeSafe(t - n * glm::dot(n, t));
+        if(t == glm::vec3(0))
+        {
+            // Fall back to the bitangent if the tangents cancelled out, and to an arbitrary frame if there is nothing to use
+            t = normalizeSafe(glm::cross(b, n));
+            if(t == glm::vec3(0))
+            {
+                buildBasis(n, tangent, bitangent);
+                return;
+            }
+        }
+
+        // The bitangent is rebuilt from the normal and tangent, so the frame is orthonormal. The accumulated bitangent only decides the handedness.
+        float handedness = (glm::dot(glm::cross(n, t), b) < 0) ? -1.0f : 1.0f;
+        tangent = t;
+        bitangent = handedness * glm::cross(n, t);
+    }
+
+    void generateTangentSpace(const TangentSpaceInput& input, glm::vec3* pTangents, glm::vec3* pBitangents, bool runInParallel)
+    {
+        const uint32_t triangleCount = input.indexCount / 3;
+        const uint32_t vertexCount = input.vertexCount;
+
+        auto parallelFor = [runInParallel](uint32_t count, const std::function<void(uint32_t)>& func)
+        {
+            if(runInParallel && count > 1)
+            {
+                ThreadPool::getDefaultPool()->parallelFor(count, func);
+            }
+            else
+            {
+                for(uint32_t i = 0; i < count; i++)
+                {
+                    func(i);
+                }
+            }
+        };
+
+        // Per-triangle UV derivatives, 4 triangles at a time
+        std::vector<TriangleFrame> frames(input.pTexCrds ? triangleCount : 0);
+        if(input.pTexCrds)
+        {
+            uint32_t taskCount = (triangleCount + kTrianglesPerTask - 1) / kTrianglesPerTask;
+            parallelFor(taskCount, [&](uint32_t task)
+            {
+                uint32_t first = task * kTrianglesPerTask;
+                uint32_t end = std::min(first + kTrianglesPerTask, triangleCount);
+                uint32_t triangle = first;
+                for(; triangle + 4 <= end; triangle += 4)
+                {
+                    calculateTriangleFrames4(input, triangle, &frames[triangle]);
+                }
+                for(; triangle < end; triangle++)
+                {
+                    calculateTriangleFrame(input, triangle, frames[triangle]);
+                }
+            });
+        }
+
+        // Find the triangle corners referencing each vertex. The corners are sorted, which makes the accumulation order (and the result) deterministic.
+        std::vector<uint32_t> cornerOffsets(vertexCount + 1, 0);
+        std::vector<uint32_t> corners(frames.size() ? triangleCount * 3 : 0);
+        if(frames.size())
+        {
+            for(uint32_t i = 0; i < triangleCount * 3; i++)
+            {
+                cornerOffsets[input.pIndices[i] + 1]++;
+            }
+            for(uint32_t v = 0; v < vertexCount; v++)
+            {
+                cornerOffsets[v + 1] += cornerOffsets[v];
+            }
+            std::vector<uint32_t> next(cornerOffsets.begin(), cornerOffsets.end() - 1);
+            for(uint32_t i = 0; i < triangleCount * 3; i++)
+            {
+                corners[next[input.pIndices[i]]++] = i;
+            }
+        }
+
+        // Per-vertex accumulation. Each task owns a range of vertices, so there's no need for synchronization.
+        uint32_t taskCount = (vertexCount + kVerticesPerTask - 1) / kVerticesPerTask;
+        parallelFor(taskCount, [&](uint32_t task)
+        {
+            uint32_t first = task * kVerticesPerTask;
+            uint32_t end = std::min(first + kVerticesPerTask, vertexCount);
+            for(uint32_t v = first; v < end; v++)
+            {
+                uint32_t cornerCount = cornerOffsets[v + 1] - cornerOffsets[v];
+                const uint32_t* pCorners = corners.data() + cornerOffsets[v];
+                calculateVertexFrame(input, v, pCorners, cornerCount, frames.data(), pTangents[v], pBitangents[v]);
+            }
+        });
+    }
+}
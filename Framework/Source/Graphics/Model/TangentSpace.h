@@ -0,0 +1,61 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <stdint.h>
+#include "glm/vec3.hpp"
+
+namespace Falcor
+{
+    /** Mesh data used for tangent-space generation.
+        Strides are in bytes, so the attributes can come from separate streams or from interleaved vertices.
+    */
+    struct TangentSpaceInput
+    {
+        const void* pPositions = nullptr;   ///< 3 floats per vertex
+        uint32_t positionStride = 0;
+        const void* pNormals = nullptr;     ///< 3 floats per vertex. Don't have to be normalized
+        uint32_t normalStride = 0;
+        const void* pTexCrds = nullptr;     ///< 2 floats per vertex. Optional
+        uint32_t texCrdStride = 0;
+        const uint32_t* pIndices = nullptr; ///< Triangle list
+        uint32_t indexCount = 0;
+        uint32_t vertexCount = 0;
+    };
+
+    /** Generate per-vertex tangents and bitangents for an indexed triangle list, following MikkTSpace.
+        The UV derivatives of each triangle are projected onto the plane of the vertex normal and accumulated, weighted by the angle of the triangle's corner at the vertex.
+        Tangents point along +U and bitangents along +V. The bitangent is perpendicular to the normal and the tangent, and its sign follows the UV orientation of the triangles around the vertex, so mirrored UVs get a flipped bitangent.
+        Unlike MikkTSpace, vertices are never split. A vertex shared by triangles with different UV orientations gets the averaged frame.
+        Vertices which aren't used by any triangle with a valid UV mapping (or meshes without texture coordinates) get an arbitrary frame perpendicular to the normal.
+        \param[in] input The mesh data
+        \param[out] pTangents Receives input.vertexCount tangents
+        \param[out] pBitangents Receives input.vertexCount bitangents
+        \param[in] runInParallel Split the work between the threads of the default thread pool
+    */
+    void generateTangentSpace(const TangentSpaceInput& input, glm::vec3* pTangents, glm::vec3* pBitangents, bool runInParallel = true);
+}
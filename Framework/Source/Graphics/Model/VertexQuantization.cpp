@@ -0,0 +1,199 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "VertexQuantization.h"
+#include <cmath>
+#include <cstring>
+#include "glm/geometric.hpp"
+
+namespace Falcor
+{
+    uint16_t floatToHalf(float value)
+    {
+        uint32_t f;
+        std::memcpy(&f, &value, sizeof(f));
+
+        uint32_t sign = (f >> 16) & 0x8000;
+        int32_t exponent = int32_t((f >> 23) & 0xff) - 127 + 15;
+        uint32_t mantissa = f & 0x7fffff;
+
+        if(((f >> 23) & 0xff) == 0xff)
+        {
+            // Infinity or NaN. Keep NaNs quiet.
+            return uint16_t(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+        }
+
+        if(exponent >= 0x1f)
+        {
+            // Overflow
+            return uint16_t(sign | 0x7c00);
+        }
+
+        if(exponent <= 0)
+        {
+            // Denormal or zero
+            if(exponent < -10)
+            {
+                return uint16_t(sign);
+            }
+            mantissa |= 0x800000;
+            uint32_t shift = uint32_t(14 - exponent);
+            uint32_t halfMantissa = mantissa >> shift;
+            uint32_t remainder = mantissa & ((1 << shift) - 1);
+            uint32_t halfway = 1 << (shift - 1);
+            if(remainder > halfway || (remainder == halfway && (halfMantissa & 1)))
+            {
+                halfMantissa++;
+            }
+            return uint16_t(sign | halfMantissa);
+        }
+
+        uint32_t half = sign | (uint32_t(exponent) << 10) | (mantissa >> 13);
+        uint32_t remainder = mantissa & 0x1fff;
+        if(remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+        {
+            // Rounding can carry into the exponent, which correctly produces the next power of 2 or infinity
+            half++;
+        }
+        return uint16_t(half);
+    }
+
+    float halfToFloat(uint16_t value)
+    {
+        uint32_t sign = uint32_t(value & 0x8000) << 16;
+        uint32_t exponent = (value >> 10) & 0x1f;
+        uint32_t mantissa = value & 0x3ff;
+
+        uint32_t f;
+        if(exponent == 0x1f)
+        {
+            f = sign | 0x7f800000 | (mantissa << 13);
+        }
+        else if(exponent == 0)
+        {
+            if(mantissa == 0)
+            {
+                f = sign;
+            }
+            else
+            {
+                // Denormal. Normalize it.
+                exponent = 127 - 15 + 1;
+                while((mantissa & 0x400) == 0)
+                {
+                    mantissa <<= 1;
+                    exponent--;
+                }
+                mantissa &= 0x3ff;
+                f = sign | (exponent << 23) | (mantissa << 13);
+            }
+        }
+        else
+        {
+            f = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+        }
+
+        float result;
+        std::memcpy(&result, &f, sizeof(result));
+        return result;
+    }
+
+    int16_t encodeSnorm16(float value)
+    {
+        value = (value > 1.0f) ? 1.0f : ((value < -1.0f) ? -1.0f : value);
+        return int16_t(std::floor(value * 32767.0f + 0.5f));
+    }
+
+    float decodeSnorm16(int16_t value)
+    {
+        float f = float(value) / 32767.0f;
+        return (f < -1.0f) ? -1.0f : f;
+    }
+
+    uint16_t encodeUnorm16(float value)
+    {
+        value = (value > 1.0f) ? 1.0f : ((value < 0.0f) ? 0.0f : value);
+        return uint16_t(std::floor(value * 65535.0f + 0.5f));
+    }
+
+    float decodeUnorm16(uint16_t value)
+    {
+        return float(value) / 65535.0f;
+    }
+
+    static float signNotZero(float f)
+    {
+        return (f >= 0.0f) ? 1.0f : -1.0f;
+    }
+
+    void encodeOctahedral(const glm::vec3& v, int16_t encoded[2])
+    {
+        // Project onto the octahedron and unfold the lower hemisphere
+        // See "A Survey of Efficient Representations for Independent Unit Vectors", Cigolle et al. 2014
+        glm::vec3 n = v / (std::abs(v.x) + std::abs(v.y) + std::abs(v.z));
+        float x = n.x;
+        float y = n.y;
+        if(n.z < 0)
+        {
+            x = (1.0f - std::abs(n.y)) * signNotZero(n.x);
+            y = (1.0f - std::abs(n.x)) * signNotZero(n.y);
+        }
+
+        // Pick the rounding with the smallest decoding error
+        glm::vec3 target = glm::normalize(v);
+        float fx = std::floor(x * 32767.0f);
+        float fy = std::floor(y * 32767.0f);
+        float bestDot = -2.0f;
+        for(uint32_t i = 0; i < 4; i++)
+        {
+            int16_t candidate[2];
+            candidate[0] = encodeSnorm16((fx + float(i & 1)) / 32767.0f);
+            candidate[1] = encodeSnorm16((fy + float(i >> 1)) / 32767.0f);
+            float d = glm::dot(decodeOctahedral(candidate), target);
+            if(d > bestDot)
+            {
+                bestDot = d;
+                encoded[0] = candidate[0];
+                encoded[1] = candidate[1];
+            }
+        }
+    }
+
+    glm::vec3 decodeOctahedral(const int16_t encoded[2])
+    {
+        float x = decodeSnorm16(encoded[0]);
+        float y = decodeSnorm16(encoded[1]);
+        glm::vec3 n(x, y, 1.0f - std::abs(x) - std::abs(y));
+        if(n.z < 0)
+        {
+            n.x = (1.0f - std::abs(y)) * signNotZero(x);
+            n.y = (1.0f - std::abs(x)) * signNotZero(y);
+        }
+        return glm::normalize(n);
+    }
+}
@@ -0,0 +1,72 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <stdint.h>
+#include "glm/vec3.hpp"
+
+namespace Falcor
+{
+    /** Conversion between 32-bit floats and the compact vertex attribute encodings used by binary models.
+        All the functions are CPU-only and deterministic.
+    */
+
+    /** Convert a float to a half float, rounding to nearest even. Values too large for a half float become infinity.
+    */
+    uint16_t floatToHalf(float value);
+
+    /** Convert a half float to a float
+    */
+    float halfToFloat(uint16_t value);
+
+    /** Convert a value in [-1, 1] to a 16-bit signed normalized integer. Values outside the range are clamped.
+    */
+    int16_t encodeSnorm16(float value);
+
+    /** Convert a 16-bit signed normalized integer to a float in [-1, 1]
+    */
+    float decodeSnorm16(int16_t value);
+
+    /** Convert a value in [0, 1] to a 16-bit unsigned normalized integer. Values outside the range are clamped.
+    */
+    uint16_t encodeUnorm16(float value);
+
+    /** Convert a 16-bit unsigned normalized integer to a float in [0, 1]
+    */
+    float decodeUnorm16(uint16_t value);
+
+    /** Encode a unit vector using the octahedral mapping into 2 SNORM16 values.
+        All 4 roundings of the projected coordinates are tried, and the one which decodes closest to the input is used.
+        \param[in] v The vector to encode. Doesn't have to be normalized, but can't be zero.
+        \param[out] encoded Receives the encoded vector
+    */
+    void encodeOctahedral(const glm::vec3& v, int16_t encoded[2]);
+
+    /** Decode an octahedral-encoded unit vector
+    */
+    glm::vec3 decodeOctahedral(const int16_t encoded[2]);
+}
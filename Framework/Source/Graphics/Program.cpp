@@ -37,8 +37,10 @@
 #include "Core/Texture.h"
 #include "Core/Sampler.h"
 #include "Utils/ShaderUtils.h"
+#include "Utils/ShaderCache.h"
 #include "Core/RenderContext.h"
 #include "Utils/StringUtils.h"
+#include "Utils/ThreadPool.h"
 
 namespace Falcor
 {
@@ -140,78 +142,277 @@ namespace Falcor
     {
         if(mLinkRequired)
         {
+            mUsingFallbackVersion = false;
             const auto& it = mProgramVersions.find(mDefineList);
-            ProgramVersion::SharedConstPtr pVersion = nullptr;
             if(it == mProgramVersions.end())
             {
-                // New version
-                pVersion = link();
+                // New version. With asynchronous compilation, a compiled version is used until the new one is ready.
+                ProgramVersion::SharedConstPtr pVersion = nullptr;
+                ProgramVersion::SharedConstPtr pFallback = mAsyncCompilation ? findFallbackVersion(mDefineList) : nullptr;
+                const bool useFallback = (pFallback != nullptr);
+                const auto& pendingIt = mPendingVersions.find(mDefineList);
+                if(pendingIt == mPendingVersions.end())
+                {
+                    if(useFallback)
+                    {
+                        queueVersion(mDefineList);
+                    }
+                    else
+                    {
+                        pVersion = link(mDefineList);
+                    }
+                }
+                else if((useFallback == false) || pendingIt->second->isDone())
+                {
+                    pVersion = finishPendingVersion(mDefineList, *pendingIt->second);
+                    mPendingVersions.erase(pendingIt);
+                }
 
                 if(pVersion == nullptr)
                 {
-                    return false;
+                    mUsingFallbackVersion = useFallback;
+                    return pFallback;
                 }
                 else
                 {
+                    mUboMap.clear();
                     mProgramVersions[mDefineList] = pVersion;
                     mpActiveProgram = pVersion;
                 }
             }
             else
             {
-                mpActiveProgram = mProgramVersions[mDefineList];
+                mpActiveProgram = it->second;
             }
         }
 
         return mpActiveProgram;
     }
 
-    ProgramVersion::SharedConstPtr Program::link() const
+    ProgramVersion::SharedConstPtr Program::findFallbackVersion(const DefineList& defines) const
     {
-        mUboMap.clear();
-        while(1)
+        ProgramVersion::SharedConstPtr pFallback = nullptr;
+        for(const auto& version : mProgramVersions)
+        {
+            bool sameLayout = true;
+            for(const auto& name : mLayoutDefines)
+            {
+                const auto& a = version.first.find(name);
+                const auto& b = defines.find(name);
+                const bool aExists = (a != version.first.end());
+                const bool bExists = (b != defines.end());
+                sameLayout = sameLayout && (aExists == bExists) && ((aExists == false) || (a->second == b->second));
+            }
+
+            if(sameLayout)
+            {
+                // Prefer the active version, so that the fallback doesn't change what is rendered
+                if(version.second == mpActiveProgram)
+                {
+                    return mpActiveProgram;
+                }
+                pFallback = (pFallback == nullptr) ? version.second : pFallback;
+            }
+        }
+        return pFallback;
+    }
+
+    void Program::prewarm(const std::vector<DefineList>& defineLists)
+    {
+        for(const auto& defines : defineLists)
+        {
+            if((mProgramVersions.find(defines) == mProgramVersions.end()) && (mPendingVersions.find(defines) == mPendingVersions.end()))
+            {
+                queueVersion(defines);
+            }
+        }
+    }
+
+    void Program::queueVersion(const DefineList& defines) const
+    {
+        auto pPending = std::make_shared<PendingVersion>();
+        std::copy(mShaderStrings, mShaderStrings + kShaderCount, pPending->shaderStrings);
+        pPending->createdFromFile = mCreatedFromFile;
+        pPending->defines = defines;
+        // The compiler identity is queried from the device, which can only be done on this thread
+        pPending->compilerIdentity = ShaderCache::isEnabled() ? ProgramVersion::getCompilerIdentity() : "";
+        pPending->doneFuture = pPending->done.get_future();
+
+        ThreadPool::getDefaultPool()->addTask([pPending]()
         {
-            Shader::SharedPtr pShaders[kShaderCount];
+            pPending->succeeded = preprocess(pPending->shaderStrings, pPending->createdFromFile, pPending->defines, pPending->compilerIdentity, pPending->preprocessed);
+            pPending->done.set_value();
+        });
+        mPendingVersions[defines] = pPending;
+    }
+
+    ProgramVersion::SharedConstPtr Program::finishPendingVersion(const DefineList& defines, PendingVersion& pending) const
+    {
+        pending.doneFuture.wait();
+        if(pending.succeeded)
+        {
+            bool retry;
+            ProgramVersion::SharedConstPtr pVersion = createVersion(pending.preprocessed, retry);
+            if(retry == false)
+            {
+                return pVersion;
+            }
+        }
+
+        // The errors are reported by a synchronous link, which also lets the user fix the shaders and retry
+        return link(defines);
+    }
 
-            // create the shaders
-            for(uint32_t i = 0; i < kShaderCount; i++)
+    uint32_t Program::compilePendingVersions(uint32_t maxVersions)
+    {
+        uint32_t compiledCount = 0;
+        for(auto& pProgram : sPrograms)
+        {
+            auto& pendingVersions = pProgram->mPendingVersions;
+            for(auto it = pendingVersions.begin(); (it != pendingVersions.end()) && (compiledCount < maxVersions);)
             {
-                if(mShaderStrings[i].size())
+                if(it->second->isDone())
                 {
-                    if(mCreatedFromFile)
+                    ProgramVersion::SharedConstPtr pVersion = pProgram->finishPendingVersion(it->first, *it->second);
+                    if(pVersion)
                     {
-                        pShaders[i] = createShaderFromFile(mShaderStrings[i], ShaderType(i), mDefineList);
+                        pProgram->mProgramVersions[it->first] = pVersion;
                     }
-                    else
+                    it = pendingVersions.erase(it);
+                    compiledCount++;
+                }
+                else
+                {
+                    it++;
+                }
+            }
+        }
+        return compiledCount;
+    }
+
+    bool Program::preprocess(const std::string shaderStrings[kShaderCount], bool createdFromFile, const DefineList& defines, const std::string& compilerIdentity, PreprocessedVersion& result)
+    {
+        for(uint32_t i = 0; i < kShaderCount; i++)
+        {
+            result.sources[i].clear();
+            if(shaderStrings[i].size())
+            {
+                std::string errorMsg;
+                if(preprocessShader(shaderStrings[i], createdFromFile, defines, result.sources[i], errorMsg) == false)
+                {
+                    result.errorMsg = std::string("Error when pre-processing shader ") + (createdFromFile ? shaderStrings[i] : "from string") + "\n" + errorMsg;
+                    return false;
+                }
+            }
+        }
+
+        // The preprocessed sources identify the program, so a binary which was cached for them can be used instead of compiling
+        result.binary.clear();
+        if(ShaderCache::isEnabled())
+        {
+            result.binaryKey = ShaderCache::calculateProgramKey(result.sources, compilerIdentity);
+            if(ShaderCache::loadBinary(result.binaryKey, result.binaryFormat, result.binary) == false)
+            {
+                result.binary.clear();
+            }
+        }
+        return true;
+    }
+
+    ProgramVersion::SharedConstPtr Program::createVersion(const PreprocessedVersion& preprocessed, bool& retry) const
+    {
+        retry = false;
+        if(preprocessed.binary.size())
+        {
+            std::string log;
+            ProgramVersion::SharedConstPtr pProgram = ProgramVersion::createFromBinary(preprocessed.binaryFormat, preprocessed.binary, log, getProgramDescString());
+            if(pProgram)
+            {
+                return pProgram;
+            }
+        }
+
+        // create the shaders
+        Shader::SharedPtr pShaders[kShaderCount];
+        for(uint32_t i = 0; i < kShaderCount; i++)
+        {
+            if(mShaderStrings[i].size())
+            {
+                std::string log;
+                pShaders[i] = Shader::create(preprocessed.sources[i], ShaderType(i), log);
+                if(pShaders[i] == nullptr)
+                {
+                    std::string error = std::string("Compilation of shader ") + (mCreatedFromFile ? mShaderStrings[i] : "from string") + "\n\n" + log;
+                    if(mCreatedFromFile == false)
                     {
-                        pShaders[i] = createShaderFromString(mShaderStrings[i], ShaderType(i), mDefineList);
+                        error += "\nShader string:\n" + mShaderStrings[i] + "\n";
                     }
+
+                    if(msgBox(error, MsgBoxType::RetryCancel) == MsgBoxButton::Cancel)
+                    {
+                        Logger::log(Logger::Level::Fatal, error);
+                        return nullptr;
+                    }
+
+                    // The shaders are preprocessed again, so changes to their files are picked up
+                    retry = true;
+                    return nullptr;
                 }
             }
+        }
 
-            // create the program
-            std::string log;
-            ProgramVersion::SharedConstPtr pProgram = ProgramVersion::create(pShaders[(uint32_t)ShaderType::Vertex],
-                pShaders[(uint32_t)ShaderType::Fragment],
-                pShaders[(uint32_t)ShaderType::Geometry],
-                pShaders[(uint32_t)ShaderType::Hull],
-                pShaders[(uint32_t)ShaderType::Domain],
-                log, 
-                getProgramDescString());
-
-            if(pProgram == nullptr)
+        // create the program
+        std::string log;
+        ProgramVersion::SharedConstPtr pProgram = ProgramVersion::create(pShaders[(uint32_t)ShaderType::Vertex],
+            pShaders[(uint32_t)ShaderType::Fragment],
+            pShaders[(uint32_t)ShaderType::Geometry],
+            pShaders[(uint32_t)ShaderType::Hull],
+            pShaders[(uint32_t)ShaderType::Domain],
+            log, 
+            getProgramDescString());
+
+        if(pProgram == nullptr)
+        {
+            std::string error = std::string("Program Linkage failed.\n\n");
+            error += getProgramDescString() + "\n";
+            error += log;
+
+            if(msgBox(error, MsgBoxType::RetryCancel) == MsgBoxButton::Cancel)
             {
-                std::string error = std::string("Program Linkage failed.\n\n");
-                error += getProgramDescString() + "\n";
-                error += log;
+                Logger::log(Logger::Level::Fatal, error);
+                return nullptr;
+            }
+            retry = true;
+            return nullptr;
+        }
+
+        uint32_t format;
+        std::vector<uint8_t> binary;
+        if(ShaderCache::isEnabled() && pProgram->getBinary(format, binary))
+        {
+            ShaderCache::storeBinary(preprocessed.binaryKey, format, binary);
+        }
+        return pProgram;
+    }
 
-                if(msgBox(error, MsgBoxType::RetryCancel) == MsgBoxButton::Cancel)
+    ProgramVersion::SharedConstPtr Program::link(const DefineList& defines) const
+    {
+        const std::string compilerIdentity = ShaderCache::isEnabled() ? ProgramVersion::getCompilerIdentity() : "";
+        while(1)
+        {
+            PreprocessedVersion preprocessed;
+            while(preprocess(mShaderStrings, mCreatedFromFile, defines, compilerIdentity, preprocessed) == false)
+            {
+                if((mCreatedFromFile == false) || (msgBox(preprocessed.errorMsg, MsgBoxType::RetryCancel) == MsgBoxButton::Cancel))
                 {
-                    Logger::log(Logger::Level::Fatal, error);
+                    Logger::log(Logger::Level::Fatal, preprocessed.errorMsg);
                     return nullptr;
                 }
             }
-            else
+
+            bool retry;
+            ProgramVersion::SharedConstPtr pProgram = createVersion(preprocessed, retry);
+            if(retry == false)
             {
                 return pProgram;
             }
@@ -223,6 +424,7 @@ namespace Falcor
         for(auto& pProgram : sPrograms)
         {
 			pProgram->mProgramVersions.clear();
+            pProgram->mPendingVersions.clear();
             pProgram->mLinkRequired = true;
         }
     }
@@ -29,7 +29,10 @@
 #include "Framework.h"
 #include <string>
 #include <map>
+#include <set>
 #include <vector>
+#include <memory>
+#include <future>
 #include "Core/ProgramVersion.h"
 #include "Core/UniformBuffer.h"
 
@@ -121,6 +124,35 @@ namespace Falcor
         */
         ProgramVersion::SharedConstPtr getActiveProgramVersion() const;
 
+        /** Enable/disable asynchronous compilation of new program versions. When enabled, requesting a version which wasn't compiled yet doesn't stall the frame. Its shaders are preprocessed on worker threads,
+            and getActiveProgramVersion() returns a compiled version instead until compilePendingVersions() compiled the requested one. See isUsingFallbackVersion().
+            A version is only used as a fallback if it has the same layout defines as the requested version, see addLayoutDefine(). It's the last active version if possible. When there is no such version, the requested version is compiled synchronously. This is always the case for the first version of a program.
+            A version compiled by compilePendingVersions() doesn't reset the uniform buffers when it becomes active, so the versions should have the same buffer layouts.
+        */
+        void setAsyncCompilation(bool enable) { mAsyncCompilation = enable; }
+
+        /** Check whether the last call to getActiveProgramVersion() returned a fallback version, because the version for the current macro definitions is still being compiled
+        */
+        bool isUsingFallbackVersion() const { return mUsingFallbackVersion; }
+
+        /** Mark a macro definition as changing the resources the program reads, for example the uniform-buffers and storage buffers its shaders declare.
+            The caller sets the resources of the version it requested, so a fallback version which reads different resources would render garbage. With asynchronous compilation, a version is only used as a fallback if the define is set to the same value in both versions, or is missing from both.
+            \param[in] name The name of the define
+        */
+        void addLayoutDefine(const std::string& name) { mLayoutDefines.insert(name); }
+
+        /** Start compiling versions of the program which are expected to be used, so that they are ready when they are requested. The shaders are preprocessed on worker threads, then compilePendingVersions() compiles them.
+            Versions which were already compiled or requested are ignored.
+            \param[in] defineLists The full macro definition list of each version
+        */
+        void prewarm(const std::vector<DefineList>& defineLists);
+
+        /** Compile the program versions whose shaders finished preprocessing on the worker threads. Sample calls it once per frame. The API objects are created on the calling thread, which must own the device context.
+            \param[in] maxVersions The maximum number of versions to compile, across all programs. Limits the time spent in a single call.
+            \return The number of versions which were compiled
+        */
+        static uint32_t compilePendingVersions(uint32_t maxVersions);
+
         /** Adds a macro definition to the program. If the macro already exists, its will be replaced.
 
             \param[in] name The name of define. Must be valid
@@ -181,7 +213,40 @@ namespace Falcor
 
         Program();
         static SharedPtr createInternal(const std::string& vs, const std::string& fs, const std::string& gs, const std::string& hs, const std::string& ds, const DefineList& programDefines, bool createdFromFile);
-        ProgramVersion::SharedConstPtr link() const;
+
+        // The preprocessed shaders of a version, and its cached binary if there is one
+        struct PreprocessedVersion
+        {
+            std::string sources[kShaderCount];
+            std::string errorMsg;
+            uint64_t binaryKey = 0;
+            uint32_t binaryFormat = 0;
+            std::vector<uint8_t> binary;
+        };
+
+        // A version which is preprocessed on a worker thread. The worker only accesses this object, so it can outlive the program.
+        struct PendingVersion
+        {
+            std::string shaderStrings[kShaderCount];
+            bool createdFromFile;
+            DefineList defines;
+            std::string compilerIdentity;
+
+            PreprocessedVersion preprocessed;
+            bool succeeded = false;
+            std::promise<void> done;
+            std::future<void> doneFuture;
+
+            bool isDone() const { return doneFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+        };
+
+        // Thread-safe
+        static bool preprocess(const std::string shaderStrings[kShaderCount], bool createdFromFile, const DefineList& defines, const std::string& compilerIdentity, PreprocessedVersion& result);
+        ProgramVersion::SharedConstPtr createVersion(const PreprocessedVersion& preprocessed, bool& retry) const;
+        ProgramVersion::SharedConstPtr link(const DefineList& defines) const;
+        void queueVersion(const DefineList& defines) const;
+        ProgramVersion::SharedConstPtr finishPendingVersion(const DefineList& defines, PendingVersion& pending) const;
+        ProgramVersion::SharedConstPtr findFallbackVersion(const DefineList& defines) const;
         std::string mShaderStrings[kShaderCount]; // Either a filename or a string, depending on the value of mCreatedFromFile
 
         DefineList mDefineList;
@@ -192,6 +257,11 @@ namespace Falcor
         mutable ProgramVersion::SharedConstPtr mpActiveProgram = nullptr;
         mutable std::map<const std::string, UniformBuffer::SharedPtr> mUboMap;
 
+        bool mAsyncCompilation = false;
+        mutable bool mUsingFallbackVersion = false;
+        std::set<std::string> mLayoutDefines;
+        mutable std::map<const DefineList, std::shared_ptr<PendingVersion>> mPendingVersions;
+
         std::string getProgramDescString() const;
         static std::vector<Program*> sPrograms;
 
@@ -0,0 +1,170 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "ResourceCache.h"
+#include "Utils/Hash.h"
+
+namespace Falcor
+{
+    std::mutex ResourceCache::sMutex;
+    ResourceCache::EntryMap<Texture> ResourceCache::sTextures;
+    ResourceCache::EntryMap<Buffer> ResourceCache::sBuffers;
+    ResourceCache::Stats ResourceCache::sStats;
+
+    ResourceCache::Key::Key(const void* pData, size_t size, const void* pDesc, size_t descSize)
+    {
+        contentHash = calculateHash64(pData, size);
+        descHash = calculateHash64(pDesc, descSize, size);
+    }
+
+    template<typename T>
+    std::shared_ptr<T> ResourceCache::find(EntryMap<T>& entries, const Key& key)
+    {
+        auto it = entries.find(key);
+        if(it != entries.end())
+        {
+            std::shared_ptr<T> pResource = it->second.pResource.lock();
+            if(pResource)
+            {
+                sStats.hits++;
+                sStats.bytesSaved += it->second.dataSize;
+                return pResource;
+            }
+            entries.erase(it);
+        }
+
+        sStats.misses++;
+        return nullptr;
+    }
+
+    template<typename T>
+    void ResourceCache::add(EntryMap<T>& entries, const Key& key, const std::shared_ptr<T>& pResource, size_t dataSize)
+    {
+        // Entries are only removed when they are looked up after their resource was released. Prune the map when it doubles in size, so that it doesn't grow without bound
+        static size_t sizeAfterPrune = 0;
+        if(entries.size() >= 2 * sizeAfterPrune + 64)
+        {
+            for(auto it = entries.begin(); it != entries.end();)
+            {
+                it = it->second.pResource.expired() ? entries.erase(it) : std::next(it);
+            }
+            sizeAfterPrune = entries.size();
+        }
+
+        Entry<T>& entry = entries[key];
+        entry.pResource = pResource;
+        entry.dataSize = dataSize;
+    }
+
+    size_t ResourceCache::getTextureDataSize(uint32_t width, uint32_t height, ResourceFormat format)
+    {
+        uint32_t widthRatio = getFormatWidthCompressionRatio(format);
+        uint32_t heightRatio = getFormatHeightCompressionRatio(format);
+        size_t blocks = size_t((width + widthRatio - 1) / widthRatio) * ((height + heightRatio - 1) / heightRatio);
+        return blocks * getFormatBytesPerBlock(format);
+    }
+
+    Texture::SharedPtr ResourceCache::createTexture2D(uint32_t width, uint32_t height, ResourceFormat format, uint32_t arraySize, uint32_t mipLevels, const void* pInitData)
+    {
+        assert(pInitData);
+        struct
+        {
+            uint32_t width, height, arraySize, mipLevels;
+            ResourceFormat format;
+        } desc = {width, height, arraySize, mipLevels, format};
+
+        size_t dataSize = getTextureDataSize(width, height, format) * arraySize;
+        Key key(pInitData, dataSize, &desc, sizeof(desc));
+
+        std::lock_guard<std::mutex> lock(sMutex);
+        Texture::SharedPtr pTexture = find(sTextures, key);
+        if(pTexture == nullptr)
+        {
+            pTexture = Texture::create2D(width, height, format, arraySize, mipLevels, pInitData);
+            if(pTexture)
+            {
+                add(sTextures, key, pTexture, dataSize);
+            }
+        }
+        return pTexture;
+    }
+
+    Buffer::SharedPtr ResourceCache::createBuffer(size_t size, Buffer::BindFlags bind, Buffer::AccessFlags access, const void* pInitData)
+    {
+        assert(pInitData);
+        struct
+        {
+            Buffer::BindFlags bind;
+            Buffer::AccessFlags access;
+        } desc = {bind, access};
+        Key key(pInitData, size, &desc, sizeof(desc));
+
+        std::lock_guard<std::mutex> lock(sMutex);
+        Buffer::SharedPtr pBuffer = find(sBuffers, key);
+        if(pBuffer == nullptr)
+        {
+            pBuffer = Buffer::create(size, bind, access, pInitData);
+            if(pBuffer)
+            {
+                add(sBuffers, key, pBuffer, size);
+            }
+        }
+        return pBuffer;
+    }
+
+    Texture::SharedPtr ResourceCache::findTexture(const Key& key)
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        return find(sTextures, key);
+    }
+
+    void ResourceCache::addTexture(const Key& key, const Texture::SharedPtr& pTexture, size_t dataSize)
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        add(sTextures, key, pTexture, dataSize);
+    }
+
+    ResourceCache::Stats ResourceCache::getStats()
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        return sStats;
+    }
+
+    void ResourceCache::resetStats()
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        sStats = Stats();
+    }
+
+    void ResourceCache::clear()
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        sTextures.clear();
+        sBuffers.clear();
+    }
+}
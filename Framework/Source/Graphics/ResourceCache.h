@@ -0,0 +1,122 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <map>
+#include <memory>
+#include <mutex>
+#include "Core/Texture.h"
+#include "Core/Buffer.h"
+
+namespace Falcor
+{
+    /** Process-wide cache of GPU resources, keyed by the hash of their content and description.
+        Loaders create their resources through the cache, so identical textures and buffers referenced by multiple models are only uploaded once.
+        The cache only holds weak references. A resource is released when the last model using it is destroyed, and the next request for it creates it again.
+        Resources returned by the cache are shared, so they shouldn't be modified.
+    */
+    class ResourceCache
+    {
+    public:
+        struct Stats
+        {
+            uint64_t hits = 0;          ///< Number of requests which returned an existing resource
+            uint64_t misses = 0;        ///< Number of requests which had to create a new resource
+            uint64_t bytesSaved = 0;    ///< Total size of the data which wasn't uploaded because of hits
+        };
+
+        /** Identifies a resource. contentHash is the hash of the data used to create the resource, descHash is the hash of everything else which affects it (format, size, flags)
+        */
+        struct Key
+        {
+            Key() = default;
+            Key(const void* pData, size_t size, const void* pDesc, size_t descSize);
+            uint64_t contentHash = 0;
+            uint64_t descHash = 0;
+            bool operator<(const Key& other) const { return (contentHash < other.contentHash) || (contentHash == other.contentHash && descHash < other.descHash); }
+        };
+
+        /** Get a 2D texture with the requested description and content. Arguments match Texture::create2D().
+            If a matching texture is alive it is returned, otherwise a new texture is created and added to the cache.
+        */
+        static Texture::SharedPtr createTexture2D(uint32_t width, uint32_t height, ResourceFormat format, uint32_t arraySize, uint32_t mipLevels, const void* pInitData);
+
+        /** Get a buffer with the requested description and content. Arguments match Buffer::create(), but pInitData can't be nullptr.
+            If a matching buffer is alive it is returned, otherwise a new buffer is created and added to the cache.
+        */
+        static Buffer::SharedPtr createBuffer(size_t size, Buffer::BindFlags bind, Buffer::AccessFlags access, const void* pInitData);
+
+        /** Look for a texture using a user-defined key. Use it for textures which are identified by something other than their initial data, for example the content of the file they were loaded from.
+            \return The texture if it is alive, otherwise nullptr. A failed search is counted as a miss.
+        */
+        static Texture::SharedPtr findTexture(const Key& key);
+
+        /** Add a texture to the cache
+            \param[in] key The texture's key
+            \param[in] pTexture The texture
+            \param[in] dataSize Size of the data used to create the texture. Reported in the stats when the texture is reused.
+        */
+        static void addTexture(const Key& key, const Texture::SharedPtr& pTexture, size_t dataSize);
+
+        /** Get the cache statistics
+        */
+        static Stats getStats();
+
+        /** Reset the cache statistics
+        */
+        static void resetStats();
+
+        /** Remove all the entries from the cache. Doesn't affect resources which are already in use.
+        */
+        static void clear();
+
+        /** Get the size of a texture's most detailed mip-level in bytes
+        */
+        static size_t getTextureDataSize(uint32_t width, uint32_t height, ResourceFormat format);
+
+    private:
+        template<typename T>
+        struct Entry
+        {
+            std::weak_ptr<T> pResource;
+            size_t dataSize = 0;
+        };
+
+        template<typename T>
+        using EntryMap = std::map<Key, Entry<T>>;
+
+        template<typename T>
+        static std::shared_ptr<T> find(EntryMap<T>& entries, const Key& key);
+        template<typename T>
+        static void add(EntryMap<T>& entries, const Key& key, const std::shared_ptr<T>& pResource, size_t dataSize);
+
+        static std::mutex sMutex;
+        static EntryMap<Texture> sTextures;
+        static EntryMap<Buffer> sBuffers;
+        static Stats sStats;
+    };
+}
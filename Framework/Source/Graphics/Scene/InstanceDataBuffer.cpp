@@ -0,0 +1,85 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "InstanceDataBuffer.h"
+
+namespace Falcor
+{
+    InstanceDataBuffer::InstanceDataBuffer(uint32_t elementCount, uint32_t elementSize) : mAllocator(elementCount), mElementSize(elementSize)
+    {
+    }
+
+    InstanceDataBuffer::SharedPtr InstanceDataBuffer::create(uint32_t elementCount, uint32_t elementSize)
+    {
+        SharedPtr pBuffer = SharedPtr(new InstanceDataBuffer(elementCount, elementSize));
+        pBuffer->mpBuffer = Buffer::create(size_t(elementCount) * elementSize, Buffer::BindFlags::ShaderResource, Buffer::AccessFlags::MapWrite | Buffer::AccessFlags::Persistent, nullptr);
+        if(pBuffer->mpBuffer == nullptr)
+        {
+            return nullptr;
+        }
+
+        // The buffer is mapped once. The mapping is coherent, so writes are visible to draws issued after them.
+        pBuffer->mpData = (uint8_t*)pBuffer->mpBuffer->map(Buffer::MapType::Write);
+        if(pBuffer->mpData == nullptr)
+        {
+            Logger::log(Logger::Level::Error, "InstanceDataBuffer::create() - can't map the buffer persistently");
+            return nullptr;
+        }
+        pBuffer->mpFence = GpuFence::create();
+        return pBuffer;
+    }
+
+    InstanceDataBuffer::~InstanceDataBuffer()
+    {
+        if(mpData)
+        {
+            mpBuffer->unmap();
+        }
+    }
+
+    uint32_t InstanceDataBuffer::allocate(uint32_t count)
+    {
+        mAllocator.releaseCompleted(mpFence->getCompletedValue());
+        uint32_t offset = mAllocator.allocate(count);
+
+        // Wait for the oldest frames one at a time, until enough space is released
+        while(offset == kInvalidOffset && mAllocator.getOldestPendingFence() != 0)
+        {
+            uint64_t fenceValue = mAllocator.getOldestPendingFence();
+            mpFence->wait(fenceValue);
+            mAllocator.releaseCompleted(fenceValue);
+            offset = mAllocator.allocate(count);
+        }
+        return offset;
+    }
+
+    void InstanceDataBuffer::endFrame()
+    {
+        mAllocator.endFrame(mpFence->signal());
+    }
+}
@@ -0,0 +1,86 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <memory>
+#include "Core/Buffer.h"
+#include "Core/GpuFence.h"
+#include "Utils/RingBufferAllocator.h"
+
+namespace Falcor
+{
+    /** A ring buffer of per-instance data which stays mapped for the lifetime of the object.
+        The CPU writes the data of a frame directly into GPU-visible memory, and the buffer is read by shaders as a shader storage buffer. Call endFrame() after issuing the frame's draws, the frame's space is reused once the GPU is done with it.
+        Only supported in OpenGL.
+    */
+    class InstanceDataBuffer
+    {
+    public:
+        using SharedPtr = std::shared_ptr<InstanceDataBuffer>;
+        using SharedConstPtr = std::shared_ptr<const InstanceDataBuffer>;
+
+        static const uint32_t kInvalidOffset = RingBufferAllocator::kInvalidOffset;
+
+        /** create a new object
+            \param[in] elementCount The number of elements in the buffer
+            \param[in] elementSize The size of an element in bytes
+            \return A new object, or nullptr if the buffer could not be created
+        */
+        static SharedPtr create(uint32_t elementCount, uint32_t elementSize);
+
+        /** Destroy the object
+        */
+        ~InstanceDataBuffer();
+
+        /** Allocate a contiguous range of elements for the current frame. If the buffer is full, blocks until the GPU is done with enough of the previous frames.
+            \param[in] count The number of elements
+            \return The index of the first element, or kInvalidOffset if the range doesn't fit even after waiting for the GPU
+        */
+        uint32_t allocate(uint32_t count);
+
+        /** Get a CPU pointer to an element. Only write to elements allocated in the current frame.
+        */
+        void* getData(uint32_t element) const { return mpData + size_t(element) * mElementSize; }
+
+        /** Close the current frame. Call after issuing all the draws which read the frame's elements.
+        */
+        void endFrame();
+
+        const Buffer::SharedPtr& getBuffer() const { return mpBuffer; }
+        uint32_t getElementCount() const { return mAllocator.getCapacity(); }
+        uint32_t getElementSize() const { return mElementSize; }
+
+    private:
+        InstanceDataBuffer(uint32_t elementCount, uint32_t elementSize);
+
+        RingBufferAllocator mAllocator;
+        Buffer::SharedPtr mpBuffer;
+        GpuFence::SharedPtr mpFence;
+        uint8_t* mpData = nullptr;
+        uint32_t mElementSize;
+    };
+}
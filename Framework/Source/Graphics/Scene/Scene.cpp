@@ -30,6 +30,7 @@
 #include "SceneImporter.h"
 #include "glm/gtx/euler_angles.hpp"
 #include "glm/gtc/matrix_transform.hpp"
+#include <algorithm>
 
 namespace Falcor
 {
@@ -90,6 +91,8 @@ namespace Falcor
         instance.translation = translate;
         instance.name = name;
         mModels[modelID].instances.push_back(instance);
+        onStructureChanged();
+        mModels[modelID].instances.back().generation = mGeneration;
         calculateModelInstanceMatrix(modelID, (uint32_t)mModels[modelID].instances.size() - 1);
 
         return (uint32_t)mModels[modelID].instances.size() - 1;
@@ -99,6 +102,7 @@ namespace Falcor
     {
         auto& instances = mModels[modelID].instances;
         instances.erase(instances.begin() + instanceID);
+        onStructureChanged();
     }
 
     void Scene::calculateModelInstanceMatrix(uint32_t modelID, uint32_t instanceID)
@@ -111,6 +115,193 @@ namespace Falcor
         instance.transformMatrix = translation * scaling * rotation;
     }
 
+    void Scene::onModelInstanceChanged(uint32_t modelID, uint32_t instanceID, bool moved)
+    {
+        mGeneration++;
+        mModels[modelID].instances[instanceID].generation = mGeneration;
+        mChangeLog.push_back({mGeneration, modelID, instanceID});
+        if(moved && (mIsBvhDirty == false))
+        {
+            mMovedInstances.push_back(std::make_pair(modelID, instanceID));
+        }
+
+        // Drop the entries of instances which changed again later. This keeps the log proportional to the number of changed instances, not to the number of changes.
+        if(mChangeLog.size() > 2 * mCompactChangeLogSize + 1024)
+        {
+            auto isSuperseded = [this](const ChangeLogEntry& entry)
+            {
+                return mModels[entry.modelID].instances[entry.instanceID].generation != entry.generation;
+            };
+            mChangeLog.erase(std::remove_if(mChangeLog.begin(), mChangeLog.end(), isSuperseded), mChangeLog.end());
+            mCompactChangeLogSize = mChangeLog.size();
+        }
+    }
+
+    void Scene::onStructureChanged()
+    {
+        // IDs might have changed, so the log can't be used to find the changes anymore
+        mGeneration++;
+        mStructureGeneration = mGeneration;
+        mChangeLog.clear();
+        mCompactChangeLogSize = 0;
+        mIsBvhDirty = true;
+    }
+
+    bool Scene::getChangedModelInstances(uint32_t sinceGeneration, std::vector<ModelInstanceRef>& changedInstances) const
+    {
+        changedInstances.clear();
+        if(sinceGeneration < mStructureGeneration)
+        {
+            return false;
+        }
+
+        auto isBefore = [](uint32_t generation, const ChangeLogEntry& entry) { return generation < entry.generation; };
+        auto it = std::upper_bound(mChangeLog.begin(), mChangeLog.end(), sinceGeneration, isBefore);
+        for(; it != mChangeLog.end(); it++)
+        {
+            // Only report an instance once, at its last change
+            if(mModels[it->modelID].instances[it->instanceID].generation == it->generation)
+            {
+                changedInstances.push_back({it->modelID, it->instanceID});
+            }
+        }
+        return true;
+    }
+
+    void Scene::rebuildBvh()
+    {
+        mBvhItems.clear();
+        mRenderProxies.worldMatrices.clear();
+        mRenderProxies.worldBoxes.clear();
+        mRenderProxies.meshIds.clear();
+        mRenderProxies.materialIds.clear();
+        std::vector<BoundingBox> boxes;
+        for(uint32_t modelID = 0; modelID < getModelCount(); modelID++)
+        {
+            ModelData& modelData = mModels[modelID];
+            const Model* pModel = modelData.pModel.get();
+            modelData.bvhItemOffset = (uint32_t)mBvhItems.size();
+            modelData.modelGeneration = pModel->getStructureGeneration();
+            modelData.meshInstanceCount = 0;
+            for(uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                modelData.meshInstanceCount += pModel->getMesh(meshID)->getInstanceCount();
+            }
+            for(uint32_t instanceID = 0; instanceID < (uint32_t)modelData.instances.size(); instanceID++)
+            {
+                const glm::mat4& transform = modelData.instances[instanceID].transformMatrix;
+                for(uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+                {
+                    const Mesh* pMesh = pModel->getMesh(meshID).get();
+                    const Material* pMaterial = pMesh->getMaterial().get();
+                    uint32_t materialId = pMaterial ? (uint32_t)pMaterial->getId() : RenderProxies::kInvalidMaterialId;
+                    for(uint32_t meshInstanceID = 0; meshInstanceID < pMesh->getInstanceCount(); meshInstanceID++)
+                    {
+                        mBvhItems.push_back({modelID, instanceID, meshID, meshInstanceID});
+                        boxes.push_back(pMesh->getInstanceBoundingBox(meshInstanceID).transform(transform));
+                        mRenderProxies.worldMatrices.push_back(pMesh->hasBones() ? transform : transform * pMesh->getInstanceMatrix(meshInstanceID));
+                        mRenderProxies.worldBoxes.push_back(boxes.back());
+                        mRenderProxies.meshIds.push_back(pMesh->getId());
+                        mRenderProxies.materialIds.push_back(materialId);
+                    }
+                }
+            }
+        }
+
+        mBvh.build(boxes.data(), (uint32_t)boxes.size());
+        mMovedInstances.clear();
+        mIsBvhDirty = false;
+    }
+
+    void Scene::refitBvh()
+    {
+        // An instance can be moved several times between updates
+        std::sort(mMovedInstances.begin(), mMovedInstances.end());
+        mMovedInstances.erase(std::unique(mMovedInstances.begin(), mMovedInstances.end()), mMovedInstances.end());
+
+        for(const auto& moved : mMovedInstances)
+        {
+            const Model* pModel = mModels[moved.first].pModel.get();
+            const glm::mat4& transform = mModels[moved.first].instances[moved.second].transformMatrix;
+            uint32_t item = getBvhItemOffset(moved.first, moved.second);
+            for(uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                const Mesh* pMesh = pModel->getMesh(meshID).get();
+                for(uint32_t meshInstanceID = 0; meshInstanceID < pMesh->getInstanceCount(); meshInstanceID++, item++)
+                {
+                    BoundingBox box = pMesh->getInstanceBoundingBox(meshInstanceID).transform(transform);
+                    mRenderProxies.worldMatrices[item] = pMesh->hasBones() ? transform : transform * pMesh->getInstanceMatrix(meshInstanceID);
+                    mRenderProxies.worldBoxes.set(item, box);
+                    mBvh.updateItem(item, box);
+                }
+            }
+        }
+        mBvh.refit();
+        mMovedInstances.clear();
+    }
+
+    void Scene::updateSpatialData()
+    {
+        // Meshes or mesh instances which were added to or removed from a model move the BVH items of all the following mesh instances
+        for(uint32_t modelID = 0; (modelID < getModelCount()) && (mIsBvhDirty == false); modelID++)
+        {
+            if(mModels[modelID].modelGeneration != mModels[modelID].pModel->getStructureGeneration())
+            {
+                onStructureChanged();
+            }
+        }
+
+        if(mIsBvhDirty)
+        {
+            rebuildBvh();
+        }
+        else if(mMovedInstances.size())
+        {
+            refitBvh();
+        }
+    }
+
+    const BoundingVolumeHierarchy& Scene::getBvh()
+    {
+        updateSpatialData();
+        return mBvh;
+    }
+
+    const Scene::RenderProxies& Scene::getRenderProxies()
+    {
+        updateSpatialData();
+        return mRenderProxies;
+    }
+
+    bool Scene::pickMeshInstance(const glm::vec3& origin, const glm::vec3& direction, MeshInstanceRef& hit, float& distance)
+    {
+        const BoundingVolumeHierarchy& bvh = getBvh();
+        auto isVisible = [this](uint32_t item)
+        {
+            return getModelInstance(mBvhItems[item].modelID, mBvhItems[item].modelInstanceID).isVisible;
+        };
+
+        uint32_t item;
+        if(bvh.intersectRay(origin, direction, item, distance, FLT_MAX, isVisible))
+        {
+            hit = mBvhItems[item];
+            return true;
+        }
+        return false;
+    }
+
+    void Scene::queryMeshInstances(const BoundingBox& box, std::vector<MeshInstanceRef>& meshInstances)
+    {
+        std::vector<uint32_t> items;
+        getBvh().queryBoundingBox(box, items);
+        meshInstances.clear();
+        meshInstances.reserve(items.size());
+        for(uint32_t item : items)
+        {
+            meshInstances.push_back(mBvhItems[item]);
+        }
+    }
+
     const Scene::UserVariable& Scene::getUserVariable(const std::string& name)
     {
         const auto& a = mUserVars.find(name);
@@ -146,6 +337,7 @@ namespace Falcor
     {
         mModels.push_back(ModelData(pModel, filename)); 
 		uint32_t modelID = (uint32_t)mModels.size() - 1;
+		onStructureChanged();
 		if (createIdentityInstance)
 		{
 			addModelInstance(modelID, pModel->getName(), vec3(0.0), vec3(1.0), vec3(0.0));
@@ -156,6 +348,7 @@ namespace Falcor
     void Scene::deleteModel(uint32_t modelID)
     {
         mModels.erase(mModels.begin() + modelID);
+        onStructureChanged();
     }
 
     uint32_t Scene::addLight(const Light::SharedPtr& pLight)
@@ -213,18 +406,40 @@ namespace Falcor
     {
         mModels[modelID].instances[instanceID].translation = translation;
         calculateModelInstanceMatrix(modelID, instanceID);
+        onModelInstanceChanged(modelID, instanceID, true);
     }
 
     void Scene::setModelInstanceRotation(uint32_t modelID, uint32_t instanceID, const glm::vec3& rotation)
     {
         mModels[modelID].instances[instanceID].rotation = rotation;
         calculateModelInstanceMatrix(modelID, instanceID);
+        onModelInstanceChanged(modelID, instanceID, true);
     }
 
     void Scene::setModelInstanceScaling(uint32_t modelID, uint32_t instanceID, const glm::vec3& scaling)
     {
         mModels[modelID].instances[instanceID].scaling = scaling;
         calculateModelInstanceMatrix(modelID, instanceID);
+        onModelInstanceChanged(modelID, instanceID, true);
+    }
+
+    void Scene::setModelInstanceTransform(uint32_t modelID, uint32_t instanceID, const glm::vec3& translation, const glm::vec3& rotation, const glm::vec3& scaling)
+    {
+        ModelInstance& instance = mModels[modelID].instances[instanceID];
+        instance.translation = translation;
+        instance.rotation = rotation;
+        instance.scaling = scaling;
+        calculateModelInstanceMatrix(modelID, instanceID);
+        onModelInstanceChanged(modelID, instanceID, true);
+    }
+
+    void Scene::setModelInstanceVisible(uint32_t modelID, uint32_t instanceID, bool isVisible)
+    {
+        if(mModels[modelID].instances[instanceID].isVisible != isVisible)
+        {
+            mModels[modelID].instances[instanceID].isVisible = isVisible;
+            onModelInstanceChanged(modelID, instanceID, false);
+        }
     }
 
     void Scene::setActiveCamera(uint32_t camID)
@@ -272,6 +487,10 @@ namespace Falcor
         merge(mCameras);
 #undef merge
         mUserVars.insert(pFrom->mUserVars.begin(), pFrom->mUserVars.end());
+
+        // Keep the generation larger than the generations of the merged instances
+        mGeneration = std::max(mGeneration, pFrom->mGeneration);
+        onStructureChanged();
     }
 
 	void Scene::createAreaLights()
@@ -35,6 +35,7 @@
 #include "Graphics/Camera/Camera.h"
 #include "Graphics/Camera/CameraController.h"
 #include "Graphics/Paths/ObjectPath.h"
+#include "Utils/Math/BoundingVolumeHierarchy.h"
 
 namespace Falcor
 {
@@ -85,6 +86,24 @@ namespace Falcor
             UserVariable(const std::string& s) : str(s),            type(Type::String)    { }
         };
 
+        /** Identifies a single mesh instance of a model instance
+        */
+        struct MeshInstanceRef
+        {
+            uint32_t modelID;
+            uint32_t modelInstanceID;
+            uint32_t meshID;
+            uint32_t meshInstanceID;
+        };
+
+        /** Identifies a model instance
+        */
+        struct ModelInstanceRef
+        {
+            uint32_t modelID;
+            uint32_t modelInstanceID;
+        };
+
         struct ModelInstance
         {
             std::string name;
@@ -93,6 +112,19 @@ namespace Falcor
             glm::vec3 rotation;
             glm::vec3 translation;
             bool isVisible = true;
+            uint32_t generation = 0;    ///< The scene generation of the last change to the instance. See Scene::getGeneration().
+        };
+
+        /** A flattened table of the mesh instances of all the model instances, with the data needed to render them. Indexed by BVH item.
+            The table is built once and shared by all the views rendering the scene. Only the entries of model instances which moved are updated.
+        */
+        struct RenderProxies
+        {
+            std::vector<glm::mat4> worldMatrices;   ///< The final world matrices. Skinned meshes use the model instance transform, like the renderer.
+            BoundingBoxSoA worldBoxes;              ///< The world-space bounding-boxes
+            std::vector<uint32_t> meshIds;          ///< Mesh::getId()
+            std::vector<uint32_t> materialIds;      ///< The ID of the mesh's material, or kInvalidMaterialId if the mesh has no material
+            static const uint32_t kInvalidMaterialId = uint32_t(-1);
         };
 
 		/**
@@ -124,10 +156,64 @@ namespace Falcor
         void setModelInstanceRotation(uint32_t modelID, uint32_t instanceID, const glm::vec3& rotation);
         void setModelInstanceScaling(uint32_t modelID, uint32_t instanceID, const glm::vec3& scaling);
 
-        void setModelInstanceVisible(uint32_t modelID, uint32_t instanceID, bool isVisible) { mModels[modelID].instances[instanceID].isVisible = isVisible; }
+        /** Set the translation, rotation and scaling of a model instance at once. Cheaper than calling the individual setters, since the transform matrix is only calculated once.
+        */
+        void setModelInstanceTransform(uint32_t modelID, uint32_t instanceID, const glm::vec3& translation, const glm::vec3& rotation, const glm::vec3& scaling);
+
+        void setModelInstanceVisible(uint32_t modelID, uint32_t instanceID, bool isVisible);
         uint32_t addModelInstance(uint32_t modelID, const std::string& name, const glm::vec3& rotate, const glm::vec3& scale, const glm::vec3& translate);
         void deleteModelInstance(uint32_t modelID, uint32_t instanceID);
 
+        // Spatial queries
+        /** Get the BVH over the world-space bounding-boxes of all the mesh instances in the scene, including hidden model instances.
+            The BVH is rebuilt after models or model instances are added or removed, or the meshes of a model change (see Model::getStructureGeneration()), and refitted after model instances move.
+            The items of a model instance are contiguous, sorted by mesh ID and mesh instance ID. Use getBvhItem() and getBvhItemOffset() to translate between items and mesh instances.
+        */
+        const BoundingVolumeHierarchy& getBvh();
+
+        /** Get the mesh instance a BVH item refers to. Only valid after getBvh() was called.
+        */
+        const MeshInstanceRef& getBvhItem(uint32_t item) const { return mBvhItems[item]; }
+
+        /** Get the BVH item of the first mesh instance of a model instance. Only valid after getBvh() was called.
+        */
+        uint32_t getBvhItemOffset(uint32_t modelID, uint32_t instanceID) const { return mModels[modelID].bvhItemOffset + instanceID * mModels[modelID].meshInstanceCount; }
+
+        /** Find the closest visible mesh instance whose world-space bounding-box is hit by a ray
+            \param[in] origin The ray origin
+            \param[in] direction The ray direction
+            \param[out] hit The mesh instance which was hit
+            \param[out] distance The distance to the hit along the ray, in multiples of direction
+            \return true if a mesh instance was hit, otherwise false
+        */
+        bool pickMeshInstance(const glm::vec3& origin, const glm::vec3& direction, MeshInstanceRef& hit, float& distance);
+
+        /** Find the mesh instances whose world-space bounding-box overlaps a box
+        */
+        void queryMeshInstances(const BoundingBox& box, std::vector<MeshInstanceRef>& meshInstances);
+
+        /** Get the render proxies of all the mesh instances, indexed by BVH item. Brings the table up to date first, only the mesh instances of model instances which moved since the last call are recalculated.
+        */
+        const RenderProxies& getRenderProxies();
+
+        // Change tracking
+        /** Get the scene generation. The generation is incremented by every change to the model instances: transforms, visibility, and adding or removing models and model instances.
+            Store the generation after processing the scene, and pass it to getChangedModelInstances() on the next frame to process only what changed.
+        */
+        uint32_t getGeneration() const { return mGeneration; }
+
+        /** Get the generation of the last time models or model instances were added or removed. IDs and BVH items from older generations are no longer valid.
+            Meshes or mesh instances added to or removed from a model also change the structure. These changes are detected by getBvh() and getRenderProxies().
+        */
+        uint32_t getStructureGeneration() const { return mStructureGeneration; }
+
+        /** Get the model instances which changed after a generation
+            \param[in] sinceGeneration A value returned by getGeneration()
+            \param[out] changedInstances The instances whose generation is larger than sinceGeneration, in the order of their last change
+            \return false if models or model instances were added or removed after sinceGeneration. changedInstances is empty in that case, and everything should be processed again.
+        */
+        bool getChangedModelInstances(uint32_t sinceGeneration, std::vector<ModelInstanceRef>& changedInstances) const;
+
         // Light sources
         uint32_t addLight(const Light::SharedPtr& pLight);
         void deleteLight(uint32_t lightID);
@@ -208,6 +294,11 @@ namespace Falcor
 		uint32_t mId;
 
         void calculateModelInstanceMatrix(uint32_t modelID, uint32_t instanceID);
+        void onModelInstanceChanged(uint32_t modelID, uint32_t instanceID, bool moved);
+        void onStructureChanged();
+        void updateSpatialData();
+        void rebuildBvh();
+        void refitBvh();
         void detachActiveCameraFromPath();
         void attachActiveCameraToPath();
 
@@ -216,6 +307,9 @@ namespace Falcor
             Model::SharedPtr pModel;
             std::string Filename;
             std::vector<ModelInstance> instances;
+            uint32_t bvhItemOffset = 0;
+            uint32_t meshInstanceCount = 0;     // The model's mesh instance count and structure generation when the BVH was built
+            uint32_t modelGeneration = 0;
 
             ModelData(const Model::SharedPtr& pModel, const std::string& _Filename) : pModel(pModel), Filename(_Filename) {}
         };
@@ -233,6 +327,23 @@ namespace Falcor
         float mLightingScale = 1.0f;
         uint32_t mVersion = 0;
 
+        BoundingVolumeHierarchy mBvh;
+        std::vector<MeshInstanceRef> mBvhItems;
+        RenderProxies mRenderProxies;
+        std::vector<std::pair<uint32_t, uint32_t>> mMovedInstances;    // Model and instance IDs of the model instances which moved since the BVH was refitted. Can contain duplicates.
+        bool mIsBvhDirty = true;
+
+        struct ChangeLogEntry
+        {
+            uint32_t generation;
+            uint32_t modelID;
+            uint32_t instanceID;
+        };
+        std::vector<ChangeLogEntry> mChangeLog;     // Sorted by generation. Cleared when the structure changes.
+        size_t mCompactChangeLogSize = 0;           // The log size after the last compaction
+        uint32_t mGeneration = 0;
+        uint32_t mStructureGeneration = 0;
+
         using string_uservar_map = std::map<const std::string, UserVariable>;
         string_uservar_map mUserVars;
         static const UserVariable kInvalidVar;
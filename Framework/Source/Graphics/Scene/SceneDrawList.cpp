@@ -0,0 +1,225 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "SceneDrawList.h"
+#include "Utils/ThreadPool.h"
+#include "glm/geometric.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace Falcor
+{
+    void SceneDrawList::build(const std::vector<ModelInstanceDesc>& modelInstances, const std::vector<MeshDesc>& meshes, const ViewDesc& view, ThreadPool* pThreadPool)
+    {
+        // Flatten the model instances into groups of mesh instances
+        mGroups.clear();
+        mGroupOffsets.clear();
+        uint32_t instanceCount = 0;
+        uint32_t visibilityItemEnd = 0;
+        for(uint32_t i = 0; i < (uint32_t)modelInstances.size(); i++)
+        {
+            const ModelInstanceDesc& modelInstance = modelInstances[i];
+            uint32_t visibilityItem = modelInstance.firstVisibilityItem;
+            for(uint32_t mesh = modelInstance.firstMesh; mesh < modelInstance.firstMesh + modelInstance.meshCount; mesh++)
+            {
+                mGroups.push_back({i, mesh, visibilityItem});
+                mGroupOffsets.push_back(instanceCount);
+                visibilityItem += meshes[mesh].instanceCount;
+                instanceCount += meshes[mesh].instanceCount;
+            }
+            visibilityItemEnd = std::max(visibilityItemEnd, visibilityItem);
+        }
+        mGroupOffsets.push_back(instanceCount);
+
+        // The per-item data must have been built for the same meshes. Otherwise the chunks read past it.
+        assert((view.pItemViewMasks == nullptr) || (visibilityItemEnd <= (uint32_t)view.pItemViewMasks->size()));
+        assert((view.pItemWorldBoxes == nullptr) || (visibilityItemEnd <= view.pItemWorldBoxes->size()));
+
+        // The chunks depend only on the instance count, which keeps the result independent of the number of threads
+        uint32_t chunkCount = (instanceCount + kChunkSize - 1) / kChunkSize;
+        if(mChunks.size() < chunkCount)
+        {
+            mChunks.resize(chunkCount);
+        }
+
+        auto buildFunc = [&](uint32_t chunk) { buildChunk(chunk, modelInstances, meshes, view); };
+        if(pThreadPool && chunkCount > 1)
+        {
+            pThreadPool->parallelFor(chunkCount, buildFunc);
+        }
+        else
+        {
+            for(uint32_t chunk = 0; chunk < chunkCount; chunk++)
+            {
+                buildFunc(chunk);
+            }
+        }
+
+        // Concatenate the chunks
+        mDraws.clear();
+        uint32_t matrixCount = 0;
+        for(uint32_t chunk = 0; chunk < chunkCount; chunk++)
+        {
+            matrixCount += (uint32_t)mChunks[chunk].worldMatrices.size();
+        }
+        mWorldMatrices.resize(matrixCount);
+        mVisibilityItems.resize(matrixCount);
+
+        uint32_t firstInstance = 0;
+        for(uint32_t chunk = 0; chunk < chunkCount; chunk++)
+        {
+            const Chunk& data = mChunks[chunk];
+            for(Draw draw : data.draws)
+            {
+                draw.firstInstance += firstInstance;
+                mDraws.push_back(draw);
+            }
+            std::copy(data.worldMatrices.begin(), data.worldMatrices.end(), mWorldMatrices.begin() + firstInstance);
+            std::copy(data.visibilityItems.begin(), data.visibilityItems.end(), mVisibilityItems.begin() + firstInstance);
+            firstInstance += (uint32_t)data.worldMatrices.size();
+        }
+    }
+
+    void SceneDrawList::buildChunk(uint32_t chunkIndex, const std::vector<ModelInstanceDesc>& modelInstances, const std::vector<MeshDesc>& meshes, const ViewDesc& view)
+    {
+        Chunk& chunk = mChunks[chunkIndex];
+        chunk.draws.clear();
+        chunk.worldMatrices.clear();
+        chunk.visibilityItems.clear();
+
+        const uint32_t chunkBegin = chunkIndex * kChunkSize;
+        const uint32_t chunkEnd = std::min(chunkBegin + kChunkSize, mGroupOffsets.back());
+
+        // Find the group containing the first instance. Empty groups are skipped by upper_bound().
+        uint32_t group = uint32_t(std::upper_bound(mGroupOffsets.begin(), mGroupOffsets.end(), chunkBegin) - mGroupOffsets.begin()) - 1;
+        for(; group < (uint32_t)mGroups.size() && mGroupOffsets[group] < chunkEnd; group++)
+        {
+            const Group& groupData = mGroups[group];
+            const ModelInstanceDesc& modelInstance = modelInstances[groupData.modelInstance];
+            const MeshDesc& mesh = meshes[groupData.mesh];
+            const uint32_t begin = std::max(chunkBegin, mGroupOffsets[group]) - mGroupOffsets[group];
+            const uint32_t end = std::min(chunkEnd, mGroupOffsets[group + 1]) - mGroupOffsets[group];
+            const uint32_t lodCount = std::max(mesh.lodCount, 1u);
+            const bool useLods = (view.lodProjectionScale > 0) && (lodCount > 1);
+
+            // Sort the visible instances into LODs
+            if(chunk.lodInstances.size() < lodCount)
+            {
+                chunk.lodInstances.resize(lodCount);
+            }
+            for(uint32_t lod = 0; lod < lodCount; lod++)
+            {
+                chunk.lodInstances[lod].clear();
+            }
+
+            for(uint32_t instance = begin; instance < end; instance++)
+            {
+                const uint32_t item = groupData.firstVisibilityItem + instance;
+                if(view.pItemViewMasks && (((*view.pItemViewMasks)[item] & view.viewMask) == 0))
+                {
+                    continue;
+                }
+
+                uint32_t lod = 0;
+                if(useLods)
+                {
+                    // The LOD is selected using the mesh instance matrix even for skinned meshes
+                    BoundingBox worldBox = view.pItemWorldBoxes ? view.pItemWorldBoxes->get(item) : mesh.pInstanceBoxes[instance].transform(modelInstance.transform);
+                    glm::mat4 world = (view.pItemWorldMatrices && (mesh.hasBones == false)) ? view.pItemWorldMatrices[item] : modelInstance.transform * mesh.pInstanceMatrices[instance];
+                    lod = Mesh::selectLod(mesh.pLods, lodCount, worldBox, world, view.cameraPosition, view.lodProjectionScale, view.maxPixelError);
+                }
+                chunk.lodInstances[lod].push_back(instance);
+            }
+
+            // Emit the draws
+            for(uint32_t lod = 0; lod < lodCount; lod++)
+            {
+                const auto& instances = chunk.lodInstances[lod];
+                for(uint32_t first = 0; first < (uint32_t)instances.size(); first += view.maxInstanceCount)
+                {
+                    Draw draw;
+                    draw.modelInstance = groupData.modelInstance;
+                    draw.mesh = groupData.mesh;
+                    draw.lod = lod;
+                    draw.firstInstance = (uint32_t)chunk.worldMatrices.size();
+                    draw.instanceCount = std::min(view.maxInstanceCount, (uint32_t)instances.size() - first);
+
+                    for(uint32_t i = first; i < first + draw.instanceCount; i++)
+                    {
+                        const uint32_t item = groupData.firstVisibilityItem + instances[i];
+                        if(view.pItemWorldMatrices)
+                        {
+                            chunk.worldMatrices.push_back(view.pItemWorldMatrices[item]);
+                        }
+                        else
+                        {
+                            chunk.worldMatrices.push_back(mesh.hasBones ? modelInstance.transform : modelInstance.transform * mesh.pInstanceMatrices[instances[i]]);
+                        }
+                        chunk.visibilityItems.push_back(item);
+                    }
+                    draw.depth = glm::length(glm::vec3(chunk.worldMatrices[draw.firstInstance][3]) - view.cameraPosition);
+                    chunk.draws.push_back(draw);
+                }
+            }
+        }
+    }
+
+    uint64_t SceneDrawList::createSortKey(bool isSkinned, uint64_t materialDescId, uint32_t materialId, uint32_t vaoId)
+    {
+        // 1 bit program variant, 15 bits material desc, 16 bits material, 16 bits VAO. The low 16 bits are left for the depth.
+        uint64_t key = isSkinned ? 1 : 0;
+        key = (key << 15) | (materialDescId & 0x7fff);
+        key = (key << 16) | (materialId & 0xffff);
+        key = (key << 16) | (vaoId & 0xffff);
+        return key << 16;
+    }
+
+    void SceneDrawList::sort(const std::vector<MeshDesc>& meshes)
+    {
+        const uint32_t drawCount = (uint32_t)mDraws.size();
+        mSortKeys.resize(drawCount);
+        mSortedDraws.resize(drawCount);
+        for(uint32_t i = 0; i < drawCount; i++)
+        {
+            // Positive floats compare like their bit patterns, so the top bits are a logarithmic depth
+            uint32_t depthBits;
+            std::memcpy(&depthBits, &mDraws[i].depth, sizeof(depthBits));
+            mSortKeys[i] = meshes[mDraws[i].mesh].sortKey | (depthBits >> 16);
+            mSortedDraws[i] = i;
+        }
+
+        mSorter.sort(mSortKeys, mSortedDraws);
+
+        mTempDraws.resize(drawCount);
+        for(uint32_t i = 0; i < drawCount; i++)
+        {
+            mTempDraws[i] = mDraws[mSortedDraws[i]];
+        }
+        mDraws.swap(mTempDraws);
+    }
+}
@@ -0,0 +1,162 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include "glm/mat4x4.hpp"
+#include "Graphics/Model/Mesh.h"
+#include "Utils/Math/RadixSort.h"
+
+namespace Falcor
+{
+    class Model;
+    class ThreadPool;
+
+    /** A flat list of the draws of a frame.
+        Building the list culls the mesh instances, selects their LODs, computes their world matrices and batches them into instanced draws.
+        It only reads CPU-side data, so it runs on worker threads and can be tested without a GPU. Submitting the draws is left to the caller (see SceneRenderer).
+        The result only depends on the inputs, not on the number of threads.
+    */
+    class SceneDrawList
+    {
+    public:
+        /** The CPU-side data of a mesh
+        */
+        struct MeshDesc
+        {
+            const Mesh* pMesh = nullptr;                        // Passed through to the draws, never dereferenced
+            uint32_t instanceCount = 0;
+            const glm::mat4* pInstanceMatrices = nullptr;
+            const BoundingBox* pInstanceBoxes = nullptr;        // The instances' bounding-boxes in model space
+            const Mesh::Lod* pLods = nullptr;
+            uint32_t lodCount = 0;
+            bool hasBones = false;                              // Skinned meshes don't use the instance matrices
+            uint64_t sortKey = 0;                               // The render state part of the draw keys, see createSortKey(). Only used by sort().
+        };
+
+        /** A model instance to draw
+        */
+        struct ModelInstanceDesc
+        {
+            const Model* pModel = nullptr;                      // Passed through to the draws, never dereferenced
+            glm::mat4 transform;
+            uint32_t firstMesh = 0;                             // The model's meshes are MeshDesc entries [firstMesh, firstMesh + meshCount)
+            uint32_t meshCount = 0;
+            uint32_t firstVisibilityItem = 0;                   // The visibility entry of the first instance of the first mesh. The other mesh instances follow it, in mesh order.
+        };
+
+        /** The view the list is built for
+        */
+        struct ViewDesc
+        {
+            const std::vector<uint32_t>* pItemViewMasks = nullptr;  // Per mesh instance culling results, a bit per culled view. nullptr draws all the instances.
+            uint32_t viewMask = 1;                                  // The views to draw. An instance is drawn if it's visible in any of them.
+            const glm::mat4* pItemWorldMatrices = nullptr;          // Cached world matrices, indexed like pItemViewMasks. nullptr calculates them from the transforms.
+            const BoundingBoxSoA* pItemWorldBoxes = nullptr;        // Cached world-space bounding-boxes, indexed like pItemViewMasks. nullptr calculates them from the transforms.
+            glm::vec3 cameraPosition;
+            float lodProjectionScale = 0;                           // 0 disables LOD selection. See Mesh::calculateLodProjectionScale().
+            float maxPixelError = 1;
+            uint32_t maxInstanceCount = 64;                         // The maximal number of instances in a draw
+        };
+
+        /** An instanced draw of a single mesh LOD
+        */
+        struct Draw
+        {
+            uint32_t modelInstance;     // Index into the ModelInstanceDesc array
+            uint32_t mesh;              // Index into the MeshDesc array
+            uint32_t lod;
+            uint32_t firstInstance;     // The draw's world matrices are getWorldMatrices()[firstInstance, firstInstance + instanceCount)
+            uint32_t instanceCount;
+            float depth;                // The distance between the camera and the origin of the first instance
+        };
+
+        /** Build the draw list. Draws are ordered by model instance, then by mesh and LOD.
+            \param[in] modelInstances The model instances to draw
+            \param[in] meshes The meshes referenced by the model instances
+            \param[in] view The view
+            \param[in] pThreadPool The thread pool to use. nullptr builds the list on the calling thread.
+        */
+        void build(const std::vector<ModelInstanceDesc>& modelInstances, const std::vector<MeshDesc>& meshes, const ViewDesc& view, ThreadPool* pThreadPool);
+
+        /** Sort the draws by render state, and front to back within each state. Call after build().
+            The keys are 64-bit, from the most significant bits down: program variant, material desc, material, VAO and depth. The draws are ordered with a radix sort.
+            \param[in] meshes The meshes used to build the list, with their sortKey field set
+        */
+        void sort(const std::vector<MeshDesc>& meshes);
+
+        /** Create the render state part of a draw key. Only the low bits of the IDs are used, so distinct states can share a key. This only affects the quality of the sort.
+            \param[in] isSkinned Whether the mesh is drawn with the vertex blending program variant
+            \param[in] materialDescId The material's desc identifier, which selects the statically compiled material program
+            \param[in] materialId The material's ID
+            \param[in] vaoId An ID of the mesh's VAO
+        */
+        static uint64_t createSortKey(bool isSkinned, uint64_t materialDescId, uint32_t materialId, uint32_t vaoId);
+
+        const std::vector<Draw>& getDraws() const { return mDraws; }
+        const std::vector<glm::mat4>& getWorldMatrices() const { return mWorldMatrices; }
+
+        /** Get the visibility item of every world matrix, the mesh instance it was computed for. Identifies instances across frames.
+        */
+        const std::vector<uint32_t>& getVisibilityItems() const { return mVisibilityItems; }
+
+        /** The number of mesh instances processed by a single task
+        */
+        static const uint32_t kChunkSize = 2048;
+
+    private:
+        // A mesh of a model instance
+        struct Group
+        {
+            uint32_t modelInstance;
+            uint32_t mesh;
+            uint32_t firstVisibilityItem;
+        };
+
+        struct Chunk
+        {
+            std::vector<Draw> draws;
+            std::vector<glm::mat4> worldMatrices;
+            std::vector<uint32_t> visibilityItems;
+            std::vector<std::vector<uint32_t>> lodInstances;
+        };
+
+        void buildChunk(uint32_t chunkIndex, const std::vector<ModelInstanceDesc>& modelInstances, const std::vector<MeshDesc>& meshes, const ViewDesc& view);
+
+        std::vector<Group> mGroups;
+        std::vector<uint32_t> mGroupOffsets;    // Prefix sum of the groups' instance counts
+        std::vector<Chunk> mChunks;
+        std::vector<Draw> mDraws;
+        std::vector<glm::mat4> mWorldMatrices;
+        std::vector<uint32_t> mVisibilityItems;
+
+        RadixSort mSorter;
+        std::vector<uint64_t> mSortKeys;
+        std::vector<uint32_t> mSortedDraws;
+        std::vector<Draw> mTempDraws;
+    };
+}
@@ -37,6 +37,9 @@
 #include "Core/Window.h"
 #include "glm/matrix.hpp"
 #include "Graphics/Material/MaterialSystem.h"
+#include "Utils/ThreadPool.h"
+#include "Data/VertexAttrib.h"
+#include <set>
 
 namespace Falcor
 {
@@ -48,6 +51,9 @@ namespace Falcor
     size_t SceneRenderer::sCameraDataOffset = 0;
     size_t SceneRenderer::sWorldMatOffset = 0;
     size_t SceneRenderer::sMeshIdOffset = 0;
+    size_t SceneRenderer::sOctahedralAttribsOffset = 0;
+    size_t SceneRenderer::sPositionOffsetOffset = 0;
+    size_t SceneRenderer::sPositionScaleOffset = 0;
     
 
     static const std::string kPerMaterialCbName = "InternalPerMaterialCB";
@@ -55,6 +61,14 @@ namespace Falcor
     static const std::string kPerStaticMeshCbName = "InternalPerStaticMeshCB";
     static const std::string kPerSkinnedMeshCbName = "InternalPerSkinnedMeshCB";
 
+    // The instance buffer variants read the world matrices from the instance buffer instead of the per-mesh uniform buffer, and the vertex blending variant reads the bones. A program version can't stand in for another variant while it compiles asynchronously.
+    static void addLayoutDefines(Program* pProgram)
+    {
+        pProgram->addLayoutDefine("_INSTANCE_BUFFER");
+        pProgram->addLayoutDefine("_INSTANCE_PREV_WORLD_MAT");
+        pProgram->addLayoutDefine("_VERTEX_BLENDING");
+    }
+
     SceneRenderer::UniquePtr SceneRenderer::create(const Scene::SharedPtr& pScene)
     {
         return UniquePtr(new SceneRenderer(pScene));
@@ -79,6 +93,9 @@ namespace Falcor
             sBonesOffset = sPerSkinnedMeshCB->getVariableOffset("gBones");
             sWorldMatOffset = sPerStaticMeshCB->getVariableOffset("gWorldMat");
             sMeshIdOffset = sPerStaticMeshCB->getVariableOffset("gMeshId");
+            sOctahedralAttribsOffset = sPerStaticMeshCB->getVariableOffset("gOctahedralAttribs");
+            sPositionOffsetOffset = sPerStaticMeshCB->getVariableOffset("gPositionOffset");
+            sPositionScaleOffset = sPerStaticMeshCB->getVariableOffset("gPositionScale");
             sCameraDataOffset = sPerFrameCB->getVariableOffset("gCam.viewMat");
         }
     }
@@ -126,21 +143,24 @@ namespace Falcor
 
     bool SceneRenderer::setPerMeshData(RenderContext* pContext, const CurrentWorkingData& currentData)
     {
+        // Set mesh id
+        sPerStaticMeshCB->setVariable(sMeshIdOffset, currentData.pMesh->getId());
+
+        // Vertex decoding, see Model::CompressVertices
+        const Mesh::VertexEncoding& encoding = currentData.pMesh->getVertexEncoding();
+        sPerStaticMeshCB->setVariable(sOctahedralAttribsOffset, encoding.octahedralAttribs);
+        sPerStaticMeshCB->setVariable(sPositionOffsetOffset, glm::vec4(encoding.positionOffset, 0));
+        sPerStaticMeshCB->setVariable(sPositionScaleOffset, glm::vec4(encoding.positionScale, 1));
 		return true;
     }
 
-    bool SceneRenderer::setPerMeshInstanceData(RenderContext* pContext, const glm::mat4& translation, uint32_t meshInstanceID, uint32_t drawInstanceID, const CurrentWorkingData& currentData)
+    bool SceneRenderer::setPerDrawInstanceData(RenderContext* pContext, const glm::mat4* pWorldMatrices, uint32_t instanceCount, const CurrentWorkingData& currentData)
     {
-        glm::mat4 worldMat = translation;
-        if(currentData.pMesh->hasBones() == false)
+        // With the instance buffer, the matrices were already written by uploadInstanceData()
+        if (mInstanceBufferBase == InstanceDataBuffer::kInvalidOffset)
         {
-            worldMat = worldMat * currentData.pMesh->getInstanceMatrix(meshInstanceID);
+            sPerStaticMeshCB->setBlob(pWorldMatrices, sWorldMatOffset, instanceCount * sizeof(glm::mat4));
         }
-        sPerStaticMeshCB->setBlob(&worldMat, sWorldMatOffset + drawInstanceID*sizeof(glm::mat4), sizeof(glm::mat4));
-
-        // Set mesh id
-        sPerStaticMeshCB->setVariable(sMeshIdOffset, currentData.pMesh->getId());
-
 		return true;
     }
 
@@ -150,7 +170,7 @@ namespace Falcor
 		return true;
     }
 
-    void SceneRenderer::flushDraw(RenderContext* pContext, const Mesh* pMesh, uint32_t instanceCount, CurrentWorkingData& currentData)
+    void SceneRenderer::flushDraw(RenderContext* pContext, const Mesh* pMesh, uint32_t instanceCount, uint32_t lod, CurrentWorkingData& currentData)
     {
 		currentData.pMaterial = pMesh->getMaterial().get();
         // Bind material
@@ -162,16 +182,25 @@ namespace Falcor
             }
             mpLastMaterial = pMesh->getMaterial().get();
             setPerMaterialData(pContext, currentData);
+            mDrawStats.materialChanges++;
 
             if(mCompileMaterialWithProgram)
             {
                 ProgramVersion::SharedConstPtr pPatchedProgram = MaterialSystem::patchActiveProgramVersion(currentData.pProgram, mpLastMaterial);
                 pContext->setProgram(pPatchedProgram);
+                mpBoundProgramVersion = pPatchedProgram.get();
+                mDrawStats.programChanges++;
             }
         }
+        else
+        {
+            mDrawStats.materialChangesAvoided++;
+        }
 
         // Draw
-        pContext->drawIndexedInstanced(pMesh->getIndexCount(), instanceCount, 0, 0, 0);
+        const Mesh::Lod& meshLod = pMesh->getLod(lod);
+        pContext->drawIndexedInstanced(meshLod.indexCount, instanceCount, meshLod.firstIndex, 0, currentData.baseInstance);
+        mDrawStats.drawCount++;
         postFlushDraw(pContext, currentData);
     }
 
@@ -180,76 +209,321 @@ namespace Falcor
 
     }
 
-    void SceneRenderer::renderMesh(RenderContext* pContext, const Mesh* pMesh, const glm::mat4& translation, Camera* pCamera, CurrentWorkingData& currentData)
+    void SceneRenderer::setInstanceBufferState(bool enable, bool storePrevWorldMatrices)
     {
-		currentData.pMesh = pMesh;
+#ifdef FALCOR_DX11
+        if (enable)
+        {
+            Logger::log(Logger::Level::Warning, "SceneRenderer::setInstanceBufferState() - the instance buffer is only supported in OpenGL");
+            return;
+        }
+#endif
+        mUseInstanceBuffer = enable;
+        mStorePrevWorldMatrices = storePrevWorldMatrices;
+        if (enable == false)
+        {
+            mpInstanceBuffer = nullptr;
+            mPrevWorldMatrices.clear();
+            mPrevWorldMatrixFrame.clear();
+        }
+    }
 
-		if (setPerMeshData(pContext, currentData))
-		{
-			// Bind VAO and set topology
-			pContext->setVao(pMesh->getVao());
-			pContext->setTopology(pMesh->getTopology());
-
-			uint32_t InstanceCount = pMesh->getInstanceCount();
-
-			uint32_t activeInstances = 0;
-			//auto pCamera = mpScene->getActiveCamera();
-
-			for (uint32_t instanceID = 0; instanceID < InstanceCount; instanceID++)
-			{
-				BoundingBox box = pMesh->getInstanceBoundingBox(instanceID).transform(translation);
-
-				if ((mCullEnabled == false) || (pCamera->isObjectCulled(box) == false))
-				{
-					if (setPerMeshInstanceData(pContext, translation, instanceID, activeInstances, currentData))
-					{
-						activeInstances++;
-
-						if (activeInstances == mMaxInstanceCount)
-						{
-
-							pContext->setProgram(currentData.pProgram->getActiveProgramVersion());
-							flushDraw(pContext, pMesh, activeInstances, currentData);
-							activeInstances = 0;
-						}
-					}
-				}
-			}
-			if(activeInstances != 0)
-			{
-				pContext->setProgram(currentData.pProgram->getActiveProgramVersion());
-				flushDraw(pContext, currentData.pMesh, activeInstances, currentData);
-			}
-		}
+    bool SceneRenderer::uploadInstanceData()
+    {
+        mInstanceBufferBase = InstanceDataBuffer::kInvalidOffset;
+        if (mUseInstanceBuffer == false)
+        {
+            return false;
+        }
+
+        const uint32_t elementSize = sizeof(glm::mat4) * (mStorePrevWorldMatrices ? 2 : 1);
+        if (mpInstanceBuffer == nullptr || mpInstanceBuffer->getElementSize() != elementSize || mpInstanceBuffer->getElementCount() != mInstanceBufferSize)
+        {
+            // The driver keeps the old buffer alive until the GPU is done with it
+            mpInstanceBuffer = InstanceDataBuffer::create(mInstanceBufferSize, elementSize);
+            if (mpInstanceBuffer == nullptr)
+            {
+                Logger::log(Logger::Level::Error, "SceneRenderer - can't create the instance buffer. Falling back to the uniform buffer.");
+                mUseInstanceBuffer = false;
+                return false;
+            }
+        }
+
+        const auto& worldMatrices = mDrawList.getWorldMatrices();
+        const uint32_t count = (uint32_t)worldMatrices.size();
+        uint32_t base = mpInstanceBuffer->allocate(count);
+        if (base == InstanceDataBuffer::kInvalidOffset)
+        {
+            Logger::log(Logger::Level::Warning, "SceneRenderer - the instance buffer can't hold " + std::to_string(count) + " instances. Rendering the frame using the uniform buffer.");
+            return false;
+        }
+        mInstanceBufferBase = base;
+
+        glm::mat4* pDst = (glm::mat4*)mpInstanceBuffer->getData(base);
+        if (mStorePrevWorldMatrices == false)
+        {
+            std::memcpy(pDst, worldMatrices.data(), count * sizeof(glm::mat4));
+        }
+        else
+        {
+            // Instances which weren't drawn in the previous frame use the current matrix, so they have no motion
+            const auto& items = mDrawList.getVisibilityItems();
+            const uint32_t itemCount = (uint32_t)mpScene->getRenderProxies().worldMatrices.size();
+            if (mPrevWorldMatrixFrame.size() != itemCount)
+            {
+                mPrevWorldMatrices.resize(itemCount);
+                mPrevWorldMatrixFrame.assign(itemCount, uint32_t(-1));
+            }
+
+            for (uint32_t i = 0; i < count; i++)
+            {
+                const glm::mat4& world = worldMatrices[i];
+                uint32_t item = items[i];
+                pDst[2 * i] = world;
+                pDst[2 * i + 1] = (mPrevWorldMatrixFrame[item] == mFrameIndex - 1) ? mPrevWorldMatrices[item] : world;
+                mPrevWorldMatrices[item] = world;
+                mPrevWorldMatrixFrame[item] = mFrameIndex;
+            }
+            mFrameIndex++;
+        }
+        return true;
     }
 
-    void SceneRenderer::renderModel(RenderContext* pContext, Program* pProgram, const Model* pModel, const glm::mat4& instanceMatrix, Camera* pCamera, CurrentWorkingData& currentData)
-    {        
-		currentData.pModel = pModel;
-		if (setPerModelData(pContext, currentData))
-		{
-			// Bind the program
-			if(pModel->hasBones())
-			{
-				pProgram->addDefine("_VERTEX_BLENDING");
-			}
+    void SceneRenderer::gatherDraws(const Camera* pCamera, const CurrentWorkingData& currentData)
+    {
+        // The model instance list only changes with the scene
+        const bool updateModelInstances = (mpScene->getGeneration() != mGatherGeneration);
+        mMeshDescs.clear();
+        if (updateModelInstances)
+        {
+            mModelInstanceDescs.clear();
+        }
+        for (uint32_t modelID = 0; modelID < mpScene->getModelCount(); modelID++)
+        {
+            const Model* pModel = mpScene->getModel(modelID).get();
+            uint32_t firstMesh = (uint32_t)mMeshDescs.size();
+            for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                const Mesh* pMesh = pModel->getMesh(meshID).get();
+                SceneDrawList::MeshDesc mesh;
+                mesh.pMesh = pMesh;
+                mesh.instanceCount = pMesh->getInstanceCount();
+                mesh.pInstanceMatrices = pMesh->getInstanceMatrices();
+                mesh.pInstanceBoxes = mesh.instanceCount ? &pMesh->getInstanceBoundingBox(0) : nullptr;
+                mesh.pLods = &pMesh->getLod(0);
+                mesh.lodCount = pMesh->getLodCount();
+                mesh.hasBones = pMesh->hasBones();
+                if (mSortDraws)
+                {
+                    // The vertex blending define is set per model, so the model decides the program variant
+                    const Material* pMaterial = pMesh->getMaterial().get();
+                    uint64_t materialDescId = pMaterial ? pMaterial->getDescIdentifier() : 0;
+                    uint32_t materialId = pMaterial ? (uint32_t)pMaterial->getId() : 0;
+                    mesh.sortKey = SceneDrawList::createSortKey(pModel->hasBones(), materialDescId, materialId, (uint32_t)mMeshDescs.size());
+                }
+                mMeshDescs.push_back(mesh);
+            }
 
+            for (uint32_t instanceID = 0; updateModelInstances && (instanceID < mpScene->getModelInstanceCount(modelID)); instanceID++)
+            {
+                const auto& instance = mpScene->getModelInstance(modelID, instanceID);
+                if (instance.isVisible)
+                {
+                    SceneDrawList::ModelInstanceDesc modelInstance;
+                    modelInstance.pModel = pModel;
+                    modelInstance.transform = instance.transformMatrix;
+                    modelInstance.firstMesh = firstMesh;
+                    modelInstance.meshCount = pModel->getMeshCount();
+                    modelInstance.firstVisibilityItem = mpScene->getBvhItemOffset(modelID, instanceID);
+                    mModelInstanceDescs.push_back(modelInstance);
+                }
+            }
+        }
 
-			mpLastMaterial = nullptr;
+        mGatherGeneration = mpScene->getGeneration();
+
+        // The world matrices and bounding-boxes are read from the scene's render proxies, which are shared by all the views and only updated for instances which moved
+        const Scene::RenderProxies& proxies = mpScene->getRenderProxies();
+        SceneDrawList::ViewDesc view;
+        view.pItemViewMasks = mCullEnabled ? &mItemViewMasks : nullptr;
+        view.viewMask = mActiveViewMask;
+        view.pItemWorldMatrices = proxies.worldMatrices.data();
+        view.pItemWorldBoxes = &proxies.worldBoxes;
+        view.cameraPosition = pCamera ? pCamera->getPosition() : glm::vec3(0);
+        view.lodProjectionScale = currentData.lodProjectionScale;
+        view.maxPixelError = mLodPixelError;
+        view.maxInstanceCount = mMaxInstanceCount;
+        mDrawList.build(mModelInstanceDescs, mMeshDescs, view, mGatherInParallel ? ThreadPool::getDefaultPool().get() : nullptr);
+    }
 
-			// Loop over the meshes
-			for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
-			{
-				renderMesh(pContext, pModel->getMesh(meshID).get(), instanceMatrix, pCamera, currentData);
-			}
+    void SceneRenderer::submitDraws(RenderContext* pContext, CurrentWorkingData& currentData)
+    {
+        const auto& draws = mDrawList.getDraws();
+        const auto& worldMatrices = mDrawList.getWorldMatrices();
+        Program* pProgram = currentData.pProgram;
+
+        uint32_t currentModelInstance = (uint32_t)-1;
+        bool skipModel = false;
+        bool skipMesh = false;
+        for (const auto& draw : draws)
+        {
+            // Draws are sorted by model instance, so model and mesh changes are detected by comparing with the previous draw
+            if (draw.modelInstance != currentModelInstance)
+            {
+                // Restore the program state
+                if (currentData.pModel && currentData.pModel->hasBones() && (skipModel == false))
+                {
+                    pProgram->removeDefine("_VERTEX_BLENDING");
+                }
 
-			// Restore the program state
-			if(pModel->hasBones())
-			{
-                pProgram->removeDefine("_VERTEX_BLENDING");
+                currentModelInstance = draw.modelInstance;
+                currentData.pModel = mModelInstanceDescs[draw.modelInstance].pModel;
+                currentData.pMesh = nullptr;
+                skipModel = (setPerModelData(pContext, currentData) == false);
+                if ((skipModel == false) && currentData.pModel->hasBones())
+                {
+                    pProgram->addDefine("_VERTEX_BLENDING");
+                }
+                mpLastMaterial = nullptr;
             }
-		}
+            if (skipModel)
+            {
+                continue;
+            }
+
+            const Mesh* pMesh = mMeshDescs[draw.mesh].pMesh;
+            if (pMesh != currentData.pMesh)
+            {
+                currentData.pMesh = pMesh;
+                skipMesh = (setPerMeshData(pContext, currentData) == false);
+                if (skipMesh == false)
+                {
+                    // Bind VAO and set topology
+                    pContext->setVao(pMesh->getVao());
+                    pContext->setTopology(pMesh->getTopology());
+                    mDrawStats.vaoChanges++;
+                }
+            }
+            else if (skipMesh == false)
+            {
+                mDrawStats.vaoChangesAvoided++;
+            }
+            if (skipMesh)
+            {
+                continue;
+            }
+
+            currentData.baseInstance = (mInstanceBufferBase == InstanceDataBuffer::kInvalidOffset) ? 0 : mInstanceBufferBase + draw.firstInstance;
+            if (setPerDrawInstanceData(pContext, &worldMatrices[draw.firstInstance], draw.instanceCount, currentData))
+            {
+                pContext->setProgram(pProgram->getActiveProgramVersion());
+                mDrawStats.programChanges++;
+                flushDraw(pContext, pMesh, draw.instanceCount, draw.lod, currentData);
+            }
+        }
+
+        if (currentData.pModel && currentData.pModel->hasBones() && (skipModel == false))
+        {
+            pProgram->removeDefine("_VERTEX_BLENDING");
+        }
+    }
+
+    void SceneRenderer::submitSortedDraws(RenderContext* pContext, CurrentWorkingData& currentData)
+    {
+        const auto& draws = mDrawList.getDraws();
+        const auto& worldMatrices = mDrawList.getWorldMatrices();
+        Program* pProgram = currentData.pProgram;
+
+        // Draws of different instances of a model are interleaved. The instance transforms are already in the world matrices, so only model changes matter.
+        bool isBlending = false;
+        bool skipModel = false;
+        bool skipMesh = false;
+        mpLastMaterial = nullptr;
+        mpBoundProgramVersion = nullptr;
+        for (const auto& draw : draws)
+        {
+            const Model* pModel = mModelInstanceDescs[draw.modelInstance].pModel;
+            if (pModel != currentData.pModel)
+            {
+                currentData.pModel = pModel;
+                currentData.pMesh = nullptr;
+                skipModel = (setPerModelData(pContext, currentData) == false);
+
+                // The program variant is the most significant part of the key, so this changes at most once
+                if ((skipModel == false) && (pModel->hasBones() != isBlending))
+                {
+                    isBlending = pModel->hasBones();
+                    if (isBlending)
+                    {
+                        pProgram->addDefine("_VERTEX_BLENDING");
+                    }
+                    else
+                    {
+                        pProgram->removeDefine("_VERTEX_BLENDING");
+                    }
+
+                    // The material programs have to be patched again for the new variant
+                    mpLastMaterial = nullptr;
+                    mpBoundProgramVersion = nullptr;
+                }
+            }
+            if (skipModel)
+            {
+                continue;
+            }
+
+            const Mesh* pMesh = mMeshDescs[draw.mesh].pMesh;
+            if (pMesh != currentData.pMesh)
+            {
+                currentData.pMesh = pMesh;
+                skipMesh = (setPerMeshData(pContext, currentData) == false);
+                if (skipMesh == false)
+                {
+                    pContext->setVao(pMesh->getVao());
+                    pContext->setTopology(pMesh->getTopology());
+                    mDrawStats.vaoChanges++;
+                }
+            }
+            else if (skipMesh == false)
+            {
+                mDrawStats.vaoChangesAvoided++;
+            }
+            if (skipMesh)
+            {
+                continue;
+            }
+
+            currentData.baseInstance = (mInstanceBufferBase == InstanceDataBuffer::kInvalidOffset) ? 0 : mInstanceBufferBase + draw.firstInstance;
+            if (setPerDrawInstanceData(pContext, &worldMatrices[draw.firstInstance], draw.instanceCount, currentData))
+            {
+                // With static material compilation, flushDraw() binds the program patched for a new material, and it stays valid for the following draws with the same material
+                bool materialChanges = (pMesh->getMaterial().get() != mpLastMaterial);
+                if (mCompileMaterialWithProgram == false)
+                {
+                    ProgramVersion::SharedConstPtr pVersion = pProgram->getActiveProgramVersion();
+                    if (pVersion.get() != mpBoundProgramVersion)
+                    {
+                        pContext->setProgram(pVersion);
+                        mpBoundProgramVersion = pVersion.get();
+                        mDrawStats.programChanges++;
+                    }
+                    else
+                    {
+                        mDrawStats.programChangesAvoided++;
+                    }
+                }
+                else if (materialChanges == false)
+                {
+                    mDrawStats.programChangesAvoided++;
+                }
+                flushDraw(pContext, pMesh, draw.instanceCount, draw.lod, currentData);
+            }
+        }
 
+        if (isBlending)
+        {
+            pProgram->removeDefine("_VERTEX_BLENDING");
+        }
     }
 
     bool SceneRenderer::update(double currentTime)
@@ -284,6 +558,7 @@ namespace Falcor
 
     void SceneRenderer::renderScene(RenderContext* pContext, Program* pProgram, Camera* pCamera)
     {
+        addLayoutDefines(pProgram);
         bindUniformBuffers(pContext, pProgram);
 		CurrentWorkingData currentData;
 		currentData.pProgram = pProgram;
@@ -291,20 +566,159 @@ namespace Falcor
 		currentData.pMaterial = nullptr;
 		currentData.pMesh = nullptr;
 		currentData.pModel = nullptr;
+		currentData.lodProjectionScale = 0;
+		currentData.baseInstance = 0;
+		if (mLodEnabled && pCamera && pCamera->getFovY() > 0)
+		{
+			currentData.lodProjectionScale = Mesh::calculateLodProjectionScale(pCamera->getFovY(), pContext->getViewport(0).height);
+		}
         setupVR();
         setPerFrameData(pContext, currentData);
 
-        for (uint32_t modelID = 0; modelID < mpScene->getModelCount(); modelID++)
+        // Cull all the mesh instances at once, unless cullViews() already did. This also brings the BVH up to date, which the item offsets used by gatherDraws() rely on.
+        mpScene->getBvh();
+        if (mCullEnabled)
         {
-            for (uint32_t InstanceID = 0; InstanceID < mpScene->getModelInstanceCount(modelID); InstanceID++)
+            // Stereo draws the instances visible to either eye
+            const glm::mat4& viewProj = pCamera->getViewProjMatrix();
+            if (mRenderMode == RenderMode::Mono)
+            {
+                mActiveViewMask = findCulledView(viewProj);
+                if (mActiveViewMask == 0)
+                {
+                    cullViews(&viewProj, 1);
+                    mActiveViewMask = 1;
+                }
+            }
+            else
             {
-                auto& Instance = mpScene->getModelInstance(modelID, InstanceID);
-                if (Instance.isVisible)
+                const glm::mat4 eyeViewProjs[2] = { viewProj, pCamera->getRightEyeViewProjMatrix() };
+                uint32_t leftEyeMask = findCulledView(eyeViewProjs[0]);
+                uint32_t rightEyeMask = findCulledView(eyeViewProjs[1]);
+                mActiveViewMask = leftEyeMask | rightEyeMask;
+                if ((leftEyeMask == 0) || (rightEyeMask == 0))
                 {
-                    renderModel(pContext, pProgram, mpScene->getModel(modelID).get(), Instance.transformMatrix, pCamera, currentData);
+                    cullViews(eyeViewProjs, 2);
+                    mActiveViewMask = 3;
                 }
             }
         }
+
+        // Build the draw list on worker threads, then submit it from this thread
+        mDrawStats = DrawStats();
+        gatherDraws(pCamera, currentData);
+
+        // Write all the world matrices at once, the draws only select their range
+        bool useInstanceBuffer = uploadInstanceData();
+        if (useInstanceBuffer)
+        {
+            pProgram->addDefine("_INSTANCE_BUFFER");
+            if (mStorePrevWorldMatrices)
+            {
+                pProgram->addDefine("_INSTANCE_PREV_WORLD_MAT");
+            }
+            pContext->setStorageBuffer(INSTANCE_BUFFER_BINDING, mpInstanceBuffer->getBuffer());
+        }
+
+        if (mSortDraws)
+        {
+            mDrawList.sort(mMeshDescs);
+            submitSortedDraws(pContext, currentData);
+        }
+        else
+        {
+            submitDraws(pContext, currentData);
+        }
+
+        if (useInstanceBuffer)
+        {
+            pProgram->removeDefine("_INSTANCE_BUFFER");
+            if (mStorePrevWorldMatrices)
+            {
+                pProgram->removeDefine("_INSTANCE_PREV_WORLD_MAT");
+            }
+
+            // The frame's range is reused once the GPU is done with the draws
+            mpInstanceBuffer->endFrame();
+        }
+    }
+
+    void SceneRenderer::prewarmProgram(Program* pProgram) const
+    {
+        addLayoutDefines(pProgram);
+
+        // The instance buffer defines are set for the whole frame, then every model selects the vertex blending variant, and static material compilation adds each material's desc
+        Program::DefineList variantDefines[2] = { pProgram->getActiveDefinesList(), pProgram->getActiveDefinesList() };
+        for(auto& defines : variantDefines)
+        {
+            if(mUseInstanceBuffer)
+            {
+                defines.add("_INSTANCE_BUFFER");
+                if(mStorePrevWorldMatrices)
+                {
+                    defines.add("_INSTANCE_PREV_WORLD_MAT");
+                }
+            }
+        }
+        variantDefines[1].add("_VERTEX_BLENDING");
+
+        bool variantUsed[2] = { false, false };
+        std::set<uint64_t> variantMaterialDescs[2];
+        std::vector<Program::DefineList> materialDefineLists;
+        for(uint32_t modelID = 0; modelID < mpScene->getModelCount(); modelID++)
+        {
+            const Model* pModel = mpScene->getModel(modelID).get();
+            const uint32_t variant = pModel->hasBones() ? 1 : 0;
+            variantUsed[variant] = true;
+            for(uint32_t meshID = 0; mCompileMaterialWithProgram && (meshID < pModel->getMeshCount()); meshID++)
+            {
+                const Material* pMaterial = pModel->getMesh(meshID)->getMaterial().get();
+                if(pMaterial && variantMaterialDescs[variant].insert(pMaterial->getDescIdentifier()).second)
+                {
+                    std::string materialDesc;
+                    pMaterial->getMaterialDescStr(materialDesc);
+                    Program::DefineList defines = variantDefines[variant];
+                    defines.add("_MS_STATIC_MATERIAL_DESC", materialDesc);
+                    materialDefineLists.push_back(defines);
+                }
+            }
+        }
+
+        // The variants are needed before the material versions, and the versions are compiled in the order they were requested
+        std::vector<Program::DefineList> defineLists;
+        for(uint32_t variant = 0; variant < 2; variant++)
+        {
+            if(variantUsed[variant])
+            {
+                defineLists.push_back(variantDefines[variant]);
+            }
+        }
+        defineLists.insert(defineLists.end(), materialDefineLists.begin(), materialDefineLists.end());
+        pProgram->prewarm(defineLists);
+    }
+
+    void SceneRenderer::cullViews(const glm::mat4* pViewProjs, uint32_t viewCount)
+    {
+        const BoundingVolumeHierarchy& bvh = mpScene->getBvh();
+        bvh.cullFrusta(pViewProjs, viewCount, mItemViewMasks);
+        mCulledViews.assign(pViewProjs, pViewProjs + viewCount);
+        mCulledViewsGeneration = mpScene->getGeneration();
+    }
+
+    uint32_t SceneRenderer::findCulledView(const glm::mat4& viewProj) const
+    {
+        if (mCulledViewsGeneration != mpScene->getGeneration())
+        {
+            return 0;
+        }
+        for (uint32_t view = 0; view < (uint32_t)mCulledViews.size(); view++)
+        {
+            if (mCulledViews[view] == viewProj)
+            {
+                return 1 << view;
+            }
+        }
+        return 0;
     }
 
     void SceneRenderer::setCameraControllerType(CameraControllerType type)
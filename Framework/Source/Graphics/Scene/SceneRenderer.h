@@ -31,6 +31,8 @@
 #include "Graphics/Camera/CameraController.h"
 #include "Graphics/Scene/Scene.h"
 #include "SceneEditor.h"
+#include "SceneDrawList.h"
+#include "InstanceDataBuffer.h"
 #include "utils/CpuTimer.h"
 #include "Core/UniformBuffer.h"
 
@@ -38,6 +40,7 @@ namespace Falcor
 {
     class Model;
     class Program;
+    class ProgramVersion;
     class RenderContext;
     class Material;
     class Mesh;
@@ -77,13 +80,65 @@ namespace Falcor
         bool onMouseEvent(const MouseEvent& mouseEvent);
 
         /** Enable/disable mesh culling. Culling does not always result in performance gain, especially when there are a lot of meshes to process with low rejection rate.
+            Mesh instances are culled hierarchically using the scene's BVH.
         */
         void setObjectCullState(bool enable) { mCullEnabled = enable; }
 
+        /** Cull the scene for several views in a single BVH traversal, e.g. all the cascades of a shadow map. A following renderScene() call whose camera has one of the view-projection matrices reuses the result instead of culling again.
+            The result is dropped when the scene changes or cullViews() is called again. Stereo render modes cull both eyes this way on their own.
+            \param[in] pViewProjs The view-projection matrices
+            \param[in] viewCount The number of views, at most BoundingVolumeHierarchy::kMaxViews
+        */
+        void cullViews(const glm::mat4* pViewProjs, uint32_t viewCount);
+
         /** Set the maximal number of mesh instance to dispatch in a single draw call.
         */
         void setMaxInstanceCount(uint32_t instanceCount) { mMaxInstanceCount = instanceCount; }
 
+        /** Enable/disable building the draw list on the framework's thread pool. The draw list is the same either way.
+        */
+        void setParallelGatherState(bool enable) { mGatherInParallel = enable; }
+
+        /** Enable/disable sorting the draws by render state before submitting them. When enabled, draws are ordered by program variant, material and VAO, then front to back, and redundant program and VAO binds are skipped.
+            When disabled, draws follow the scene order.
+        */
+        void setDrawSortState(bool enable) { mSortDraws = enable; }
+
+        /** Render state counters of the last renderScene() call. A change is avoided when a draw needs state which is already bound.
+        */
+        struct DrawStats
+        {
+            uint32_t drawCount = 0;
+            uint32_t programChanges = 0;
+            uint32_t programChangesAvoided = 0;
+            uint32_t materialChanges = 0;
+            uint32_t materialChangesAvoided = 0;
+            uint32_t vaoChanges = 0;
+            uint32_t vaoChangesAvoided = 0;
+        };
+
+        const DrawStats& getDrawStats() const { return mDrawStats; }
+
+        /** Enable/disable the instance buffer. When enabled, the world matrices of all the draws are written once per frame into a persistently mapped ring buffer, instead of into the per-mesh uniform buffer before every draw. The draws select their matrices with their base instance.
+            Programs are compiled with _INSTANCE_BUFFER, which requires GL_ARB_shader_draw_parameters. If a frame doesn't fit into the buffer, it is rendered using the uniform buffer. Only supported in OpenGL.
+            \param[in] enable Enable or disable the instance buffer
+            \param[in] storePrevWorldMatrices Also store the world matrices of the previous renderScene() call, for motion vectors. Programs are compiled with _INSTANCE_PREV_WORLD_MAT, and read the matrices using getPrevWorldMat().
+        */
+        void setInstanceBufferState(bool enable, bool storePrevWorldMatrices = false);
+
+        /** Set the number of instances the instance buffer can hold. The buffer is shared by the frames in flight, so it should be a few times larger than the number of instances drawn in a frame.
+        */
+        void setInstanceBufferSize(uint32_t instanceCount) { mInstanceBufferSize = instanceCount; }
+
+        /** Enable/disable LOD selection. When enabled, every mesh instance is drawn using the coarsest LOD whose error on screen is below the pixel error threshold.
+            LODs are only used with perspective cameras.
+        */
+        void setLodState(bool enable) { mLodEnabled = enable; }
+
+        /** Set the largest error allowed by the LOD selection, in pixels. Larger values trade quality for performance.
+        */
+        void setLodPixelError(float pixelError) { mLodPixelError = pixelError; }
+
         /** This setting controls whether to unload textures from GPU memory before binding a new material.\n
         Useful for rendering very large models with many textures that can't fit into GPU memory at once. Setting this to true usually results in performance loss.
         */
@@ -103,6 +158,12 @@ namespace Falcor
 
         void setRenderMode(RenderMode mode);
         void toggleStaticMaterialCompilation(bool on) { mCompileMaterialWithProgram = on; }
+
+        /** Start compiling the versions of a program which renderScene() is expected to use, based on the scene's models and materials and on the renderer settings. Call it after loading the scene, with the program's defines set as they will be when rendering.
+            Together with Program::setAsyncCompilation(), this avoids stalling the frame when a new model or material comes into view. See Program::prewarm().
+            Only the material variants fall back to another version while they compile. The instance buffer and vertex blending defines are layout defines, see Program::addLayoutDefine().
+        */
+        void prewarmProgram(Program* pProgram) const;
     protected:
 
 		struct CurrentWorkingData
@@ -112,6 +173,8 @@ namespace Falcor
 			const Model* pModel;
 			const Mesh* pMesh;
 			const Material* pMaterial;
+			float lodProjectionScale;   // 0 if LODs are disabled
+			uint32_t baseInstance;      // The index of the draw's first world matrix in the instance buffer, 0 if it isn't used
 		};
 
         SceneRenderer(const Scene::SharedPtr& pScene);
@@ -125,6 +188,9 @@ namespace Falcor
         static size_t sCameraDataOffset;
         static size_t sWorldMatOffset;
         static size_t sMeshIdOffset;
+        static size_t sOctahedralAttribsOffset;
+        static size_t sPositionOffsetOffset;
+        static size_t sPositionScaleOffset;
 
     private:
         void createUniformBuffers(Program* pProgram);
@@ -133,13 +199,16 @@ namespace Falcor
         virtual void setPerFrameData(RenderContext* pContext, const CurrentWorkingData& currentData);
         virtual bool setPerModelData(RenderContext* pContext, const CurrentWorkingData& currentData);
         virtual bool setPerMeshData(RenderContext* pContext,  const CurrentWorkingData& currentData);
-        virtual bool setPerMeshInstanceData(RenderContext* pContext, const glm::mat4& translation, uint32_t meshInstanceID, uint32_t drawInstanceID, const CurrentWorkingData& currentData);
+        virtual bool setPerDrawInstanceData(RenderContext* pContext, const glm::mat4* pWorldMatrices, uint32_t instanceCount, const CurrentWorkingData& currentData);
         virtual bool setPerMaterialData(RenderContext* pContext, const CurrentWorkingData& currentData);
         virtual void postFlushDraw(RenderContext* pContext, const CurrentWorkingData& currentData);
 
-        void renderModel(RenderContext* pContext, Program* pProgram, const Model* pModel, const glm::mat4& instanceMatrix, Camera* pCamera, CurrentWorkingData& currentData);
-        void renderMesh(RenderContext* pContext, const Mesh* pMesh, const glm::mat4& translation, Camera* pCamera, CurrentWorkingData& currentData);
-        void flushDraw(RenderContext* pContext, const Mesh* pMesh, uint32_t instanceCount, CurrentWorkingData& currentData);
+        void gatherDraws(const Camera* pCamera, const CurrentWorkingData& currentData);
+        void submitDraws(RenderContext* pContext, CurrentWorkingData& currentData);
+        void submitSortedDraws(RenderContext* pContext, CurrentWorkingData& currentData);
+        void flushDraw(RenderContext* pContext, const Mesh* pMesh, uint32_t instanceCount, uint32_t lod, CurrentWorkingData& currentData);
+        bool uploadInstanceData();
+        uint32_t findCulledView(const glm::mat4& viewProj) const;
 
     protected:
         void setupVR();
@@ -150,8 +219,31 @@ namespace Falcor
         uint32_t mMaxInstanceCount = 64;
         const Material* mpLastMaterial = nullptr;
         bool mCullEnabled = true;
+        bool mLodEnabled = true;
+        float mLodPixelError = 1.0f;
+        bool mGatherInParallel = true;
+        bool mSortDraws = false;
+        DrawStats mDrawStats;
+        const ProgramVersion* mpBoundProgramVersion = nullptr;
+        std::vector<uint32_t> mItemViewMasks;               // Frustum culling results, indexed by scene BVH item. Bit N is set if the item is visible in mCulledViews[N].
+        std::vector<glm::mat4> mCulledViews;                // The view-projection matrices of the last cullViews() call
+        uint32_t mCulledViewsGeneration = uint32_t(-1);     // The scene generation mItemViewMasks was computed for
+        uint32_t mActiveViewMask = 0;                       // The culled views drawn by the current renderScene() call
+        std::vector<SceneDrawList::MeshDesc> mMeshDescs;
+        std::vector<SceneDrawList::ModelInstanceDesc> mModelInstanceDescs;
+        uint32_t mGatherGeneration = uint32_t(-1);          // The scene generation mModelInstanceDescs was built for
+        SceneDrawList mDrawList;
         bool mUnloadTexturesOnMaterialChange = false;
         RenderMode mRenderMode = RenderMode::Mono;
         bool mCompileMaterialWithProgram = true;
+
+        bool mUseInstanceBuffer = false;
+        bool mStorePrevWorldMatrices = false;
+        uint32_t mInstanceBufferSize = 1 << 18;
+        InstanceDataBuffer::SharedPtr mpInstanceBuffer;
+        uint32_t mInstanceBufferBase = InstanceDataBuffer::kInvalidOffset;     // The current frame's first element in the instance buffer, kInvalidOffset if the frame uses the uniform buffer
+        std::vector<glm::mat4> mPrevWorldMatrices;          // Indexed by scene BVH item
+        std::vector<uint32_t> mPrevWorldMatrixFrame;        // The frame each entry of mPrevWorldMatrices was written in
+        uint32_t mFrameIndex = 1;
     };
 }
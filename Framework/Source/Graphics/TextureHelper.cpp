@@ -32,6 +32,9 @@
 #include "Core/DDSHeader.h"
 #include "Utils/BinaryFileStream.h"
 #include "Utils/StringUtils.h"
+#include "Utils/MemoryMappedFile.h"
+#include "Utils/OS.h"
+#include "Graphics/ResourceCache.h"
 
 #ifdef FALCOR_GL
 static const bool kTopDown = false;
@@ -573,7 +576,7 @@ namespace Falcor
             ddsData.hasDX10Header = false;
 		}
 
-        uint32_t dataSize = stream.getRemainingStreamSize();
+        size_t dataSize = (size_t)stream.getRemainingStreamSize();
         ddsData.data.resize(dataSize);
         stream.read(ddsData.data.data(), dataSize);
 	}
@@ -673,7 +676,7 @@ namespace Falcor
 		return nullptr;
 	}
 
-	Texture::SharedPtr createTextureFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb)
+	static Texture::SharedPtr loadTextureFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb)
     {
 #define no_srgb()   \
     if(loadAsSrgb)  \
@@ -731,4 +734,36 @@ namespace Falcor
         return pTex;
     }
 #undef no_srgb
+
+    Texture::SharedPtr createTextureFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb)
+    {
+        // Textures are identified by the content of their file, so a texture which is referenced by multiple models (or copied into multiple directories) is only decoded and uploaded once
+        ResourceCache::Key key;
+        std::string fullpath;
+        MemoryMappedFile file;
+        bool useCache = findFileInDataDirectories(filename, fullpath) && file.open(fullpath);
+        if(useCache)
+        {
+            struct
+            {
+                bool generateMipLevels;
+                bool loadAsSrgb;
+            } desc = {generateMipLevels, loadAsSrgb};
+            key = ResourceCache::Key(file.getData(), file.getSize(), &desc, sizeof(desc));
+            file.close();
+
+            Texture::SharedPtr pTex = ResourceCache::findTexture(key);
+            if(pTex)
+            {
+                return pTex;
+            }
+        }
+
+        Texture::SharedPtr pTex = loadTextureFromFile(filename, generateMipLevels, loadAsSrgb);
+        if(pTex && useCache)
+        {
+            ResourceCache::addTexture(key, pTex, ResourceCache::getTextureDataSize(pTex->getWidth(), pTex->getHeight(), pTex->getFormat()));
+        }
+        return pTex;
+    }
 }
@@ -377,6 +377,11 @@ void RTContext::addGeometryToGroup(ObjectHandle groupToAddGeometry, const Model:
             Logger::log(Logger::Level::Error, "Submesh of a model '" + model->getName() + "' has unsupported geometry topology (only triangle list is supported)");
             continue;
         }
+        if(mesh->hasCompressedVertices())
+        {
+            Logger::log(Logger::Level::Error, "Submesh of a model '" + model->getName() + "' has compressed vertices (load the model without Model::CompressVertices)");
+            continue;
+        }
         if(vao->getVertexBuffer(0)->getSize() % vao->getVertexBufferStride(0) != 0 ||
             vao->getVertexBuffer(0)->getSize() / vao->getVertexBufferStride(0) != vtxCount)
         {
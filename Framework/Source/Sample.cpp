@@ -32,6 +32,7 @@
 #include "Core/Window.h"
 #include "Graphics/Program.h"
 #include "Utils/OS.h"
+#include "Utils/ShaderCache.h"
 #include "Core/FBO.h"
 #include "VR\OpenVR\VRSystem.h"
 
@@ -160,11 +161,15 @@ namespace Falcor
     {
         mTimeScale = config.timeScale;
         mFreezeTime = config.freezeTimeOnStartup;
+        mAsyncCompilesPerFrame = config.asyncCompilesPerFrame;
 
         // Start the logger
         Logger::init();
         Logger::showBoxOnError(config.showMessageBoxOnError);
 
+        // Must be set before any program is linked
+        ShaderCache::setDirectory(config.enableShaderCache ? getExecutableDirectory() + "\\ShaderCache" : "");
+
         mpWindow = Window::create(config.windowDesc, this);
 
         if(mpWindow == nullptr)
@@ -222,6 +227,11 @@ namespace Falcor
     void Sample::renderFrame()
     {
         mFrameRate.newFrame();
+        UniformBuffer::resetUploadStats();
+        {
+            PROFILE(compilePendingVersions);
+            Program::compilePendingVersions(mAsyncCompilesPerFrame);
+        }
         {
             PROFILE(onFrameRender);
             calculateTime();
@@ -55,6 +55,8 @@ namespace Falcor
         float timeScale = 1;                ///< A scaling factor for the time elapsed between frames.
         bool freezeTimeOnStartup = false;   ///< Control whether or not to start the clock when the sample start running.
         bool enableVR            = false;   ///< If you need VR support, set it to true to let Sample control the VR calls. Alternatively, if you want better control, you can call the VRSystem yourself
+        bool enableShaderCache = true;      ///< Cache preprocessed shaders and program binaries in the ShaderCache directory next to the executable, so that they are reused across runs. See ShaderCache.
+        uint32_t asyncCompilesPerFrame = 1; ///< The maximum number of program versions compiled per frame, out of the versions which were preprocessed on worker threads. See Program::setAsyncCompilation() and Program::prewarm().
     };
 
     /** Bootstrapper class for Falcor.
@@ -197,6 +199,7 @@ namespace Falcor
 
         FrameRate mFrameRate;
         float mTimeScale;
+        uint32_t mAsyncCompilesPerFrame = 1;
         TextMode mTextMode = TextMode::All;
 
         TextRenderer::UniquePtr mpTextRenderer;
@@ -29,6 +29,7 @@
 #include "glm/vec3.hpp"
 #include "glm/mat4x4.hpp"
 #include "glm/common.hpp"
+#include <vector>
 
 namespace Falcor
 {
@@ -77,4 +78,68 @@ namespace Falcor
             return box;
         }
     };
+
+    /** A list of bounding-boxes stored as structure-of-arrays, for batched processing using SIMD.
+        The arrays are padded with empty boxes to a multiple of kBatchSize, so that a full batch can always be loaded.
+    */
+    class BoundingBoxSoA
+    {
+    public:
+        static const uint32_t kBatchSize = 8;
+
+        uint32_t size() const { return mCount; }
+
+        void clear()
+        {
+            mCount = 0;
+            for(auto& a : mArrays)
+            {
+                a.clear();
+            }
+        }
+
+        void push_back(const BoundingBox& box)
+        {
+            if(mCount % kBatchSize == 0)
+            {
+                for(auto& a : mArrays)
+                {
+                    a.resize(mCount + kBatchSize, 0.0f);
+                }
+            }
+            set(mCount++, box);
+        }
+
+        void set(uint32_t index, const BoundingBox& box)
+        {
+            for(uint32_t i = 0; i < 3; i++)
+            {
+                mArrays[i][index] = box.center[i];
+                mArrays[i + 3][index] = box.extent[i];
+            }
+        }
+
+        BoundingBox get(uint32_t index) const
+        {
+            BoundingBox box;
+            for(uint32_t i = 0; i < 3; i++)
+            {
+                box.center[i] = mArrays[i][index];
+                box.extent[i] = mArrays[i + 3][index];
+            }
+            return box;
+        }
+
+        /** Get the array of the center's X/Y/Z (axis 0/1/2) component
+        */
+        const float* getCenters(uint32_t axis) const { return mArrays[axis].data(); }
+
+        /** Get the array of the extent's X/Y/Z (axis 0/1/2) component
+        */
+        const float* getExtents(uint32_t axis) const { return mArrays[axis + 3].data(); }
+
+    private:
+        uint32_t mCount = 0;
+        std::vector<float> mArrays[6];
+    };
 }
\ No newline at end of file
@@ -75,14 +75,24 @@ namespace Falcor
             std::remove(mFilename.c_str());
         }
 
-		uint32_t getRemainingStreamSize()
-		{	
-			std::streamoff currentPos = mStream.tellg();
-			mStream.seekg(0, mStream.end);
-			std::streamoff length = mStream.tellg();
-			mStream.seekg(currentPos);
-			return (uint32_t)(length - currentPos); 
-		}
+        /** Get the number of bytes between the read position and the end of the file. 64-bit, since files can be larger than 4GB
+        */
+        uint64_t getRemainingStreamSize()
+        {
+            std::streamoff currentPos = mStream.tellg();
+            mStream.seekg(0, mStream.end);
+            std::streamoff length = mStream.tellg();
+            mStream.seekg(currentPos);
+            return (uint64_t)(length - currentPos);
+        }
+
+        /** Move the read and write position to an offset from the beginning of the file
+        */
+        void seek(uint64_t offset)
+        {
+            mStream.seekg(offset);
+            mStream.seekp(offset);
+        }
 
         bool isGood() { return mStream.good(); }
         bool isBad()  { return mStream.bad(); }
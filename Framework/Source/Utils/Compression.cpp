@@ -0,0 +1,232 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "Compression.h"
+#include <cstring>
+
+namespace Falcor
+{
+    // LZ4 block format constants
+    static const size_t kMinMatch = 4;
+    static const size_t kLastLiterals = 5;          // The last 5 bytes are always literals
+    static const size_t kMatchFindLimit = 12;       // The last match has to start at least 12 bytes before the end of the block
+    static const size_t kMaxOffset = 65535;
+    static const uint32_t kHashLog = 16;
+
+    static uint32_t read32(const uint8_t* p)
+    {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    static uint32_t hashSequence(uint32_t sequence)
+    {
+        return (sequence * 2654435761u) >> (32 - kHashLog);
+    }
+
+    static void writeLength(std::vector<uint8_t>& out, size_t length)
+    {
+        while(length >= 255)
+        {
+            out.push_back(255);
+            length -= 255;
+        }
+        out.push_back(uint8_t(length));
+    }
+
+    static void writeSequence(std::vector<uint8_t>& out, const uint8_t* pLiterals, size_t literalCount, size_t offset, size_t matchLength)
+    {
+        size_t tokenPos = out.size();
+        out.push_back(0);
+        uint8_t token = 0;
+
+        if(literalCount >= 15)
+        {
+            token = 15 << 4;
+            writeLength(out, literalCount - 15);
+        }
+        else
+        {
+            token = uint8_t(literalCount << 4);
+        }
+        out.insert(out.end(), pLiterals, pLiterals + literalCount);
+
+        // The last sequence only contains literals
+        if(matchLength)
+        {
+            out.push_back(uint8_t(offset & 0xff));
+            out.push_back(uint8_t(offset >> 8));
+
+            size_t ml = matchLength - kMinMatch;
+            if(ml >= 15)
+            {
+                token |= 15;
+                writeLength(out, ml - 15);
+            }
+            else
+            {
+                token |= uint8_t(ml);
+            }
+        }
+        out[tokenPos] = token;
+    }
+
+    size_t getLz4CompressBound(size_t size)
+    {
+        return size + size / 255 + 16;
+    }
+
+    void compressLz4(const void* pData, size_t size, std::vector<uint8_t>& compressed)
+    {
+        compressed.clear();
+        compressed.reserve(getLz4CompressBound(size));
+
+        const uint8_t* pSrc = (const uint8_t*)pData;
+        const uint8_t* pAnchor = pSrc;
+        const uint8_t* pEnd = pSrc + size;
+
+        if(size > kMatchFindLimit)
+        {
+            const uint8_t* pMatchFindLimit = pEnd - kMatchFindLimit;
+            const uint8_t* pMatchLimit = pEnd - kLastLiterals;
+
+            // Position + 1 of the last occurrence of every hashed sequence. 0 means empty.
+            std::vector<uint32_t> hashTable(size_t(1) << kHashLog, 0);
+            const uint8_t* pCur = pSrc;
+
+            while(pCur < pMatchFindLimit)
+            {
+                uint32_t sequence = read32(pCur);
+                uint32_t& entry = hashTable[hashSequence(sequence)];
+                const uint8_t* pRef = entry ? pSrc + entry - 1 : nullptr;
+                entry = uint32_t(pCur - pSrc) + 1;
+
+                if(pRef && (size_t(pCur - pRef) <= kMaxOffset) && (read32(pRef) == sequence))
+                {
+                    size_t matchLength = kMinMatch;
+                    while((pCur + matchLength < pMatchLimit) && (pRef[matchLength] == pCur[matchLength]))
+                    {
+                        matchLength++;
+                    }
+
+                    writeSequence(compressed, pAnchor, pCur - pAnchor, pCur - pRef, matchLength);
+                    pCur += matchLength;
+                    pAnchor = pCur;
+                }
+                else
+                {
+                    pCur++;
+                }
+            }
+        }
+
+        writeSequence(compressed, pAnchor, pEnd - pAnchor, 0, 0);
+    }
+
+    bool decompressLz4(const void* pCompressed, size_t compressedSize, void* pData, size_t size)
+    {
+        const uint8_t* pIn = (const uint8_t*)pCompressed;
+        const uint8_t* pInEnd = pIn + compressedSize;
+        uint8_t* pOutStart = (uint8_t*)pData;
+        uint8_t* pOut = pOutStart;
+        uint8_t* pOutEnd = pOut + size;
+
+        while(pIn < pInEnd)
+        {
+            uint8_t token = *pIn++;
+
+            // Literals
+            size_t literalCount = token >> 4;
+            if(literalCount == 15)
+            {
+                uint8_t b;
+                do
+                {
+                    if(pIn >= pInEnd) return false;
+                    b = *pIn++;
+                    literalCount += b;
+                } while(b == 255);
+            }
+
+            if((literalCount > size_t(pInEnd - pIn)) || (literalCount > size_t(pOutEnd - pOut)))
+            {
+                return false;
+            }
+            std::memcpy(pOut, pIn, literalCount);
+            pIn += literalCount;
+            pOut += literalCount;
+
+            // The last sequence doesn't have a match
+            if(pIn == pInEnd)
+            {
+                break;
+            }
+
+            // Match
+            if(pInEnd - pIn < 2)
+            {
+                return false;
+            }
+            size_t offset = size_t(pIn[0]) | (size_t(pIn[1]) << 8);
+            pIn += 2;
+            if((offset == 0) || (offset > size_t(pOut - pOutStart)))
+            {
+                return false;
+            }
+
+            size_t matchLength = token & 15;
+            if(matchLength == 15)
+            {
+                uint8_t b;
+                do
+                {
+                    if(pIn >= pInEnd) return false;
+                    b = *pIn++;
+                    matchLength += b;
+                } while(b == 255);
+            }
+            matchLength += kMinMatch;
+
+            if(matchLength > size_t(pOutEnd - pOut))
+            {
+                return false;
+            }
+
+            // The source and destination can overlap, so copy one byte at a time
+            const uint8_t* pMatch = pOut - offset;
+            for(size_t i = 0; i < matchLength; i++)
+            {
+                pOut[i] = pMatch[i];
+            }
+            pOut += matchLength;
+        }
+
+        return pOut == pOutEnd;
+    }
+}
@@ -0,0 +1,54 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include <stdint.h>
+
+namespace Falcor
+{
+    /** Get the worst-case size of LZ4-compressed data
+        \param[in] size The size of the uncompressed data
+    */
+    size_t getLz4CompressBound(size_t size);
+
+    /** Compress data into the LZ4 block format. The output can be read by any LZ4 block decoder.
+        \param[in] pData The data to compress
+        \param[in] size The size of the data in bytes
+        \param[out] compressed Receives the compressed data
+    */
+    void compressLz4(const void* pData, size_t size, std::vector<uint8_t>& compressed);
+
+    /** Decompress data in the LZ4 block format. The decoder validates the input, so corrupt data doesn't cause reads or writes outside of the buffers.
+        \param[in] pCompressed The compressed data
+        \param[in] compressedSize The size of the compressed data in bytes
+        \param[out] pData Receives the uncompressed data
+        \param[in] size The expected size of the uncompressed data
+        \return true if the data was decompressed successfully and its size matches 'size', otherwise false
+    */
+    bool decompressLz4(const void* pCompressed, size_t compressedSize, void* pData, size_t size);
+}
@@ -0,0 +1,610 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "BoundingVolumeHierarchy.h"
+#include "FrustumCulling.h"
+#include <algorithm>
+#include "glm/common.hpp"
+#include "glm/geometric.hpp"
+#include "glm/matrix.hpp"
+
+namespace Falcor
+{
+    static const uint32_t kSahBinCount = 16;
+    static const uint32_t kInvalidNode = (uint32_t)-1;
+    static const uint32_t kMaxSahDepth = 32;    // Deeper nodes are split in the middle, which bounds the traversal stack size
+    static const uint32_t kMaxStackSize = 64;
+
+    struct AabbBounds
+    {
+        glm::vec3 min = glm::vec3(FLT_MAX);
+        glm::vec3 max = glm::vec3(-FLT_MAX);
+
+        void grow(const glm::vec3& p) { min = glm::min(min, p); max = glm::max(max, p); }
+        void grow(const AabbBounds& b) { min = glm::min(min, b.min); max = glm::max(max, b.max); }
+
+        float halfArea() const
+        {
+            glm::vec3 e = glm::max(max - min, glm::vec3(0));
+            return e.x * e.y + e.y * e.z + e.z * e.x;
+        }
+    };
+
+    void BoundingVolumeHierarchy::clear()
+    {
+        mNodes.clear();
+        mParents.clear();
+        mItems.clear();
+        mItemLeaves.clear();
+        mItemBoxes.clear();
+        mDirtyLeaves.clear();
+        mIsLeafDirty.clear();
+    }
+
+    void BoundingVolumeHierarchy::build(const BoundingBox* pBoxes, uint32_t itemCount)
+    {
+        clear();
+        if(itemCount == 0)
+        {
+            return;
+        }
+
+        mItemBoxes.assign(pBoxes, pBoxes + itemCount);
+        mItems.resize(itemCount);
+        std::vector<glm::vec3> centers(itemCount);
+        for(uint32_t i = 0; i < itemCount; i++)
+        {
+            mItems[i] = i;
+            centers[i] = pBoxes[i].center;
+        }
+
+        mNodes.reserve(2 * (itemCount / kMaxLeafSize + 1));
+        mParents.reserve(mNodes.capacity());
+        mNodes.push_back(Node());
+        mParents.push_back(kInvalidNode);
+
+        struct BuildTask
+        {
+            uint32_t node;
+            uint32_t begin;
+            uint32_t end;
+            uint32_t depth;
+        };
+        std::vector<BuildTask> stack;
+        stack.push_back({0, 0, itemCount, 0});
+
+        while(stack.empty() == false)
+        {
+            BuildTask task = stack.back();
+            stack.pop_back();
+            uint32_t count = task.end - task.begin;
+
+            AabbBounds bounds;
+            AabbBounds centerBounds;
+            for(uint32_t i = task.begin; i < task.end; i++)
+            {
+                const BoundingBox& box = mItemBoxes[mItems[i]];
+                bounds.grow(box.center - box.extent);
+                bounds.grow(box.center + box.extent);
+                centerBounds.grow(centers[mItems[i]]);
+            }
+            mNodes[task.node].min = bounds.min;
+            mNodes[task.node].max = bounds.max;
+
+            // Find the best split plane, using the surface-area heuristic over binned item centers
+            int bestAxis = -1;
+            uint32_t bestSplit = 0;
+            float bestCost = FLT_MAX;
+            if(count > kMaxLeafSize && task.depth < kMaxSahDepth)
+            {
+                for(int axis = 0; axis < 3; axis++)
+                {
+                    float extent = centerBounds.max[axis] - centerBounds.min[axis];
+                    if(extent <= 0)
+                    {
+                        continue;
+                    }
+
+                    AabbBounds binBounds[kSahBinCount];
+                    uint32_t binCounts[kSahBinCount] = {};
+                    float binScale = float(kSahBinCount) / extent;
+                    for(uint32_t i = task.begin; i < task.end; i++)
+                    {
+                        const BoundingBox& box = mItemBoxes[mItems[i]];
+                        uint32_t bin = std::min(uint32_t((centers[mItems[i]][axis] - centerBounds.min[axis]) * binScale), kSahBinCount - 1);
+                        binCounts[bin]++;
+                        binBounds[bin].grow(box.center - box.extent);
+                        binBounds[bin].grow(box.center + box.extent);
+                    }
+
+                    // Sweep from the right to get the cost of the right side of every split, then from the left
+                    float rightCosts[kSahBinCount];
+                    AabbBounds right;
+                    uint32_t rightCount = 0;
+                    for(uint32_t bin = kSahBinCount - 1; bin > 0; bin--)
+                    {
+                        right.grow(binBounds[bin]);
+                        rightCount += binCounts[bin];
+                        rightCosts[bin] = rightCount ? right.halfArea() * float(rightCount) : 0;
+                    }
+
+                    AabbBounds left;
+                    uint32_t leftCount = 0;
+                    for(uint32_t split = 1; split < kSahBinCount; split++)
+                    {
+                        left.grow(binBounds[split - 1]);
+                        leftCount += binCounts[split - 1];
+                        float cost = (leftCount ? left.halfArea() * float(leftCount) : 0) + rightCosts[split];
+                        if(leftCount && leftCount < count && cost < bestCost)
+                        {
+                            bestCost = cost;
+                            bestAxis = axis;
+                            bestSplit = split;
+                        }
+                    }
+                }
+            }
+
+            uint32_t middle = task.begin;
+            if(bestAxis >= 0)
+            {
+                float binScale = float(kSahBinCount) / (centerBounds.max[bestAxis] - centerBounds.min[bestAxis]);
+                float minCenter = centerBounds.min[bestAxis];
+                middle = (uint32_t)(std::partition(mItems.begin() + task.begin, mItems.begin() + task.end, [&](uint32_t item)
+                {
+                    return std::min(uint32_t((centers[item][bestAxis] - minCenter) * binScale), kSahBinCount - 1) < bestSplit;
+                }) - mItems.begin());
+            }
+            else if(count > kMaxLeafSize)
+            {
+                // The centers are all at the same position or the tree is too deep. Split in the middle, so that leaves stay small.
+                middle = task.begin + count / 2;
+            }
+
+            if(middle == task.begin)
+            {
+                mNodes[task.node].first = task.begin;
+                mNodes[task.node].count = count;
+                continue;
+            }
+
+            uint32_t leftChild = (uint32_t)mNodes.size();
+            mNodes[task.node].first = leftChild;
+            mNodes[task.node].count = 0;
+            mNodes.push_back(Node());
+            mNodes.push_back(Node());
+            mParents.push_back(task.node);
+            mParents.push_back(task.node);
+            stack.push_back({leftChild, task.begin, middle, task.depth + 1});
+            stack.push_back({leftChild + 1, middle, task.end, task.depth + 1});
+        }
+
+        mItemLeaves.resize(itemCount);
+        for(uint32_t n = 0; n < (uint32_t)mNodes.size(); n++)
+        {
+            const Node& node = mNodes[n];
+            for(uint32_t i = 0; i < node.count; i++)
+            {
+                mItemLeaves[mItems[node.first + i]] = n;
+            }
+        }
+        mIsLeafDirty.assign(mNodes.size(), false);
+    }
+
+    void BoundingVolumeHierarchy::updateItem(uint32_t item, const BoundingBox& box)
+    {
+        mItemBoxes[item] = box;
+        uint32_t leaf = mItemLeaves[item];
+        if(mIsLeafDirty[leaf] == false)
+        {
+            mIsLeafDirty[leaf] = true;
+            mDirtyLeaves.push_back(leaf);
+        }
+    }
+
+    void BoundingVolumeHierarchy::refitNode(uint32_t nodeIndex)
+    {
+        Node& node = mNodes[nodeIndex];
+        if(node.count)
+        {
+            AabbBounds bounds;
+            for(uint32_t i = 0; i < node.count; i++)
+            {
+                const BoundingBox& box = mItemBoxes[mItems[node.first + i]];
+                bounds.grow(box.center - box.extent);
+                bounds.grow(box.center + box.extent);
+            }
+            node.min = bounds.min;
+            node.max = bounds.max;
+        }
+        else
+        {
+            const Node& left = mNodes[node.first];
+            const Node& right = mNodes[node.first + 1];
+            node.min = glm::min(left.min, right.min);
+            node.max = glm::max(left.max, right.max);
+        }
+    }
+
+    void BoundingVolumeHierarchy::refit()
+    {
+        if(mDirtyLeaves.empty())
+        {
+            return;
+        }
+
+        // Children are always stored after their parent. When many leaves changed, a single backward sweep is cheaper than walking up from every leaf.
+        if(mDirtyLeaves.size() * 16 > mNodes.size())
+        {
+            for(uint32_t n = (uint32_t)mNodes.size(); n-- > 0;)
+            {
+                refitNode(n);
+            }
+        }
+        else
+        {
+            for(uint32_t leaf : mDirtyLeaves)
+            {
+                refitNode(leaf);
+                for(uint32_t n = mParents[leaf]; n != kInvalidNode; n = mParents[n])
+                {
+                    glm::vec3 oldMin = mNodes[n].min;
+                    glm::vec3 oldMax = mNodes[n].max;
+                    refitNode(n);
+                    if(oldMin == mNodes[n].min && oldMax == mNodes[n].max)
+                    {
+                        break;
+                    }
+                }
+            }
+        }
+
+        for(uint32_t leaf : mDirtyLeaves)
+        {
+            mIsLeafDirty[leaf] = false;
+        }
+        mDirtyLeaves.clear();
+    }
+
+    BoundingBox BoundingVolumeHierarchy::getBoundingBox() const
+    {
+        if(mNodes.empty())
+        {
+            return BoundingBox::fromMinMax(glm::vec3(0), glm::vec3(0));
+        }
+        return BoundingBox::fromMinMax(mNodes[0].min, mNodes[0].max);
+    }
+
+    static const uint32_t kAllPlanes = (1 << 6) - 1;
+
+    // Test a box against the frustum planes in planeMask. Returns true if the box is culled, otherwise clears the planes the box is completely inside of.
+    static bool cullBox(const FrustumPlanes& frustum, const glm::vec3& center, const glm::vec3& extent, uint32_t& planeMask)
+    {
+        for(uint32_t plane = 0; plane < 6; plane++)
+        {
+            if((planeMask & (1 << plane)) == 0)
+            {
+                continue;
+            }
+
+            glm::vec3 signedExtent = extent * frustum.sign[plane];
+            if(glm::dot(center + signedExtent, frustum.xyz[plane]) <= frustum.negW[plane])
+            {
+                return true;
+            }
+            if(glm::dot(center - signedExtent, frustum.xyz[plane]) > frustum.negW[plane])
+            {
+                planeMask &= ~(1 << plane);
+            }
+        }
+        return false;
+    }
+
+    void BoundingVolumeHierarchy::cullFrustum(const glm::mat4& viewProj, std::vector<uint32_t>& visibleItems) const
+    {
+        visibleItems.clear();
+        if(mNodes.empty())
+        {
+            return;
+        }
+
+        FrustumPlanes frustum(viewProj);
+
+        // Every stack entry carries the mask of planes the node isn't known to be completely inside of
+        struct StackEntry
+        {
+            uint32_t node;
+            uint32_t planeMask;
+        };
+        StackEntry stack[kMaxStackSize];
+        uint32_t stackSize = 0;
+        stack[stackSize++] = {0, kAllPlanes};
+
+        while(stackSize)
+        {
+            StackEntry entry = stack[--stackSize];
+            const Node& node = mNodes[entry.node];
+            uint32_t planeMask = entry.planeMask;
+
+            if(planeMask)
+            {
+                glm::vec3 center = (node.min + node.max) * 0.5f;
+                glm::vec3 extent = (node.max - node.min) * 0.5f;
+                if(cullBox(frustum, center, extent, planeMask))
+                {
+                    continue;
+                }
+            }
+
+            if(node.count == 0)
+            {
+                stack[stackSize++] = {node.first + 1, planeMask};
+                stack[stackSize++] = {node.first, planeMask};
+                continue;
+            }
+
+            for(uint32_t i = 0; i < node.count; i++)
+            {
+                uint32_t item = mItems[node.first + i];
+                const BoundingBox& box = mItemBoxes[item];
+                uint32_t itemPlaneMask = planeMask;
+                if(cullBox(frustum, box.center, box.extent, itemPlaneMask) == false)
+                {
+                    visibleItems.push_back(item);
+                }
+            }
+        }
+    }
+
+    void BoundingVolumeHierarchy::cullFrusta(const glm::mat4* pViewProjs, uint32_t viewCount, std::vector<uint32_t>& itemViewMasks) const
+    {
+        itemViewMasks.assign(mItemBoxes.size(), 0);
+        if(viewCount > kMaxViews)
+        {
+            Logger::log(Logger::Level::Error, "BoundingVolumeHierarchy::cullFrusta() - can't cull more than " + std::to_string(kMaxViews) + " views at once, got " + std::to_string(viewCount));
+            return;
+        }
+        if(mNodes.empty() || (viewCount == 0))
+        {
+            return;
+        }
+
+        FrustumPlanes frusta[kMaxViews];
+        for(uint32_t view = 0; view < viewCount; view++)
+        {
+            frusta[view] = FrustumPlanes(pViewProjs[view]);
+        }
+
+        // Every stack entry carries the views which might see the node, the subset of them the node isn't known to be completely inside of,
+        // and for each view the planes which still need to be tested
+        struct StackEntry
+        {
+            uint32_t node;
+            uint32_t viewMask;
+            uint32_t partialMask;
+            uint8_t planeMasks[kMaxViews];
+        };
+        StackEntry stack[kMaxStackSize];
+        uint32_t stackSize = 1;
+        stack[0].node = 0;
+        stack[0].viewMask = (1 << viewCount) - 1;
+        stack[0].partialMask = stack[0].viewMask;
+        for(uint32_t view = 0; view < kMaxViews; view++)
+        {
+            stack[0].planeMasks[view] = kAllPlanes;
+        }
+
+        while(stackSize)
+        {
+            StackEntry entry = stack[--stackSize];
+            const Node& node = mNodes[entry.node];
+
+            // Drop the views which don't see the node. Once no view is left, the subtree is skipped.
+            glm::vec3 center = (node.min + node.max) * 0.5f;
+            glm::vec3 extent = (node.max - node.min) * 0.5f;
+            for(uint32_t view = 0; (1u << view) <= entry.partialMask; view++)
+            {
+                if(entry.partialMask & (1 << view))
+                {
+                    uint32_t planeMask = entry.planeMasks[view];
+                    if(cullBox(frusta[view], center, extent, planeMask))
+                    {
+                        entry.viewMask &= ~(1 << view);
+                        entry.partialMask &= ~(1 << view);
+                    }
+                    else if(planeMask == 0)
+                    {
+                        entry.partialMask &= ~(1 << view);
+                    }
+                    entry.planeMasks[view] = (uint8_t)planeMask;
+                }
+            }
+            if(entry.viewMask == 0)
+            {
+                continue;
+            }
+
+            if(node.count == 0)
+            {
+                stack[stackSize] = entry;
+                stack[stackSize++].node = node.first + 1;
+                stack[stackSize] = entry;
+                stack[stackSize++].node = node.first;
+                continue;
+            }
+
+            // Views which contain the whole leaf see all of its items
+            for(uint32_t i = 0; i < node.count; i++)
+            {
+                uint32_t item = mItems[node.first + i];
+                const BoundingBox& box = mItemBoxes[item];
+                uint32_t itemMask = entry.viewMask & ~entry.partialMask;
+                for(uint32_t view = 0; (1u << view) <= entry.partialMask; view++)
+                {
+                    uint32_t planeMask = entry.planeMasks[view];
+                    if((entry.partialMask & (1 << view)) && (cullBox(frusta[view], box.center, box.extent, planeMask) == false))
+                    {
+                        itemMask |= (1 << view);
+                    }
+                }
+                itemViewMasks[item] = itemMask;
+            }
+        }
+    }
+
+    static bool intersectRayBox(const glm::vec3& origin, const glm::vec3& invDirection, const glm::vec3& boxMin, const glm::vec3& boxMax, float maxDistance, float& entryDistance)
+    {
+        glm::vec3 t0 = (boxMin - origin) * invDirection;
+        glm::vec3 t1 = (boxMax - origin) * invDirection;
+        glm::vec3 tNear = glm::min(t0, t1);
+        glm::vec3 tFar = glm::max(t0, t1);
+        float entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+        entryDistance = entry;
+        return entry <= exit;
+    }
+
+    bool BoundingVolumeHierarchy::intersectRay(const glm::vec3& origin, const glm::vec3& direction, uint32_t& hitItem, float& hitDistance, float maxDistance, const ItemFilter& filter) const
+    {
+        if(mNodes.empty())
+        {
+            return false;
+        }
+
+        glm::vec3 invDirection = 1.0f / direction;
+        bool isHit = false;
+        float closest = maxDistance;
+
+        struct StackEntry
+        {
+            uint32_t node;
+            float entry;
+        };
+        StackEntry stack[kMaxStackSize];
+        uint32_t stackSize = 0;
+        float rootEntry;
+        if(intersectRayBox(origin, invDirection, mNodes[0].min, mNodes[0].max, closest, rootEntry))
+        {
+            stack[stackSize++] = {0, rootEntry};
+        }
+
+        while(stackSize)
+        {
+            StackEntry entry = stack[--stackSize];
+            if(entry.entry > closest)
+            {
+                continue;
+            }
+
+            const Node& node = mNodes[entry.node];
+            if(node.count)
+            {
+                for(uint32_t i = 0; i < node.count; i++)
+                {
+                    uint32_t item = mItems[node.first + i];
+                    const BoundingBox& box = mItemBoxes[item];
+                    float distance;
+                    if(intersectRayBox(origin, invDirection, box.center - box.extent, box.center + box.extent, closest, distance) && (isHit == false || distance < closest) && (!filter || filter(item)))
+                    {
+                        isHit = true;
+                        closest = distance;
+                        hitItem = item;
+                    }
+                }
+                continue;
+            }
+
+            // Visit the closer child first
+            float leftEntry, rightEntry;
+            bool hitLeft = intersectRayBox(origin, invDirection, mNodes[node.first].min, mNodes[node.first].max, closest, leftEntry);
+            bool hitRight = intersectRayBox(origin, invDirection, mNodes[node.first + 1].min, mNodes[node.first + 1].max, closest, rightEntry);
+            if(hitLeft && hitRight)
+            {
+                bool leftFirst = leftEntry <= rightEntry;
+                stack[stackSize++] = leftFirst ? StackEntry{node.first + 1, rightEntry} : StackEntry{node.first, leftEntry};
+                stack[stackSize++] = leftFirst ? StackEntry{node.first, leftEntry} : StackEntry{node.first + 1, rightEntry};
+            }
+            else if(hitLeft)
+            {
+                stack[stackSize++] = {node.first, leftEntry};
+            }
+            else if(hitRight)
+            {
+                stack[stackSize++] = {node.first + 1, rightEntry};
+            }
+        }
+
+        hitDistance = closest;
+        return isHit;
+    }
+
+    void BoundingVolumeHierarchy::queryBoundingBox(const BoundingBox& box, std::vector<uint32_t>& items) const
+    {
+        items.clear();
+        if(mNodes.empty())
+        {
+            return;
+        }
+
+        glm::vec3 queryMin = box.center - box.extent;
+        glm::vec3 queryMax = box.center + box.extent;
+        auto overlaps = [&](const glm::vec3& min, const glm::vec3& max)
+        {
+            return glm::all(glm::lessThanEqual(min, queryMax)) && glm::all(glm::lessThanEqual(queryMin, max));
+        };
+
+        uint32_t stack[kMaxStackSize];
+        uint32_t stackSize = 0;
+        stack[stackSize++] = 0;
+        while(stackSize)
+        {
+            const Node& node = mNodes[stack[--stackSize]];
+            if(overlaps(node.min, node.max) == false)
+            {
+                continue;
+            }
+
+            if(node.count == 0)
+            {
+                stack[stackSize++] = node.first + 1;
+                stack[stackSize++] = node.first;
+                continue;
+            }
+
+            for(uint32_t i = 0; i < node.count; i++)
+            {
+                uint32_t item = mItems[node.first + i];
+                const BoundingBox& itemBox = mItemBoxes[item];
+                if(overlaps(itemBox.center - itemBox.extent, itemBox.center + itemBox.extent))
+                {
+                    items.push_back(item);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,133 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include <cfloat>
+#include <functional>
+#include "glm/vec3.hpp"
+#include "glm/mat4x4.hpp"
+#include "Utils/AABB.h"
+
+namespace Falcor
+{
+    /** A bounding volume hierarchy over a set of axis-aligned bounding-boxes.
+        The hierarchy is built using a binned SAH, and can be refitted incrementally when items move. Refitting keeps the tree topology, so after large movements it's better to rebuild.
+        Items are referred to by their index in the array passed to build().
+    */
+    class BoundingVolumeHierarchy
+    {
+    public:
+        /** Build the hierarchy
+            \param[in] pBoxes The items' bounding-boxes
+            \param[in] itemCount The number of items
+        */
+        void build(const BoundingBox* pBoxes, uint32_t itemCount);
+
+        /** Remove all the items
+        */
+        void clear();
+
+        /** Update the bounding-box of an item. The change only affects the queries after refit() is called.
+        */
+        void updateItem(uint32_t item, const BoundingBox& box);
+
+        /** Update the nodes which contain items updated since the last call
+        */
+        void refit();
+
+        /** Find the items whose bounding-box intersects a view frustum. The test is the same one used by Camera::isObjectCulled().
+            \param[in] viewProj The view-projection matrix defining the frustum
+            \param[out] visibleItems The visible items. The vector is cleared first.
+        */
+        void cullFrustum(const glm::mat4& viewProj, std::vector<uint32_t>& visibleItems) const;
+
+        /** Cull against several view frusta in a single traversal. Each node is only tested against the views which might still see it, and subtrees which no view sees are skipped.
+            The results are the same as calling cullFrustum() for every view.
+            \param[in] pViewProjs The view-projection matrices defining the frusta
+            \param[in] viewCount The number of views, at most kMaxViews
+            \param[out] itemViewMasks A mask per item. Bit N is set if the item is visible in view N. The vector is resized to the item count.
+        */
+        void cullFrusta(const glm::mat4* pViewProjs, uint32_t viewCount, std::vector<uint32_t>& itemViewMasks) const;
+
+        /** Returns true if an item should be considered by a query
+        */
+        using ItemFilter = std::function<bool(uint32_t item)>;
+
+        /** Find the closest item whose bounding-box intersects a ray
+            \param[in] origin The ray origin
+            \param[in] direction The ray direction. Doesn't have to be normalized, the distance is measured in multiples of it.
+            \param[out] hitItem The closest item
+            \param[out] hitDistance The distance to the entry point into the item's bounding-box. 0 if the origin is inside the box.
+            \param[in] maxDistance The maximal distance to search
+            \param[in] filter Optional. Items for which it returns false are ignored.
+            \return true if an item was hit, otherwise false
+        */
+        bool intersectRay(const glm::vec3& origin, const glm::vec3& direction, uint32_t& hitItem, float& hitDistance, float maxDistance = FLT_MAX, const ItemFilter& filter = nullptr) const;
+
+        /** Find the items whose bounding-box overlaps a box
+            \param[in] box The query box
+            \param[out] items The overlapping items. The vector is cleared first.
+        */
+        void queryBoundingBox(const BoundingBox& box, std::vector<uint32_t>& items) const;
+
+        uint32_t getItemCount() const { return (uint32_t)mItemBoxes.size(); }
+        uint32_t getNodeCount() const { return (uint32_t)mNodes.size(); }
+        const BoundingBox& getItemBoundingBox(uint32_t item) const { return mItemBoxes[item]; }
+
+        /** Get the bounding-box of all the items
+        */
+        BoundingBox getBoundingBox() const;
+
+        /** Maximal number of items in a leaf
+        */
+        static const uint32_t kMaxLeafSize = 4;
+
+        /** Maximal number of views culled by cullFrusta()
+        */
+        static const uint32_t kMaxViews = 8;
+
+    private:
+        struct Node
+        {
+            glm::vec3 min;
+            uint32_t first;     // Leaf - the first entry in mItems. Inner node - the index of the left child. The right child follows it.
+            glm::vec3 max;
+            uint32_t count;     // The number of items in a leaf, 0 for inner nodes
+        };
+
+        void refitNode(uint32_t nodeIndex);
+
+        std::vector<Node> mNodes;
+        std::vector<uint32_t> mParents;
+        std::vector<uint32_t> mItems;           // Item indices, sorted by leaf
+        std::vector<uint32_t> mItemLeaves;      // The leaf containing each item
+        std::vector<BoundingBox> mItemBoxes;
+        std::vector<uint32_t> mDirtyLeaves;
+        std::vector<bool> mIsLeafDirty;
+    };
+}
@@ -0,0 +1,150 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "FrustumCulling.h"
+#include "glm/common.hpp"
+#include "glm/geometric.hpp"
+#include "glm/matrix.hpp"
+#include <emmintrin.h>
+
+namespace Falcor
+{
+    FrustumPlanes::FrustumPlanes(const glm::mat4& viewProj)
+    {
+        // Same extraction as in Camera::calculateCameraParameters(). Only valid for OpenGL style clip-space.
+        glm::mat4 tempMat = glm::transpose(viewProj);
+        for(int i = 0; i < 6; i++)
+        {
+            glm::vec4 plane = (i & 1) ? tempMat[i >> 1] : -tempMat[i >> 1];
+            plane += tempMat[3];
+
+            xyz[i] = glm::vec3(plane);
+            sign[i] = glm::sign(xyz[i]);
+            negW[i] = -plane.w;
+        }
+    }
+
+    bool FrustumPlanes::isCulled(const BoundingBox& box) const
+    {
+        bool isInside = true;
+        for(int plane = 0; plane < 6; plane++)
+        {
+            glm::vec3 signedExtent = box.extent * sign[plane];
+            float dr = glm::dot(box.center + signedExtent, xyz[plane]);
+            isInside = isInside & (dr > negW[plane]);
+        }
+        return !isInside;
+    }
+
+    struct SimdPlane
+    {
+        __m128 nx, ny, nz;
+        __m128 sx, sy, sz;
+        __m128 negW;
+    };
+
+    // Returns a lane mask of the boxes inside all planes.
+    // The operations are ordered like in FrustumPlanes::isCulled(), which keeps the results bit-exact.
+    static inline __m128 testBatch(const SimdPlane planes[6], __m128 cx, __m128 cy, __m128 cz, __m128 ex, __m128 ey, __m128 ez)
+    {
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for(uint32_t p = 0; p < 6; p++)
+        {
+            const SimdPlane& plane = planes[p];
+            __m128 px = _mm_add_ps(cx, _mm_mul_ps(ex, plane.sx));
+            __m128 py = _mm_add_ps(cy, _mm_mul_ps(ey, plane.sy));
+            __m128 pz = _mm_add_ps(cz, _mm_mul_ps(ez, plane.sz));
+            __m128 dr = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, plane.nx), _mm_mul_ps(py, plane.ny)), _mm_mul_ps(pz, plane.nz));
+            inside = _mm_and_ps(inside, _mm_cmpgt_ps(dr, plane.negW));
+        }
+        return inside;
+    }
+
+    // Write the indices of the visible lanes. Every lane is written, but the output only advances past visible ones, which avoids unpredictable branches.
+    static inline uint32_t* appendVisible(uint32_t mask, uint32_t firstIndex, uint32_t* pOut)
+    {
+        for(uint32_t lane = 0; lane < 4; lane++)
+        {
+            *pOut = firstIndex + lane;
+            pOut += (mask >> lane) & 1;
+        }
+        return pOut;
+    }
+
+    uint32_t cullBoundingBoxes(const FrustumPlanes& frustum, const BoundingBoxSoA& boxes, uint32_t* pVisible)
+    {
+        static_assert(BoundingBoxSoA::kBatchSize == 8, "cullBoundingBoxes() processes 2 SSE vectors per batch");
+
+        SimdPlane planes[6];
+        for(uint32_t p = 0; p < 6; p++)
+        {
+            planes[p].nx = _mm_set1_ps(frustum.xyz[p].x);
+            planes[p].ny = _mm_set1_ps(frustum.xyz[p].y);
+            planes[p].nz = _mm_set1_ps(frustum.xyz[p].z);
+            planes[p].sx = _mm_set1_ps(frustum.sign[p].x);
+            planes[p].sy = _mm_set1_ps(frustum.sign[p].y);
+            planes[p].sz = _mm_set1_ps(frustum.sign[p].z);
+            planes[p].negW = _mm_set1_ps(frustum.negW[p]);
+        }
+
+        const float* pCx = boxes.getCenters(0);
+        const float* pCy = boxes.getCenters(1);
+        const float* pCz = boxes.getCenters(2);
+        const float* pEx = boxes.getExtents(0);
+        const float* pEy = boxes.getExtents(1);
+        const float* pEz = boxes.getExtents(2);
+
+        uint32_t* pOut = pVisible;
+        const uint32_t count = boxes.size();
+        for(uint32_t i = 0; i < count; i += BoundingBoxSoA::kBatchSize)
+        {
+            __m128 inside0 = testBatch(planes, _mm_loadu_ps(pCx + i), _mm_loadu_ps(pCy + i), _mm_loadu_ps(pCz + i), _mm_loadu_ps(pEx + i), _mm_loadu_ps(pEy + i), _mm_loadu_ps(pEz + i));
+            __m128 inside1 = testBatch(planes, _mm_loadu_ps(pCx + i + 4), _mm_loadu_ps(pCy + i + 4), _mm_loadu_ps(pCz + i + 4), _mm_loadu_ps(pEx + i + 4), _mm_loadu_ps(pEy + i + 4), _mm_loadu_ps(pEz + i + 4));
+            uint32_t mask = uint32_t(_mm_movemask_ps(inside0)) | (uint32_t(_mm_movemask_ps(inside1)) << 4);
+
+            // Mask out the padding of the last batch
+            uint32_t remaining = count - i;
+            if(remaining < BoundingBoxSoA::kBatchSize)
+            {
+                mask &= (1 << remaining) - 1;
+            }
+
+            pOut = appendVisible(mask & 0xF, i, pOut);
+            pOut = appendVisible(mask >> 4, i + 4, pOut);
+        }
+        return uint32_t(pOut - pVisible);
+    }
+
+    void cullBoundingBoxes(const FrustumPlanes& frustum, const BoundingBoxSoA& boxes, std::vector<uint32_t>& visible)
+    {
+        const uint32_t batchSize = BoundingBoxSoA::kBatchSize;
+        visible.resize((boxes.size() + batchSize - 1) / batchSize * batchSize);
+        uint32_t visibleCount = visible.empty() ? 0 : cullBoundingBoxes(frustum, boxes, visible.data());
+        visible.resize(visibleCount);
+    }
+}
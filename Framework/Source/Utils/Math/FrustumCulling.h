@@ -0,0 +1,67 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include "glm/vec3.hpp"
+#include "glm/mat4x4.hpp"
+#include "Utils/AABB.h"
+
+namespace Falcor
+{
+    /** The 6 planes of a view frustum, extracted from a view-projection matrix.
+        The representation and the box test match Camera::isObjectCulled(), so results are identical.
+    */
+    struct FrustumPlanes
+    {
+        glm::vec3 xyz[6];       // Plane normals, not normalized
+        glm::vec3 sign[6];      // The sign of the normals' components
+        float negW[6];          // The negated plane distances
+
+        FrustumPlanes() = default;
+        explicit FrustumPlanes(const glm::mat4& viewProj);
+
+        /** Test a single bounding-box. Returns true if the box is outside the frustum.
+        */
+        bool isCulled(const BoundingBox& box) const;
+    };
+
+    /** Cull a list of bounding-boxes against a frustum using SIMD, 8 boxes per iteration.
+        \param[in] frustum The frustum planes
+        \param[in] boxes The bounding-boxes
+        \param[out] pVisible Receives the indices of the visible boxes, in increasing order. Must have room for boxes.size() rounded up to BoundingBoxSoA::kBatchSize entries.
+        \return The number of visible boxes
+    */
+    uint32_t cullBoundingBoxes(const FrustumPlanes& frustum, const BoundingBoxSoA& boxes, uint32_t* pVisible);
+
+    /** Cull a list of bounding-boxes against a frustum using SIMD
+        \param[in] frustum The frustum planes
+        \param[in] boxes The bounding-boxes
+        \param[out] visible The indices of the visible boxes, in increasing order
+    */
+    void cullBoundingBoxes(const FrustumPlanes& frustum, const BoundingBoxSoA& boxes, std::vector<uint32_t>& visible);
+}
@@ -0,0 +1,99 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "RadixSort.h"
+#include <utility>
+
+namespace Falcor
+{
+    static const uint32_t kPassCount = 8;
+    static const uint32_t kBucketCount = 256;
+
+    void RadixSort::sort(std::vector<uint64_t>& keys, std::vector<uint32_t>& values)
+    {
+        assert(keys.size() == values.size());
+        const uint32_t count = (uint32_t)keys.size();
+        if(count < 2)
+        {
+            return;
+        }
+
+        // Count the bytes of all the passes at once
+        uint32_t histograms[kPassCount][kBucketCount] = {};
+        for(uint64_t key : keys)
+        {
+            for(uint32_t pass = 0; pass < kPassCount; pass++)
+            {
+                histograms[pass][(key >> (pass * 8)) & 0xff]++;
+            }
+        }
+
+        mTempKeys.resize(count);
+        mTempValues.resize(count);
+        uint64_t* pSrcKeys = keys.data();
+        uint32_t* pSrcValues = values.data();
+        uint64_t* pDstKeys = mTempKeys.data();
+        uint32_t* pDstValues = mTempValues.data();
+
+        for(uint32_t pass = 0; pass < kPassCount; pass++)
+        {
+            const uint32_t shift = pass * 8;
+            uint32_t* pOffsets = histograms[pass];
+
+            // If all the keys have the same byte, the pass wouldn't change the order
+            if(pOffsets[(pSrcKeys[0] >> shift) & 0xff] == count)
+            {
+                continue;
+            }
+
+            uint32_t offset = 0;
+            for(uint32_t bucket = 0; bucket < kBucketCount; bucket++)
+            {
+                uint32_t bucketSize = pOffsets[bucket];
+                pOffsets[bucket] = offset;
+                offset += bucketSize;
+            }
+
+            for(uint32_t i = 0; i < count; i++)
+            {
+                uint32_t dst = pOffsets[(pSrcKeys[i] >> shift) & 0xff]++;
+                pDstKeys[dst] = pSrcKeys[i];
+                pDstValues[dst] = pSrcValues[i];
+            }
+            std::swap(pSrcKeys, pDstKeys);
+            std::swap(pSrcValues, pDstValues);
+        }
+
+        // An odd number of passes leaves the result in the scratch buffers
+        if(pSrcKeys != keys.data())
+        {
+            keys.swap(mTempKeys);
+            values.swap(mTempValues);
+        }
+    }
+}
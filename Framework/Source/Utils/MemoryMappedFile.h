@@ -0,0 +1,69 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include "Utils/MemoryStream.h"
+
+namespace Falcor
+{
+    /** Read-only view of a file mapped into the address space of the process.
+        The mapping is read through the MemoryReadStream interface, which mirrors BinaryFileStream, so loaders can be written once against both.
+        Pages are only brought into memory when they are touched, which means that large files can be parsed without reading them into intermediate buffers.
+    */
+    class MemoryMappedFile : public MemoryReadStream
+    {
+    public:
+        MemoryMappedFile() = default;
+        MemoryMappedFile(const std::string& filename) { open(filename); }
+        ~MemoryMappedFile() { close(); }
+
+        MemoryMappedFile(const MemoryMappedFile&) = delete;
+        MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+        /** Map a file for reading. Closes a previously opened file.
+            \param[in] filename The full path of the file to map
+            \return true if the file was mapped successfully, otherwise false. Mapping an empty file fails.
+        */
+        bool open(const std::string& filename);
+
+        /** Unmap the file and release the handles
+        */
+        void close();
+
+        /** Check if a file is currently mapped
+        */
+        bool isOpen() const { return mpData != nullptr; }
+
+    private:
+        std::string mFilename;
+
+        // OS handles. Stored as void* so that the header doesn't depend on the OS headers.
+        void* mpFileHandle = nullptr;
+        void* mpMappingHandle = nullptr;
+    };
+}
@@ -0,0 +1,164 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include <cstring>
+#include <stdint.h>
+
+namespace Falcor
+{
+    /** Read-only stream over a block of memory. Exposes the same reading interface as BinaryFileStream, so parsers can be written once against both.
+        The stream doesn't own the memory.
+    */
+    class MemoryReadStream
+    {
+    public:
+        MemoryReadStream() = default;
+        MemoryReadStream(const void* pData, size_t size) { setData(pData, size); }
+
+        /** Set the memory block to read from. Resets the read position and the fail state.
+        */
+        void setData(const void* pData, size_t size)
+        {
+            mpData = (const uint8_t*)pData;
+            mSize = size;
+            mPosition = 0;
+            mFail = false;
+        }
+
+        /** Get the start of the memory block
+        */
+        const uint8_t* getData() const { return mpData; }
+
+        /** Get the size of the memory block in bytes
+        */
+        size_t getSize() const { return mSize; }
+
+        /** Get the current read position
+        */
+        size_t getPosition() const { return mPosition; }
+
+        /** Set the read position. Setting a position past the end of the block puts the stream into a fail state.
+        */
+        void setPosition(size_t position)
+        {
+            if(position > mSize)
+            {
+                mFail = true;
+                return;
+            }
+            mPosition = position;
+        }
+
+        /** Get the number of bytes between the read position and the end of the block
+        */
+        size_t getRemainingStreamSize() const { return mSize - mPosition; }
+
+        /** Get a pointer to the next block of data and advance the read position past it. No data is copied.
+            \param[in] count The size of the block in bytes
+            \return A pointer into the memory block, or nullptr if the block extends past the end of the memory. In that case the stream is put into a fail state.
+        */
+        const uint8_t* consume(size_t count)
+        {
+            if(mFail || count > getRemainingStreamSize())
+            {
+                mFail = true;
+                return nullptr;
+            }
+            const uint8_t* pData = mpData + mPosition;
+            mPosition += count;
+            return pData;
+        }
+
+        bool isGood() const { return mFail == false; }
+        bool isFail() const { return mFail; }
+        bool isEof() const { return mPosition == mSize; }
+
+        MemoryReadStream& read(void* pData, size_t count)
+        {
+            const uint8_t* pSrc = consume(count);
+            if(pSrc)
+            {
+                std::memcpy(pData, pSrc, count);
+            }
+            return *this;
+        }
+
+        template<typename T>
+        MemoryReadStream& operator>>(T& val) { return read(&val, sizeof(T)); }
+
+    protected:
+        const uint8_t* mpData = nullptr;
+        size_t mSize = 0;
+        size_t mPosition = 0;
+        bool mFail = false;
+    };
+
+    /** Stream writing into a growing block of memory. Exposes the same writing interface as BinaryFileStream.
+    */
+    class MemoryWriteStream
+    {
+    public:
+        MemoryWriteStream& write(const void* pData, size_t count)
+        {
+            const uint8_t* pSrc = (const uint8_t*)pData;
+            mData.insert(mData.end(), pSrc, pSrc + count);
+            return *this;
+        }
+
+        template<typename T>
+        MemoryWriteStream& operator<<(const T& val) { return write(&val, sizeof(T)); }
+
+        /** Overwrite a value that was already written. Used to patch offsets which are only known after writing the data they point to.
+            \param[in] offset The offset of the value from the beginning of the stream
+            \param[in] val The new value
+        */
+        template<typename T>
+        void writeAt(size_t offset, const T& val)
+        {
+            std::memcpy(mData.data() + offset, &val, sizeof(T));
+        }
+
+        /** Pad the stream with zeros until its size is a multiple of 'alignment'
+        */
+        void align(size_t alignment)
+        {
+            size_t remainder = mData.size() % alignment;
+            if(remainder)
+            {
+                mData.resize(mData.size() + alignment - remainder, 0);
+            }
+        }
+
+        const uint8_t* getData() const { return mData.data(); }
+        size_t getSize() const { return mData.size(); }
+
+    private:
+        std::vector<uint8_t> mData;
+    };
+}
@@ -104,6 +104,12 @@ namespace Falcor
     */
     bool doesFileExist(const std::string& filename);
 
+    /** Checks if a directory exists in the file system
+        \param[in] filename The directory to look for
+        \return true if the directory was found, otherwise false
+    */
+    bool isDirectoryExists(const std::string& filename);
+
     /** Get the current executable directory
         \return The full path of the application directory
     */
@@ -175,6 +181,44 @@ namespace Falcor
     /** Enumerate Files Using search string
     */
     void enumerateFiles(std::string searchString, std::vector<std::string>& filenames);
+
+    /** Find all the files in a directory and its sub-directories
+        \param[in] directory The directory to search
+        \param[out] filenames Receives the full paths of the files found. Existing entries are kept.
+    */
+    void enumerateFilesRecursive(const std::string& directory, std::vector<std::string>& filenames);
+
+    /** Get the last modification time of a file
+        \param[in] filename The full path of the file
+        \param[out] time On success, the time of the last write to the file. Only useful for comparing against other file times.
+        \return true if the file exists, otherwise false
+    */
+    bool getFileModifiedTime(const std::string& filename, uint64_t& time);
+
+    /** Get the size of a file
+        \param[in] filename The full path of the file
+        \param[out] size On success, the size of the file in bytes
+        \return true if the file exists, otherwise false
+    */
+    bool getFileSize(const std::string& filename, uint64_t& size);
+
+    /** Create a directory, including all the missing intermediate directories
+        \return true if the directory was created or already exists, otherwise false
+    */
+    bool createDirectory(const std::string& path);
+
+    /** Start a new process
+        \param[in] appName The full path of the executable
+        \param[in] commandLineArgs The arguments to pass to the process
+        \return A handle to the process, or 0 if the process couldn't be started. The handle must be released by calling waitForProcess()
+    */
+    size_t executeProcess(const std::string& appName, const std::string& commandLineArgs);
+
+    /** Wait for a process to exit and release its handle
+        \param[in] processHandle A handle returned by executeProcess()
+        \return The process exit code
+    */
+    uint32_t waitForProcess(size_t processHandle);
     
     /** Return current thread handle
     */
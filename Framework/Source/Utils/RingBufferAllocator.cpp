@@ -0,0 +1,93 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "RingBufferAllocator.h"
+
+namespace Falcor
+{
+    uint32_t RingBufferAllocator::allocate(uint32_t count)
+    {
+        if(count == 0 || count > mCapacity)
+        {
+            return (count == 0) ? mHead : kInvalidOffset;
+        }
+
+        if(mUsed == 0)
+        {
+            // Nothing is in use, restart from the beginning to avoid skipping a tail
+            mHead = 0;
+            mTail = 0;
+        }
+
+        uint32_t skipped = 0;
+        if(mUsed == 0 || mHead > mTail)
+        {
+            // The free space is [head, capacity) and [0, tail)
+            if(mCapacity - mHead < count)
+            {
+                if(mTail < count)
+                {
+                    return kInvalidOffset;
+                }
+                skipped = mCapacity - mHead;
+                mHead = 0;
+            }
+        }
+        else if(mTail - mHead < count)
+        {
+            // The free space is [head, tail)
+            return kInvalidOffset;
+        }
+
+        uint32_t offset = mHead;
+        mHead += count;
+        mUsed += count + skipped;
+        mFrameSize += count + skipped;
+        return offset;
+    }
+
+    void RingBufferAllocator::endFrame(uint64_t fenceValue)
+    {
+        if(mFrameSize == 0)
+        {
+            return;
+        }
+        mFrames.push_back({fenceValue, mHead, mFrameSize});
+        mFrameSize = 0;
+    }
+
+    void RingBufferAllocator::releaseCompleted(uint64_t completedValue)
+    {
+        while(mFrames.empty() == false && mFrames.front().fenceValue <= completedValue)
+        {
+            mUsed -= mFrames.front().size;
+            mTail = mFrames.front().end;
+            mFrames.pop_front();
+        }
+    }
+}
@@ -0,0 +1,89 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <deque>
+#include <stdint.h>
+
+namespace Falcor
+{
+    /** Allocates ranges of a ring buffer which is written by the CPU and read by the GPU.
+        Allocations are grouped into frames. Each frame is tagged with a fence value when it ends, and its ranges are released once the fence has completed.
+        Ranges are always contiguous. If an allocation doesn't fit before the end of the buffer, the tail is skipped and the range starts at the beginning of the buffer.
+        The class only does the bookkeeping, so it doesn't depend on the API. Units are arbitrary, usually elements of the buffer.
+    */
+    class RingBufferAllocator
+    {
+    public:
+        static const uint32_t kInvalidOffset = uint32_t(-1);
+
+        /** Constructor
+            \param[in] capacity The size of the ring buffer
+        */
+        RingBufferAllocator(uint32_t capacity = 0) : mCapacity(capacity) {}
+
+        /** Allocate a contiguous range
+            \param[in] count The size of the range
+            \return The offset of the range, or kInvalidOffset if there is not enough free space. Call releaseCompleted() after the GPU made progress, then try again.
+        */
+        uint32_t allocate(uint32_t count);
+
+        /** Close the current frame. The ranges allocated since the last call will be released when the fence value completes.
+            \param[in] fenceValue The fence value signaled after the GPU work which reads the frame's ranges
+        */
+        void endFrame(uint64_t fenceValue);
+
+        /** Release the ranges of all the frames whose fence value is less than or equal to completedValue
+        */
+        void releaseCompleted(uint64_t completedValue);
+
+        /** Get the fence value of the oldest frame which still holds ranges. Waiting for it is the fastest way to free space. Returns 0 if no frame is pending.
+        */
+        uint64_t getOldestPendingFence() const { return mFrames.empty() ? 0 : mFrames.front().fenceValue; }
+
+        /** Get the number of units in use, including the skipped tails
+        */
+        uint32_t getUsedCount() const { return mUsed; }
+
+        uint32_t getCapacity() const { return mCapacity; }
+
+    private:
+        struct Frame
+        {
+            uint64_t fenceValue;
+            uint32_t end;       // The head position when the frame ended
+            uint32_t size;      // The units owned by the frame, including skipped tails
+        };
+
+        uint32_t mCapacity;
+        uint32_t mHead = 0;         // The next free unit
+        uint32_t mTail = 0;         // The first unit in use
+        uint32_t mUsed = 0;
+        uint32_t mFrameSize = 0;    // The units allocated by the current frame
+        std::deque<Frame> mFrames;
+    };
+}
@@ -0,0 +1,371 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "ShaderCache.h"
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include "Utils/Hash.h"
+#include "Utils/OS.h"
+#include "Utils/BinaryFileStream.h"
+
+namespace Falcor
+{
+    std::mutex ShaderCache::sMutex;
+    std::string ShaderCache::sDirectory;
+    ShaderCache::Stats ShaderCache::sStats;
+
+    static const uint32_t kSourceMagic = 0x43535346;    // 'FSSC'
+    static const uint32_t kBinaryMagic = 0x42505346;    // 'FSPB'
+    // Bump this when the file layout or the key calculation changes
+    static const uint32_t kCacheVersion = 2;
+
+    static uint64_t hashString(const std::string& str, uint64_t seed)
+    {
+        // Hash the length as well, so that concatenated strings can't collide by moving characters between them
+        seed = calculateHash64(str.data(), str.size(), seed);
+        uint64_t size = str.size();
+        return calculateHash64(&size, sizeof(size), seed);
+    }
+
+    static void writeString(BinaryFileStream& stream, const std::string& str)
+    {
+        stream << (uint32_t)str.size();
+        stream.write(str.data(), str.size());
+    }
+
+    static bool readString(BinaryFileStream& stream, std::string& str)
+    {
+        uint32_t size = 0;
+        stream >> size;
+        if(stream.isGood() == false || size > stream.getRemainingStreamSize())
+        {
+            return false;
+        }
+        str.resize(size);
+        if(size)
+        {
+            stream.read(&str[0], size);
+        }
+        return stream.isGood();
+    }
+
+    static bool readHeader(BinaryFileStream& stream, uint32_t magic, uint64_t key)
+    {
+        uint32_t fileMagic = 0;
+        uint32_t fileVersion = 0;
+        uint64_t fileKey = 0;
+        stream >> fileMagic >> fileVersion >> fileKey;
+        return stream.isGood() && (fileMagic == magic) && (fileVersion == kCacheVersion) && (fileKey == key);
+    }
+
+    static bool readSourceEntry(const std::string& filename, uint64_t key, std::vector<ShaderCache::Dependency>& dependencies, std::string& source)
+    {
+        BinaryFileStream stream(filename, BinaryFileStream::Mode::Read);
+        bool valid = readHeader(stream, kSourceMagic, key);
+
+        uint32_t dependencyCount = 0;
+        stream >> dependencyCount;
+        valid = valid && stream.isGood();
+        for(uint32_t i = 0; valid && (i < dependencyCount); i++)
+        {
+            ShaderCache::Dependency d;
+            valid = readString(stream, d.path);
+            stream >> d.contentHash >> d.modifiedTime >> d.size;
+            valid = valid && stream.isGood();
+            dependencies.push_back(d);
+        }
+        return valid && readString(stream, source);
+    }
+
+    static void writeSourceEntry(const std::string& filename, uint64_t key, const std::vector<ShaderCache::Dependency>& dependencies, const std::string& source)
+    {
+        BinaryFileStream stream(filename, BinaryFileStream::Mode::Write);
+        stream << kSourceMagic << kCacheVersion << key;
+        stream << (uint32_t)dependencies.size();
+        for(const auto& d : dependencies)
+        {
+            writeString(stream, d.path);
+            stream << d.contentHash << d.modifiedTime << d.size;
+        }
+        writeString(stream, source);
+
+        if(stream.isGood() == false)
+        {
+            stream.remove();
+        }
+    }
+
+    void ShaderCache::setDirectory(const std::string& directory)
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        sDirectory.clear();
+        if(directory.size())
+        {
+            if(createDirectory(directory))
+            {
+                sDirectory = directory;
+            }
+            else
+            {
+                Logger::log(Logger::Level::Error, "ShaderCache::setDirectory() - Can't create directory " + directory + ". The shader cache is disabled.");
+            }
+        }
+    }
+
+    std::string ShaderCache::getDirectory()
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        return sDirectory;
+    }
+
+    bool ShaderCache::isEnabled()
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        return sDirectory.size() != 0;
+    }
+
+    uint64_t ShaderCache::calculateSourceKey(const std::string& shaderString, bool isFile, const Program::DefineList& defines)
+    {
+        uint64_t key = hashString(isFile ? "file" : "string", kCacheVersion);
+        key = hashString(shaderString, key);
+        // The define list is sorted, so the same defines always produce the same key
+        for(const auto& d : defines)
+        {
+            key = hashString(d.first, key);
+            key = hashString(d.second, key);
+        }
+        return key;
+    }
+
+    uint64_t ShaderCache::calculateProgramKey(const std::string sources[(uint32_t)ShaderType::Count], const std::string& compilerIdentity)
+    {
+        uint64_t key = hashString(compilerIdentity, kCacheVersion);
+        for(uint32_t i = 0; i < (uint32_t)ShaderType::Count; i++)
+        {
+            key = hashString(sources[i], key);
+        }
+        return key;
+    }
+
+    bool ShaderCache::calculateFileHash(const std::string& path, uint64_t& hash)
+    {
+        std::string content;
+        if(readFileToString(path, content) == false)
+        {
+            return false;
+        }
+        hash = hashString(content, 0);
+        return true;
+    }
+
+    std::string ShaderCache::getEntryFilename(uint64_t key, const std::string& extension)
+    {
+        std::stringstream ss;
+        ss << sDirectory << "\\" << std::hex << std::setw(16) << std::setfill('0') << key << extension;
+        return ss.str();
+    }
+
+    bool ShaderCache::loadSource(uint64_t key, std::string& source)
+    {
+        std::string filename;
+        std::vector<Dependency> dependencies;
+        uint64_t entryTime = 0;
+        bool valid;
+        {
+            std::lock_guard<std::mutex> lock(sMutex);
+            if(sDirectory.empty())
+            {
+                return false;
+            }
+
+            filename = getEntryFilename(key, ".src");
+            if(doesFileExist(filename) == false)
+            {
+                sStats.sourceMisses++;
+                return false;
+            }
+            valid = readSourceEntry(filename, key, dependencies, source) && getFileModifiedTime(filename, entryTime);
+        }
+
+        // Check the dependencies without the lock, so that threads linking other programs don't wait for these reads
+        bool changed = false;
+        bool refresh = false;
+        for(auto& d : dependencies)
+        {
+            if(valid == false)
+            {
+                break;
+            }
+
+            uint64_t time;
+            uint64_t size;
+            if((getFileModifiedTime(d.path, time) == false) || (getFileSize(d.path, size) == false))
+            {
+                changed = true;
+                valid = false;
+                break;
+            }
+
+            // A file with the same time as the entry could have been written again in the same timer tick after it was hashed, so its time can't be trusted
+            if((time == d.modifiedTime) && (size == d.size) && (time < entryTime))
+            {
+                continue;
+            }
+
+            uint64_t currentHash;
+            if((calculateFileHash(d.path, currentHash) == false) || (currentHash != d.contentHash))
+            {
+                changed = true;
+                valid = false;
+                break;
+            }
+
+            // The content didn't change. Record the file's current time, so the next lookup doesn't hash it again.
+            d.modifiedTime = time;
+            d.size = size;
+            refresh = true;
+        }
+
+        std::lock_guard<std::mutex> lock(sMutex);
+        if(valid)
+        {
+            if(refresh)
+            {
+                writeSourceEntry(filename, key, dependencies, source);
+            }
+            sStats.sourceHits++;
+            return true;
+        }
+
+        // Either a file the source was preprocessed from changed, or the entry is corrupt. Either way, it's useless.
+        std::remove(filename.c_str());
+        sStats.invalidations += changed ? 1 : 0;
+        sStats.sourceMisses++;
+        return false;
+    }
+
+    void ShaderCache::storeSource(uint64_t key, const std::string& source, const std::vector<std::string>& dependencies)
+    {
+        if(isEnabled() == false)
+        {
+            return;
+        }
+
+        // Hash the dependencies before opening the entry, so that a missing file doesn't leave a half-written entry behind. This doesn't need the lock.
+        // The time is read before the content, so a file which is written while it's hashed gets a newer time than the recorded one and is hashed again by the next lookup.
+        std::vector<Dependency> entryDependencies(dependencies.size());
+        for(size_t i = 0; i < dependencies.size(); i++)
+        {
+            Dependency& d = entryDependencies[i];
+            d.path = dependencies[i];
+            if((getFileModifiedTime(d.path, d.modifiedTime) == false) || (getFileSize(d.path, d.size) == false) || (calculateFileHash(d.path, d.contentHash) == false))
+            {
+                Logger::log(Logger::Level::Warning, "ShaderCache::storeSource() - Can't read " + dependencies[i] + ". The shader won't be cached.");
+                return;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(sMutex);
+        if(sDirectory.empty())
+        {
+            return;
+        }
+        writeSourceEntry(getEntryFilename(key, ".src"), key, entryDependencies, source);
+    }
+
+    bool ShaderCache::loadBinary(uint64_t key, uint32_t& format, std::vector<uint8_t>& binary)
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        if(sDirectory.empty())
+        {
+            return false;
+        }
+
+        const std::string filename = getEntryFilename(key, ".bin");
+        if(doesFileExist(filename) == false)
+        {
+            sStats.binaryMisses++;
+            return false;
+        }
+
+        BinaryFileStream stream(filename, BinaryFileStream::Mode::Read);
+        uint32_t size = 0;
+        bool valid = readHeader(stream, kBinaryMagic, key);
+        stream >> format >> size;
+        valid = valid && stream.isGood() && (size > 0) && (size <= stream.getRemainingStreamSize());
+        if(valid)
+        {
+            binary.resize(size);
+            stream.read(binary.data(), size);
+            valid = stream.isGood();
+        }
+        stream.close();
+
+        if(valid)
+        {
+            sStats.binaryHits++;
+            return true;
+        }
+
+        std::remove(filename.c_str());
+        sStats.binaryMisses++;
+        return false;
+    }
+
+    void ShaderCache::storeBinary(uint64_t key, uint32_t format, const std::vector<uint8_t>& binary)
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        if(sDirectory.empty() || binary.empty())
+        {
+            return;
+        }
+
+        BinaryFileStream stream(getEntryFilename(key, ".bin"), BinaryFileStream::Mode::Write);
+        stream << kBinaryMagic << kCacheVersion << key;
+        stream << format << (uint32_t)binary.size();
+        stream.write(binary.data(), binary.size());
+
+        if(stream.isGood() == false)
+        {
+            stream.remove();
+        }
+    }
+
+    ShaderCache::Stats ShaderCache::getStats()
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        return sStats;
+    }
+
+    void ShaderCache::resetStats()
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        sStats = Stats();
+    }
+}
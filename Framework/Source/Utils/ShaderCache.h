@@ -0,0 +1,139 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include "Graphics/Program.h"
+
+namespace Falcor
+{
+    /** Persistent on-disk cache of preprocessed shader sources and program binaries.
+        Linking a program version preprocesses every stage and compiles it. The cache stores the results of both steps, so a version which was linked in an earlier run skips them.
+        - Preprocessed sources are keyed by the shader file or string and the defines. Every entry records the files it was preprocessed from and a hash of their content, and is dropped when one of them changes. A file whose modification time and size didn't change isn't read again.
+        - Program binaries are keyed by the preprocessed sources of all the stages and the identity of the driver which compiled them, so a driver update invalidates them.
+        Each entry is a file in the cache directory. The cache is disabled until a directory is set. All the functions are thread-safe.
+    */
+    class ShaderCache
+    {
+    public:
+        struct Stats
+        {
+            uint64_t sourceHits = 0;        ///< Number of shaders which weren't preprocessed because of the cache
+            uint64_t sourceMisses = 0;      ///< Number of shaders which had to be preprocessed
+            uint64_t binaryHits = 0;        ///< Number of programs which were created from a cached binary
+            uint64_t binaryMisses = 0;      ///< Number of programs which had to be compiled
+            uint64_t invalidations = 0;     ///< Number of source entries dropped because a file they depend on changed. Also counted as misses.
+        };
+
+        /** A file a preprocessed source depends on
+        */
+        struct Dependency
+        {
+            std::string path;
+            uint64_t contentHash = 0;
+            uint64_t modifiedTime = 0;  ///< See getFileModifiedTime()
+            uint64_t size = 0;
+        };
+
+        /** Set the cache directory, creating it if it doesn't exist. An empty string disables the cache.
+        */
+        static void setDirectory(const std::string& directory);
+
+        /** Get the cache directory. Empty if the cache is disabled.
+        */
+        static std::string getDirectory();
+
+        /** Check if the cache is enabled
+        */
+        static bool isEnabled();
+
+        /** Calculate the key of a preprocessed source
+            \param[in] shaderString The shader's canonical filename, or the shader code
+            \param[in] isFile Whether shaderString is a filename
+            \param[in] defines The defines the shader is preprocessed with
+        */
+        static uint64_t calculateSourceKey(const std::string& shaderString, bool isFile, const Program::DefineList& defines);
+
+        /** Calculate the key of a program binary
+            \param[in] sources The preprocessed sources of the program's stages, indexed by ShaderType. Unused stages are empty.
+            \param[in] compilerIdentity A string identifying the driver which compiles the program. See ProgramVersion::getCompilerIdentity().
+        */
+        static uint64_t calculateProgramKey(const std::string sources[(uint32_t)ShaderType::Count], const std::string& compilerIdentity);
+
+        /** Calculate the hash of a file's content
+            \return false if the file can't be read
+        */
+        static bool calculateFileHash(const std::string& path, uint64_t& hash);
+
+        /** Look for a preprocessed source. An entry is only used if all the files it depends on are unchanged.
+            The files are checked without holding the cache's lock. Only the files whose modification time or size changed since the entry was stored are hashed, and if their content didn't change the entry is updated with their new time and size.
+            \param[in] key The key returned by calculateSourceKey()
+            \param[out] source The preprocessed source
+            \return true if a valid entry was found
+        */
+        static bool loadSource(uint64_t key, std::string& source);
+
+        /** Store a preprocessed source
+            \param[in] key The key returned by calculateSourceKey()
+            \param[in] source The preprocessed source
+            \param[in] dependencies The files the source was preprocessed from. Their content, modification time and size are recorded when the entry is stored.
+        */
+        static void storeSource(uint64_t key, const std::string& source, const std::vector<std::string>& dependencies);
+
+        /** Look for a program binary
+            \param[in] key The key returned by calculateProgramKey()
+            \param[out] format The API-specific binary format
+            \param[out] binary The binary
+            \return true if the binary was found
+        */
+        static bool loadBinary(uint64_t key, uint32_t& format, std::vector<uint8_t>& binary);
+
+        /** Store a program binary
+            \param[in] key The key returned by calculateProgramKey()
+            \param[in] format The API-specific binary format
+            \param[in] binary The binary
+        */
+        static void storeBinary(uint64_t key, uint32_t format, const std::vector<uint8_t>& binary);
+
+        /** Get the cache statistics
+        */
+        static Stats getStats();
+
+        /** Reset the cache statistics
+        */
+        static void resetStats();
+
+    private:
+        static std::string getEntryFilename(uint64_t key, const std::string& extension);
+
+        static std::mutex sMutex;
+        static std::string sDirectory;
+        static Stats sStats;
+    };
+}
@@ -32,6 +32,7 @@
 #include "Utils/StringUtils.h"
 #include <cctype>
 #include <set>
+#include <mutex>
 
 namespace Falcor
 {
@@ -194,6 +195,31 @@ namespace Falcor
         return line;
     }
 
+    void parseLineDirective(const std::string& pragmaLine, const std::string& rootFileName, size_t& line, std::string& filename)
+    {
+        std::vector<std::string> tokens = splitString(pragmaLine, " \t");
+        assert(tokens.size() == 2 || tokens.size() == 3);
+
+        // Get the line information
+        assert(std::isdigit(tokens[1][0]));
+        line = atoi(tokens[1].c_str()) - 1; // #line actually tells where the next line is, so we subtract one to compensate for that
+
+        if(tokens.size() == 3)
+        {
+            // Pragma of the form "#line N \"filename\"".
+            const auto& f = tokens[2];
+            assert(f[0] == '"');
+            assert(f[f.length() - 1] == '"');
+            filename = f.substr(1, f.length() - 2);
+            filename = replaceSubstring(filename,"/","\\");
+        }
+        else
+        {
+            // Pragma of the form "#line N", meaning that the file is the root file.
+            filename = rootFileName;
+        }
+    }
+
     void getLineInformation(const std::string& code, size_t offset, size_t& line, std::string& filename, const std::string& rootFileName)
     {
         // Find the previous line pragma
@@ -212,29 +238,8 @@ namespace Falcor
             // Find the next newline after the preceding line pragma
             size_t endLine = code.find_first_of("\n", precedingLinePragmaOffset);
             std::string pragmaLine = (endLine == npos) ? code.substr(precedingLinePragmaOffset) : code.substr(precedingLinePragmaOffset, endLine - precedingLinePragmaOffset);
-
-            std::vector<std::string> tokens = splitString(pragmaLine, " \t");
-            assert(tokens.size() == 2 || tokens.size() == 3);
-
-            // Get the line information
-            assert(std::isdigit(tokens[1][0]));
-            line = atoi(tokens[1].c_str()) - 1; // #line actually tells where the next line is, so we subtract one to compensate for that
+            parseLineDirective(pragmaLine, rootFileName, line, filename);
             line += countNewLines(code, precedingLinePragmaOffset, offset);
-
-            if(tokens.size() == 3)
-            {
-                // Pragma of the form "#line N \"filename\"".
-                const auto& f = tokens[2];
-                assert(f[0] == '"');
-                assert(f[f.length() - 1] == '"');
-                filename = f.substr(1, f.length() - 2);
-                filename = replaceSubstring(filename,"/","\\");
-            }
-            else
-            {
-                // Pragma of the form "#line N", meaning that the file is the root file.
-                filename = rootFileName;
-            }
         }
     }
 
@@ -253,6 +258,220 @@ namespace Falcor
         return getLinePragma(line, filename);
     }
 
+    /** A shader file split into the tokens which the include pass needs. Each file is tokenized once, and the result is shared between parseShader() calls as long as the file doesn't change.
+    */
+    struct ParsedShaderFile
+    {
+        enum class TokenType
+        {
+            NewLine,
+            BlockCommentStart,
+            BlockCommentEnd,
+            LineComment,
+            LineDirective,
+            IncludeDirective,
+        };
+
+        struct Token
+        {
+            TokenType type;
+            size_t offset;
+            uint32_t includeIndex;  // Index into the include list, for include directives
+        };
+
+        struct Include
+        {
+            std::string filename;   // The raw filename, as it appears in the directive
+            size_t codeOffset;      // Where the code continues after the directive. npos if the filename is missing.
+        };
+
+        std::string content;
+        std::vector<Token> tokens;
+        std::vector<Include> includes;
+        bool hasPragmaOnce = false;
+    };
+
+    void tokenizeShaderCode(const std::string& code, std::vector<ParsedShaderFile::Token>& tokens, std::vector<ParsedShaderFile::Include>* pIncludes)
+    {
+        using TokenType = ParsedShaderFile::TokenType;
+        const size_t size = code.size();
+        for(size_t i = 0; i < size; i++)
+        {
+            const char c = code[i];
+            const char next = (i + 1 < size) ? code[i + 1] : 0;
+            ParsedShaderFile::Token token = {TokenType::NewLine, i, 0};
+            if(c == '\n')
+            {
+                tokens.push_back(token);
+            }
+            else if(c == '/' && (next == '*' || next == '/'))
+            {
+                token.type = (next == '*') ? TokenType::BlockCommentStart : TokenType::LineComment;
+                tokens.push_back(token);
+            }
+            else if(c == '*' && next == '/')
+            {
+                token.type = TokenType::BlockCommentEnd;
+                tokens.push_back(token);
+            }
+            else if(c == '#')
+            {
+                if(code.compare(i, 5, "#line") == 0)
+                {
+                    token.type = TokenType::LineDirective;
+                    tokens.push_back(token);
+                }
+                else if(pIncludes && code.compare(i, 8, "#include") == 0)
+                {
+                    ParsedShaderFile::Include include;
+                    include.codeOffset = getIncludedFileName(code, i, include.filename);
+                    // The directive ends with the filename's closing token and the character after it
+                    include.codeOffset = (include.codeOffset == npos) ? npos : std::min(include.codeOffset + 2, size);
+
+                    token.type = TokenType::IncludeDirective;
+                    token.includeIndex = (uint32_t)pIncludes->size();
+                    tokens.push_back(token);
+                    pIncludes->push_back(include);
+                }
+            }
+        }
+    }
+
+    std::shared_ptr<const ParsedShaderFile> parseShaderFile(const std::string& code)
+    {
+        auto pFile = std::make_shared<ParsedShaderFile>();
+        pFile->content = code;
+        tokenizeShaderCode(pFile->content, pFile->tokens, &pFile->includes);
+        pFile->hasPragmaOnce = findShaderDirective<false>(pFile->content, 0, "#pragma once") != npos;
+        return pFile;
+    }
+
+    static std::mutex gParsedFilesMutex;
+    static std::map<std::string, std::shared_ptr<const ParsedShaderFile>> gParsedFiles;
+
+    std::shared_ptr<const ParsedShaderFile> getParsedIncludeFile(const std::string& pathAbs)
+    {
+        std::string content;
+        readFileToString(pathAbs, content);
+
+        // Add a trailing newline as required.  TODO: emit a warning while doing this.
+        if(!content.empty() && content.back() != '\n')
+        {
+            content += '\n';
+        }
+
+        // The file is read anyway, so comparing the content is the most reliable way to detect changes
+        {
+            std::lock_guard<std::mutex> lock(gParsedFilesMutex);
+            const auto& it = gParsedFiles.find(pathAbs);
+            if(it != gParsedFiles.end() && it->second->content == content)
+            {
+                return it->second;
+            }
+        }
+
+        auto pFile = parseShaderFile(content);
+        std::lock_guard<std::mutex> lock(gParsedFilesMutex);
+        gParsedFiles[pathAbs] = pFile;
+        return pFile;
+    }
+
+    /** The output of the include pass. Keeps track of the comments and line directives in the code written so far, so that a directive's state can be found without searching backwards through the code.
+        The results are the same as isInComment() and getLineInformation() would return for the complete code.
+    */
+    class IncludeOutput
+    {
+    public:
+        std::string code;
+
+        void append(const std::string& str, size_t offset, size_t count)
+        {
+            code.append(str, offset, count);
+        }
+
+        /** Append generated code, such as a line directive
+        */
+        void appendGenerated(const std::string& str)
+        {
+            std::vector<ParsedShaderFile::Token> tokens;
+            tokenizeShaderCode(str, tokens, nullptr);
+            for(const auto& t : tokens)
+            {
+                addToken(t.type, code.size() + t.offset);
+            }
+            code += str;
+        }
+
+        /** Register a token which is about to be written at an offset in the code. Tokens must be added in order.
+        */
+        void addToken(ParsedShaderFile::TokenType type, size_t offset)
+        {
+            switch(type)
+            {
+            case ParsedShaderFile::TokenType::NewLine:
+                mLastNewLine = offset;
+                mNewLineCount++;
+                break;
+            case ParsedShaderFile::TokenType::BlockCommentStart:
+                mLastBlockCommentStart = offset;
+                break;
+            case ParsedShaderFile::TokenType::BlockCommentEnd:
+                mLastBlockCommentEnd = offset;
+                break;
+            case ParsedShaderFile::TokenType::LineComment:
+                mLastLineComment = offset;
+                break;
+            case ParsedShaderFile::TokenType::LineDirective:
+                if(isInComment(offset) == false)
+                {
+                    mLineDirective = offset;
+                    mNewLinesBeforeLineDirective = mNewLineCount;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+
+        /** Check if an offset after all the registered tokens is inside a comment. Same logic as isInComment().
+        */
+        bool isInComment(size_t offset) const
+        {
+            if((mLastBlockCommentStart > mLastBlockCommentEnd) && (mLastBlockCommentStart != npos))
+            {
+                return true;
+            }
+            return (mLastLineComment > mLastNewLine) && (mLastLineComment != npos);
+        }
+
+        /** Get the line information at the end of the code. Same logic as getLineInformation().
+        */
+        void getLineInformation(size_t& line, std::string& filename, const std::string& rootFileName) const
+        {
+            if(mLineDirective == npos)
+            {
+                filename = rootFileName;
+                line = mNewLineCount + 1;
+            }
+            else
+            {
+                size_t endLine = code.find('\n', mLineDirective);
+                std::string pragmaLine = (endLine == npos) ? code.substr(mLineDirective) : code.substr(mLineDirective, endLine - mLineDirective);
+                parseLineDirective(pragmaLine, rootFileName, line, filename);
+                line += mNewLineCount - mNewLinesBeforeLineDirective;
+            }
+        }
+
+    private:
+        size_t mLastNewLine = npos;
+        size_t mLastBlockCommentStart = npos;
+        size_t mLastBlockCommentEnd = npos;
+        size_t mLastLineComment = npos;
+        size_t mLineDirective = npos;
+        size_t mNewLineCount = 0;
+        size_t mNewLinesBeforeLineDirective = 0;
+    };
+
     bool ShaderPreprocessor::addIncludes(std::string& code)
     {
         auto getDirAbs = [](const std::string& path) -> std::string 
@@ -268,26 +487,73 @@ namespace Falcor
         // Set of all included files' absolute paths
         std::set<std::string> includedPathsAbs;
 
-        // Loop over every found include in the file
-        const std::string includeMacro = "#include";
-        const std::string pragmaStatement = "#pragma once";
-        while(true) 
+        // Files which are included more than once are only read once
+        std::map<std::string, std::shared_ptr<const ParsedShaderFile>> parsedFiles;
+
+        // The code is written in a single pass. Every include pushes the included file onto the stack, and its code is written before the rest of the including file.
+        struct Frame
         {
-            size_t offset = findShaderDirective<false>(code, 0, includeMacro);
-            if(offset == npos) 
+            std::shared_ptr<const ParsedShaderFile> pFile;
+            size_t codeOffset;          // The first character of the file which wasn't written yet
+            size_t tokenIndex;          // The first token which wasn't processed yet
+            std::string linePragma;     // Written after the file, to restore the including file's line numbers
+        };
+        std::vector<Frame> stack;
+        stack.push_back({parseShaderFile(code), 0, 0, std::string()});
+
+        IncludeOutput output;
+        output.code.reserve(code.size() * 2);
+
+        while(stack.size())
+        {
+            Frame& frame = stack.back();
+            const ParsedShaderFile& file = *frame.pFile;
+
+            // Look for the next include which isn't in a comment. The tokens before it are only registered, the code is written in one go.
+            const ParsedShaderFile::Token* pInclude = nullptr;
+            for(; frame.tokenIndex < file.tokens.size(); frame.tokenIndex++)
+            {
+                const auto& token = file.tokens[frame.tokenIndex];
+                if(token.offset < frame.codeOffset)
+                {
+                    // Part of an include directive which was replaced
+                    continue;
+                }
+
+                const size_t outputOffset = output.code.size() + token.offset - frame.codeOffset;
+                if(token.type != ParsedShaderFile::TokenType::IncludeDirective)
+                {
+                    output.addToken(token.type, outputOffset);
+                }
+                else if(output.isInComment(outputOffset) == false)
+                {
+                    pInclude = &token;
+                    frame.tokenIndex++;
+                    break;
+                }
+            }
+
+            if(pInclude == nullptr)
             {
-                break; //Completed
+                // Done with this file
+                output.append(file.content, frame.codeOffset, npos);
+                std::string linePragma = std::move(frame.linePragma);
+                stack.pop_back();
+                output.appendGenerated(linePragma);
+                continue;
             }
 
+            output.append(file.content, frame.codeOffset, pInclude->offset - frame.codeOffset);
+
             // Get absolute path to the including file.  Note that it is absolute because we only ever write absolute paths in #line directives.
             std::string includingPathAbs;
             size_t line;
-            getLineInformation(code, offset, line, includingPathAbs, mShaderPathAbs);
+            output.getLineInformation(line, includingPathAbs, mShaderPathAbs);
 
             // Get raw path to the include (may be relative to the including file or absolute)
-            std::string includedPathRaw;
-            size_t postFilenameOffset = getIncludedFileName(code, offset, includedPathRaw);
-            if(postFilenameOffset == npos)
+            const ParsedShaderFile::Include& include = file.includes[pInclude->includeIndex];
+            const std::string& includedPathRaw = include.filename;
+            if(include.codeOffset == npos)
             {
                 mErrorStr += mShaderPathAbs + "(" + std::to_string(line) + "):Missing included filename";
                 return false;
@@ -309,8 +575,14 @@ namespace Falcor
 
                 // Search relative to the including file.
                 // Note canonicalization is necessary because the relative path might contain "..\\".
-                includedPathAbs = canonicalizeFilename( pathsAbsToDirsAbs.at(includingPathAbs) + "\\" + includedPathRaw );
-                if(doesFileExist(includedPathAbs)) goto SUCCESS;
+                {
+                    const auto& includingDir = pathsAbsToDirsAbs.find(includingPathAbs);
+                    if(includingDir != pathsAbsToDirsAbs.end())
+                    {
+                        includedPathAbs = canonicalizeFilename(includingDir->second + "\\" + includedPathRaw);
+                        if(doesFileExist(includedPathAbs)) goto SUCCESS;
+                    }
+                }
 
                 // Could not find file!
                 mErrorStr += includingPathAbs + "(" + std::to_string(line) + "):Cannot find apparent relative include file \"" + includedPathRaw + "\".";
@@ -320,18 +592,15 @@ namespace Falcor
             }
 
             // Read the included file.
-            std::string includedContent;
-            readFileToString(includedPathAbs, includedContent);
-
-            // Add a trailing newline as required.  TODO: emit a warning while doing this.
-            if(!includedContent.empty() && includedContent.back() != '\n')
+            std::shared_ptr<const ParsedShaderFile>& pIncludedFile = parsedFiles[includedPathAbs];
+            if(pIncludedFile == nullptr)
             {
-                includedContent += '\n';
+                pIncludedFile = getParsedIncludeFile(includedPathAbs);
             }
 
             // If the included file contains "#pragma once", and we already included it, ignore it.  TODO: need to check that the pragma is valid.
             bool shouldInclude = true;
-            if(findShaderDirective<false>(includedContent, 0, pragmaStatement) != npos)
+            if(pIncludedFile->hasPragmaOnce)
             {
                 if(includedPathsAbs.find(includedPathAbs) != includedPathsAbs.end())
                 {
@@ -339,24 +608,22 @@ namespace Falcor
                 }
             }
 
-            std::string prologue = code.substr(0, offset);
-            std::string epilogue = code.substr(postFilenameOffset + 2);
+            // Skip the directive
+            frame.codeOffset = include.codeOffset;
             if(shouldInclude)
             {
-                includedPathsAbs.insert(includedPathAbs);
+                if(includedPathsAbs.insert(includedPathAbs).second)
+                {
+                    mIncludedFiles.push_back(includedPathAbs);
+                }
                 pathsAbsToDirsAbs[includedPathAbs] = getDirAbs(includedPathAbs);
 
-                std::string preIncludeLine = getLinePragma(1, includedPathAbs);
-                std::string replacedIncludeLine = getLinePragma(line+1, includingPathAbs);
-                code = prologue + preIncludeLine + includedContent + replacedIncludeLine + epilogue;
+                output.appendGenerated(getLinePragma(1, includedPathAbs));
+                stack.push_back({pIncludedFile, 0, 0, getLinePragma(line + 1, includingPathAbs)});
             }
-            else
-            {
-                code = prologue + epilogue;
-            }
-
         }
 
+        code = std::move(output.code);
         return true;
     }
 
@@ -814,6 +1081,15 @@ namespace Falcor
     {
         const std::string expect("#expect");
         size_t expectOffset = findShaderDirective<false>(shader, 0, expect);
+        if(expectOffset == npos)
+        {
+            return true;
+        }
+
+        // Each directive is replaced with a line directive. The code is written to a new string, instead of patching the shader once per directive.
+        std::string patched;
+        patched.reserve(shader.size());
+        size_t copiedOffset = 0;
 
         while(expectOffset != npos)
         {
@@ -849,17 +1125,19 @@ namespace Falcor
             }
 
             // Get line directives so that the error will appear in the correct location
-            std::string linePragma = getLinePragma(line, file);
-
-            std::string prolog = shader.substr(0, expectOffset);
-            std::string epilogue = (endLine == npos) ? std::string() : shader.substr(endLine);
-
-            shader = prolog + linePragma + epilogue;
+            patched.append(shader, copiedOffset, expectOffset - copiedOffset);
+            patched += getLinePragma(line, file);
+            copiedOffset = endLine;
 
             // Get the next directive
             expectOffset = findShaderDirective<false>(shader, endLine, expect);
         }
 
+        if(copiedOffset != npos)
+        {
+            patched.append(shader, copiedOffset, npos);
+        }
+        shader = std::move(patched);
         return true;
     }
 
@@ -963,7 +1241,7 @@ namespace Falcor
         mDefineMap.clear();
     }
 
-    bool ShaderPreprocessor::parseShader(const std::string& filename, std::string& shader, std::string& errorMsg, const Program::DefineList& shaderDefines)
+    bool ShaderPreprocessor::parseShader(const std::string& filename, std::string& shader, std::string& errorMsg, const Program::DefineList& shaderDefines, std::vector<std::string>* pIncludedFiles)
     {
         ShaderPreprocessor preProc(errorMsg);
 
@@ -976,6 +1254,10 @@ namespace Falcor
             preProc.parsePragmaBlock(shader, "#foreach", "#endforeach", generateForEachBody) &&
             preProc.parsePragmaBlock(shader, "#for", "#endfor", generateForLoopBody))
         {
+            if(pIncludedFiles)
+            {
+                *pIncludedFiles = preProc.mIncludedFiles;
+            }
             return true;
         }
         return false;
@@ -160,9 +160,10 @@ namespace Falcor
             \param[out] shader On success, the parsed shader string.
             \param[out] errorMsg If an error occured, will contain the error message
             \param[in] shaderDefines Optional. A string containing a list of macro definitions to add. Do not put the #define directive, just the macro. Macro definitions are separated by a newline character.
+            \param[out] pIncludedFiles Optional. If not null, receives the absolute paths of all the files which were included, each path listed once.
             \return true if parsing was succesful, otherwise false. Call GetErrorString() to get the error message.
         */
-        static bool parseShader(const std::string& filename, std::string& shader, std::string& errorMsg, const Program::DefineList& shaderDefines = Program::DefineList());
+        static bool parseShader(const std::string& filename, std::string& shader, std::string& errorMsg, const Program::DefineList& shaderDefines = Program::DefineList(), std::vector<std::string>* pIncludedFiles = nullptr);
 
     private:
         ShaderPreprocessor(std::string& errorStr);
@@ -179,5 +180,6 @@ namespace Falcor
 
         std::map<std::string, std::string> mDefineMap;
         std::string mShaderPathAbs;
+        std::vector<std::string> mIncludedFiles;
     };
 }
@@ -30,6 +30,7 @@
 #include "Utils/ShaderPreprocessor.h"
 #include "Core/Shader.h"
 #include "Utils/OS.h"
+#include "Utils/ShaderCache.h"
 
 namespace Falcor
 {
@@ -55,12 +56,58 @@ namespace Falcor
         }
     }
 
+    bool preprocessShader(const std::string& shaderString, bool isFile, const Program::DefineList& shaderDefines, std::string& source, std::string& errorMsg)
+    {
+        std::string fullpath;
+        if(isFile)
+        {
+            if(findFileInDataDirectories(shaderString, fullpath) == false)
+            {
+                errorMsg = std::string("Can't find shader file ") + shaderString;
+                return false;
+            }
+        }
+
+        // Files are keyed by their full path, so that the same shader found in different data directories doesn't share an entry
+        const uint64_t key = ShaderCache::calculateSourceKey(isFile ? fullpath : shaderString, isFile, shaderDefines);
+        if(ShaderCache::loadSource(key, source))
+        {
+            return true;
+        }
+
+        if(isFile)
+        {
+            if(readFileToString(fullpath, source) == false)
+            {
+                errorMsg = std::string("Can't read shader file ") + fullpath;
+                return false;
+            }
+        }
+        else
+        {
+            source = shaderString;
+        }
+
+        std::vector<std::string> dependencies;
+        if(ShaderPreprocessor::parseShader(fullpath, source, errorMsg, shaderDefines, &dependencies) == false)
+        {
+            return false;
+        }
+
+        if(isFile)
+        {
+            dependencies.push_back(fullpath);
+        }
+        ShaderCache::storeSource(key, source, dependencies);
+        return true;
+    }
+
     const Shader::SharedPtr createShaderFromString(const std::string& shaderString, ShaderType shaderType, const Program::DefineList& shaderDefines)
     {
-        std::string shader = shaderString;
+        std::string shader;
         std::string errorMsg;
 
-        if(ShaderPreprocessor::parseShader("", shader, errorMsg, shaderDefines) == false)
+        if(preprocessShader(shaderString, false, shaderDefines, shader, errorMsg) == false)
         {
             std::string msg = std::string("Error when parsing shader from string. Code:\n") + shaderString + "\nError:\n" + errorMsg;
             Logger::log(Logger::Level::Fatal, msg);
@@ -92,13 +139,10 @@ namespace Falcor
 
         while(1)
         {
-            // Open the file
-            std::string shader;
-            readFileToString(fullpath, shader);
-
             // Preprocess
+            std::string shader;
             std::string errorMsg;
-            if(ShaderPreprocessor::parseShader(fullpath, shader, errorMsg, shaderDefines) == false)
+            if(preprocessShader(fullpath, true, shaderDefines, shader, errorMsg) == false)
             {
                 std::string msg = std::string("Error when pre-processing shader ") + filename + "\n" + errorMsg;
                 if(msgBox(msg, MsgBoxType::RetryCancel) == MsgBoxButton::Cancel)
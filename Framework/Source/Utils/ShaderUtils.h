@@ -52,4 +52,14 @@ namespace Falcor
     \return A pointer to a new object if compilation was successful, otherwise nullptr.
     */
     const Shader::SharedPtr createShaderFromString(const std::string& shaderString, ShaderType type, const Program::DefineList& shaderDefines = Program::DefineList());
+
+    /** Run the shader pre-processor on a shader. If the shader cache is enabled, the result is looked up in the cache first, and stored in it after pre-processing. See ShaderCache.
+    \param[in] shaderString Either a shader filename, which will be searched for in the common directory structure, or the shader code.
+    \param[in] isFile Whether shaderString is a filename
+    \param[in] shaderDefines Macro definitions to be patched into the shader
+    \param[out] source On success, the pre-processed shader
+    \param[out] errorMsg On failure, the error message
+    \return true if pre-processing was successful, otherwise false
+    */
+    bool preprocessShader(const std::string& shaderString, bool isFile, const Program::DefineList& shaderDefines, std::string& source, std::string& errorMsg);
 }
\ No newline at end of file
@@ -28,7 +28,6 @@
 #include "Framework.h"
 #include "Font.h"
 #include "TextRenderer.h"
-#include <vector>
 #include "glm/mat4x4.hpp"
 
 namespace Falcor
@@ -56,7 +55,8 @@ namespace Falcor
 
         mpProgram = Program::createFromFile(kVsFile, kFsFile);
         const uint32_t vbSize = (uint32_t)(sizeof(Vertex)*kMaxBatchSize*arraysize(kVertexPos));
-        mpVertexBuffer = Buffer::create(vbSize, Buffer::BindFlags::Vertex, Buffer::AccessFlags::MapWrite, nullptr);
+        mpVertexBuffer = Buffer::create(vbSize, Buffer::BindFlags::Vertex, Buffer::AccessFlags::Dynamic, nullptr);
+        mBufferData.resize(kMaxBatchSize*arraysize(kVertexPos));
         
         createVAO();
         // create the depth-state
@@ -138,9 +138,6 @@ namespace Falcor
         pRenderContext->setDepthStencilState(mpDepthStencilState, 0);
         pRenderContext->setBlendState(mpBlendState);
         pRenderContext->setTopology(RenderContext::Topology::TriangleList);
-
-        // Map the buffer
-        mpBufferData = (Vertex*)mpVertexBuffer->map(Buffer::MapType::WriteDiscard);
     }
 
     void TextRenderer::end()
@@ -148,17 +145,15 @@ namespace Falcor
         flush();
         mpRenderContext->popState();
         mpRenderContext = nullptr;
-        mpVertexBuffer->unmap();
     }
 
     void TextRenderer::flush()
     {
         if(mCurrentVertexID != 0)
         {
-            mpVertexBuffer->unmap();
+            mpRenderContext->updateBuffer(mpVertexBuffer, mBufferData.data(), 0, sizeof(Vertex)*mCurrentVertexID);
             mpRenderContext->draw(mCurrentVertexID, 0);
             mCurrentVertexID = 0;
-            mpVertexBuffer->map(Buffer::MapType::WriteDiscard);
         }
     }
 
@@ -167,7 +162,7 @@ namespace Falcor
         for(size_t CurChar = 0; CurChar < line.size() ; CurChar++)
         {
             // Make sure we enough space for the next char
-            if(mCurrentVertexID + arraysize(kVertexPos) > mpVertexBuffer->getSize())
+            if(mCurrentVertexID + arraysize(kVertexPos) > mBufferData.size())
             {
                 flush();
             }
@@ -200,8 +195,8 @@ namespace Falcor
 #endif
                     glm::vec2 pos = desc.size * posScale;
                     pos += mCurPos;
-                    mpBufferData[mCurrentVertexID].screenPos = pos;
-                    mpBufferData[mCurrentVertexID].texCoord = desc.topLeft + desc.size * kVertexPos[i];
+                    mBufferData[mCurrentVertexID].screenPos = pos;
+                    mBufferData[mCurrentVertexID].texCoord = desc.topLeft + desc.size * kVertexPos[i];
                 }
 
                 mCurPos.x += mpFont->getLettersSpacing();
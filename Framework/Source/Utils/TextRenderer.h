@@ -29,6 +29,7 @@
 #include "glm/vec2.hpp"
 #include "glm/vec3.hpp"
 #include <string>
+#include <vector>
 #include "Font.h"
 #include "Graphics/Program.h"
 #include "Core/VAO.h"
@@ -45,6 +46,7 @@ namespace Falcor
 
     /** Class that renders text into the screen.
         This class batches messages before drawing them for more efficient rendering. In order to do that, you have to enclose CTextRenderer#RenderLine() calls between CTextRenderer#Begin() and CTextRenderer#End() calls.
+        The vertices are uploaded through RenderContext#updateBuffer(), so the text can be recorded into a RenderCommandList.
     */
     class TextRenderer
     {
@@ -112,7 +114,7 @@ namespace Falcor
         static const auto kMaxBatchSize = 1000;
 
         void flush();
-        Vertex* mpBufferData = nullptr;
+        std::vector<Vertex> mBufferData;
 
         struct  
         {
@@ -0,0 +1,175 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "ThreadPool.h"
+#include <atomic>
+
+namespace Falcor
+{
+    ThreadPool::SharedPtr ThreadPool::create(uint32_t threadCount)
+    {
+        if(threadCount == 0)
+        {
+            uint32_t hwThreads = std::thread::hardware_concurrency();
+            threadCount = (hwThreads > 1) ? hwThreads - 1 : 1;
+        }
+        return SharedPtr(new ThreadPool(threadCount));
+    }
+
+    ThreadPool::SharedPtr ThreadPool::getDefaultPool()
+    {
+        static std::mutex sMutex;
+        static SharedPtr spPool;
+
+        std::lock_guard<std::mutex> lock(sMutex);
+        if(spPool == nullptr)
+        {
+            spPool = create();
+        }
+        return spPool;
+    }
+
+    ThreadPool::ThreadPool(uint32_t threadCount)
+    {
+        mThreads.reserve(threadCount);
+        for(uint32_t i = 0; i < threadCount; i++)
+        {
+            mThreads.push_back(std::thread(&ThreadPool::workerThread, this));
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mShutdown = true;
+        }
+        mTaskAdded.notify_all();
+        for(auto& t : mThreads)
+        {
+            t.join();
+        }
+    }
+
+    void ThreadPool::addTask(const Task& task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mTasks.push_back(task);
+        }
+        mTaskAdded.notify_one();
+    }
+
+    void ThreadPool::waitForAll()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mTaskDone.wait(lock, [this]() { return mTasks.empty() && (mActiveTaskCount == 0); });
+    }
+
+    void ThreadPool::workerThread()
+    {
+        while(true)
+        {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mTaskAdded.wait(lock, [this]() { return mShutdown || (mTasks.empty() == false); });
+                if(mTasks.empty())
+                {
+                    // Shutting down and nothing left to do
+                    return;
+                }
+                task = std::move(mTasks.front());
+                mTasks.pop_front();
+                mActiveTaskCount++;
+            }
+
+            task();
+
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mActiveTaskCount--;
+            }
+            mTaskDone.notify_all();
+        }
+    }
+
+    void ThreadPool::parallelFor(uint32_t count, const std::function<void(uint32_t)>& func)
+    {
+        if(count == 0)
+        {
+            return;
+        }
+
+        // The state is shared with the tasks. Tasks which start after all of the work was done by other threads still access it, so it can't live on the stack.
+        struct State
+        {
+            std::function<void(uint32_t)> func;
+            uint32_t count;
+            std::atomic<uint32_t> next;
+            std::atomic<uint32_t> done;
+            std::mutex mutex;
+            std::condition_variable cv;
+        };
+        auto pState = std::make_shared<State>();
+        pState->func = func;
+        pState->count = count;
+        pState->next = 0;
+        pState->done = 0;
+
+        auto work = [pState]()
+        {
+            while(true)
+            {
+                uint32_t i = pState->next++;
+                if(i >= pState->count)
+                {
+                    return;
+                }
+                pState->func(i);
+                if(++pState->done == pState->count)
+                {
+                    std::lock_guard<std::mutex> lock(pState->mutex);
+                    pState->cv.notify_all();
+                }
+            }
+        };
+
+        uint32_t taskCount = (count - 1 < getThreadCount()) ? count - 1 : getThreadCount();
+        for(uint32_t i = 0; i < taskCount; i++)
+        {
+            addTask(work);
+        }
+
+        work();
+
+        // Completion is tracked per item, not per task. If all of the workers are busy, the calling thread ends up doing all of the work and doesn't wait for the queued tasks.
+        std::unique_lock<std::mutex> lock(pState->mutex);
+        pState->cv.wait(lock, [&pState]() { return pState->done == pState->count; });
+    }
+}
@@ -0,0 +1,90 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <memory>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <stdint.h>
+
+namespace Falcor
+{
+    /** A fixed-size pool of worker threads consuming a shared task queue
+    */
+    class ThreadPool
+    {
+    public:
+        using SharedPtr = std::shared_ptr<ThreadPool>;
+        using Task = std::function<void()>;
+
+        /** Create a new thread pool
+            \param[in] threadCount Number of worker threads. 0 means one thread per hardware thread, minus one for the calling thread.
+        */
+        static SharedPtr create(uint32_t threadCount = 0);
+
+        /** Get the pool shared by the framework. Created on first use.
+        */
+        static SharedPtr getDefaultPool();
+
+        ~ThreadPool();
+
+        /** Add a task to the queue. Tasks are executed in FIFO order, but can complete in any order.
+        */
+        void addTask(const Task& task);
+
+        /** Block until the queue is empty and all tasks finished executing
+        */
+        void waitForAll();
+
+        /** Execute func(i) for every i in [0, count) and wait for all of the invocations to finish.
+            The calling thread participates in the work, so it is safe to call this from inside a task.
+            \param[in] count Number of invocations
+            \param[in] func The function to execute. Invocations can run concurrently and in any order.
+        */
+        void parallelFor(uint32_t count, const std::function<void(uint32_t)>& func);
+
+        /** Get the number of worker threads
+        */
+        uint32_t getThreadCount() const { return (uint32_t)mThreads.size(); }
+
+    private:
+        ThreadPool(uint32_t threadCount);
+        void workerThread();
+
+        std::vector<std::thread> mThreads;
+        std::deque<Task> mTasks;
+        std::mutex mMutex;
+        std::condition_variable mTaskAdded;
+        std::condition_variable mTaskDone;
+        uint32_t mActiveTaskCount = 0;
+        bool mShutdown = false;
+    };
+}
@@ -394,6 +394,101 @@ namespace Falcor
         }
     }
 
+    void enumerateFilesRecursive(const std::string& directory, std::vector<std::string>& filenames)
+    {
+        WIN32_FIND_DATAA ffd;
+        HANDLE hFind = FindFirstFileA((directory + "\\*").c_str(), &ffd);
+        if(hFind == INVALID_HANDLE_VALUE)
+        {
+            return;
+        }
+
+        do
+        {
+            std::string name = ffd.cFileName;
+            if(name == "." || name == "..")
+            {
+                continue;
+            }
+
+            std::string fullpath = directory + '\\' + name;
+            if(ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            {
+                enumerateFilesRecursive(fullpath, filenames);
+            }
+            else
+            {
+                filenames.push_back(fullpath);
+            }
+        } while(FindNextFileA(hFind, &ffd) != 0);
+
+        FindClose(hFind);
+    }
+
+    bool getFileModifiedTime(const std::string& filename, uint64_t& time)
+    {
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if(GetFileAttributesExA(filename.c_str(), GetFileExInfoStandard, &data) == FALSE)
+        {
+            return false;
+        }
+        time = (uint64_t(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+        return true;
+    }
+
+    bool getFileSize(const std::string& filename, uint64_t& size)
+    {
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if(GetFileAttributesExA(filename.c_str(), GetFileExInfoStandard, &data) == FALSE)
+        {
+            return false;
+        }
+        size = (uint64_t(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+        return true;
+    }
+
+    bool createDirectory(const std::string& path)
+    {
+        // SHCreateDirectoryEx() requires a full path
+        char fullpath[MAX_PATH];
+        if(GetFullPathNameA(path.c_str(), MAX_PATH, fullpath, nullptr) == 0)
+        {
+            return false;
+        }
+        int result = SHCreateDirectoryExA(nullptr, fullpath, nullptr);
+        return (result == ERROR_SUCCESS) || (result == ERROR_ALREADY_EXISTS) || (result == ERROR_FILE_EXISTS);
+    }
+
+    size_t executeProcess(const std::string& appName, const std::string& commandLineArgs)
+    {
+        // CreateProcess() can modify the command line buffer, so it can't be a const string
+        std::string commandLine = '"' + appName + "\" " + commandLineArgs;
+        std::vector<char> buffer(commandLine.begin(), commandLine.end());
+        buffer.push_back(0);
+
+        STARTUPINFOA startupInfo = {};
+        startupInfo.cb = sizeof(startupInfo);
+        PROCESS_INFORMATION processInfo = {};
+        if(CreateProcessA(appName.c_str(), buffer.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startupInfo, &processInfo) == FALSE)
+        {
+            Logger::log(Logger::Level::Error, "Failed to start process " + appName);
+            return 0;
+        }
+
+        CloseHandle(processInfo.hThread);
+        return (size_t)processInfo.hProcess;
+    }
+
+    uint32_t waitForProcess(size_t processHandle)
+    {
+        HANDLE hProcess = (HANDLE)processHandle;
+        WaitForSingleObject(hProcess, INFINITE);
+        DWORD exitCode = 0;
+        GetExitCodeProcess(hProcess, &exitCode);
+        CloseHandle(hProcess);
+        return (uint32_t)exitCode;
+    }
+
     std::thread::native_handle_type getCurrentThread()
     {
         return ::GetCurrentThread();
@@ -160,7 +160,17 @@ void Shadows::onFrameRender()
         }
     }
 
-    renderText(getGlobalSampleMessage(true), glm::vec2(10, 10));
+    std::string msg = getGlobalSampleMessage(true);
+    if(mpScene)
+    {
+        const auto& pCsm = mpCsmTech[mControls.lightIndex];
+        msg += "\nDraws per cascade:";
+        for(uint32_t c = 0; c < pCsm->getCascadeCount(); c++)
+        {
+            msg += " " + std::to_string(pCsm->getCascadeDrawCount(c));
+        }
+    }
+    renderText(msg, glm::vec2(10, 10));
 }
 
 void Shadows::onShutdown()
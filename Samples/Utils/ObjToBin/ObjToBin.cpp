@@ -26,79 +26,396 @@
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ***************************************************************************/
 #include "ObjToBin.h"
+#include "Utils/MemoryMappedFile.h"
+#include "Utils/ThreadPool.h"
+#include "Utils/Hash.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <sstream>
 
-ObjToBin::ObjToBin(std::vector<std::string> objFiles)
+static const uint32_t kModelFlags = Model::GenerateTangentSpace | Model::OptimizeVertexCache;
+static const uint32_t kBinSceneVersion = 12;    // Part of the input hash, so that outputs are regenerated when the format changes
+
+ObjToBin::ObjToBin(const std::string& input, const std::string& output, const std::string& statsFile, uint32_t modelFlags, bool compress, bool quantize) :
+    mInput(input), mOutput(output), mStatsFile(statsFile), mModelFlags(modelFlags), mCompress(compress), mQuantize(quantize)
+{
+}
+
+void ObjToBin::onLoad()
 {
-    mObjFiles = objFiles;
+    auto pModel = Model::createFromFile(mInput, mModelFlags);
+    if(pModel)
+    {
+        createDirectory(getDirectoryFromFile(mOutput));
+        std::remove(mOutput.c_str());
+        pModel->exportToBinaryFile(mOutput, mCompress, mQuantize);
+
+        // The exporter deletes the file if it fails
+        mSucceeded = doesFileExist(mOutput);
+        if(mSucceeded)
+        {
+            std::ofstream stats(mStatsFile);
+            stats << pModel->getVertexCount() << " " << pModel->getPrimitiveCount() << std::endl;
+        }
+    }
+    shutdownApp();
 }
 
-void ObjToBin::convertObjToBin(const std::string& objFile)
+static bool isSupportedFile(const std::string& filename)
 {
-    printf("Converting %s ...\n", objFile.c_str());
-    auto pModel = Model::createFromFile(objFile, Model::GenerateTangentSpace);
+    return hasSuffix(filename, ".obj", false) || hasSuffix(filename, ".fbx", false) || hasSuffix(filename, ".dae", false);
+}
 
-    if (pModel)
+static std::string getOutputFilename(const std::string& input, const std::string& inputRoot, const std::string& outputDir)
+{
+    std::string output = input.substr(0, input.find_last_of('.')) + ".bin";
+    if(outputDir.size())
     {
+        // Mirror the input directory tree inside the output directory
+        output = outputDir + '\\' + output.substr(inputRoot.size());
+    }
+    return canonicalizeFilename(output);
+}
 
-        std::string fullpath;
-        if (findFileInDataDirectories(objFile, fullpath) == false)
+static uint64_t getFileSize(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    return file.good() ? (uint64_t)file.tellg() : 0;
+}
+
+static uint64_t hashFile(const std::string& filename, uint64_t seed)
+{
+    MemoryMappedFile file;
+    if(file.open(filename) == false)
+    {
+        return seed;
+    }
+    return calculateHash64(file.getData(), file.getSize(), seed);
+}
+
+static std::string escapeJson(const std::string& str)
+{
+    std::string result;
+    for(char c : str)
+    {
+        if(c == '\\' || c == '"')
         {
-            printf("    Cannot find OBJ file.\n");
+            result += '\\';
         }
+        result += c;
+    }
+    return result;
+}
 
-        std::string binFilename = Falcor::swapFileExtension(fullpath, ".obj", ".bin");
+static const char* to_string(ConversionResult::Status status)
+{
+    switch(status)
+    {
+    case ConversionResult::Status::Converted:
+        return "converted";
+    case ConversionResult::Status::UpToDate:
+        return "up-to-date";
+    case ConversionResult::Status::Failed:
+        return "failed";
+    default:
+        should_not_get_here();
+        return "";
+    }
+}
 
-        if (!Falcor::doesFileExist(binFilename))
+class Converter
+{
+public:
+    Converter(const ConverterOptions& options) : mOptions(options) {}
+
+    /** Run the conversion
+        \return The number of files which failed to convert
+    */
+    uint32_t run()
+    {
+        if(findInputFiles() == false)
+        {
+            return 1;
+        }
+
+        uint32_t workerCount = mOptions.workerCount ? mOptions.workerCount : std::thread::hardware_concurrency();
+        workerCount = std::max(workerCount, 1u);
+        printf("Converting %u files using %u workers\n", (uint32_t)mResults.size(), workerCount);
+
+        // Each task spends most of its time waiting for a worker process. The calling thread participates in parallelFor(), so the pool only needs workerCount - 1 threads.
+        auto convertFunc = [this](uint32_t i) { convert(mResults[i]); };
+        if(workerCount > 1)
         {
-            printf("    Writing %s ...\n", binFilename.c_str());
-            pModel->exportToBinaryFile(binFilename);
+            ThreadPool::create(workerCount - 1)->parallelFor((uint32_t)mResults.size(), convertFunc);
         }
         else
         {
-            printf("    BIN file already exists.\n");
+            for(uint32_t i = 0; i < (uint32_t)mResults.size(); i++)
+            {
+                convertFunc(i);
+            }
+        }
+
+        uint32_t failureCount = 0;
+        for(const auto& r : mResults)
+        {
+            failureCount += (r.status == ConversionResult::Status::Failed) ? 1 : 0;
+        }
+
+        if(mOptions.summaryFile.size())
+        {
+            writeSummary();
+        }
+
+        printf("Done. %u files failed\n", failureCount);
+        return failureCount;
+    }
+
+private:
+    const ConverterOptions& mOptions;
+    std::vector<ConversionResult> mResults;
+    std::mutex mPrintMutex;
+
+    bool findInputFiles()
+    {
+        for(const auto& input : mOptions.inputs)
+        {
+            std::string fullpath = canonicalizeFilename(input);
+            if(isDirectoryExists(fullpath))
+            {
+                std::vector<std::string> files;
+                enumerateFilesRecursive(fullpath, files);
+                for(const auto& f : files)
+                {
+                    if(isSupportedFile(f))
+                    {
+                        addFile(f, fullpath);
+                    }
+                }
+            }
+            else if(doesFileExist(fullpath))
+            {
+                addFile(fullpath, getDirectoryFromFile(fullpath));
+            }
+            else
+            {
+                printf("Can't find %s\n", input.c_str());
+                return false;
+            }
         }
+        return true;
     }
-    else
+
+    void addFile(const std::string& input, const std::string& inputRoot)
     {
-        printf("   ");
+        ConversionResult result;
+        result.input = input;
+        result.output = getOutputFilename(input, inputRoot, mOptions.outputDir);
+        mResults.push_back(result);
     }
-}
 
-void ObjToBin::onLoad()
-{
-    for (const auto& objFile : mObjFiles)
+    uint64_t getHashSeed() const
     {
-        convertObjToBin(objFile);
+        return kModelFlags | (uint64_t(mOptions.compress) << 32) | (uint64_t(mOptions.quantize) << 33) | (uint64_t(mOptions.generateLods) << 34) | (uint64_t(kBinSceneVersion) << 40);
     }
-    shutdownApp();
+
+    bool isUpToDate(const ConversionResult& result, uint64_t inputHash) const
+    {
+        if(mOptions.force || doesFileExist(result.output) == false)
+        {
+            return false;
+        }
+
+        if(mOptions.useHash)
+        {
+            uint64_t storedHash = 0;
+            std::ifstream hashFile(result.output + ".hash");
+            hashFile >> std::hex >> storedHash;
+            return hashFile.fail() == false && storedHash == inputHash;
+        }
+        else
+        {
+            uint64_t inputTime, outputTime;
+            return getFileModifiedTime(result.input, inputTime) && getFileModifiedTime(result.output, outputTime) && (outputTime >= inputTime);
+        }
+    }
+
+    void convert(ConversionResult& result)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        uint64_t inputHash = mOptions.useHash ? hashFile(result.input, getHashSeed()) : 0;
+
+        if(isUpToDate(result, inputHash))
+        {
+            result.status = ConversionResult::Status::UpToDate;
+        }
+        else
+        {
+            std::string statsFile = result.output + ".stats";
+            std::string args = "-convert \"" + result.input + "\" \"" + result.output + "\" \"" + statsFile + "\"";
+            args += mOptions.compress ? " -compress" : "";
+            args += mOptions.quantize ? " -quantize" : "";
+            args += mOptions.generateLods ? " -lods" : "";
+
+            result.status = ConversionResult::Status::Failed;
+            size_t process = executeProcess(getExecutableDirectory() + '\\' + getExecutableName(), args);
+            if(process && waitForProcess(process) == 0)
+            {
+                std::ifstream stats(statsFile);
+                stats >> result.vertexCount >> result.triangleCount;
+                if(stats.fail() == false)
+                {
+                    result.status = ConversionResult::Status::Converted;
+                }
+            }
+            std::remove(statsFile.c_str());
+
+            if(result.status == ConversionResult::Status::Converted && mOptions.useHash)
+            {
+                std::ofstream hashFile(result.output + ".hash");
+                hashFile << std::hex << inputHash << std::endl;
+            }
+        }
+
+        result.bytes = getFileSize(result.output);
+        result.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lock(mPrintMutex);
+        printf("%s: %s (%.2f s)\n", result.input.c_str(), to_string(result.status), result.seconds);
+    }
+
+    void writeSummary() const
+    {
+        std::ofstream summary(mOptions.summaryFile);
+        summary << "[\n";
+        for(size_t i = 0; i < mResults.size(); i++)
+        {
+            const ConversionResult& r = mResults[i];
+            summary << "    {";
+            summary << "\"input\": \"" << escapeJson(r.input) << "\", ";
+            summary << "\"output\": \"" << escapeJson(r.output) << "\", ";
+            summary << "\"status\": \"" << to_string(r.status) << "\", ";
+            summary << "\"vertices\": " << r.vertexCount << ", ";
+            summary << "\"triangles\": " << r.triangleCount << ", ";
+            summary << "\"bytes\": " << r.bytes << ", ";
+            summary << "\"seconds\": " << r.seconds;
+            summary << ((i + 1 < mResults.size()) ? "},\n" : "}\n");
+        }
+        summary << "]\n";
+
+        if(summary.fail())
+        {
+            printf("Failed to write the summary file %s\n", mOptions.summaryFile.c_str());
+        }
+    }
+};
+
+static void printUsage()
+{
+    printf("Syntax: ObjToBin [options] <files or directories>\n");
+    printf("Converts OBJ, FBX and DAE files into BinScene files. Directories are searched recursively.\n");
+    printf("    -o <directory>      Write the outputs into a directory, mirroring the input directory tree. By default outputs are written next to the inputs\n");
+    printf("    -j <count>          Number of concurrent conversions. Defaults to the number of hardware threads\n");
+    printf("    -summary <file>     Write a JSON summary of the conversion\n");
+    printf("    -force              Convert all the files, even if their output is up-to-date\n");
+    printf("    -hash               Detect up-to-date outputs using a hash of the input file instead of timestamps\n");
+    printf("    -compress           Compress the outputs\n");
+    printf("    -quantize           Store vertex attributes using compact encodings\n");
+    printf("    -lods               Generate simplified LODs for every mesh\n");
 }
 
-void ObjToBin::onShutdown()
+static int runWorker(int argc, char* argv[])
 {
+    // ObjToBin -convert <input> <output> <stats file> [-compress] [-quantize] [-lods]
+    if(argc < 5)
+    {
+        return 1;
+    }
 
-}
+    bool compress = false;
+    bool quantize = false;
+    uint32_t modelFlags = kModelFlags;
+    for(int i = 5; i < argc; i++)
+    {
+        compress = compress || (std::string(argv[i]) == "-compress");
+        quantize = quantize || (std::string(argv[i]) == "-quantize");
+        modelFlags |= (std::string(argv[i]) == "-lods") ? Model::GenerateLods : 0;
+    }
 
+    ObjToBin worker(argv[2], argv[3], argv[4], modelFlags, compress, quantize);
+    SampleConfig config;
+    config.windowDesc.swapChainDesc.width = 64;
+    config.windowDesc.swapChainDesc.height = 64;
+    config.windowDesc.title = "ObjToBin";
+    config.windowDesc.isVisible = false;
+    config.showMessageBoxOnError = false;
+    worker.run(config);
+    return worker.succeeded() ? 0 : 1;
+}
 
 int main(int argc, char* argv[])
 {
-    if (argc >= 2)
+    if(argc >= 2 && std::string(argv[1]) == "-convert")
     {
-        std::vector<std::string> objFiles;
+        return runWorker(argc, argv);
+    }
 
-        for (int argi = 1; argi < argc; ++argi)
+    ConverterOptions options;
+    for(int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if(arg == "-o" && hasValue)
         {
-            objFiles.push_back(std::string(argv[argi]));
+            options.outputDir = canonicalizeFilename(argv[++i]);
+        }
+        else if(arg == "-j" && hasValue)
+        {
+            options.workerCount = (uint32_t)std::stoul(argv[++i]);
+        }
+        else if(arg == "-summary" && hasValue)
+        {
+            options.summaryFile = argv[++i];
+        }
+        else if(arg == "-force")
+        {
+            options.force = true;
+        }
+        else if(arg == "-hash")
+        {
+            options.useHash = true;
+        }
+        else if(arg == "-compress")
+        {
+            options.compress = true;
+        }
+        else if(arg == "-quantize")
+        {
+            options.quantize = true;
+        }
+        else if(arg == "-lods")
+        {
+            options.generateLods = true;
+        }
+        else if(arg[0] == '-')
+        {
+            printUsage();
+            return 1;
+        }
+        else
+        {
+            options.inputs.push_back(arg);
         }
-
-        ObjToBin ObjToBin(objFiles);
-        SampleConfig config;
-        config.windowDesc.swapChainDesc.width = 256;
-        config.windowDesc.swapChainDesc.height = 256;
-        config.windowDesc.title = "ObjToBin";
-        ObjToBin.run(config);
     }
-    else
+
+    if(options.inputs.empty())
     {
-        printf("Syntax: ObjToBin <list of obj files>\n");
+        printUsage();
+        return 1;
     }
-}
\ No newline at end of file
+
+    Converter converter(options);
+    return (converter.run() == 0) ? 0 : 1;
+}
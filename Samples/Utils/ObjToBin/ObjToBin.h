@@ -30,16 +30,56 @@
 
 using namespace Falcor;
 
+/** Batch converter from model files supported by Assimp (OBJ, FBX, DAE) to BinScene files.
+    The converter process doesn't create a graphics device. It finds the input files, skips the ones which are up-to-date, and launches a pool of worker processes (this executable with the -convert argument).
+    Each worker creates a hidden window for the graphics device, converts a single file and reports the result through a stats file.
+*/
+struct ConverterOptions
+{
+    std::vector<std::string> inputs;    ///< Files and directories to convert. Directories are searched recursively
+    std::string outputDir;              ///< If not empty, outputs are written into this directory, mirroring the input directory tree. Otherwise outputs are written next to the inputs
+    std::string summaryFile;            ///< If not empty, a JSON summary of the conversion is written into this file
+    uint32_t workerCount = 0;           ///< Number of concurrent worker processes. 0 means one per hardware thread
+    bool force = false;                 ///< Convert files even if the output is up-to-date
+    bool useHash = false;               ///< Decide if an output is up-to-date using a hash of the input file (stored next to the output) instead of timestamps
+    bool compress = false;              ///< Compress the output files
+    bool quantize = false;              ///< Store vertex attributes using compact encodings
+    bool generateLods = false;          ///< Generate a chain of simplified LODs for every mesh
+};
+
+struct ConversionResult
+{
+    enum class Status
+    {
+        Converted,
+        UpToDate,
+        Failed
+    };
+
+    std::string input;
+    std::string output;
+    Status status = Status::Failed;
+    uint32_t vertexCount = 0;
+    uint32_t triangleCount = 0;
+    uint64_t bytes = 0;
+    double seconds = 0;
+};
+
+/** Worker which converts a single file
+*/
 class ObjToBin : public Sample
 {
-public:    
+public:
+    ObjToBin(const std::string& input, const std::string& output, const std::string& statsFile, uint32_t modelFlags, bool compress, bool quantize);
     void onLoad() override;
-    void onShutdown() override;
+    bool succeeded() const { return mSucceeded; }
 
-    ObjToBin(std::vector<std::string> objFiles);
-    void convertObjToBin(const std::string& objFile);
 private:
-    inline void shutdown() {}
-
-    std::vector<std::string> mObjFiles;
-};
\ No newline at end of file
+    std::string mInput;
+    std::string mOutput;
+    std::string mStatsFile;
+    uint32_t mModelFlags;
+    bool mCompress;
+    bool mQuantize;
+    bool mSucceeded = false;
+};
@@ -69,6 +69,10 @@ void SceneEditorSample::initNewScene()
         getSceneLightString(mpScene.get(), lights);
         mpProgram->addDefine("_LIGHT_SOURCES", lights);
         mpLightBuffer = UniformBuffer::create(mpProgram->getActiveProgramVersion().get(), "PerFrameCB");
+
+        // Compile the versions for the scene's models and materials in the background, instead of when they first come into view
+        mpProgram->setAsyncCompilation(true);
+        mpRenderer->prewarmProgram(mpProgram.get());
     }
 }
 
@@ -0,0 +1,832 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "BinaryModelImporterTest.h"
+#include "Graphics/Model/Loaders/SimpleModelImporter.h"
+#include "Graphics/Model/Loaders/BinaryModelImporter.h"
+#include "Graphics/Model/VertexQuantization.h"
+#include "Data/VertexAttrib.h"
+#include "Utils/CpuTimer.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <psapi.h>
+
+#pragma comment(lib, "psapi.lib")
+
+static const std::string kWorkerArg = "-load";
+static const uint32_t kSphereCount = 8;
+static const uint32_t kSphereRings = 16;
+static const uint32_t kSphereSegments = 32;
+
+static uint64_t getFileSize(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    return file.good() ? (uint64_t)file.tellg() : 0;
+}
+
+static PROCESS_MEMORY_COUNTERS getMemoryCounters()
+{
+    PROCESS_MEMORY_COUNTERS counters = {};
+    counters.cb = sizeof(counters);
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return counters;
+}
+
+/** A flat grid of size x size quads. Only has positions, which keeps the in-memory model small compared to the file.
+*/
+static Model::SharedPtr createGridModel(uint32_t size)
+{
+    std::vector<glm::vec3> positions;
+    positions.reserve((size + 1) * (size + 1));
+    for(uint32_t y = 0; y <= size; y++)
+    {
+        for(uint32_t x = 0; x <= size; x++)
+        {
+            positions.push_back(glm::vec3(float(x), float(y), 0));
+        }
+    }
+
+    std::vector<uint32_t> indices;
+    indices.reserve(size * size * 6);
+    for(uint32_t y = 0; y < size; y++)
+    {
+        for(uint32_t x = 0; x < size; x++)
+        {
+            uint32_t v0 = y * (size + 1) + x;
+            uint32_t quad[6] = {v0, v0 + 1, v0 + size + 1, v0 + size + 1, v0 + 1, v0 + size + 2};
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+
+    SimpleModelImporter::VertexFormat format;
+    SimpleModelImporter::VertexAttrib position = {SimpleModelImporter::AttribType::Position, 3, AttribFormat_F32};
+    format.attribs.push_back(position);
+    return SimpleModelImporter::create(format, uint32_t(positions.size() * sizeof(glm::vec3)), positions.data(), uint32_t(indices.size() * sizeof(uint32_t)), indices.data());
+}
+
+template<typename T>
+static void writeValue(std::ofstream& file, const T& value)
+{
+    file.write((const char*)&value, sizeof(T));
+}
+
+/** Write meshCount grids of size x size vertices into a BinScene v8 file. v8 files store interleaved vertices, which the importer de-interleaves while loading.
+    The file is written directly, since the exporter only writes the latest version. Every vertex has a position, a normal and a texture coordinate.
+*/
+static bool writeLegacyGridFile(const std::string& filename, uint32_t meshCount, uint32_t size)
+{
+    std::ofstream file(filename, std::ios::binary);
+    file.write("BinScene", 8);
+    writeValue(file, int32_t(8));
+    writeValue(file, int32_t(0));               // numTextures
+    writeValue(file, int32_t(meshCount));
+    writeValue(file, int32_t(meshCount));       // numInstances
+
+    struct Vertex
+    {
+        glm::vec3 position;
+        glm::vec3 normal;
+        glm::vec2 texCoord;
+    };
+
+    std::vector<Vertex> row(size);
+    std::vector<uint32_t> indexRow((size - 1) * 6);
+    for(uint32_t meshID = 0; meshID < meshCount; meshID++)
+    {
+        // Mesh header and the attributes, {type, format, length}
+        writeValue(file, int32_t(3));
+        writeValue(file, int32_t(size * size));
+        writeValue(file, int32_t(1));
+        const int32_t attribs[3][3] = {{AttribType_Position, AttribFormat_F32, 3}, {AttribType_Normal, AttribFormat_F32, 3}, {AttribType_TexCoord, AttribFormat_F32, 2}};
+        file.write((const char*)attribs, sizeof(attribs));
+
+        for(uint32_t y = 0; y < size; y++)
+        {
+            for(uint32_t x = 0; x < size; x++)
+            {
+                row[x].position = glm::vec3(float(meshID * size + x), float(y), 0);
+                row[x].normal = glm::vec3(0, 0, 1);
+                row[x].texCoord = glm::vec2(float(x), float(y)) / float(size - 1);
+            }
+            file.write((const char*)row.data(), row.size() * sizeof(Vertex));
+        }
+
+        // Submesh. Ambient, diffuse, specular, glossiness, displacement coefficient and bias, the texture slots and the triangle count
+        const float material[13] = {0, 0, 0, 1, 1, 1, 0, 0, 0, 0, 1, 0, 0};
+        file.write((const char*)material, sizeof(material));
+        for(int32_t slot = 0; slot <= TextureType_Glossiness; slot++)
+        {
+            writeValue(file, int32_t(-1));
+        }
+        writeValue(file, int32_t((size - 1) * (size - 1) * 2));
+
+        for(uint32_t y = 0; y < size - 1; y++)
+        {
+            for(uint32_t x = 0; x < size - 1; x++)
+            {
+                uint32_t v0 = y * size + x;
+                uint32_t quad[6] = {v0, v0 + 1, v0 + size, v0 + size, v0 + 1, v0 + size + 1};
+                std::copy(quad, quad + 6, indexRow.begin() + x * 6);
+            }
+            file.write((const char*)indexRow.data(), indexRow.size() * sizeof(uint32_t));
+        }
+    }
+
+    // Instances. Mesh index, enabled flag, transformation, name and meta-data
+    for(uint32_t meshID = 0; meshID < meshCount; meshID++)
+    {
+        writeValue(file, int32_t(meshID));
+        writeValue(file, int32_t(1));
+        writeValue(file, glm::mat4());
+        writeValue(file, int32_t(0));
+        writeValue(file, int32_t(0));
+    }
+    return file.good();
+}
+
+static glm::vec3 getSphereCenter(uint32_t sphereID)
+{
+    return glm::vec3(10.0f * float(sphereID), 0, 0);
+}
+
+/** Write unit UV-spheres with normals and texture coordinates into an OBJ file. Every sphere is a separate object, which becomes a separate mesh when loading with Model::DontMergeMeshes.
+*/
+static bool writeSpheresObj(const std::string& filename)
+{
+    std::ofstream file(filename);
+    uint32_t firstVertex = 1;
+    for(uint32_t i = 0; i < kSphereCount; i++)
+    {
+        file << "o Sphere" << i << "\n";
+        const glm::vec3 center = getSphereCenter(i);
+        for(uint32_t r = 0; r <= kSphereRings; r++)
+        {
+            for(uint32_t s = 0; s <= kSphereSegments; s++)
+            {
+                float theta = glm::pi<float>() * float(r) / float(kSphereRings);
+                float phi = 2 * glm::pi<float>() * float(s % kSphereSegments) / float(kSphereSegments);
+                glm::vec3 normal(sin(theta) * cos(phi), sin(theta) * sin(phi), cos(theta));
+                glm::vec3 position = center + normal;
+                file << "v " << position.x << " " << position.y << " " << position.z << "\n";
+                file << "vn " << normal.x << " " << normal.y << " " << normal.z << "\n";
+                file << "vt " << float(s) / float(kSphereSegments) << " " << float(r) / float(kSphereRings) << "\n";
+            }
+        }
+
+        for(uint32_t r = 0; r < kSphereRings; r++)
+        {
+            for(uint32_t s = 0; s < kSphereSegments; s++)
+            {
+                uint32_t v0 = firstVertex + r * (kSphereSegments + 1) + s;
+                uint32_t quad[6] = {v0, v0 + kSphereSegments + 1, v0 + 1, v0 + 1, v0 + kSphereSegments + 1, v0 + kSphereSegments + 2};
+                for(uint32_t t = 0; t < 6; t += 3)
+                {
+                    file << "f";
+                    for(uint32_t v = t; v < t + 3; v++)
+                    {
+                        file << " " << quad[v] << "/" << quad[v] << "/" << quad[v];
+                    }
+                    file << "\n";
+                }
+            }
+        }
+        firstVertex += (kSphereRings + 1) * (kSphereSegments + 1);
+    }
+    return file.good();
+}
+
+/** Read a GPU buffer. Most of the model buffers can't be mapped, so they are copied into a staging buffer first.
+*/
+static std::vector<uint8_t> readBuffer(const Buffer* pBuffer)
+{
+    auto pStaging = Buffer::create(pBuffer->getSize(), Buffer::BindFlags::None, Buffer::AccessFlags::MapRead, nullptr);
+    pBuffer->copy(pStaging.get());
+    const uint8_t* pData = (const uint8_t*)pStaging->map(Buffer::MapType::Read);
+    std::vector<uint8_t> data(pData, pData + pBuffer->getSize());
+    pStaging->unmap();
+    return data;
+}
+
+/** Read the table of contents of a BinScene v9+ file
+*/
+static std::vector<ChunkDesc> readTableOfContents(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    file.seekg(8 + 4 * sizeof(int32_t));
+    int32_t chunkCount = 0;
+    file.read((char*)&chunkCount, sizeof(chunkCount));
+    std::vector<ChunkDesc> chunks(file.good() ? chunkCount : 0);
+    for(auto& chunk : chunks)
+    {
+        file.read((char*)&chunk.type, sizeof(chunk.type));
+        file.read((char*)&chunk.compression, sizeof(chunk.compression));
+        file.read((char*)&chunk.offset, sizeof(chunk.offset));
+        file.read((char*)&chunk.storedSize, sizeof(chunk.storedSize));
+        file.read((char*)&chunk.size, sizeof(chunk.size));
+        file.read((char*)&chunk.hash, sizeof(chunk.hash));
+    }
+    return file.good() ? chunks : std::vector<ChunkDesc>();
+}
+
+static bool compareBuffers(const Buffer* pA, const Buffer* pB)
+{
+    if(pA == pB)
+    {
+        return true;
+    }
+    return pA && pB && (pA->getSize() == pB->getSize()) && (readBuffer(pA) == readBuffer(pB));
+}
+
+/** Compare the meshes of two models, including the content of their vertex and index buffers
+    \param[out] difference Receives a description of the first difference
+*/
+static bool compareModels(const Model* pA, const Model* pB, std::string& difference)
+{
+    if(pA->getMeshCount() != pB->getMeshCount())
+    {
+        difference = "the mesh count is different";
+        return false;
+    }
+
+    for(uint32_t meshID = 0; meshID < pA->getMeshCount(); meshID++)
+    {
+        const Mesh* pMeshA = pA->getMesh(meshID).get();
+        const Mesh* pMeshB = pB->getMesh(meshID).get();
+        const std::string meshName = "mesh " + std::to_string(meshID);
+        if((pMeshA->getVertexCount() != pMeshB->getVertexCount()) || (pMeshA->getIndexCount() != pMeshB->getIndexCount()))
+        {
+            difference = "the size of " + meshName + " is different";
+            return false;
+        }
+
+        BoundingBox boxA = pMeshA->getObjectSpaceBoundingBox();
+        if((boxA == pMeshB->getObjectSpaceBoundingBox()) == false)
+        {
+            difference = "the bounding-box of " + meshName + " is different";
+            return false;
+        }
+
+        bool sameLods = (pMeshA->getLodCount() == pMeshB->getLodCount());
+        for(uint32_t lod = 0; sameLods && (lod < pMeshA->getLodCount()); lod++)
+        {
+            const Mesh::Lod& lodA = pMeshA->getLod(lod);
+            const Mesh::Lod& lodB = pMeshB->getLod(lod);
+            sameLods = (lodA.firstIndex == lodB.firstIndex) && (lodA.indexCount == lodB.indexCount) && (lodA.error == lodB.error);
+        }
+        if(sameLods == false)
+        {
+            difference = "the LODs of " + meshName + " are different";
+            return false;
+        }
+
+        if((pMeshA->getInstanceCount() != pMeshB->getInstanceCount()) || std::memcmp(pMeshA->getInstanceMatrices(), pMeshB->getInstanceMatrices(), pMeshA->getInstanceCount() * sizeof(glm::mat4)))
+        {
+            difference = "the instances of " + meshName + " are different";
+            return false;
+        }
+
+        const Vao* pVaoA = pMeshA->getVao().get();
+        const Vao* pVaoB = pMeshB->getVao().get();
+        if(pVaoA->getVertexBuffersCount() != pVaoB->getVertexBuffersCount())
+        {
+            difference = "the vertex buffer count of " + meshName + " is different";
+            return false;
+        }
+
+        for(uint32_t i = 0; i < pVaoA->getVertexBuffersCount(); i++)
+        {
+            if((pVaoA->getVertexBufferLayout(i)->getElementFormat(0) != pVaoB->getVertexBufferLayout(i)->getElementFormat(0)) || (compareBuffers(pVaoA->getVertexBuffer(i).get(), pVaoB->getVertexBuffer(i).get()) == false))
+            {
+                difference = "vertex buffer " + std::to_string(i) + " of " + meshName + " is different";
+                return false;
+            }
+        }
+
+        if(compareBuffers(pVaoA->getIndexBuffer().get(), pVaoB->getIndexBuffer().get()) == false)
+        {
+            difference = "the index buffer of " + meshName + " is different";
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Read a 3-component vertex attribute as floats, decoding compressed vertices
+    \return The attribute of every vertex, or an empty vector if the mesh doesn't have the attribute
+*/
+static std::vector<glm::vec3> readVertexAttribute(const Mesh* pMesh, uint32_t shaderLocation)
+{
+    const Vao* pVao = pMesh->getVao().get();
+    const Mesh::VertexEncoding& encoding = pMesh->getVertexEncoding();
+    std::vector<glm::vec3> attribute;
+    for(uint32_t i = 0; i < pVao->getVertexBuffersCount(); i++)
+    {
+        const VertexLayout* pLayout = pVao->getVertexBufferLayout(i).get();
+        if(pLayout->getElementShaderLocation(0) != shaderLocation)
+        {
+            continue;
+        }
+
+        const ResourceFormat format = pLayout->getElementFormat(0);
+        const uint32_t stride = pVao->getVertexBufferStride(i);
+        std::vector<uint8_t> data = readBuffer(pVao->getVertexBuffer(i).get());
+        for(uint32_t v = 0; v < pMesh->getVertexCount(); v++)
+        {
+            const uint8_t* pVertex = data.data() + size_t(stride) * v;
+            if(format == ResourceFormat::RGBA16Unorm)
+            {
+                const uint16_t* pPos = (const uint16_t*)pVertex;
+                glm::vec3 t(decodeUnorm16(pPos[0]), decodeUnorm16(pPos[1]), decodeUnorm16(pPos[2]));
+                attribute.push_back(encoding.positionOffset + encoding.positionScale * t);
+            }
+            else if(format == ResourceFormat::RG16Snorm)
+            {
+                attribute.push_back(decodeOctahedral((const int16_t*)pVertex));
+            }
+            else
+            {
+                attribute.push_back(*(const glm::vec3*)pVertex);
+            }
+        }
+    }
+    return attribute;
+}
+
+/** Compare the decoded positions, normals and tangent frames of two meshes
+    \param[in] maxPositionError The largest allowed position difference, per component
+    \param[out] difference Receives a description of the first difference
+*/
+static bool compareDecodedVertices(const Mesh* pA, const Mesh* pB, float maxPositionError, std::string& difference)
+{
+    // 1e-3 radians, a few times the octahedral encoding error
+    const float kMinUnitVectorDot = 0.9999995f;
+    const uint32_t locations[] = {VERTEX_POSITION_LOC, VERTEX_NORMAL_LOC, VERTEX_TANGENT_LOC, VERTEX_BITANGENT_LOC};
+    for(uint32_t location : locations)
+    {
+        std::vector<glm::vec3> a = readVertexAttribute(pA, location);
+        std::vector<glm::vec3> b = readVertexAttribute(pB, location);
+        const std::string attribName = "attribute " + std::to_string(location);
+        if(a.size() != b.size())
+        {
+            difference = "the vertex count of " + attribName + " is different";
+            return false;
+        }
+
+        for(size_t v = 0; v < a.size(); v++)
+        {
+            bool isClose = (location == VERTEX_POSITION_LOC) ? (glm::all(glm::lessThanEqual(glm::abs(a[v] - b[v]), glm::vec3(maxPositionError)))) : (glm::dot(a[v], b[v]) >= kMinUnitVectorDot * glm::length(a[v]) * glm::length(b[v]));
+            if(isClose == false)
+            {
+                difference = attribName + " of vertex " + std::to_string(v) + " is different";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static uint64_t getVertexBufferMemory(const Model* pModel)
+{
+    uint64_t size = 0;
+    for(uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+    {
+        const Vao* pVao = pModel->getMesh(meshID)->getVao().get();
+        for(uint32_t i = 0; i < pVao->getVertexBuffersCount(); i++)
+        {
+            size += pVao->getVertexBuffer(i)->getSize();
+        }
+    }
+    return size;
+}
+
+LoadWorker::LoadWorker(const std::string& filename, uint32_t modelFlags, const std::string& statsFile) : mFilename(filename), mModelFlags(modelFlags), mStatsFile(statsFile)
+{
+}
+
+void LoadWorker::onLoad()
+{
+    PROCESS_MEMORY_COUNTERS before = getMemoryCounters();
+    auto start = CpuTimer::getCurrentTimePoint();
+    auto pModel = Model::createFromFile(mFilename, mModelFlags);
+    float duration = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+    PROCESS_MEMORY_COUNTERS after = getMemoryCounters();
+
+    // The peaks are measured from the usage before the load. This includes anything the process allocated before, so it is an upper bound of the load's own peak.
+    if(pModel)
+    {
+        std::ofstream stats(mStatsFile);
+        stats << duration << " " << (after.PeakWorkingSetSize - before.WorkingSetSize) << " " << (after.PeakPagefileUsage - before.PagefileUsage) << std::endl;
+    }
+    shutdownApp();
+}
+
+void BinaryModelImporterTest::createTestDirectory()
+{
+    // Start from an empty directory, so that files left by a previous run aren't used
+    mDirectory = getExecutableDirectory() + "\\BinaryModelImporterTest";
+    std::vector<std::string> filenames;
+    enumerateFilesRecursive(mDirectory, filenames);
+    for(const auto& f : filenames)
+    {
+        std::remove(f.c_str());
+    }
+    createDirectory(mDirectory);
+}
+
+void BinaryModelImporterTest::benchmarkMemoryMapping()
+{
+    // A 2048x2048 grid is a ~150MB file, most of it index data. Uncompressed index data is passed to the GPU straight from the mapping.
+    const std::string gridFile = mDirectory + "\\Grid.bin";
+    {
+        auto pModel = createGridModel(2048);
+        pModel->exportToBinaryFile(gridFile);
+    }
+    check(getFileSize(gridFile) > 0, "can't export the benchmark model");
+    benchmarkLoad(gridFile);
+
+    // 40 meshes of 1024x1024 vertices are a ~2.3GB v8 file. Its interleaved vertices are de-interleaved while loading, either straight from the mapping or from the stream buffers.
+    const std::string legacyFile = mDirectory + "\\LegacyGrid.bin";
+    check(writeLegacyGridFile(legacyFile, 40, 1024), "can't write " + legacyFile);
+    benchmarkLoad(legacyFile);
+    std::remove(legacyFile.c_str());
+}
+
+void BinaryModelImporterTest::benchmarkLoad(const std::string& filename)
+{
+    const uint64_t fileSize = getFileSize(filename);
+    if(fileSize == 0)
+    {
+        return;
+    }
+
+    struct Config
+    {
+        const char* name;
+        uint32_t flags;
+        float minDuration;
+        size_t peakWorkingSet;
+        size_t peakCommit;
+    };
+    Config configs[] = {{"mapped", 0, 0, 0, 0}, {"file stream", Model::DontMemoryMapFiles, 0, 0, 0}};
+
+    // The first run only brings the file into the OS cache. The configurations are interleaved, so they see the same cache state.
+    const uint32_t kRunCount = 4;
+    const std::string statsFile = mDirectory + "\\LoadStats.txt";
+    for(uint32_t run = 0; run < kRunCount; run++)
+    {
+        for(auto& config : configs)
+        {
+            std::string args = kWorkerArg + " \"" + filename + "\" " + std::to_string(config.flags) + " \"" + statsFile + "\"";
+            std::remove(statsFile.c_str());
+            size_t process = executeProcess(getExecutableDirectory() + '\\' + getExecutableName(), args);
+            check(process && (waitForProcess(process) == 0), "the " + std::string(config.name) + " load worker failed");
+
+            float duration = 0;
+            size_t peakWorkingSet = 0;
+            size_t peakCommit = 0;
+            std::ifstream stats(statsFile);
+            stats >> duration >> peakWorkingSet >> peakCommit;
+            check(stats.fail() == false, "the " + std::string(config.name) + " load failed");
+
+            if(run > 0)
+            {
+                config.minDuration = (run == 1) ? duration : std::min(config.minDuration, duration);
+                config.peakWorkingSet = std::max(config.peakWorkingSet, peakWorkingSet);
+                config.peakCommit = std::max(config.peakCommit, peakCommit);
+            }
+        }
+    }
+    std::remove(statsFile.c_str());
+
+    auto toMB = [](size_t bytes) { return std::to_string(bytes / (1024 * 1024)) + "MB"; };
+    std::string msg = "Loading " + getFilenameFromPath(filename) + " (" + toMB(size_t(fileSize)) + "), best of " + std::to_string(kRunCount - 1) + " runs:";
+    for(const auto& config : configs)
+    {
+        msg += "\n    " + std::string(config.name) + ": " + std::to_string(config.minDuration) + "ms, peak working set +" + toMB(config.peakWorkingSet) + ", peak commit +" + toMB(config.peakCommit);
+    }
+    Logger::log(Logger::Level::Info, msg);
+}
+
+bool BinaryModelImporterTest::loadSpheres()
+{
+    const std::string objFile = mDirectory + "\\Spheres.obj";
+    check(writeSpheresObj(objFile), "can't write " + objFile);
+    mpSpheres = Model::createFromFile(objFile, Model::DontMergeMeshes);
+    check(mpSpheres && (mpSpheres->getMeshCount() == kSphereCount), "can't load " + objFile);
+    return mpSpheres != nullptr;
+}
+
+void BinaryModelImporterTest::testParallelDecode()
+{
+    // Generating the tangents and the LODs and optimizing the meshes are the most expensive parts of the decoding. Quantized and compressed files add the attribute decoding and the decompression.
+    const uint32_t flags = Model::GenerateTangentSpace | Model::OptimizeVertexCache | Model::GenerateLods;
+    for(uint32_t packed = 0; packed < 2; packed++)
+    {
+        const std::string binFile = mDirectory + "\\Spheres" + std::to_string(packed) + ".bin";
+        mpSpheres->exportToBinaryFile(binFile, packed != 0, packed != 0);
+
+        auto pParallel = Model::createFromFile(binFile, flags);
+        auto pSerial = Model::createFromFile(binFile, flags | Model::DontLoadInParallel);
+        check(pParallel && pSerial, "can't load " + binFile);
+        if(pParallel && pSerial)
+        {
+            std::string difference;
+            check(compareModels(pParallel.get(), pSerial.get(), difference), "the parallel and the serial decoding of " + binFile + " give different results: " + difference);
+            check(pParallel->getMeshCount() == kSphereCount, binFile + " has " + std::to_string(pParallel->getMeshCount()) + " meshes instead of " + std::to_string(kSphereCount));
+        }
+    }
+}
+
+void BinaryModelImporterTest::testStreaming()
+{
+    // The file isn't compressed, so all the mesh chunks have the same size
+    const std::string binFile = mDirectory + "\\SpheresStreaming.bin";
+    mpSpheres->exportToBinaryFile(binFile);
+    std::vector<ChunkDesc> chunks = readTableOfContents(binFile);
+    check(chunks.size() == kSphereCount + 2, "the streaming test file has " + std::to_string(chunks.size()) + " chunks");
+    if(chunks.size() != kSphereCount + 2)
+    {
+        return;
+    }
+
+    const uint64_t meshChunkSize = chunks[0].storedSize;
+    for(uint32_t i = 0; i < kSphereCount; i++)
+    {
+        check((chunks[i].type == ChunkType_Mesh) && (chunks[i].storedSize == meshChunkSize), "chunk " + std::to_string(i) + " isn't a mesh of the expected size");
+    }
+
+    // Opening the file reads the header, the table of contents, the instances and the mesh bounds
+    const uint64_t headerSize = 8 + 5 * sizeof(int32_t) + chunks.size() * sizeof(ChunkDesc);
+    const uint64_t openBytes = headerSize + chunks[kSphereCount].storedSize + chunks[kSphereCount + 1].storedSize;
+
+    // Returns the sorted IDs of the loaded spheres
+    auto getLoadedSpheres = [](const Model* pModel) -> std::vector<uint32_t>
+    {
+        std::vector<uint32_t> sphereIDs;
+        for(uint32_t i = 0; i < pModel->getMeshCount(); i++)
+        {
+            const Mesh* pMesh = pModel->getMesh(i).get();
+            float sphereID = pMesh->getObjectSpaceBoundingBox().center.x / getSphereCenter(1).x;
+            sphereIDs.push_back((pMesh->getInstanceCount() == 1) ? (uint32_t)(sphereID + 0.5f) : uint32_t(-1));
+        }
+        std::sort(sphereIDs.begin(), sphereIDs.end());
+        return sphereIDs;
+    };
+
+    const uint32_t flags[] = {0, Model::DontMemoryMapFiles};
+    for(uint32_t f : flags)
+    {
+        const std::string config = (f & Model::DontMemoryMapFiles) ? "file stream" : "mapped file";
+        auto pImporter = BinaryModelImporter::createStreaming(binFile, f);
+        check(pImporter != nullptr, "can't open " + binFile + " for streaming (" + config + ")");
+        if(pImporter == nullptr)
+        {
+            continue;
+        }
+        const Model* pModel = pImporter->getModel().get();
+        check(pModel->getMeshCount() == 0, "opening a file for streaming created meshes (" + config + ")");
+        check(pImporter->getBytesRead() == openBytes, "opening a file for streaming read " + std::to_string(pImporter->getBytesRead()) + " bytes instead of " + std::to_string(openBytes) + " (" + config + ")");
+
+        // A box inside sphere 2 only loads its mesh
+        BinaryModelImporter::Region region;
+        region.boxes.push_back(BoundingBox::fromMinMax(getSphereCenter(2) - glm::vec3(0.5f), getSphereCenter(2) + glm::vec3(0.5f)));
+        check(pImporter->loadRegion(region), "loading a region failed (" + config + ")");
+        check(getLoadedSpheres(pModel) == std::vector<uint32_t>({2}), "the first region didn't load sphere 2 only (" + config + ")");
+        check(pImporter->getBytesRead() == openBytes + meshChunkSize, "the first region read " + std::to_string(pImporter->getBytesRead() - openBytes) + " mesh bytes instead of " + std::to_string(meshChunkSize) + " (" + config + ")");
+
+        // Loading the same region again doesn't read or add anything
+        check(pImporter->loadRegion(region), "reloading a region failed (" + config + ")");
+        check(getLoadedSpheres(pModel) == std::vector<uint32_t>({2}), "reloading a region changed the model (" + config + ")");
+        check(pImporter->getBytesRead() == openBytes + meshChunkSize, "reloading a region read more data (" + config + ")");
+
+        // A box around spheres 1 to 3 adds spheres 1 and 3
+        region.boxes[0] = BoundingBox::fromMinMax(getSphereCenter(1) - glm::vec3(1.5f), getSphereCenter(3) + glm::vec3(1.5f));
+        check(pImporter->loadRegion(region), "loading a second region failed (" + config + ")");
+        check(getLoadedSpheres(pModel) == std::vector<uint32_t>({1, 2, 3}), "the second region didn't add spheres 1 and 3 (" + config + ")");
+        check(pImporter->getBytesRead() == openBytes + 3 * meshChunkSize, "after the second region " + std::to_string(pImporter->getBytesRead() - openBytes) + " mesh bytes were read instead of " + std::to_string(3 * meshChunkSize) + " (" + config + ")");
+    }
+}
+
+void BinaryModelImporterTest::testLargeFileStream()
+{
+    // Move the chunks of the spheres beyond 4GB. Chunks don't have to follow each other, so the gap is left unused.
+    const std::string binFile = mDirectory + "\\Spheres.bin";
+    const std::string largeFile = mDirectory + "\\SpheresLarge.bin";
+    mpSpheres->exportToBinaryFile(binFile);
+    std::vector<ChunkDesc> chunks = readTableOfContents(binFile);
+    check(chunks.size() == kSphereCount + 2, "the large file test has " + std::to_string(chunks.size()) + " chunks");
+    if(chunks.size() != kSphereCount + 2)
+    {
+        return;
+    }
+
+    const uint64_t kGap = 4ull * 1024 * 1024 * 1024;
+    {
+        std::ifstream src(binFile, std::ios::binary);
+        std::ofstream dst(largeFile, std::ios::binary);
+        char header[8 + 5 * sizeof(int32_t)];
+        src.read(header, sizeof(header));
+        dst.write(header, sizeof(header));
+        for(const auto& chunk : chunks)
+        {
+            writeValue(dst, chunk.type);
+            writeValue(dst, chunk.compression);
+            writeValue(dst, chunk.offset + kGap);
+            writeValue(dst, chunk.storedSize);
+            writeValue(dst, chunk.size);
+            writeValue(dst, chunk.hash);
+        }
+
+        std::vector<char> data;
+        for(const auto& chunk : chunks)
+        {
+            data.resize(size_t(chunk.storedSize));
+            src.seekg(std::streamoff(chunk.offset));
+            src.read(data.data(), data.size());
+            dst.seekp(std::streamoff(chunk.offset + kGap));
+            dst.write(data.data(), data.size());
+        }
+        check(src.good() && dst.good(), "can't write " + largeFile);
+    }
+
+    // The file stream path doesn't depend on mapping the file, so its size must be 64-bit
+    const uint64_t fileSize = getFileSize(largeFile);
+    auto pImporter = BinaryModelImporter::createStreaming(largeFile, Model::DontMemoryMapFiles);
+    check(pImporter != nullptr, "can't open a file larger than 4GB for streaming (file stream)");
+    if(pImporter)
+    {
+        check(pImporter->getFileSize() == fileSize, "the importer reports a file size of " + std::to_string(pImporter->getFileSize()) + " bytes instead of " + std::to_string(fileSize));
+        const uint64_t openBytes = 8 + 5 * sizeof(int32_t) + chunks.size() * sizeof(ChunkDesc) + chunks[kSphereCount].storedSize + chunks[kSphereCount + 1].storedSize;
+        check(pImporter->getBytesRead() == openBytes, "opening a file larger than 4GB read " + std::to_string(pImporter->getBytesRead()) + " bytes instead of " + std::to_string(openBytes));
+
+        BinaryModelImporter::Region region;
+        region.boxes.push_back(BoundingBox::fromMinMax(getSphereCenter(0) - glm::vec3(1.5f), getSphereCenter(kSphereCount - 1) + glm::vec3(1.5f)));
+        check(pImporter->loadRegion(region) && (pImporter->getModel()->getMeshCount() == kSphereCount), "can't stream the meshes of a file larger than 4GB");
+    }
+
+    auto pModel = Model::createFromFile(largeFile, Model::DontMemoryMapFiles);
+    check(pModel && (pModel->getMeshCount() == kSphereCount), "can't load a file larger than 4GB (file stream)");
+    pImporter = nullptr;
+    pModel = nullptr;
+    std::remove(largeFile.c_str());
+}
+
+void BinaryModelImporterTest::testStreamingScene()
+{
+    // Streaming adds mesh instances to a model which is already in a scene. The scene's BVH items and render proxies must follow.
+    const std::string binFile = mDirectory + "\\SpheresStreaming.bin";
+    auto pImporter = BinaryModelImporter::createStreaming(binFile, 0);
+    check(pImporter != nullptr, "can't open " + binFile + " for streaming");
+    if(pImporter == nullptr)
+    {
+        return;
+    }
+
+    auto pScene = Scene::create();
+    const uint32_t modelID = pScene->addModel(pImporter->getModel(), binFile, true);
+    pScene->addModelInstance(modelID, "Second", glm::vec3(0), glm::vec3(1), glm::vec3(0, 100, 0));
+    check(pScene->getRenderProxies().worldMatrices.size() == 0, "the scene has render proxies before any region was loaded");
+    const uint32_t structureGeneration = pScene->getStructureGeneration();
+
+    BinaryModelImporter::Region region;
+    region.boxes.push_back(BoundingBox::fromMinMax(getSphereCenter(1) - glm::vec3(1.5f), getSphereCenter(3) + glm::vec3(1.5f)));
+    check(pImporter->loadRegion(region), "loading a region into a scene model failed");
+
+    // 3 spheres for each of the 2 model instances
+    const Scene::RenderProxies& proxies = pScene->getRenderProxies();
+    check(pScene->getStructureGeneration() != structureGeneration, "loading a region didn't change the scene structure");
+    check((proxies.worldMatrices.size() == 6) && (proxies.worldBoxes.size() == 6), "the scene has " + std::to_string(proxies.worldMatrices.size()) + " render proxies after loading 3 spheres instead of 6");
+    check(pScene->getBvhItemOffset(modelID, 1) == 3, "the BVH items of the second model instance start at " + std::to_string(pScene->getBvhItemOffset(modelID, 1)) + " instead of 3");
+    for(uint32_t item = 0; item < (uint32_t)proxies.worldMatrices.size(); item++)
+    {
+        const Scene::MeshInstanceRef& ref = pScene->getBvhItem(item);
+        const Mesh* pMesh = pScene->getModel(ref.modelID)->getMesh(ref.meshID).get();
+        check(proxies.worldBoxes.get(item) == pMesh->getInstanceBoundingBox(ref.meshInstanceID).transform(pScene->getModelInstance(ref.modelID, ref.modelInstanceID).transformMatrix), "the world box of BVH item " + std::to_string(item) + " doesn't match its mesh instance");
+    }
+}
+
+void BinaryModelImporterTest::testCompressedVertices()
+{
+    const std::string binFile = mDirectory + "\\SpheresCompressedVertices.bin";
+    mpSpheres->exportToBinaryFile(binFile);
+    auto pFloat = Model::createFromFile(binFile, Model::GenerateTangentSpace);
+    auto pCompressed = Model::createFromFile(binFile, Model::GenerateTangentSpace | Model::CompressVertices);
+    check(pFloat && pCompressed && (pFloat->getMeshCount() == pCompressed->getMeshCount()), "can't load " + binFile);
+    if((pFloat && pCompressed && (pFloat->getMeshCount() == pCompressed->getMeshCount())) == false)
+    {
+        return;
+    }
+
+    // The compressed vertices decode to the float vertices, within the quantization error
+    for(uint32_t meshID = 0; meshID < pCompressed->getMeshCount(); meshID++)
+    {
+        const Mesh* pMesh = pCompressed->getMesh(meshID).get();
+        const Mesh::VertexEncoding& encoding = pMesh->getVertexEncoding();
+        const std::string meshName = "compressed mesh " + std::to_string(meshID);
+        const Vao* pVao = pMesh->getVao().get();
+        check(encoding.compressedPositions && (pVao->getVertexBufferLayout(pVao->getElementIndexByLocation(VERTEX_POSITION_LOC).vbIndex)->getElementFormat(0) == ResourceFormat::RGBA16Unorm), "the positions of " + meshName + " aren't compressed");
+        check((encoding.octahedralAttribs & (1 << VERTEX_NORMAL_LOC)) && (pVao->getVertexBufferLayout(pVao->getElementIndexByLocation(VERTEX_NORMAL_LOC).vbIndex)->getElementFormat(0) == ResourceFormat::RG16Snorm), "the normals of " + meshName + " aren't compressed");
+        BoundingBox box = pMesh->getObjectSpaceBoundingBox();
+        check(box == pFloat->getMesh(meshID)->getObjectSpaceBoundingBox(), "the bounding-box of " + meshName + " changed");
+
+        const float maxPositionError = std::max(encoding.positionScale.x, std::max(encoding.positionScale.y, encoding.positionScale.z)) / 65535.0f;
+        std::string difference;
+        check(compareDecodedVertices(pFloat->getMesh(meshID).get(), pMesh, maxPositionError, difference), meshName + " doesn't match the float mesh: " + difference);
+    }
+
+    const uint64_t floatMemory = getVertexBufferMemory(pFloat.get());
+    const uint64_t compressedMemory = getVertexBufferMemory(pCompressed.get());
+    Logger::log(Logger::Level::Info, "Vertex buffer memory of " + binFile + ": " + std::to_string(floatMemory) + " bytes, " + std::to_string(compressedMemory) + " bytes with compressed vertices");
+    check(compressedMemory < floatMemory, "compressing the vertices didn't reduce the vertex buffer memory");
+
+    // Compressed vertices are exported in the matching file encodings, so reloading them without compression gives the same decoded vertices.
+    // The exporter doesn't preserve the mesh order, so the spheres are matched by position.
+    const std::string exportFile = mDirectory + "\\SpheresCompressedExport.bin";
+    pCompressed->exportToBinaryFile(exportFile);
+    auto pReloaded = Model::createFromFile(exportFile, 0);
+    check(pReloaded && (pReloaded->getMeshCount() == pCompressed->getMeshCount()), "can't load " + exportFile);
+    for(uint32_t meshID = 0; pReloaded && (meshID < pReloaded->getMeshCount()); meshID++)
+    {
+        const Mesh* pMesh = pReloaded->getMesh(meshID).get();
+        const Mesh* pSource = nullptr;
+        for(uint32_t i = 0; i < pCompressed->getMeshCount(); i++)
+        {
+            if(glm::length(pCompressed->getMesh(i)->getObjectSpaceBoundingBox().center - pMesh->getObjectSpaceBoundingBox().center) < 0.5f)
+            {
+                pSource = pCompressed->getMesh(i).get();
+            }
+        }
+
+        const std::string meshName = "reloaded mesh " + std::to_string(meshID);
+        check(pSource != nullptr, meshName + " doesn't match any of the spheres");
+        if(pSource)
+        {
+            const float maxPositionError = 1e-5f * getSphereCenter(kSphereCount).x;
+            std::string difference;
+            check(compareDecodedVertices(pSource, pMesh, maxPositionError, difference), meshName + " doesn't match the compressed mesh: " + difference);
+        }
+    }
+}
+
+void BinaryModelImporterTest::onLoad()
+{
+    createTestDirectory();
+    benchmarkMemoryMapping();
+    if(loadSpheres())
+    {
+        testParallelDecode();
+        testStreaming();
+        testStreamingScene();
+        testLargeFileStream();
+        testCompressedVertices();
+    }
+
+    finishTests("binary model importer");
+}
+
+int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPSTR lpCmdLine, _In_ int nShowCmd)
+{
+    // BinaryModelImporterTest -load <file> <model flags> <stats file>
+    if(__argc == 5 && std::string(__argv[1]) == kWorkerArg)
+    {
+        LoadWorker worker(__argv[2], (uint32_t)std::stoul(__argv[3]), __argv[4]);
+        SampleConfig config;
+        config.windowDesc.swapChainDesc.width = 64;
+        config.windowDesc.swapChainDesc.height = 64;
+        config.windowDesc.title = "BinaryModelImporterTest load worker";
+        config.windowDesc.isVisible = false;
+        config.showMessageBoxOnError = false;
+        worker.run(config);
+        return 0;
+    }
+
+    BinaryModelImporterTest binaryModelImporterTest;
+    SampleConfig config;
+    binaryModelImporterTest.run(config);
+}
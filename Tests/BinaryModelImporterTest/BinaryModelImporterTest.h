@@ -0,0 +1,67 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Falcor.h"
+#include "../TestBase.h"
+
+using namespace Falcor;
+
+class BinaryModelImporterTest : public TestBase
+{
+public:
+    void onLoad() override;
+
+private:
+    void createTestDirectory();
+    void benchmarkMemoryMapping();
+    void benchmarkLoad(const std::string& filename);
+    bool loadSpheres();
+    void testParallelDecode();
+    void testStreaming();
+    void testStreamingScene();
+    void testLargeFileStream();
+    void testCompressedVertices();
+
+    std::string mDirectory;
+    Model::SharedPtr mpSpheres;
+};
+
+/** Loads a binary model and writes the load time and the memory usage into a file.
+    The memory peaks are per-process, so the benchmark runs every configuration in its own worker process.
+*/
+class LoadWorker : public Sample
+{
+public:
+    LoadWorker(const std::string& filename, uint32_t modelFlags, const std::string& statsFile);
+    void onLoad() override;
+
+private:
+    std::string mFilename;
+    uint32_t mModelFlags;
+    std::string mStatsFile;
+};
@@ -0,0 +1,219 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "CsmCullingTest.h"
+#include <random>
+
+static const uint32_t kCascadeCount = 4;
+static const uint32_t kBoxCount = 20000;
+
+void CsmCullingTest::createScene()
+{
+    // Casters of different sizes scattered over a terrain-like area
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> position(-500, 500);
+    std::uniform_real_distribution<float> height(0, 50);
+    std::uniform_real_distribution<float> size(0.5f, 5);
+
+    mBoxes.resize(kBoxCount);
+    for(auto& box : mBoxes)
+    {
+        box.center = glm::vec3(position(rng), height(rng), position(rng));
+        box.extent = glm::vec3(size(rng), size(rng), size(rng));
+    }
+    mBvh.build(mBoxes.data(), (uint32_t)mBoxes.size());
+}
+
+void CsmCullingTest::createCascades()
+{
+    // The view frustum corners, the same way CascadedShadowMaps::partitionCascades() gets them from the camera
+    glm::mat4 viewProj = perspectiveMatrix(1.0f, 16.0f / 9.0f, 0.1f, 300) * glm::lookAt(glm::vec3(0, 20, 0), glm::vec3(1, 15, 1), glm::vec3(0, 1, 0));
+    glm::mat4 invViewProj = glm::inverse(viewProj);
+    const glm::vec3 clipSpace[8] =
+    {
+        glm::vec3(-1.0f, 1.0f, 0),
+        glm::vec3(1.0f, 1.0f, 0),
+        glm::vec3(1.0f, -1.0f, 0),
+        glm::vec3(-1.0f, -1.0f, 0),
+        glm::vec3(-1.0f, 1.0f, 1.0f),
+        glm::vec3(1.0f, 1.0f, 1.0f),
+        glm::vec3(1.0f, -1.0f, 1.0f),
+        glm::vec3(-1.0f, -1.0f, 1.0f),
+    };
+    glm::vec3 frustum[8];
+    glm::vec3 center(0);
+    for(uint32_t i = 0; i < 8; i++)
+    {
+        glm::vec4 crd = invViewProj * glm::vec4(clipSpace[i], 1);
+        frustum[i] = glm::vec3(crd) / crd.w;
+        center += frustum[i] / 8.0f;
+    }
+    float radius = 0;
+    for(uint32_t i = 0; i < 8; i++)
+    {
+        radius = max(radius, glm::length(frustum[i] - center));
+    }
+
+    // The global shadow matrix of a directional light
+    mLightDir = glm::normalize(glm::vec3(0.4f, -1, 0.3f));
+    mGlobalMat = orthographicMatrix(-radius, radius, -radius, radius, -radius, radius) * glm::lookAt(center, center + mLightDir, glm::vec3(0, 1, 0));
+
+    // Linear partitions
+    for(uint32_t c = 0; c < kCascadeCount; c++)
+    {
+        float cascadeStart = float(c) / float(kCascadeCount);
+        float cascadeEnd = float(c + 1) / float(kCascadeCount);
+        for(uint32_t i = 0; i < 4; i++)
+        {
+            glm::vec3 edge = frustum[i + 4] - frustum[i];
+            mCascadeCorners[c][i] = frustum[i] + edge * cascadeStart;
+            mCascadeCorners[c][i + 4] = frustum[i] + edge * cascadeEnd;
+        }
+        CascadedShadowMaps::getCascadeCropParams(mCascadeCorners[c], mGlobalMat, mCascadeScale[c], mCascadeOffset[c]);
+        mCullMatrices[c] = CascadedShadowMaps::calcCascadeCullMatrix(mGlobalMat, mCascadeScale[c], mCascadeOffset[c], mBvh.getBoundingBox());
+    }
+    mBvh.cullFrusta(mCullMatrices, kCascadeCount, mItemCascadeMasks);
+}
+
+void CsmCullingTest::testAgainstCropSpace()
+{
+    // A caster is kept by a cascade if its bounds overlap the cascade's crop region, [-1, 1] along x and y after the GS transformation, and aren't beyond the cascade's receivers along z
+    uint32_t mismatches = 0;
+    for(uint32_t item = 0; item < kBoxCount; item++)
+    {
+        const BoundingBox& box = mBoxes[item];
+        for(uint32_t c = 0; c < kCascadeCount; c++)
+        {
+            glm::vec3 minCrop(FLT_MAX);
+            glm::vec3 maxCrop(-FLT_MAX);
+            for(uint32_t i = 0; i < 8; i++)
+            {
+                glm::vec3 corner = box.center + box.extent * glm::vec3((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f);
+                glm::vec4 light = mGlobalMat * glm::vec4(corner, 1);
+                glm::vec3 crop = glm::vec3(light) / light.w * glm::vec3(mCascadeScale[c]) + glm::vec3(mCascadeOffset[c]);
+                minCrop = glm::min(minCrop, crop);
+                maxCrop = glm::max(maxCrop, crop);
+            }
+
+            // Boxes touching a plane can go either way
+            const float kEpsilon = 1e-4f;
+            float margin = min(min(abs(maxCrop.x + 1), abs(minCrop.x - 1)), min(min(abs(maxCrop.y + 1), abs(minCrop.y - 1)), abs(minCrop.z - 1)));
+            if(margin < kEpsilon)
+            {
+                continue;
+            }
+
+            bool expected = (maxCrop.x > -1) && (minCrop.x < 1) && (maxCrop.y > -1) && (minCrop.y < 1) && (minCrop.z < 1);
+            bool isVisible = (mItemCascadeMasks[item] & (1 << c)) != 0;
+            mismatches += (expected != isVisible) ? 1 : 0;
+        }
+    }
+    check(mismatches == 0, std::to_string(mismatches) + " casters were culled differently than their crop-space bounds");
+}
+
+void CsmCullingTest::testCastersTowardLight()
+{
+    // A point between the light and a receiver in the cascade can cast into it, so it must be inside the cull frustum as long as it's inside the scene
+    std::mt19937 rng(5678);
+    std::uniform_real_distribution<float> unit(0, 1);
+    const BoundingBox sceneBox = mBvh.getBoundingBox();
+    const glm::vec3 sceneMin = sceneBox.center - sceneBox.extent;
+    const glm::vec3 sceneMax = sceneBox.center + sceneBox.extent;
+    uint32_t failures = 0;
+    uint32_t tested = 0;
+    for(uint32_t c = 0; c < kCascadeCount; c++)
+    {
+        const glm::vec3* pCorners = mCascadeCorners[c];
+        for(uint32_t sample = 0; sample < 2000; sample++)
+        {
+            // A receiver inside the cascade's part of the view frustum
+            glm::vec3 w(unit(rng), unit(rng), unit(rng));
+            w = glm::mix(glm::vec3(0.01f), glm::vec3(0.99f), w);
+            glm::vec3 nearPoint = glm::mix(glm::mix(pCorners[3], pCorners[2], w.x), glm::mix(pCorners[0], pCorners[1], w.x), w.y);
+            glm::vec3 farPoint = glm::mix(glm::mix(pCorners[7], pCorners[6], w.x), glm::mix(pCorners[4], pCorners[5], w.x), w.y);
+            glm::vec3 receiver = glm::mix(nearPoint, farPoint, w.z);
+
+            glm::vec3 caster = receiver - mLightDir * unit(rng) * 500.0f;
+            if(glm::any(glm::lessThan(caster, sceneMin)) || glm::any(glm::greaterThan(caster, sceneMax)))
+            {
+                continue;
+            }
+
+            tested++;
+            glm::vec4 clip = mCullMatrices[c] * glm::vec4(caster, 1);
+            bool isInside = (abs(clip.x) < clip.w) && (abs(clip.y) < clip.w) && (abs(clip.z) < clip.w);
+            failures += isInside ? 0 : 1;
+        }
+    }
+    check(tested > 1000, "only " + std::to_string(tested) + " casters were inside the scene");
+    check(failures == 0, std::to_string(failures) + " casters between the light and a receiver were culled");
+}
+
+void CsmCullingTest::testCasterCounts()
+{
+    // Without per-cascade culling every caster is drawn into every cascade
+    std::string msg = "Casters drawn per cascade, out of " + std::to_string(kBoxCount) + ":";
+    uint32_t total = 0;
+    uint32_t culledEverywhere = 0;
+    for(uint32_t c = 0; c < kCascadeCount; c++)
+    {
+        uint32_t count = 0;
+        for(uint32_t mask : mItemCascadeMasks)
+        {
+            count += (mask >> c) & 1;
+        }
+        check(count > 0, "cascade " + std::to_string(c) + " doesn't have any caster");
+        check(count < kBoxCount, "cascade " + std::to_string(c) + " didn't cull any caster");
+        msg += " " + std::to_string(count);
+        total += count;
+    }
+    for(uint32_t mask : mItemCascadeMasks)
+    {
+        culledEverywhere += (mask == 0) ? 1 : 0;
+    }
+    check(culledEverywhere > 0, "no caster was culled from all the cascades");
+    msg += ". " + std::to_string(total) + " draws instead of " + std::to_string(kBoxCount * kCascadeCount) + ", " + std::to_string(culledEverywhere) + " casters can't cast into the view frustum.";
+    Logger::log(Logger::Level::Info, msg);
+}
+
+void CsmCullingTest::onLoad()
+{
+    createScene();
+    createCascades();
+    testAgainstCropSpace();
+    testCastersTowardLight();
+    testCasterCounts();
+
+    finishTests("CSM culling");
+}
+
+int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPSTR lpCmdLine, _In_ int nShowCmd)
+{
+    CsmCullingTest csmCullingTest;
+    SampleConfig config;
+    csmCullingTest.run(config);
+}
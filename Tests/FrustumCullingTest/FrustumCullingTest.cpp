@@ -0,0 +1,188 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "FrustumCullingTest.h"
+#include "Utils/Math/FrustumCulling.h"
+#include "Utils/CpuTimer.h"
+#include <random>
+
+void FrustumCullingTest::createBoxes(uint32_t count)
+{
+    std::mt19937 rng(4321);
+    std::uniform_real_distribution<float> position(-200, 200);
+    std::uniform_real_distribution<float> size(0, 20);
+
+    mBoxes.resize(count);
+    mBoxesSoA.clear();
+    for(auto& box : mBoxes)
+    {
+        box.center = glm::vec3(position(rng), position(rng), position(rng));
+        box.extent = glm::vec3(size(rng), size(rng), size(rng));
+        mBoxesSoA.push_back(box);
+    }
+}
+
+void FrustumCullingTest::testExactness(const Camera* pCamera, uint32_t boxCount, const std::string& name)
+{
+    createBoxes(boxCount);
+
+    std::vector<uint32_t> expected;
+    for(uint32_t i = 0; i < boxCount; i++)
+    {
+        if(pCamera->isObjectCulled(mBoxes[i]) == false)
+        {
+            expected.push_back(i);
+        }
+    }
+
+    std::vector<uint32_t> visible;
+    pCamera->cullBoundingBoxes(mBoxesSoA, visible);
+    check(visible == expected, name + ": " + std::to_string(visible.size()) + " visible boxes out of " + std::to_string(boxCount) + ", expected " + std::to_string(expected.size()));
+}
+
+void FrustumCullingTest::testPlaneBoundaries()
+{
+    // Boxes which touch the frustum planes exactly are where rounding differences would show. Build boxes around points on the near and far planes, and around the camera position.
+    FrustumPlanes frustum(mpCamera->getViewProjMatrix());
+    glm::mat4 invViewProj = glm::inverse(mpCamera->getViewProjMatrix());
+    mBoxes.clear();
+    mBoxesSoA.clear();
+    for(int y = -4; y <= 4; y++)
+    {
+        for(int x = -4; x <= 4; x++)
+        {
+            for(int z = -1; z <= 1; z += 2)
+            {
+                glm::vec4 p = invViewProj * glm::vec4(float(x) * 0.25f, float(y) * 0.25f, float(z), 1);
+                BoundingBox box;
+                box.center = glm::vec3(p) / p.w;
+                box.extent = glm::vec3(float(x + 4) * 0.01f);
+                mBoxes.push_back(box);
+                mBoxesSoA.push_back(box);
+            }
+        }
+    }
+
+    BoundingBox cameraBox;
+    cameraBox.center = mpCamera->getPosition();
+    cameraBox.extent = glm::vec3(0);
+    mBoxes.push_back(cameraBox);
+    mBoxesSoA.push_back(cameraBox);
+
+    std::vector<uint32_t> expected;
+    for(uint32_t i = 0; i < (uint32_t)mBoxes.size(); i++)
+    {
+        check(frustum.isCulled(mBoxes[i]) == mpCamera->isObjectCulled(mBoxes[i]), "FrustumPlanes::isCulled() doesn't match the camera for box " + std::to_string(i));
+        if(mpCamera->isObjectCulled(mBoxes[i]) == false)
+        {
+            expected.push_back(i);
+        }
+    }
+
+    std::vector<uint32_t> visible;
+    cullBoundingBoxes(frustum, mBoxesSoA, visible);
+    check(visible == expected, "plane boundaries: " + std::to_string(visible.size()) + " visible boxes, expected " + std::to_string(expected.size()));
+}
+
+void FrustumCullingTest::benchmark()
+{
+    const uint32_t kBoxCount = 1000000;
+    const uint32_t kIterations = 10;
+    createBoxes(kBoxCount);
+    const Camera* pCamera = mpCamera.get();
+
+    std::vector<uint32_t> visible;
+    visible.reserve(kBoxCount);
+    auto start = CpuTimer::getCurrentTimePoint();
+    for(uint32_t iteration = 0; iteration < kIterations; iteration++)
+    {
+        visible.clear();
+        for(uint32_t i = 0; i < kBoxCount; i++)
+        {
+            if(pCamera->isObjectCulled(mBoxes[i]) == false)
+            {
+                visible.push_back(i);
+            }
+        }
+    }
+    float scalarTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) / kIterations;
+
+    start = CpuTimer::getCurrentTimePoint();
+    for(uint32_t iteration = 0; iteration < kIterations; iteration++)
+    {
+        pCamera->cullBoundingBoxes(mBoxesSoA, visible);
+    }
+    float simdTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) / kIterations;
+
+    std::string msg = "Culling " + std::to_string(kBoxCount) + " boxes (" + std::to_string(visible.size()) + " visible): ";
+    msg += std::to_string(scalarTime) + "ms scalar, " + std::to_string(simdTime) + "ms SIMD";
+    Logger::log(Logger::Level::Info, msg);
+}
+
+void FrustumCullingTest::onLoad()
+{
+    mpCamera = Camera::create();
+    mpCamera->setDepthRange(0.5f, 150);
+    mpCamera->setPosition(glm::vec3(10, 5, -20));
+    mpCamera->setTarget(glm::vec3(0, 0, 0));
+    mpCamera->setUpVector(glm::vec3(0, 1, 0));
+
+    // Box counts which aren't a multiple of the batch size exercise the padding
+    uint32_t counts[] = {0, 1, 7, 8, 9, 1000, 100003};
+    for(uint32_t count : counts)
+    {
+        testExactness(mpCamera.get(), count, "perspective camera");
+    }
+
+    auto pWideCamera = Camera::create();
+    pWideCamera->setFovY(glm::radians(150.0f));
+    pWideCamera->setAspectRatio(2);
+    pWideCamera->setDepthRange(0.01f, 1000);
+    pWideCamera->setPosition(glm::vec3(0, 0, 0));
+    pWideCamera->setTarget(glm::vec3(0, -1, 1));
+    pWideCamera->setUpVector(glm::vec3(0, 1, 0));
+    testExactness(pWideCamera.get(), 100003, "wide camera");
+
+    // A camera looking along an axis has normals with zero components
+    auto pAxisCamera = Camera::create();
+    pAxisCamera->setPosition(glm::vec3(0, 0, 0));
+    pAxisCamera->setTarget(glm::vec3(0, 0, 1));
+    pAxisCamera->setUpVector(glm::vec3(0, 1, 0));
+    testExactness(pAxisCamera.get(), 100003, "axis-aligned camera");
+
+    testPlaneBoundaries();
+    benchmark();
+
+    finishTests("frustum culling");
+}
+
+int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPSTR lpCmdLine, _In_ int nShowCmd)
+{
+    FrustumCullingTest frustumCullingTest;
+    SampleConfig config;
+    frustumCullingTest.run(config);
+}
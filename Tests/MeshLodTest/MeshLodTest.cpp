@@ -0,0 +1,294 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "MeshLodTest.h"
+#include "Graphics/Model/MeshSimplifier.h"
+#include <cstdio>
+#include <fstream>
+
+struct TestMesh
+{
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+};
+
+static TestMesh createGrid(uint32_t size)
+{
+    TestMesh mesh;
+    for(uint32_t y = 0; y <= size; y++)
+    {
+        for(uint32_t x = 0; x <= size; x++)
+        {
+            mesh.positions.push_back(glm::vec3(float(x), float(y), 0));
+        }
+    }
+
+    for(uint32_t y = 0; y < size; y++)
+    {
+        for(uint32_t x = 0; x < size; x++)
+        {
+            uint32_t v0 = y * (size + 1) + x;
+            uint32_t quad[6] = {v0, v0 + 1, v0 + size + 1, v0 + size + 1, v0 + 1, v0 + size + 2};
+            mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+        }
+    }
+    return mesh;
+}
+
+/** A unit UV-sphere. The seam vertices are duplicated, like the ones of a textured mesh.
+*/
+static TestMesh createSphere(uint32_t rings, uint32_t segments)
+{
+    TestMesh mesh;
+    for(uint32_t r = 0; r <= rings; r++)
+    {
+        for(uint32_t s = 0; s <= segments; s++)
+        {
+            float theta = glm::pi<float>() * float(r) / float(rings);
+            // The last column must match the first one exactly, so it can't be computed from 2*pi
+            float phi = 2 * glm::pi<float>() * float(s % segments) / float(segments);
+            mesh.positions.push_back(glm::vec3(sin(theta) * cos(phi), sin(theta) * sin(phi), cos(theta)));
+        }
+    }
+
+    for(uint32_t r = 0; r < rings; r++)
+    {
+        for(uint32_t s = 0; s < segments; s++)
+        {
+            uint32_t v0 = r * (segments + 1) + s;
+            uint32_t quad[6] = {v0, v0 + segments + 1, v0 + 1, v0 + 1, v0 + segments + 1, v0 + segments + 2};
+            mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+        }
+    }
+    return mesh;
+}
+
+static float calculateArea(const TestMesh& mesh, const std::vector<uint32_t>& indices)
+{
+    float area = 0;
+    for(size_t i = 0; i < indices.size(); i += 3)
+    {
+        const glm::vec3& p0 = mesh.positions[indices[i]];
+        area += 0.5f * glm::length(glm::cross(mesh.positions[indices[i + 1]] - p0, mesh.positions[indices[i + 2]] - p0));
+    }
+    return area;
+}
+
+static bool writeObj(const std::string& filename, const TestMesh& mesh)
+{
+    std::ofstream file(filename);
+    for(const auto& p : mesh.positions)
+    {
+        file << "v " << p.x << " " << p.y << " " << p.z << "\n";
+    }
+    for(size_t i = 0; i < mesh.indices.size(); i += 3)
+    {
+        file << "f " << mesh.indices[i] + 1 << " " << mesh.indices[i + 1] + 1 << " " << mesh.indices[i + 2] + 1 << "\n";
+    }
+    return file.good();
+}
+
+/** Read the index buffer of a mesh. It can't be mapped, so it's copied into a staging buffer first.
+*/
+static std::vector<uint8_t> readIndexBuffer(const Mesh* pMesh)
+{
+    const Buffer* pIB = pMesh->getVao()->getIndexBuffer().get();
+    auto pStaging = Buffer::create(pIB->getSize(), Buffer::BindFlags::None, Buffer::AccessFlags::MapRead, nullptr);
+    pIB->copy(pStaging.get());
+    const uint8_t* pData = (const uint8_t*)pStaging->map(Buffer::MapType::Read);
+    std::vector<uint8_t> data(pData, pData + pIB->getSize());
+    pStaging->unmap();
+    return data;
+}
+
+void MeshLodTest::testFlatGrid()
+{
+    // A flat grid can be reduced to 2 triangles without any error. The border must not move, so the area is preserved.
+    TestMesh mesh = createGrid(32);
+    std::vector<uint32_t> simplified;
+    float error = simplifyMesh(simplified, mesh.indices.data(), (uint32_t)mesh.indices.size(), mesh.positions.data(), sizeof(glm::vec3), (uint32_t)mesh.positions.size(), 0, 1e-4f);
+
+    check(simplified.size() == 6, "flat grid simplified to " + std::to_string(simplified.size() / 3) + " triangles instead of 2");
+    check(error < 1e-4f, "flat grid simplification error is " + std::to_string(error));
+    check(std::abs(calculateArea(mesh, simplified) - 32.0f * 32.0f) < 1e-2f, "flat grid area changed");
+}
+
+void MeshLodTest::testSphere()
+{
+    TestMesh mesh = createSphere(32, 64);
+    uint32_t targetIndexCount = (uint32_t)mesh.indices.size() / 4;
+    std::vector<uint32_t> simplified;
+    float error = simplifyMesh(simplified, mesh.indices.data(), (uint32_t)mesh.indices.size(), mesh.positions.data(), sizeof(glm::vec3), (uint32_t)mesh.positions.size(), targetIndexCount);
+
+    check(simplified.size() <= targetIndexCount, "sphere wasn't simplified to the target index count");
+    check(simplified.size() % 3 == 0, "simplified index count isn't a multiple of 3");
+
+    // The reported error must bound the distance of the simplified surface from the sphere, up to the tessellation error of the input
+    float maxDistance = 0;
+    for(size_t i = 0; i < simplified.size(); i += 3)
+    {
+        glm::vec3 centroid = (mesh.positions[simplified[i]] + mesh.positions[simplified[i + 1]] + mesh.positions[simplified[i + 2]]) / 3.0f;
+        maxDistance = std::max(maxDistance, 1 - glm::length(centroid));
+    }
+    check(error > 0 && error < 0.05f, "sphere simplification error is " + std::to_string(error));
+    check(maxDistance < 0.05f, "simplified sphere deviates by " + std::to_string(maxDistance));
+}
+
+void MeshLodTest::testSeams()
+{
+    // Vertices which share a position with another vertex are never removed, so the LODs don't crack along UV seams
+    TestMesh mesh = createSphere(16, 32);
+    std::vector<uint32_t> simplified;
+    simplifyMesh(simplified, mesh.indices.data(), (uint32_t)mesh.indices.size(), mesh.positions.data(), sizeof(glm::vec3), (uint32_t)mesh.positions.size(), 0);
+
+    std::vector<bool> isUsed(mesh.positions.size(), false);
+    for(uint32_t index : simplified)
+    {
+        isUsed[index] = true;
+    }
+
+    for(uint32_t r = 1; r < 16; r++)
+    {
+        uint32_t first = r * 33;
+        uint32_t last = first + 32;
+        check(isUsed[first] && isUsed[last], "seam vertex of ring " + std::to_string(r) + " was removed");
+    }
+}
+
+void MeshLodTest::testLodChain()
+{
+    TestMesh mesh = createSphere(64, 128);
+    std::vector<MeshLodData> lods = generateLodChain(mesh.indices.data(), (uint32_t)mesh.indices.size(), mesh.positions.data(), sizeof(glm::vec3), (uint32_t)mesh.positions.size(), 6, 0.5f);
+    check(lods.size() == 5, "expected 5 LODs, got " + std::to_string(lods.size()));
+
+    size_t previousCount = mesh.indices.size();
+    float previousError = 0;
+    for(size_t i = 0; i < lods.size(); i++)
+    {
+        const auto& lod = lods[i];
+        check(lod.indices.size() <= previousCount / 2 + 3, "LOD " + std::to_string(i + 1) + " has too many triangles");
+        check(lod.error >= previousError, "LOD " + std::to_string(i + 1) + " error isn't monotonic");
+        for(uint32_t index : lod.indices)
+        {
+            check(index < mesh.positions.size(), "LOD " + std::to_string(i + 1) + " references an invalid vertex");
+        }
+        previousCount = lod.indices.size();
+        previousError = lod.error;
+    }
+}
+
+void MeshLodTest::testLodSelection()
+{
+    Mesh::Lod lods[4];
+    lods[0].error = 0;
+    lods[1].error = 0.01f;
+    lods[2].error = 0.1f;
+    lods[3].error = 1.0f;
+
+    // 1000 pixels per world unit at a distance of 1
+    const float kProjectionScale = 1000;
+    const float kMaxPixelError = 1;
+
+    // At a distance of 10, 0.01 units are 1 pixel
+    check(Mesh::selectLod(lods, 4, 1, 10, kProjectionScale, kMaxPixelError) == 1, "LOD selection at distance 10");
+    check(Mesh::selectLod(lods, 4, 1, 9, kProjectionScale, kMaxPixelError) == 0, "LOD selection at distance 9");
+    check(Mesh::selectLod(lods, 4, 1, 100, kProjectionScale, kMaxPixelError) == 2, "LOD selection at distance 100");
+    check(Mesh::selectLod(lods, 4, 1, 1e6f, kProjectionScale, kMaxPixelError) == 3, "LOD selection far away");
+
+    // The camera is inside the bounding-box
+    check(Mesh::selectLod(lods, 4, 1, 0, kProjectionScale, kMaxPixelError) == 0, "LOD selection inside the bounding-box");
+
+    // Scaling the instance scales the error
+    check(Mesh::selectLod(lods, 4, 10, 100, kProjectionScale, kMaxPixelError) == 1, "LOD selection of a scaled instance");
+
+    // A higher error threshold selects coarser LODs
+    check(Mesh::selectLod(lods, 4, 1, 10, kProjectionScale, 10) == 2, "LOD selection with a 10 pixels threshold");
+
+    // A mesh without LODs
+    check(Mesh::selectLod(lods, 1, 1, 1e6f, kProjectionScale, kMaxPixelError) == 0, "LOD selection without LODs");
+
+    // 90 degrees FOV, 1000 pixels high viewport
+    float projectionScale = Mesh::calculateLodProjectionScale(glm::radians(90.0f), 1000);
+    check(std::abs(projectionScale - 500) < 1e-2f, "LOD projection scale is " + std::to_string(projectionScale));
+}
+
+void MeshLodTest::testBinaryRoundTrip()
+{
+    // Binary models store the LOD table. Importing an exported model must give the same LODs, without generating them again.
+    const std::string directory = getExecutableDirectory() + "\\MeshLodTest";
+    createDirectory(directory);
+    const std::string objFile = directory + "\\Sphere.obj";
+    const std::string binFile = directory + "\\Sphere.bin";
+    check(writeObj(objFile, createSphere(32, 64)), "can't write " + objFile);
+
+    auto pSource = Model::createFromFile(objFile, Model::GenerateLods);
+    check(pSource && (pSource->getMeshCount() == 1), "can't load " + objFile);
+    if((pSource && (pSource->getMeshCount() == 1)) == false)
+    {
+        return;
+    }
+    const Mesh* pSourceMesh = pSource->getMesh(0).get();
+    check(pSourceMesh->getLodCount() > 1, "no LODs were generated for " + objFile);
+
+    pSource->exportToBinaryFile(binFile);
+    auto pImported = Model::createFromFile(binFile, 0);
+    check(pImported && (pImported->getMeshCount() == 1), "can't load " + binFile);
+    if(pImported && (pImported->getMeshCount() == 1))
+    {
+        const Mesh* pMesh = pImported->getMesh(0).get();
+        check(pMesh->getLodCount() == pSourceMesh->getLodCount(), "the imported mesh has " + std::to_string(pMesh->getLodCount()) + " LODs instead of " + std::to_string(pSourceMesh->getLodCount()));
+        for(uint32_t lod = 0; lod < std::min(pMesh->getLodCount(), pSourceMesh->getLodCount()); lod++)
+        {
+            const Mesh::Lod& imported = pMesh->getLod(lod);
+            const Mesh::Lod& source = pSourceMesh->getLod(lod);
+            check((imported.firstIndex == source.firstIndex) && (imported.indexCount == source.indexCount) && (imported.error == source.error), "LOD " + std::to_string(lod) + " changed in the binary round-trip");
+        }
+        check(readIndexBuffer(pMesh) == readIndexBuffer(pSourceMesh), "the LOD indices changed in the binary round-trip");
+    }
+
+    std::remove(objFile.c_str());
+    std::remove(binFile.c_str());
+}
+
+void MeshLodTest::onLoad()
+{
+    testFlatGrid();
+    testSphere();
+    testSeams();
+    testLodChain();
+    testLodSelection();
+    testBinaryRoundTrip();
+
+    finishTests("mesh LOD");
+}
+
+int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPSTR lpCmdLine, _In_ int nShowCmd)
+{
+    MeshLodTest meshLodTest;
+    SampleConfig config;
+    meshLodTest.run(config);
+}
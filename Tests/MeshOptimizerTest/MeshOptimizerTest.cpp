@@ -0,0 +1,219 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "MeshOptimizerTest.h"
+#include "Graphics/Model/MeshOptimizer.h"
+#include <algorithm>
+#include <array>
+
+static const uint32_t kGridSize = 300;
+static const uint32_t kUnusedVertices = 4;
+
+/** A small deterministic generator, so that the shuffled mesh is the same on every run
+*/
+static uint32_t nextRandom(uint32_t& state)
+{
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+/** Rotate every triangle so that it starts with its smallest index and sort the triangles. The winding is preserved, so two lists describe the same triangles if their canonical forms are equal.
+*/
+static std::vector<std::array<uint32_t, 3>> getCanonicalTriangles(const std::vector<uint32_t>& indices)
+{
+    std::vector<std::array<uint32_t, 3>> triangles(indices.size() / 3);
+    for(size_t t = 0; t < triangles.size(); t++)
+    {
+        const uint32_t* pTri = &indices[t * 3];
+        size_t first = std::min_element(pTri, pTri + 3) - pTri;
+        for(size_t v = 0; v < 3; v++)
+        {
+            triangles[t][v] = pTri[(first + v) % 3];
+        }
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+void MeshOptimizerTest::createShuffledGrid()
+{
+    // The grid's vertices are stored in random order, after a few vertices which aren't referenced
+    const uint32_t gridVertices = (kGridSize + 1) * (kGridSize + 1);
+    std::vector<uint32_t> vertexOrder(gridVertices);
+    for(uint32_t i = 0; i < gridVertices; i++)
+    {
+        vertexOrder[i] = kUnusedVertices + i;
+    }
+
+    uint32_t state = 1;
+    for(uint32_t i = gridVertices - 1; i > 0; i--)
+    {
+        std::swap(vertexOrder[i], vertexOrder[nextRandom(state) % (i + 1)]);
+    }
+
+    mPositions.assign(kUnusedVertices + gridVertices, glm::vec3(-1));
+    for(uint32_t y = 0; y <= kGridSize; y++)
+    {
+        for(uint32_t x = 0; x <= kGridSize; x++)
+        {
+            mPositions[vertexOrder[y * (kGridSize + 1) + x]] = glm::vec3(float(x), float(y), 0);
+        }
+    }
+
+    // Shuffled triangles
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for(uint32_t y = 0; y < kGridSize; y++)
+    {
+        for(uint32_t x = 0; x < kGridSize; x++)
+        {
+            uint32_t v0 = vertexOrder[y * (kGridSize + 1) + x];
+            uint32_t v1 = vertexOrder[y * (kGridSize + 1) + x + 1];
+            uint32_t v2 = vertexOrder[(y + 1) * (kGridSize + 1) + x];
+            uint32_t v3 = vertexOrder[(y + 1) * (kGridSize + 1) + x + 1];
+            triangles.push_back({{v0, v1, v2}});
+            triangles.push_back({{v2, v1, v3}});
+        }
+    }
+    for(size_t i = triangles.size() - 1; i > 0; i--)
+    {
+        std::swap(triangles[i], triangles[nextRandom(state) % (i + 1)]);
+    }
+
+    mIndices.clear();
+    for(const auto& tri : triangles)
+    {
+        mIndices.insert(mIndices.end(), tri.begin(), tri.end());
+    }
+}
+
+void MeshOptimizerTest::testVertexCache()
+{
+    const uint32_t indexCount = (uint32_t)mIndices.size();
+    const uint32_t vertexCount = (uint32_t)mPositions.size();
+    mCacheOptimized.resize(indexCount);
+    optimizeVertexCache(mCacheOptimized.data(), mIndices.data(), indexCount, vertexCount);
+
+    check(getCanonicalTriangles(mCacheOptimized) == getCanonicalTriangles(mIndices), "the vertex cache optimization changed the triangles");
+
+    // The optimization only depends on the input
+    std::vector<uint32_t> second(indexCount);
+    optimizeVertexCache(second.data(), mIndices.data(), indexCount, vertexCount);
+    check(second == mCacheOptimized, "the vertex cache optimization isn't deterministic");
+
+    // A shuffled grid misses the cache on almost every vertex. The optimized order is close to the grid's optimum of 0.5.
+    VertexCacheStats before = analyzeVertexCache(mIndices.data(), indexCount, vertexCount);
+    VertexCacheStats after = analyzeVertexCache(mCacheOptimized.data(), indexCount, vertexCount);
+    check(before.acmr > 2.5f, "the shuffled grid has an ACMR of " + std::to_string(before.acmr));
+    check(after.acmr < 0.8f, "the optimized grid has an ACMR of " + std::to_string(after.acmr));
+    check(after.atvr < 1.6f && after.atvr < before.atvr, "the ATVR went from " + std::to_string(before.atvr) + " to " + std::to_string(after.atvr));
+    Logger::log(Logger::Level::Info, "Vertex cache optimization of a shuffled " + std::to_string(kGridSize) + "x" + std::to_string(kGridSize) + " grid: ACMR " + std::to_string(before.acmr) + " -> " + std::to_string(after.acmr) + ", ATVR " + std::to_string(before.atvr) + " -> " + std::to_string(after.atvr));
+}
+
+void MeshOptimizerTest::testOverdraw()
+{
+    const uint32_t indexCount = (uint32_t)mCacheOptimized.size();
+    const uint32_t vertexCount = (uint32_t)mPositions.size();
+    const float threshold = 1.05f;
+    std::vector<uint32_t> optimized(indexCount);
+    optimizeOverdraw(optimized.data(), mCacheOptimized.data(), indexCount, mPositions.data(), sizeof(glm::vec3), vertexCount, threshold);
+    check(getCanonicalTriangles(optimized) == getCanonicalTriangles(mCacheOptimized), "the overdraw optimization changed the triangles");
+
+    std::vector<uint32_t> second(indexCount);
+    optimizeOverdraw(second.data(), mCacheOptimized.data(), indexCount, mPositions.data(), sizeof(glm::vec3), vertexCount, threshold);
+    check(second == optimized, "the overdraw optimization isn't deterministic");
+
+    VertexCacheStats input = analyzeVertexCache(mCacheOptimized.data(), indexCount, vertexCount);
+    VertexCacheStats output = analyzeVertexCache(optimized.data(), indexCount, vertexCount);
+    check(output.acmr <= input.acmr * threshold, "the overdraw optimization degraded the ACMR from " + std::to_string(input.acmr) + " to " + std::to_string(output.acmr));
+}
+
+void MeshOptimizerTest::testVertexFetch()
+{
+    const uint32_t indexCount = (uint32_t)mCacheOptimized.size();
+    const uint32_t vertexCount = (uint32_t)mPositions.size();
+    std::vector<uint32_t> remap(vertexCount);
+    optimizeVertexFetchRemap(remap.data(), mCacheOptimized.data(), indexCount, vertexCount);
+
+    std::vector<uint32_t> second(vertexCount);
+    optimizeVertexFetchRemap(second.data(), mCacheOptimized.data(), indexCount, vertexCount);
+    check(second == remap, "the vertex fetch remap isn't deterministic");
+
+    // Every vertex must be moved to a different location
+    std::vector<bool> isUsed(vertexCount, false);
+    bool isPermutation = true;
+    for(uint32_t v : remap)
+    {
+        isPermutation = isPermutation && (v < vertexCount) && (isUsed[v] == false);
+        isUsed[v % vertexCount] = true;
+    }
+    check(isPermutation, "the vertex fetch remap isn't a permutation");
+    if(isPermutation == false)
+    {
+        return;
+    }
+
+    // The unreferenced vertices are moved to the end in their original order
+    for(uint32_t v = 0; v < kUnusedVertices; v++)
+    {
+        check(remap[v] == vertexCount - kUnusedVertices + v, "unreferenced vertex " + std::to_string(v) + " was moved to " + std::to_string(remap[v]));
+    }
+
+    std::vector<uint32_t> indices = mCacheOptimized;
+    remapIndexBuffer(indices.data(), indexCount, remap.data());
+    std::vector<glm::vec3> positions(vertexCount);
+    remapVertexBuffer(positions.data(), mPositions.data(), vertexCount, sizeof(glm::vec3), remap.data());
+
+    // The remapped mesh draws the same triangles in the same order, and the vertices are referenced in increasing order
+    uint32_t nextVertex = 0;
+    bool isSameMesh = true;
+    bool isOrdered = true;
+    for(uint32_t i = 0; i < indexCount; i++)
+    {
+        isSameMesh = isSameMesh && (positions[indices[i]] == mPositions[mCacheOptimized[i]]);
+        isOrdered = isOrdered && (indices[i] <= nextVertex);
+        nextVertex = std::max(nextVertex, indices[i] + 1);
+    }
+    check(isSameMesh, "the remapped mesh doesn't match the original");
+    check(isOrdered, "the remapped vertices aren't ordered by their first use");
+}
+
+void MeshOptimizerTest::onLoad()
+{
+    createShuffledGrid();
+    testVertexCache();
+    testOverdraw();
+    testVertexFetch();
+
+    finishTests("mesh optimizer");
+}
+
+int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPSTR lpCmdLine, _In_ int nShowCmd)
+{
+    MeshOptimizerTest meshOptimizerTest;
+    SampleConfig config;
+    meshOptimizerTest.run(config);
+}
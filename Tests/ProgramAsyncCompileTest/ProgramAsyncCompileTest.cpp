@@ -0,0 +1,203 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "ProgramAsyncCompileTest.h"
+#include <chrono>
+#include <thread>
+
+static const std::string kVertexShader =
+    "#version 440\n"
+    "void main()\n"
+    "{\n"
+    "    gl_Position = vec4(0, 0, 0, 1);\n"
+    "}\n";
+
+static const std::string kFragmentShader =
+    "#version 440\n"
+    "out vec4 fragColor;\n"
+    "void main()\n"
+    "{\n"
+    "#if defined(_RED)\n"
+    "    fragColor = vec4(1, 0, 0, 1);\n"
+    "#elif defined(_GREEN)\n"
+    "    fragColor = vec4(0, 1, 0, 1);\n"
+    "#else\n"
+    "    fragColor = vec4(0, 0, 1, 1);\n"
+    "#endif\n"
+    "}\n";
+
+Program::SharedPtr ProgramAsyncCompileTest::createProgram(bool async)
+{
+    Program::SharedPtr pProgram = Program::createFromString(kVertexShader, kFragmentShader);
+    pProgram->setAsyncCompilation(async);
+    return pProgram;
+}
+
+uint32_t ProgramAsyncCompileTest::compilePendingVersions(uint32_t expectedCount)
+{
+    // Compile one version per call, like Sample does every frame, until the expected versions finished preprocessing on the worker threads
+    uint32_t compiledCount = 0;
+    auto start = std::chrono::steady_clock::now();
+    while((compiledCount < expectedCount) && (std::chrono::steady_clock::now() - start < std::chrono::seconds(10)))
+    {
+        uint32_t count = Program::compilePendingVersions(1);
+        check(count <= 1, "compilePendingVersions() compiled more versions than it was allowed to");
+        compiledCount += count;
+        if(count == 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    // Nothing else should be pending
+    compiledCount += Program::compilePendingVersions(100);
+    return compiledCount;
+}
+
+void ProgramAsyncCompileTest::testFirstVersion()
+{
+    // There is nothing to fall back to, so the first version is compiled right away
+    Program::SharedPtr pProgram = createProgram(true);
+    check(pProgram->getActiveProgramVersion() != nullptr, "the first version wasn't compiled");
+    check(pProgram->isUsingFallbackVersion() == false, "the first version is a fallback");
+    check(compilePendingVersions(0) == 0, "the first version was queued");
+}
+
+void ProgramAsyncCompileTest::testFallback()
+{
+    Program::SharedPtr pProgram = createProgram(true);
+    ProgramVersion::SharedConstPtr pBlue = pProgram->getActiveProgramVersion();
+
+    // The active version is used until the new one is ready
+    pProgram->addDefine("_RED");
+    check(pProgram->getActiveProgramVersion() == pBlue, "a new version didn't fall back to the active version");
+    check(pProgram->isUsingFallbackVersion(), "the fallback wasn't reported");
+    check(pProgram->getActiveProgramVersion() == pBlue, "a pending version didn't fall back to the active version");
+    check(compilePendingVersions(1) == 1, "a pending version was queued more than once, or wasn't compiled");
+
+    ProgramVersion::SharedConstPtr pRed = pProgram->getActiveProgramVersion();
+    check(pRed != nullptr && pRed != pBlue, "the compiled version wasn't used");
+    check(pProgram->isUsingFallbackVersion() == false, "a compiled version was reported as a fallback");
+
+    // Compiled versions are reused
+    pProgram->removeDefine("_RED");
+    check(pProgram->getActiveProgramVersion() == pBlue && pProgram->isUsingFallbackVersion() == false, "switching back to a compiled version didn't use it");
+    pProgram->addDefine("_RED");
+    check(pProgram->getActiveProgramVersion() == pRed && pProgram->isUsingFallbackVersion() == false, "switching to a compiled version didn't use it");
+}
+
+void ProgramAsyncCompileTest::testPrewarm()
+{
+    Program::SharedPtr pProgram = createProgram(true);
+    ProgramVersion::SharedConstPtr pBlue = pProgram->getActiveProgramVersion();
+
+    std::vector<Program::DefineList> defineLists(3);
+    defineLists[1].add("_RED");
+    defineLists[2].add("_GREEN");
+
+    // The active version is already compiled, and requesting a version again doesn't queue it twice
+    pProgram->prewarm(defineLists);
+    pProgram->prewarm(defineLists);
+    check(compilePendingVersions(2) == 2, "the versions weren't prewarmed exactly once");
+
+    pProgram->addDefine("_RED");
+    ProgramVersion::SharedConstPtr pRed = pProgram->getActiveProgramVersion();
+    check(pRed != pBlue && pProgram->isUsingFallbackVersion() == false, "a prewarmed version wasn't ready");
+    pProgram->removeDefine("_RED");
+    pProgram->addDefine("_GREEN");
+    ProgramVersion::SharedConstPtr pGreen = pProgram->getActiveProgramVersion();
+    check(pGreen != pBlue && pGreen != pRed && pProgram->isUsingFallbackVersion() == false, "a prewarmed version wasn't ready");
+}
+
+void ProgramAsyncCompileTest::testSynchronousRequest()
+{
+    // Without asynchronous compilation, a version which is still preprocessing is waited for
+    Program::SharedPtr pProgram = createProgram(false);
+    ProgramVersion::SharedConstPtr pBlue = pProgram->getActiveProgramVersion();
+
+    std::vector<Program::DefineList> defineLists(1);
+    defineLists[0].add("_RED");
+    pProgram->prewarm(defineLists);
+    pProgram->addDefine("_RED");
+    ProgramVersion::SharedConstPtr pRed = pProgram->getActiveProgramVersion();
+    check(pRed != nullptr && pRed != pBlue && pProgram->isUsingFallbackVersion() == false, "a synchronous request for a prewarmed version didn't compile it");
+    check(compilePendingVersions(0) == 0, "a version compiled by a synchronous request was still pending");
+
+    pProgram->removeDefine("_RED");
+    pProgram->addDefine("_GREEN");
+    ProgramVersion::SharedConstPtr pGreen = pProgram->getActiveProgramVersion();
+    check(pGreen != nullptr && pGreen != pBlue && pProgram->isUsingFallbackVersion() == false, "a synchronous request fell back to the active version");
+}
+
+void ProgramAsyncCompileTest::testLayoutDefines()
+{
+    // _GREEN stands for a define which changes the resources the program reads, like SceneRenderer's _INSTANCE_BUFFER
+    Program::SharedPtr pProgram = createProgram(true);
+    pProgram->addLayoutDefine("_GREEN");
+    ProgramVersion::SharedConstPtr pBlue = pProgram->getActiveProgramVersion();
+
+    // Other defines still fall back
+    pProgram->addDefine("_RED");
+    check(pProgram->getActiveProgramVersion() == pBlue && pProgram->isUsingFallbackVersion(), "a version which only differs in a regular define didn't fall back");
+    check(compilePendingVersions(1) == 1, "the pending version wasn't compiled");
+    ProgramVersion::SharedConstPtr pRed = pProgram->getActiveProgramVersion();
+
+    // No compiled version has _GREEN, so it's compiled right away
+    pProgram->removeDefine("_RED");
+    pProgram->addDefine("_GREEN");
+    ProgramVersion::SharedConstPtr pGreen = pProgram->getActiveProgramVersion();
+    check(pGreen != nullptr && pGreen != pBlue && pGreen != pRed && pProgram->isUsingFallbackVersion() == false, "a version with a different layout define fell back");
+    check(compilePendingVersions(0) == 0, "a version with a different layout define was queued");
+
+    // The fallback is a version with the same layout defines, even when it isn't the active one
+    pProgram->addDefine("_RED");
+    check(pProgram->getActiveProgramVersion() == pGreen && pProgram->isUsingFallbackVersion(), "a version with the same layout define didn't fall back to the active version");
+    check(compilePendingVersions(1) == 1, "the pending version wasn't compiled");
+    pProgram->removeDefine("_GREEN");
+    pProgram->addDefine("_UNUSED");
+    ProgramVersion::SharedConstPtr pFallback = pProgram->getActiveProgramVersion();
+    check(pProgram->isUsingFallbackVersion() && (pFallback == pBlue || pFallback == pRed), "the fallback has a different layout define than the requested version");
+    check(compilePendingVersions(1) == 1, "the pending version wasn't compiled");
+}
+
+void ProgramAsyncCompileTest::onLoad()
+{
+    testFirstVersion();
+    testFallback();
+    testPrewarm();
+    testSynchronousRequest();
+    testLayoutDefines();
+
+    finishTests("program async compilation");
+}
+
+int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPSTR lpCmdLine, _In_ int nShowCmd)
+{
+    ProgramAsyncCompileTest programAsyncCompileTest;
+    SampleConfig config;
+    programAsyncCompileTest.run(config);
+}
@@ -0,0 +1,227 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "RenderCommandListTest.h"
+#include "Utils/CpuTimer.h"
+
+using Command = RenderCommandList::Command;
+using Type = RenderCommandList::Type;
+
+static const glm::vec4 kTint(0.25f, 0.5f, 0.75f, 1);
+
+bool RenderCommandListTest::createScene()
+{
+    mpScene = Scene::loadFromFile("Scenes/DragonPlane.fscene", Model::GenerateTangentSpace);
+    check(mpScene && (mpScene->getLightCount() > 0), "can't load Scenes/DragonPlane.fscene");
+    if((mpScene && (mpScene->getLightCount() > 0)) == false)
+    {
+        return false;
+    }
+
+    mpRenderer = SceneRenderer::create(mpScene);
+    mpCsm = CascadedShadowMaps::create(1024, 1024, mpScene->getLight(0), mpScene, 4);
+    // EVSM blurs the shadow map and generates its mip-chain, so the frame also records the blur passes and the mip generation
+    mpCsm->setFilterMode(CsmFilterEvsm4);
+    mpCsm->setDistanceRange(glm::vec2(0, 0.5f));
+    mpTextRenderer = TextRenderer::create();
+    mpProgram = Program::createFromFile("", "RenderCommandListTest.fs");
+    mpPerFrameCB = UniformBuffer::create(mpProgram->getActiveProgramVersion().get(), "PerFrameCB");
+    return true;
+}
+
+void RenderCommandListTest::renderFrame()
+{
+    // The same calls a sample makes in onFrameRender()
+    mpRenderContext->clearFbo(mpDefaultFBO, glm::vec4(0.38f, 0.52f, 0.10f, 1), 1, 0, FboAttachmentType::All);
+    mpRenderer->update(mCurrentTime);
+    mpCsm->setup(mpRenderContext.get(), mpScene->getActiveCamera().get(), nullptr);
+
+    mpPerFrameCB->setVariable("gTint", kTint);
+    mpRenderContext->setUniformBuffer(0, mpPerFrameCB);
+    mpRenderer->renderScene(mpRenderContext.get(), mpProgram.get());
+
+    mpTextRenderer->begin(mpRenderContext, glm::vec2(10, 10));
+    mpTextRenderer->renderLine("Recorded frame");
+    mpTextRenderer->end();
+}
+
+void RenderCommandListTest::testRecording()
+{
+    RenderContext::Viewport vp;
+    vp.width = (float)mpDefaultFBO->getWidth();
+    vp.height = (float)mpDefaultFBO->getHeight();
+    mpRenderContext->setViewport(0, vp);
+    mpRenderContext->setFbo(mpDefaultFBO);
+    const auto pRastState = mpRenderContext->getRasterizerState();
+    const auto pBlendState = mpRenderContext->getBlendState();
+
+    mpList = RenderCommandList::create();
+    mpRenderContext->beginRecording(mpList);
+    check(mpRenderContext->getRecordingList() == mpList.get(), "the context isn't recording");
+    renderFrame();
+    const uint32_t mainPassDrawCount = mpRenderer->getDrawStats().drawCount;
+    mpRenderContext->endRecording();
+    check(mpRenderContext->getRecordingList() == nullptr, "the context is still recording");
+
+    // Nothing was sent to the API, so the context is back to the state it had before recording
+    check(mpRenderContext->getFbo() == mpDefaultFBO, "endRecording() didn't restore the FBO");
+    check(mpRenderContext->getRasterizerState() == pRastState && mpRenderContext->getBlendState() == pBlendState, "endRecording() didn't restore the state objects");
+    check(mpRenderContext->getViewport(0).width == vp.width && mpRenderContext->getViewport(0).height == vp.height, "endRecording() didn't restore the viewport");
+
+    uint32_t typeCount[(uint32_t)Type::Count] = {};
+    uint32_t drawCount = 0;
+    bool clearedShadowMap = false;
+    bool tintRecorded = false;
+    const size_t tintOffset = mpPerFrameCB->getVariableOffset("gTint");
+    for(const Command& cmd : mpList->getCommands())
+    {
+        typeCount[(uint32_t)cmd.type]++;
+        switch(cmd.type)
+        {
+        case Type::Draw:
+        case Type::DrawIndexed:
+        case Type::DrawIndexedInstanced:
+            drawCount++;
+            break;
+        case Type::ClearFbo:
+            clearedShadowMap = clearedShadowMap || (mpList->getObject<Fbo>(cmd.args[0]) != mpDefaultFBO);
+            break;
+        case Type::UpdateUniformBuffer:
+            // The uniform-buffer data is copied at the draw which uses it
+            if((mpList->getObject<UniformBuffer>(cmd.args[0]) == mpPerFrameCB) && (cmd.args[2] <= tintOffset) && (cmd.args[2] + cmd.args[3] >= tintOffset + sizeof(kTint)))
+            {
+                tintRecorded = tintRecorded || (memcmp(mpList->getData() + cmd.args[1] + tintOffset - cmd.args[2], &kTint, sizeof(kTint)) == 0);
+            }
+            break;
+        }
+    }
+
+    check(mainPassDrawCount > 0, "the main pass didn't draw anything");
+    // The main pass, at least one shadow-map draw, the 2 blur passes and the text
+    check(drawCount >= mainPassDrawCount + 4, "only " + std::to_string(drawCount) + " draws were recorded, the main pass has " + std::to_string(mainPassDrawCount));
+    check(typeCount[(uint32_t)Type::ClearFbo] >= 2 && clearedShadowMap, "the FBO clears weren't recorded");
+    check(typeCount[(uint32_t)Type::GenerateMips] == 1, "the shadow map's mip generation wasn't recorded");
+    check(typeCount[(uint32_t)Type::UpdateBuffer] == 1, "the text vertices weren't recorded");
+    check(typeCount[(uint32_t)Type::SetProgram] > 0 && typeCount[(uint32_t)Type::SetVao] > 0 && typeCount[(uint32_t)Type::SetFbo] > 0, "the state binds weren't recorded");
+    check(tintRecorded, "the per-frame uniform-buffer data wasn't copied into the list");
+}
+
+void RenderCommandListTest::testReplay()
+{
+    uint32_t bindCommandCount = 0;
+    uint32_t drawCount = 0;
+    for(const Command& cmd : mpList->getCommands())
+    {
+        if(cmd.type <= Type::SetFbo)
+        {
+            bindCommandCount++;
+        }
+        else if(cmd.type >= Type::Draw)
+        {
+            drawCount++;
+        }
+    }
+
+    RenderCommandList::Stats stats = mpList->execute(nullptr);
+    check(stats.commandCount == mpList->getCommands().size(), "wrong command count");
+    check(stats.drawCount == drawCount, "the null backend replayed " + std::to_string(stats.drawCount) + " draws instead of " + std::to_string(drawCount));
+    check(stats.bindCount + stats.redundantBindCount == bindCommandCount, "every bind should be either issued or dropped");
+    // The renderers restore their state with popState(), which rebinds everything
+    check(stats.redundantBindCount > 0, "no redundant bind was dropped");
+
+    // Replaying twice gives the same result, since the list doesn't assume anything about the context's state
+    RenderCommandList::Stats again = mpList->execute(nullptr);
+    check(again.bindCount == stats.bindCount && again.redundantBindCount == stats.redundantBindCount && again.drawCount == stats.drawCount, "replay isn't repeatable");
+
+    // Replay on the context. The list ends with the state the renderers left, and the FBO they popped back to.
+    RenderCommandList::Stats replayed = mpList->execute(mpRenderContext.get());
+    check(replayed.drawCount == stats.drawCount && replayed.bindCount == stats.bindCount, "the context replay doesn't match the null backend");
+    check(mpRenderContext->getFbo() == mpDefaultFBO, "the replay didn't end on the default FBO");
+}
+
+void RenderCommandListTest::benchmark()
+{
+    const uint32_t kIterations = 20;
+
+    // SDSM is skipped when recording, so disable it to compare the same work
+    mpCsm->toggleMinMaxSdsm(false);
+    auto start = CpuTimer::getCurrentTimePoint();
+    for(uint32_t iteration = 0; iteration < kIterations; iteration++)
+    {
+        renderFrame();
+    }
+    float directTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) / kIterations;
+
+    auto pList = RenderCommandList::create();
+    start = CpuTimer::getCurrentTimePoint();
+    for(uint32_t iteration = 0; iteration < kIterations; iteration++)
+    {
+        pList->clear();
+        mpRenderContext->beginRecording(pList);
+        renderFrame();
+        mpRenderContext->endRecording();
+    }
+    float recordTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) / kIterations;
+
+    RenderCommandList::Stats stats;
+    start = CpuTimer::getCurrentTimePoint();
+    for(uint32_t iteration = 0; iteration < kIterations; iteration++)
+    {
+        stats = pList->execute(nullptr);
+    }
+    float nullReplayTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) / kIterations;
+
+    start = CpuTimer::getCurrentTimePoint();
+    for(uint32_t iteration = 0; iteration < kIterations; iteration++)
+    {
+        pList->execute(mpRenderContext.get());
+    }
+    float replayTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) / kIterations;
+
+    Logger::log(Logger::Level::Info, "SceneRenderer + CSM + text frame: " + std::to_string(stats.commandCount) + " commands, " + std::to_string(stats.drawCount) + " draws, " + std::to_string(pList->getDataSize()) + " bytes of data. "
+        + "Rendered directly in " + std::to_string(directTime) + "ms, recorded in " + std::to_string(recordTime) + "ms, replayed on the null backend in " + std::to_string(nullReplayTime) + "ms and on the context in " + std::to_string(replayTime) + "ms. "
+        + std::to_string(stats.bindCount) + " binds, " + std::to_string(stats.redundantBindCount) + " redundant binds dropped.");
+}
+
+void RenderCommandListTest::onLoad()
+{
+    if(createScene())
+    {
+        testRecording();
+        testReplay();
+        benchmark();
+    }
+
+    finishTests("render command list");
+}
+
+int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPSTR lpCmdLine, _In_ int nShowCmd)
+{
+    RenderCommandListTest renderCommandListTest;
+    SampleConfig config;
+    renderCommandListTest.run(config);
+}
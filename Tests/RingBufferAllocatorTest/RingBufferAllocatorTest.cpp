@@ -0,0 +1,174 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "RingBufferAllocatorTest.h"
+#include "Utils/RingBufferAllocator.h"
+#include <random>
+
+static const uint32_t kInvalid = RingBufferAllocator::kInvalidOffset;
+
+void RingBufferAllocatorTest::testWrapAround()
+{
+    RingBufferAllocator allocator(100);
+    check(allocator.allocate(40) == 0, "First allocation starts at 0");
+    check(allocator.allocate(30) == 40, "Allocations are contiguous");
+    allocator.endFrame(1);
+    check(allocator.allocate(20) == 70, "Allocation after a frame ends");
+    allocator.endFrame(2);
+
+    // Frame 1 is done, [0, 70) is free. 20 units don't fit at the end, so the tail [90, 100) is skipped.
+    allocator.releaseCompleted(1);
+    check(allocator.getUsedCount() == 20, "Frame 1 released");
+    check(allocator.allocate(20) == 0, "Allocation wraps around");
+    check(allocator.getUsedCount() == 50, "The skipped tail is in use");
+    check(allocator.allocate(50) == 20, "Allocation after the wrap");
+    check(allocator.allocate(1) == kInvalid, "The head reached the tail");
+    allocator.endFrame(3);
+
+    // Releasing frame 2 releases the skipped tail with frame 3
+    allocator.releaseCompleted(2);
+    check(allocator.getUsedCount() == 80, "Frame 2 released");
+    check(allocator.allocate(21) == kInvalid, "Frame 3 still owns the skipped tail");
+    allocator.releaseCompleted(3);
+    check(allocator.getUsedCount() == 0, "All the frames released");
+    check(allocator.getOldestPendingFence() == 0, "No pending frame");
+
+    // Nothing is in use, so a large allocation starts at the beginning instead of wrapping
+    check(allocator.allocate(100) == 0, "Empty allocator restarts at 0");
+}
+
+void RingBufferAllocatorTest::testFenceRelease()
+{
+    RingBufferAllocator allocator(64);
+    allocator.allocate(16);
+    allocator.endFrame(5);
+    allocator.endFrame(6);      // Empty frames are ignored
+    allocator.allocate(16);
+    allocator.endFrame(7);
+    allocator.allocate(16);
+    allocator.endFrame(9);
+
+    check(allocator.getOldestPendingFence() == 5, "Oldest fence");
+    allocator.releaseCompleted(4);
+    check(allocator.getUsedCount() == 48, "Nothing released before the fence completes");
+    allocator.releaseCompleted(8);
+    check(allocator.getUsedCount() == 16, "Frames are released up to the completed value");
+    check(allocator.getOldestPendingFence() == 9, "Oldest fence after release");
+    allocator.releaseCompleted(8);
+    check(allocator.getUsedCount() == 16, "Releasing again has no effect");
+}
+
+void RingBufferAllocatorTest::testFull()
+{
+    RingBufferAllocator allocator(32);
+    check(allocator.allocate(33) == kInvalid, "Allocation larger than the buffer");
+    check(allocator.allocate(0) != kInvalid, "Empty allocation");
+    check(allocator.allocate(32) == 0, "Allocation of the entire buffer");
+    check(allocator.allocate(1) == kInvalid, "Allocation from a full buffer");
+    allocator.endFrame(1);
+    check(allocator.allocate(1) == kInvalid, "Allocation before the frame is released");
+    allocator.releaseCompleted(1);
+    check(allocator.allocate(1) == 0, "Allocation after the frame is released");
+}
+
+void RingBufferAllocatorTest::testRandomFrames()
+{
+    // Simulate a GPU running a few frames behind the CPU, and check that live ranges never overlap
+    const uint32_t kCapacity = 1000;
+    const uint32_t kFrameLatency = 3;
+    RingBufferAllocator allocator(kCapacity);
+    std::vector<uint64_t> owner(kCapacity, 0);     // The fence value of the frame using each unit, 0 if free
+    std::mt19937 rng(1234);
+    uint64_t fenceValue = 0;
+    uint64_t completedValue = 0;
+    uint32_t failedAllocations = 0;
+
+    for(uint32_t frame = 0; frame < 2000; frame++)
+    {
+        uint64_t frameFence = fenceValue + 1;
+        uint32_t allocationCount = rng() % 5;
+        for(uint32_t a = 0; a < allocationCount; a++)
+        {
+            uint32_t count = 1 + rng() % 150;
+            uint32_t offset = allocator.allocate(count);
+            while(offset == kInvalid && allocator.getOldestPendingFence() != 0)
+            {
+                // Wait for the GPU
+                completedValue = allocator.getOldestPendingFence();
+                allocator.releaseCompleted(completedValue);
+                offset = allocator.allocate(count);
+            }
+            if(offset == kInvalid)
+            {
+                failedAllocations++;
+                continue;
+            }
+
+            check(offset + count <= kCapacity, "Range is inside the buffer");
+            for(uint32_t i = offset; i < std::min(offset + count, kCapacity); i++)
+            {
+                if(owner[i] > completedValue)
+                {
+                    check(false, "Range overlaps a range in use");
+                    return;
+                }
+                owner[i] = frameFence;
+            }
+        }
+
+        fenceValue = frameFence;
+        allocator.endFrame(fenceValue);
+        if(fenceValue > kFrameLatency)
+        {
+            completedValue = std::max(completedValue, fenceValue - kFrameLatency);
+            allocator.releaseCompleted(completedValue);
+        }
+        check(allocator.getUsedCount() <= kCapacity, "Used count is inside the buffer");
+    }
+
+    // A frame's allocations can exceed the capacity, but the first allocation of a frame always fits after waiting
+    Logger::log(Logger::Level::Info, std::to_string(failedAllocations) + " allocations didn't fit in their frame");
+    allocator.releaseCompleted(fenceValue);
+    check(allocator.getUsedCount() == 0, "All the frames released at the end");
+}
+
+void RingBufferAllocatorTest::onLoad()
+{
+    testWrapAround();
+    testFenceRelease();
+    testFull();
+    testRandomFrames();
+
+    finishTests("ring buffer allocator");
+}
+
+int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPSTR lpCmdLine, _In_ int nShowCmd)
+{
+    RingBufferAllocatorTest ringBufferAllocatorTest;
+    SampleConfig config;
+    ringBufferAllocatorTest.run(config);
+}
@@ -0,0 +1,370 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "SceneBvhTest.h"
+#include "Utils/CpuTimer.h"
+#include <random>
+#include "glm/gtc/matrix_transform.hpp"
+
+static const float kWorldSize = 1000;
+
+void SceneBvhTest::createInstances(uint32_t count)
+{
+    // Random boxes of different sizes and orientations, like mesh instances scattered over a large scene
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> position(-kWorldSize, kWorldSize);
+    std::uniform_real_distribution<float> size(0.1f, 10);
+    std::uniform_real_distribution<float> angle(0, 2 * glm::pi<float>());
+
+    mInstances.resize(count);
+    for(auto& instance : mInstances)
+    {
+        glm::vec3 extent(size(rng), size(rng), size(rng));
+        instance.objectBox = BoundingBox::fromMinMax(-extent, extent);
+        instance.transform = glm::translate(glm::mat4(), glm::vec3(position(rng), position(rng) * 0.1f, position(rng))) * glm::rotate(glm::mat4(), angle(rng), glm::vec3(0, 1, 0));
+    }
+}
+
+void SceneBvhTest::buildBvh()
+{
+    std::vector<BoundingBox> boxes(mInstances.size());
+    for(size_t i = 0; i < mInstances.size(); i++)
+    {
+        boxes[i] = mInstances[i].objectBox.transform(mInstances[i].transform);
+    }
+    mBvh.build(boxes.data(), (uint32_t)boxes.size());
+}
+
+void SceneBvhTest::testCulling(const Camera* pCamera, const std::string& name)
+{
+    // The hierarchical culling must return exactly the instances which pass the camera's test
+    std::vector<uint32_t> expected;
+    for(uint32_t i = 0; i < (uint32_t)mInstances.size(); i++)
+    {
+        if(pCamera->isObjectCulled(mBvh.getItemBoundingBox(i)) == false)
+        {
+            expected.push_back(i);
+        }
+    }
+
+    std::vector<uint32_t> visible;
+    mBvh.cullFrustum(pCamera->getViewProjMatrix(), visible);
+    std::sort(visible.begin(), visible.end());
+    check(visible == expected, name + ": BVH culling found " + std::to_string(visible.size()) + " visible instances, expected " + std::to_string(expected.size()));
+}
+
+void SceneBvhTest::testRayPicking()
+{
+    std::mt19937 rng(5678);
+    std::uniform_real_distribution<float> position(-kWorldSize, kWorldSize);
+    for(uint32_t ray = 0; ray < 100; ray++)
+    {
+        glm::vec3 origin(position(rng), position(rng) * 0.1f, position(rng));
+        glm::vec3 direction = glm::normalize(glm::vec3(position(rng), position(rng) * 0.1f, position(rng)));
+
+        // Brute-force reference
+        float expectedDistance = FLT_MAX;
+        for(uint32_t i = 0; i < mBvh.getItemCount(); i++)
+        {
+            const BoundingBox& box = mBvh.getItemBoundingBox(i);
+            glm::vec3 t0 = (box.center - box.extent - origin) / direction;
+            glm::vec3 t1 = (box.center + box.extent - origin) / direction;
+            glm::vec3 tNear = glm::min(t0, t1);
+            glm::vec3 tFar = glm::max(t0, t1);
+            float entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+            float exit = std::min(std::min(tFar.x, tFar.y), tFar.z);
+            if(entry <= exit)
+            {
+                expectedDistance = std::min(expectedDistance, entry);
+            }
+        }
+
+        uint32_t item;
+        float distance;
+        bool isHit = mBvh.intersectRay(origin, direction, item, distance);
+        check(isHit == (expectedDistance != FLT_MAX), "ray " + std::to_string(ray) + " hit mismatch");
+        if(isHit)
+        {
+            check(std::abs(distance - expectedDistance) <= 1e-3f * std::max(1.0f, expectedDistance), "ray " + std::to_string(ray) + " hit distance is " + std::to_string(distance) + ", expected " + std::to_string(expectedDistance));
+        }
+    }
+
+    // A filter rejecting everything
+    uint32_t item;
+    float distance;
+    check(mBvh.intersectRay(glm::vec3(-2 * kWorldSize, 0, 0), glm::vec3(1, 0, 0), item, distance, FLT_MAX, [](uint32_t) { return false; }) == false, "filtered ray hit an item");
+}
+
+void SceneBvhTest::testBoxQuery()
+{
+    BoundingBox query = BoundingBox::fromMinMax(glm::vec3(-100, -20, -50), glm::vec3(50, 20, 100));
+    glm::vec3 queryMin = query.center - query.extent;
+    glm::vec3 queryMax = query.center + query.extent;
+
+    std::vector<uint32_t> expected;
+    for(uint32_t i = 0; i < mBvh.getItemCount(); i++)
+    {
+        const BoundingBox& box = mBvh.getItemBoundingBox(i);
+        if(glm::all(glm::lessThanEqual(box.center - box.extent, queryMax)) && glm::all(glm::lessThanEqual(queryMin, box.center + box.extent)))
+        {
+            expected.push_back(i);
+        }
+    }
+
+    std::vector<uint32_t> items;
+    mBvh.queryBoundingBox(query, items);
+    std::sort(items.begin(), items.end());
+    check(items == expected, "box query found " + std::to_string(items.size()) + " items, expected " + std::to_string(expected.size()));
+}
+
+void SceneBvhTest::testRefit()
+{
+    // Move a few instances, then a lot of them, which exercise the two refit paths
+    std::mt19937 rng(91011);
+    std::uniform_int_distribution<uint32_t> pick(0, (uint32_t)mInstances.size() - 1);
+    std::uniform_real_distribution<float> offset(-50, 50);
+    uint32_t moveCounts[] = {10, (uint32_t)mInstances.size() / 2};
+    for(uint32_t moveCount : moveCounts)
+    {
+        for(uint32_t i = 0; i < moveCount; i++)
+        {
+            uint32_t instance = pick(rng);
+            mInstances[instance].transform = glm::translate(glm::mat4(), glm::vec3(offset(rng), offset(rng), offset(rng))) * mInstances[instance].transform;
+            mBvh.updateItem(instance, mInstances[instance].objectBox.transform(mInstances[instance].transform));
+        }
+        mBvh.refit();
+        testCulling(mpCamera.get(), "refit after moving " + std::to_string(moveCount) + " instances");
+        testBoxQuery();
+    }
+}
+
+void SceneBvhTest::createStereoAndCascadeViews(std::vector<glm::mat4>& viewProjs)
+{
+    // Two eyes 6.4cm apart
+    viewProjs.clear();
+    viewProjs.push_back(mpCamera->getViewProjMatrix());
+    auto pRightEye = Camera::create();
+    pRightEye->setAspectRatio(16.0f / 9.0f);
+    pRightEye->setDepthRange(0.1f, 500);
+    pRightEye->setPosition(glm::vec3(0.045f, 10, -0.045f));
+    pRightEye->setTarget(glm::vec3(1.045f, 10, 0.955f));
+    pRightEye->setUpVector(glm::vec3(0, 1, 0));
+    viewProjs.push_back(pRightEye->getViewProjMatrix());
+
+    // 4 shadow cascades of a directional light, covering growing ranges along the view direction
+    const glm::vec3 lightDir = glm::normalize(glm::vec3(0.3f, -1, 0.2f));
+    const glm::vec3 viewDir = glm::normalize(glm::vec3(1, 0, 1));
+    float cascadeEnd = 0;
+    for(uint32_t cascade = 0; cascade < 4; cascade++)
+    {
+        float cascadeStart = cascadeEnd;
+        cascadeEnd = 500.0f * float(1 << cascade) / 8.0f;
+        float radius = (cascadeEnd - cascadeStart) * 0.5f + 20;
+        glm::vec3 center = glm::vec3(0, 10, 0) + viewDir * (cascadeStart + cascadeEnd) * 0.5f;
+        glm::mat4 view = glm::lookAt(center - lightDir * kWorldSize, center, glm::vec3(0, 0, 1));
+        glm::mat4 proj = glm::ortho(-radius, radius, -radius, radius, 0.0f, 2 * kWorldSize);
+        viewProjs.push_back(proj * view);
+    }
+}
+
+void SceneBvhTest::testMultiViewCulling()
+{
+    std::vector<glm::mat4> viewProjs;
+    createStereoAndCascadeViews(viewProjs);
+
+    // Every view's visibility must match culling it on its own
+    std::vector<uint32_t> masks;
+    mBvh.cullFrusta(viewProjs.data(), (uint32_t)viewProjs.size(), masks);
+    check(masks.size() == mBvh.getItemCount(), "multi-view culling returned " + std::to_string(masks.size()) + " masks, expected " + std::to_string(mBvh.getItemCount()));
+    for(uint32_t view = 0; view < (uint32_t)viewProjs.size(); view++)
+    {
+        std::vector<uint32_t> expected;
+        mBvh.cullFrustum(viewProjs[view], expected);
+        std::sort(expected.begin(), expected.end());
+
+        std::vector<uint32_t> visible;
+        for(uint32_t item = 0; item < (uint32_t)masks.size(); item++)
+        {
+            if(masks[item] & (1 << view))
+            {
+                visible.push_back(item);
+            }
+        }
+        check(visible == expected, "multi-view culling found " + std::to_string(visible.size()) + " visible instances in view " + std::to_string(view) + ", expected " + std::to_string(expected.size()));
+        check(expected.size() > 0, "view " + std::to_string(view) + " doesn't see any instance");
+    }
+
+    // Bits of views which weren't requested are never set
+    mBvh.cullFrusta(viewProjs.data(), 1, masks);
+    bool onlyFirstView = true;
+    for(uint32_t mask : masks)
+    {
+        onlyFirstView = onlyFirstView && (mask <= 1);
+    }
+    check(onlyFirstView, "single view culling set the bits of other views");
+
+    BoundingVolumeHierarchy emptyBvh;
+    emptyBvh.cullFrusta(viewProjs.data(), (uint32_t)viewProjs.size(), masks);
+    check(masks.empty(), "empty BVH returned multi-view masks");
+}
+
+void SceneBvhTest::benchmarkMultiView()
+{
+    // 2 eyes and 4 cascades, culled one view at a time and in a single traversal. Both produce the per-item view masks the scene renderer consumes.
+    const uint32_t kFrameCount = 20;
+    std::vector<glm::mat4> viewProjs;
+    createStereoAndCascadeViews(viewProjs);
+
+    std::vector<uint32_t> visible;
+    std::vector<uint32_t> perViewMasks;
+    auto start = CpuTimer::getCurrentTimePoint();
+    for(uint32_t frame = 0; frame < kFrameCount; frame++)
+    {
+        perViewMasks.assign(mBvh.getItemCount(), 0);
+        for(uint32_t view = 0; view < (uint32_t)viewProjs.size(); view++)
+        {
+            mBvh.cullFrustum(viewProjs[view], visible);
+            for(uint32_t item : visible)
+            {
+                perViewMasks[item] |= (1 << view);
+            }
+        }
+    }
+    float perViewTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) / kFrameCount;
+
+    std::vector<uint32_t> masks;
+    start = CpuTimer::getCurrentTimePoint();
+    for(uint32_t frame = 0; frame < kFrameCount; frame++)
+    {
+        mBvh.cullFrusta(viewProjs.data(), (uint32_t)viewProjs.size(), masks);
+    }
+    float multiViewTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) / kFrameCount;
+
+    size_t multiViewVisible = 0;
+    for(uint32_t mask : masks)
+    {
+        for(; mask; mask &= mask - 1)
+        {
+            multiViewVisible++;
+        }
+    }
+    check(masks == perViewMasks, "multi-view benchmark results mismatch");
+
+    Logger::log(Logger::Level::Info, "Culling " + std::to_string(mInstances.size()) + " instances for 2 eyes and 4 cascades (" + std::to_string(multiViewVisible) + " visible pairs): "
+        + std::to_string(perViewTime) + "ms per frame with a traversal per view, " + std::to_string(multiViewTime) + "ms per frame with a single traversal");
+}
+
+void SceneBvhTest::benchmark()
+{
+    const uint32_t kFrameCount = 20;
+    Camera* pCamera = mpCamera.get();
+
+    // The linear path transforms and tests every instance, as SceneRenderer used to do
+    uint32_t linearVisible = 0;
+    auto start = CpuTimer::getCurrentTimePoint();
+    for(uint32_t frame = 0; frame < kFrameCount; frame++)
+    {
+        linearVisible = 0;
+        for(const auto& instance : mInstances)
+        {
+            BoundingBox box = instance.objectBox.transform(instance.transform);
+            linearVisible += pCamera->isObjectCulled(box) ? 0 : 1;
+        }
+    }
+    float linearTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) / kFrameCount;
+
+    std::vector<uint32_t> visible;
+    start = CpuTimer::getCurrentTimePoint();
+    for(uint32_t frame = 0; frame < kFrameCount; frame++)
+    {
+        mBvh.cullFrustum(pCamera->getViewProjMatrix(), visible);
+    }
+    float bvhTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) / kFrameCount;
+
+    start = CpuTimer::getCurrentTimePoint();
+    buildBvh();
+    float buildTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+    // Refit after 1% of the instances moved
+    start = CpuTimer::getCurrentTimePoint();
+    for(uint32_t i = 0; i < (uint32_t)mInstances.size(); i += 100)
+    {
+        mBvh.updateItem(i, mInstances[i].objectBox.transform(mInstances[i].transform));
+    }
+    mBvh.refit();
+    float refitTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+    std::string msg = "Culling " + std::to_string(mInstances.size()) + " instances (" + std::to_string(visible.size()) + " visible): ";
+    msg += std::to_string(linearTime) + "ms per frame linear, " + std::to_string(bvhTime) + "ms per frame BVH. ";
+    msg += "BVH build " + std::to_string(buildTime) + "ms, refit of 1% of the instances " + std::to_string(refitTime) + "ms";
+    Logger::log(Logger::Level::Info, msg);
+    check(linearVisible == visible.size(), "benchmark visible count mismatch");
+}
+
+void SceneBvhTest::onLoad()
+{
+    createInstances(100000);
+    buildBvh();
+
+    mpCamera = Camera::create();
+    mpCamera->setAspectRatio(16.0f / 9.0f);
+    mpCamera->setDepthRange(0.1f, 500);
+    mpCamera->setPosition(glm::vec3(0, 10, 0));
+    mpCamera->setTarget(glm::vec3(1, 10, 1));
+    mpCamera->setUpVector(glm::vec3(0, 1, 0));
+    testCulling(mpCamera.get(), "perspective camera");
+
+    // Looking at the scene from the outside, so that the whole scene is inside the frustum
+    auto pFarCamera = Camera::create();
+    pFarCamera->setDepthRange(1, 10000);
+    pFarCamera->setPosition(glm::vec3(0, 5000, 0));
+    pFarCamera->setTarget(glm::vec3(0, 0, 0));
+    pFarCamera->setUpVector(glm::vec3(0, 0, 1));
+    testCulling(pFarCamera.get(), "camera seeing the whole scene");
+
+    // Empty and single-item hierarchies
+    BoundingVolumeHierarchy emptyBvh;
+    std::vector<uint32_t> items;
+    emptyBvh.cullFrustum(mpCamera->getViewProjMatrix(), items);
+    check(items.empty(), "empty BVH returned visible items");
+
+    testRayPicking();
+    testBoxQuery();
+    testRefit();
+    testMultiViewCulling();
+    benchmark();
+    benchmarkMultiView();
+
+    finishTests("scene BVH");
+}
+
+int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPSTR lpCmdLine, _In_ int nShowCmd)
+{
+    SceneBvhTest sceneBvhTest;
+    SampleConfig config;
+    sceneBvhTest.run(config);
+}
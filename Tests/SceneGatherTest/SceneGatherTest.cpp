@@ -0,0 +1,429 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "SceneGatherTest.h"
+#include "Utils/ThreadPool.h"
+#include "Utils/CpuTimer.h"
+#include "Utils/Math/RadixSort.h"
+#include <random>
+#include <map>
+#include <tuple>
+
+static const uint32_t kMeshesPerModel = 4;
+static const uint32_t kModelCount = 8;
+
+void SceneGatherTest::createScene(uint32_t modelInstanceCount)
+{
+    // The scene is described only by CPU data. The mesh and model pointers are never dereferenced by SceneDrawList.
+    std::mt19937 rng(2468);
+    std::uniform_real_distribution<float> position(-500, 500);
+    std::uniform_real_distribution<float> unit(0, 1);
+
+    mLods.resize(4);
+    for(uint32_t lod = 0; lod < 4; lod++)
+    {
+        mLods[lod].firstIndex = 0;
+        mLods[lod].indexCount = 3000 >> lod;
+        mLods[lod].error = lod ? 0.01f * float(1 << lod) : 0;
+    }
+
+    mMeshes.resize(kModelCount * kMeshesPerModel);
+    mMeshDescs.resize(mMeshes.size());
+    for(uint32_t mesh = 0; mesh < (uint32_t)mMeshes.size(); mesh++)
+    {
+        // Meshes have 1 to 8 instances, some of them skinned and some without LODs
+        TestMesh& testMesh = mMeshes[mesh];
+        uint32_t instanceCount = 1 + mesh % 8;
+        testMesh.instanceMatrices.resize(instanceCount);
+        testMesh.instanceBoxes.resize(instanceCount);
+        for(uint32_t i = 0; i < instanceCount; i++)
+        {
+            testMesh.instanceMatrices[i] = glm::translate(glm::mat4(), glm::vec3(float(i) * 3, 0, 0));
+            testMesh.instanceBoxes[i] = BoundingBox::fromMinMax(glm::vec3(-1), glm::vec3(1)).transform(testMesh.instanceMatrices[i]);
+        }
+
+        SceneDrawList::MeshDesc& desc = mMeshDescs[mesh];
+        desc.pMesh = reinterpret_cast<const Mesh*>(uintptr_t(mesh + 1));
+        desc.instanceCount = instanceCount;
+        desc.pInstanceMatrices = testMesh.instanceMatrices.data();
+        desc.pInstanceBoxes = testMesh.instanceBoxes.data();
+        desc.pLods = mLods.data();
+        desc.lodCount = (mesh % 5 == 0) ? 1 : 4;
+        desc.hasBones = (mesh % 7 == 3);
+    }
+
+    uint32_t itemCount = 0;
+    mModelInstances.resize(modelInstanceCount);
+    for(uint32_t i = 0; i < modelInstanceCount; i++)
+    {
+        uint32_t model = i % kModelCount;
+        SceneDrawList::ModelInstanceDesc& desc = mModelInstances[i];
+        desc.pModel = reinterpret_cast<const Model*>(uintptr_t(model + 1));
+        desc.transform = glm::translate(glm::mat4(), glm::vec3(position(rng), position(rng), position(rng))) * glm::scale(glm::mat4(), glm::vec3(0.5f + unit(rng)));
+        desc.firstMesh = model * kMeshesPerModel;
+        desc.meshCount = kMeshesPerModel;
+        desc.firstVisibilityItem = itemCount;
+        for(uint32_t mesh = 0; mesh < kMeshesPerModel; mesh++)
+        {
+            itemCount += mMeshDescs[desc.firstMesh + mesh].instanceCount;
+        }
+    }
+
+    // Culling results of two views, only the first is drawn
+    mItemViewMasks.resize(itemCount);
+    for(uint32_t i = 0; i < itemCount; i++)
+    {
+        mItemViewMasks[i] = ((unit(rng) < 0.6f) ? 1 : 0) | ((unit(rng) < 0.5f) ? 2 : 0);
+    }
+
+    mView.pItemViewMasks = &mItemViewMasks;
+    mView.viewMask = 1;
+    mView.cameraPosition = glm::vec3(0);
+    mView.lodProjectionScale = 1000;
+    mView.maxPixelError = 1;
+    mView.maxInstanceCount = 4;
+}
+
+void SceneGatherTest::createWorldDataCache()
+{
+    // The same data as the scene's render proxies
+    mItemWorldMatrices.clear();
+    mItemWorldBoxes.clear();
+    for(const auto& modelInstance : mModelInstances)
+    {
+        for(uint32_t mesh = modelInstance.firstMesh; mesh < modelInstance.firstMesh + modelInstance.meshCount; mesh++)
+        {
+            const auto& desc = mMeshDescs[mesh];
+            for(uint32_t instance = 0; instance < desc.instanceCount; instance++)
+            {
+                mItemWorldMatrices.push_back(desc.hasBones ? modelInstance.transform : modelInstance.transform * desc.pInstanceMatrices[instance]);
+                mItemWorldBoxes.push_back(desc.pInstanceBoxes[instance].transform(modelInstance.transform));
+            }
+        }
+    }
+}
+
+void SceneGatherTest::testCorrectness()
+{
+    createScene(3000);
+    SceneDrawList drawList;
+    drawList.build(mModelInstances, mMeshDescs, mView, ThreadPool::getDefaultPool().get());
+
+    // Reference - the world matrices of every (model instance, mesh, LOD), in mesh instance order
+    using Key = std::tuple<uint32_t, uint32_t, uint32_t>;
+    std::map<Key, std::vector<glm::mat4>> expected;
+    for(uint32_t i = 0; i < (uint32_t)mModelInstances.size(); i++)
+    {
+        const auto& modelInstance = mModelInstances[i];
+        uint32_t item = modelInstance.firstVisibilityItem;
+        for(uint32_t mesh = modelInstance.firstMesh; mesh < modelInstance.firstMesh + modelInstance.meshCount; mesh++)
+        {
+            const auto& desc = mMeshDescs[mesh];
+            for(uint32_t instance = 0; instance < desc.instanceCount; instance++, item++)
+            {
+                if(mItemViewMasks[item] & mView.viewMask)
+                {
+                    glm::mat4 world = modelInstance.transform * desc.pInstanceMatrices[instance];
+                    BoundingBox worldBox = desc.pInstanceBoxes[instance].transform(modelInstance.transform);
+                    uint32_t lod = (desc.lodCount > 1) ? Mesh::selectLod(desc.pLods, desc.lodCount, worldBox, world, mView.cameraPosition, mView.lodProjectionScale, mView.maxPixelError) : 0;
+                    expected[Key(i, mesh, lod)].push_back(desc.hasBones ? modelInstance.transform : world);
+                }
+            }
+        }
+    }
+
+    std::map<Key, std::vector<glm::mat4>> result;
+    uint32_t lastModelInstance = 0;
+    bool isSorted = true;
+    bool isSizeValid = true;
+    for(const auto& draw : drawList.getDraws())
+    {
+        isSorted = isSorted && (draw.modelInstance >= lastModelInstance);
+        isSizeValid = isSizeValid && (draw.instanceCount > 0) && (draw.instanceCount <= mView.maxInstanceCount);
+        lastModelInstance = draw.modelInstance;
+        auto& matrices = result[Key(draw.modelInstance, draw.mesh, draw.lod)];
+        const glm::mat4* pWorld = &drawList.getWorldMatrices()[draw.firstInstance];
+        matrices.insert(matrices.end(), pWorld, pWorld + draw.instanceCount);
+    }
+
+    check(isSorted, "draws aren't sorted by model instance");
+    check(isSizeValid, "draw instance count is out of range");
+    check(result == expected, "draw list doesn't match the reference");
+
+    uint32_t lodUsage[4] = {};
+    for(const auto& entry : expected)
+    {
+        lodUsage[std::get<2>(entry.first)]++;
+    }
+    check(lodUsage[0] && lodUsage[1] && lodUsage[3], "the test scene doesn't exercise the LOD selection");
+
+    // Without culling, all the instances are drawn
+    SceneDrawList::ViewDesc view = mView;
+    view.pItemViewMasks = nullptr;
+    drawList.build(mModelInstances, mMeshDescs, view, ThreadPool::getDefaultPool().get());
+    check(drawList.getWorldMatrices().size() == mItemViewMasks.size(), "draw list without culling doesn't contain all the instances");
+
+    // An empty scene
+    drawList.build(std::vector<SceneDrawList::ModelInstanceDesc>(), mMeshDescs, mView, nullptr);
+    check(drawList.getDraws().empty() && drawList.getWorldMatrices().empty(), "empty scene produced draws");
+}
+
+void SceneGatherTest::testDeterminism()
+{
+    createScene(5000);
+    SceneDrawList serial;
+    serial.build(mModelInstances, mMeshDescs, mView, nullptr);
+
+    uint32_t workerCounts[] = {1, 3, 7};
+    for(uint32_t workers : workerCounts)
+    {
+        auto pPool = ThreadPool::create(workers);
+        SceneDrawList parallel;
+        parallel.build(mModelInstances, mMeshDescs, mView, pPool.get());
+
+        const auto& a = serial.getDraws();
+        const auto& b = parallel.getDraws();
+        bool drawsMatch = (a.size() == b.size()) && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(a[0])) == 0);
+        check(drawsMatch, "draws built with " + std::to_string(workers) + " workers differ from the serial result");
+        check(serial.getWorldMatrices() == parallel.getWorldMatrices(), "matrices built with " + std::to_string(workers) + " workers differ from the serial result");
+    }
+}
+
+void SceneGatherTest::testCachedWorldData()
+{
+    // Reading the cached world data must produce the same list as calculating it
+    createScene(5000);
+    createWorldDataCache();
+    SceneDrawList reference;
+    reference.build(mModelInstances, mMeshDescs, mView, nullptr);
+
+    SceneDrawList::ViewDesc view = mView;
+    view.pItemWorldMatrices = mItemWorldMatrices.data();
+    view.pItemWorldBoxes = &mItemWorldBoxes;
+    SceneDrawList cached;
+    cached.build(mModelInstances, mMeshDescs, view, ThreadPool::getDefaultPool().get());
+
+    const auto& a = reference.getDraws();
+    const auto& b = cached.getDraws();
+    bool drawsMatch = (a.size() == b.size()) && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(a[0])) == 0);
+    check(drawsMatch, "draws built from the cached world data differ from the reference");
+    check(reference.getWorldMatrices() == cached.getWorldMatrices(), "matrices built from the cached world data differ from the reference");
+    check(reference.getVisibilityItems() == cached.getVisibilityItems(), "visibility items built from the cached world data differ from the reference");
+
+    // Every matrix comes from its visibility item
+    bool itemsMatch = true;
+    for(size_t i = 0; i < cached.getWorldMatrices().size(); i++)
+    {
+        itemsMatch = itemsMatch && (cached.getWorldMatrices()[i] == mItemWorldMatrices[cached.getVisibilityItems()[i]]);
+    }
+    check(itemsMatch, "visibility items don't match the world matrices");
+}
+
+void SceneGatherTest::testRadixSort()
+{
+    std::mt19937_64 rng(97531);
+    uint32_t counts[] = {0, 1, 2, 1000, 100000};
+    for(uint32_t count : counts)
+    {
+        // Full 64-bit keys, and keys with few distinct values so that passes are skipped and stability matters
+        for(uint64_t mask : {~0ull, 0x00ff00000000ff00ull})
+        {
+            std::vector<uint64_t> keys(count);
+            std::vector<uint32_t> values(count);
+            std::vector<std::pair<uint64_t, uint32_t>> expected(count);
+            for(uint32_t i = 0; i < count; i++)
+            {
+                keys[i] = rng() & mask;
+                values[i] = i;
+                expected[i] = std::make_pair(keys[i], i);
+            }
+            std::stable_sort(expected.begin(), expected.end(), [](const std::pair<uint64_t, uint32_t>& a, const std::pair<uint64_t, uint32_t>& b) { return a.first < b.first; });
+
+            RadixSort sorter;
+            sorter.sort(keys, values);
+            bool isCorrect = true;
+            for(uint32_t i = 0; i < count; i++)
+            {
+                isCorrect = isCorrect && (keys[i] == expected[i].first) && (values[i] == expected[i].second);
+            }
+            check(isCorrect, "radix sort of " + std::to_string(count) + " keys doesn't match std::stable_sort");
+        }
+    }
+}
+
+// Count the state changes of a draw sequence the way SceneRenderer does, with a material per 3 meshes
+static void countStateChanges(const std::vector<SceneDrawList::Draw>& draws, uint32_t& materialChanges, uint32_t& vaoChanges)
+{
+    materialChanges = 0;
+    vaoChanges = 0;
+    uint32_t material = uint32_t(-1);
+    uint32_t mesh = uint32_t(-1);
+    for(const auto& draw : draws)
+    {
+        materialChanges += (draw.mesh / 3 != material) ? 1 : 0;
+        vaoChanges += (draw.mesh != mesh) ? 1 : 0;
+        material = draw.mesh / 3;
+        mesh = draw.mesh;
+    }
+}
+
+void SceneGatherTest::testDrawSorting()
+{
+    createScene(3000);
+    for(uint32_t mesh = 0; mesh < (uint32_t)mMeshDescs.size(); mesh++)
+    {
+        mMeshDescs[mesh].sortKey = SceneDrawList::createSortKey(mMeshDescs[mesh].hasBones, 0, mesh / 3, mesh);
+    }
+
+    SceneDrawList drawList;
+    drawList.build(mModelInstances, mMeshDescs, mView, nullptr);
+    std::vector<SceneDrawList::Draw> unsorted = drawList.getDraws();
+    std::vector<glm::mat4> matrices = drawList.getWorldMatrices();
+    drawList.sort(mMeshDescs);
+    const auto& sorted = drawList.getDraws();
+
+    // The sort is a permutation of the draws, and leaves the matrices in place
+    check(sorted.size() == unsorted.size(), "sorting changed the draw count");
+    check(matrices == drawList.getWorldMatrices(), "sorting changed the world matrices");
+    std::vector<uint32_t> firstInstances;
+    for(const auto& draw : sorted)
+    {
+        firstInstances.push_back(draw.firstInstance);
+    }
+    std::sort(firstInstances.begin(), firstInstances.end());
+    bool isPermutation = true;
+    for(uint32_t i = 0; i < (uint32_t)unsorted.size() && i < (uint32_t)firstInstances.size(); i++)
+    {
+        isPermutation = isPermutation && (firstInstances[i] == unsorted[i].firstInstance);
+    }
+    check(isPermutation, "the sorted draws aren't a permutation of the draw list");
+
+    // Draws are grouped by state, skinned meshes last, and front to back within a state
+    bool isOrdered = true;
+    for(uint32_t i = 1; i < (uint32_t)sorted.size(); i++)
+    {
+        const auto& a = sorted[i - 1];
+        const auto& b = sorted[i];
+        const auto& meshA = mMeshDescs[a.mesh];
+        const auto& meshB = mMeshDescs[b.mesh];
+        isOrdered = isOrdered && (meshA.sortKey <= meshB.sortKey);
+        isOrdered = isOrdered && (meshA.hasBones == false || meshB.hasBones);
+        isOrdered = isOrdered && ((meshA.sortKey != meshB.sortKey) || (a.depth <= b.depth * 1.01f));
+    }
+    check(isOrdered, "the draws aren't sorted by key");
+
+    uint32_t unsortedMaterials, unsortedVaos, sortedMaterials, sortedVaos;
+    countStateChanges(unsorted, unsortedMaterials, unsortedVaos);
+    countStateChanges(sorted, sortedMaterials, sortedVaos);
+    check(sortedVaos == (uint32_t)mMeshDescs.size(), "sorted draws bind a VAO more than once");
+    check(sortedMaterials <= sortedVaos && sortedMaterials < unsortedMaterials, "sorting didn't reduce the material changes");
+
+    Logger::log(Logger::Level::Info, std::to_string(sorted.size()) + " draws. Material changes: " + std::to_string(unsortedMaterials) + " unsorted, " + std::to_string(sortedMaterials) + " sorted. VAO changes: "
+        + std::to_string(unsortedVaos) + " unsorted, " + std::to_string(sortedVaos) + " sorted.");
+}
+
+void SceneGatherTest::benchmark()
+{
+    const uint32_t kIterations = 10;
+    uint32_t modelInstanceCounts[] = {1000, 10000, 100000};
+    uint32_t threadCounts[] = {1, 2, 4, 8};
+    std::string sortMsg = "Draw sort time in ms (draws: time)";
+    std::string cachedMsg = "Single thread gather time in ms (mesh instances: calculated/cached world data)";
+
+    std::string msg = "Draw list gather time in ms (mesh instances: 1/2/4/8 threads)";
+    for(uint32_t modelInstanceCount : modelInstanceCounts)
+    {
+        createScene(modelInstanceCount);
+        msg += "\n" + std::to_string(mItemViewMasks.size()) + ":";
+        for(uint32_t threadCount : threadCounts)
+        {
+            // The calling thread participates in the work, so the pool needs one worker less
+            auto pPool = (threadCount > 1) ? ThreadPool::create(threadCount - 1) : nullptr;
+            SceneDrawList drawList;
+            drawList.build(mModelInstances, mMeshDescs, mView, pPool.get());
+
+            auto start = CpuTimer::getCurrentTimePoint();
+            for(uint32_t i = 0; i < kIterations; i++)
+            {
+                drawList.build(mModelInstances, mMeshDescs, mView, pPool.get());
+            }
+            float duration = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) / kIterations;
+            msg += " " + std::to_string(duration);
+        }
+
+        // Unchanged instances are read from the cache instead of being transformed again
+        createWorldDataCache();
+        SceneDrawList::ViewDesc cachedView = mView;
+        cachedView.pItemWorldMatrices = mItemWorldMatrices.data();
+        cachedView.pItemWorldBoxes = &mItemWorldBoxes;
+        float gatherTime[2];
+        for(uint32_t cached = 0; cached < 2; cached++)
+        {
+            SceneDrawList drawList;
+            auto start = CpuTimer::getCurrentTimePoint();
+            for(uint32_t i = 0; i < kIterations; i++)
+            {
+                drawList.build(mModelInstances, mMeshDescs, cached ? cachedView : mView, nullptr);
+            }
+            gatherTime[cached] = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) / kIterations;
+        }
+        cachedMsg += "\n" + std::to_string(mItemViewMasks.size()) + ": " + std::to_string(gatherTime[0]) + " " + std::to_string(gatherTime[1]);
+
+        SceneDrawList drawList;
+        drawList.build(mModelInstances, mMeshDescs, mView, nullptr);
+        drawList.sort(mMeshDescs);
+        auto start = CpuTimer::getCurrentTimePoint();
+        for(uint32_t i = 0; i < kIterations; i++)
+        {
+            drawList.sort(mMeshDescs);
+        }
+        float duration = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) / kIterations;
+        sortMsg += "\n" + std::to_string(drawList.getDraws().size()) + ": " + std::to_string(duration);
+    }
+    Logger::log(Logger::Level::Info, msg);
+    Logger::log(Logger::Level::Info, cachedMsg);
+    Logger::log(Logger::Level::Info, sortMsg);
+}
+
+void SceneGatherTest::onLoad()
+{
+    testCorrectness();
+    testDeterminism();
+    testCachedWorldData();
+    testRadixSort();
+    testDrawSorting();
+    benchmark();
+
+    finishTests("scene gather");
+}
+
+int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPSTR lpCmdLine, _In_ int nShowCmd)
+{
+    SceneGatherTest sceneGatherTest;
+    SampleConfig config;
+    sceneGatherTest.run(config);
+}
@@ -0,0 +1,280 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "ShaderCacheTest.h"
+#include <fstream>
+#include <cstdio>
+#include <thread>
+#include <chrono>
+#include "Utils/ShaderCache.h"
+#include "Utils/ShaderUtils.h"
+
+static const std::string kIncludeName = "ShaderCacheTestInclude.h";
+static const std::string kShaderCode =
+    "#version 440\n"
+    "#include \"" + kIncludeName + "\"\n"
+    "void main()\n"
+    "{\n"
+    "    gl_Position = vec4(getScale() * SCALE, 0, 0, 1);\n"
+    "}\n";
+
+void ShaderCacheTest::writeFile(const std::string& filename, const std::string& content)
+{
+    std::ofstream file(filename);
+    file << content;
+    check(file.good(), "can't write " + filename);
+}
+
+void ShaderCacheTest::createCacheDirectory()
+{
+    // Start from an empty cache, so that entries left by a previous run don't turn misses into hits
+    mDirectory = getExecutableDirectory() + "\\ShaderCacheTest";
+    std::vector<std::string> filenames;
+    enumerateFilesRecursive(mDirectory, filenames);
+    for(const auto& f : filenames)
+    {
+        std::remove(f.c_str());
+    }
+    ShaderCache::setDirectory(mDirectory);
+    check(ShaderCache::isEnabled(), "the cache wasn't enabled");
+
+    // The shader and its include live in the cache directory as well, which makes them easy to modify and clean up
+    mShaderFile = mDirectory + "\\ShaderCacheTest.vs";
+    mIncludeFile = mDirectory + "\\" + kIncludeName;
+    writeFile(mShaderFile, kShaderCode);
+    writeFile(mIncludeFile, "float getScale() { return 1; }\n");
+}
+
+void ShaderCacheTest::testSourceKeys()
+{
+    Program::DefineList defines;
+    defines.add("SCALE", "2");
+    Program::DefineList otherDefines;
+    otherDefines.add("SCALE", "3");
+    Program::DefineList moreDefines = defines;
+    moreDefines.add("_EXTRA");
+
+    const uint64_t key = ShaderCache::calculateSourceKey(mShaderFile, true, defines);
+    check(key == ShaderCache::calculateSourceKey(mShaderFile, true, defines), "the source key isn't deterministic");
+    check(key != ShaderCache::calculateSourceKey(mShaderFile, true, otherDefines), "the source key doesn't depend on the define values");
+    check(key != ShaderCache::calculateSourceKey(mShaderFile, true, moreDefines), "the source key doesn't depend on the define names");
+    check(key != ShaderCache::calculateSourceKey(mShaderFile, true, Program::DefineList()), "the source key doesn't depend on the defines");
+    check(key != ShaderCache::calculateSourceKey(mShaderFile, false, defines), "a shader file and a shader string have the same key");
+    check(key != ShaderCache::calculateSourceKey(mIncludeFile, true, defines), "the source key doesn't depend on the file");
+
+    // Moving characters between a define's name and value must change the key
+    Program::DefineList a, b;
+    a.add("AB", "C");
+    b.add("A", "BC");
+    check(ShaderCache::calculateSourceKey(mShaderFile, true, a) != ShaderCache::calculateSourceKey(mShaderFile, true, b), "the source key doesn't separate define names and values");
+}
+
+void ShaderCacheTest::testSourceCache()
+{
+    Program::DefineList defines;
+    defines.add("SCALE", "2");
+
+    ShaderCache::resetStats();
+    std::string first, second, errorMsg;
+    check(preprocessShader(mShaderFile, true, defines, first, errorMsg), "preprocessing failed: " + errorMsg);
+    ShaderCache::Stats stats = ShaderCache::getStats();
+    check(stats.sourceMisses == 1 && stats.sourceHits == 0, "the first preprocessing of a shader wasn't a miss");
+
+    check(preprocessShader(mShaderFile, true, defines, second, errorMsg), "preprocessing failed: " + errorMsg);
+    stats = ShaderCache::getStats();
+    check(stats.sourceMisses == 1 && stats.sourceHits == 1, "the second preprocessing of a shader wasn't a hit");
+    check(first == second, "the cached source is different from the preprocessed source");
+    check(second.find("getScale()") != std::string::npos, "the cached source doesn't contain the included file");
+
+    // The same shader with different defines is a different entry
+    Program::DefineList otherDefines;
+    otherDefines.add("SCALE", "3");
+    check(preprocessShader(mShaderFile, true, otherDefines, second, errorMsg), "preprocessing failed: " + errorMsg);
+    stats = ShaderCache::getStats();
+    check(stats.sourceMisses == 2 && stats.sourceHits == 1, "a shader with different defines wasn't a miss");
+    check(first != second, "shaders with different defines have the same source");
+
+    // Shader strings are cached as well
+    std::string fromString;
+    check(preprocessShader("#version 440\nvoid main() {}\n", false, defines, fromString, errorMsg), "preprocessing failed: " + errorMsg);
+    check(preprocessShader("#version 440\nvoid main() {}\n", false, defines, fromString, errorMsg), "preprocessing failed: " + errorMsg);
+    stats = ShaderCache::getStats();
+    check(stats.sourceHits == 2, "the second preprocessing of a shader string wasn't a hit");
+    check(stats.invalidations == 0, "unchanged shaders were invalidated");
+}
+
+void ShaderCacheTest::testIncludeInvalidation()
+{
+    Program::DefineList defines;
+    defines.add("SCALE", "2");
+
+    std::string before, after, errorMsg;
+    check(preprocessShader(mShaderFile, true, defines, before, errorMsg), "preprocessing failed: " + errorMsg);
+
+    ShaderCache::resetStats();
+    writeFile(mIncludeFile, "float getScale() { return 4; }\n");
+    check(preprocessShader(mShaderFile, true, defines, after, errorMsg), "preprocessing failed: " + errorMsg);
+    ShaderCache::Stats stats = ShaderCache::getStats();
+    check(stats.sourceMisses == 1 && stats.sourceHits == 0, "changing an included file didn't invalidate the source");
+    check(stats.invalidations == 1, "changing an included file wasn't counted as an invalidation");
+    check(after != before && after.find("return 4;") != std::string::npos, "the source wasn't preprocessed again after its include changed");
+
+    // The new source replaced the stale entry
+    check(preprocessShader(mShaderFile, true, defines, before, errorMsg), "preprocessing failed: " + errorMsg);
+    stats = ShaderCache::getStats();
+    check(stats.sourceHits == 1 && before == after, "the source wasn't cached again after it was invalidated");
+
+    // So does changing the shader file itself
+    writeFile(mShaderFile, kShaderCode + "// Changed\n");
+    check(preprocessShader(mShaderFile, true, defines, after, errorMsg), "preprocessing failed: " + errorMsg);
+    stats = ShaderCache::getStats();
+    check(stats.invalidations == 2 && after.find("// Changed") != std::string::npos, "changing the shader file didn't invalidate the source");
+}
+
+void ShaderCacheTest::testTouchedFiles()
+{
+    Program::DefineList defines;
+    defines.add("SCALE", "5");
+
+    std::string before, after, errorMsg;
+    check(preprocessShader(mShaderFile, true, defines, before, errorMsg), "preprocessing failed: " + errorMsg);
+
+    // Rewrite the include with the same content until its time changes
+    std::string include;
+    check(readFileToString(mIncludeFile, include), "can't read " + mIncludeFile);
+    uint64_t time = 0;
+    uint64_t touchedTime = 0;
+    check(getFileModifiedTime(mIncludeFile, time), "can't get the time of " + mIncludeFile);
+    for(uint32_t i = 0; (i < 100) && ((touchedTime == 0) || (touchedTime == time)); i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        writeFile(mIncludeFile, include);
+        getFileModifiedTime(mIncludeFile, touchedTime);
+    }
+    check(touchedTime != time, "rewriting " + mIncludeFile + " didn't change its time");
+
+    // The content is hashed again and didn't change, so the entry is still used
+    ShaderCache::resetStats();
+    check(preprocessShader(mShaderFile, true, defines, after, errorMsg), "preprocessing failed: " + errorMsg);
+    ShaderCache::Stats stats = ShaderCache::getStats();
+    check(stats.sourceHits == 1 && stats.invalidations == 0 && after == before, "touching an included file without changing it invalidated the source");
+
+    check(preprocessShader(mShaderFile, true, defines, after, errorMsg), "preprocessing failed: " + errorMsg);
+    stats = ShaderCache::getStats();
+    check(stats.sourceHits == 2 && stats.invalidations == 0, "the entry wasn't usable after it was updated with the new time");
+}
+
+void ShaderCacheTest::testProgramKeys()
+{
+    std::string sources[(uint32_t)ShaderType::Count];
+    sources[(uint32_t)ShaderType::Vertex] = "vertex";
+    sources[(uint32_t)ShaderType::Fragment] = "fragment";
+
+    const uint64_t key = ShaderCache::calculateProgramKey(sources, "Driver 1.0");
+    check(key == ShaderCache::calculateProgramKey(sources, "Driver 1.0"), "the program key isn't deterministic");
+    check(key != ShaderCache::calculateProgramKey(sources, "Driver 1.1"), "the program key doesn't depend on the compiler identity");
+
+    std::string changed[(uint32_t)ShaderType::Count];
+    std::copy(sources, sources + (uint32_t)ShaderType::Count, changed);
+    changed[(uint32_t)ShaderType::Fragment] += " ";
+    check(key != ShaderCache::calculateProgramKey(changed, "Driver 1.0"), "the program key doesn't depend on the sources");
+
+    // The same code in a different stage is a different program
+    std::string swapped[(uint32_t)ShaderType::Count];
+    swapped[(uint32_t)ShaderType::Vertex] = "vertex";
+    swapped[(uint32_t)ShaderType::Geometry] = "fragment";
+    check(key != ShaderCache::calculateProgramKey(swapped, "Driver 1.0"), "the program key doesn't depend on the stages");
+}
+
+void ShaderCacheTest::testBinaryCache()
+{
+    std::string sources[(uint32_t)ShaderType::Count];
+    sources[(uint32_t)ShaderType::Vertex] = "vertex";
+    sources[(uint32_t)ShaderType::Fragment] = "fragment";
+    const uint64_t key = ShaderCache::calculateProgramKey(sources, "Driver 1.0");
+    const uint64_t otherDriverKey = ShaderCache::calculateProgramKey(sources, "Driver 1.1");
+
+    std::vector<uint8_t> binary(1000);
+    for(size_t i = 0; i < binary.size(); i++)
+    {
+        binary[i] = (uint8_t)(i * 7);
+    }
+
+    ShaderCache::resetStats();
+    uint32_t format = 0;
+    std::vector<uint8_t> loaded;
+    check(ShaderCache::loadBinary(key, format, loaded) == false, "a binary was found before it was stored");
+
+    ShaderCache::storeBinary(key, 0x1234, binary);
+    check(ShaderCache::loadBinary(key, format, loaded), "a stored binary wasn't found");
+    check(format == 0x1234 && loaded == binary, "the loaded binary is different from the stored binary");
+    check(ShaderCache::loadBinary(otherDriverKey, format, loaded) == false, "a binary was found for a different driver");
+
+    ShaderCache::Stats stats = ShaderCache::getStats();
+    check(stats.binaryHits == 1 && stats.binaryMisses == 2, "wrong binary statistics");
+}
+
+void ShaderCacheTest::testDisabledCache()
+{
+    ShaderCache::setDirectory("");
+    check(ShaderCache::isEnabled() == false, "the cache wasn't disabled");
+
+    ShaderCache::resetStats();
+    Program::DefineList defines;
+    defines.add("SCALE", "2");
+    std::string source, errorMsg;
+    check(preprocessShader(mShaderFile, true, defines, source, errorMsg), "preprocessing failed: " + errorMsg);
+    check(preprocessShader(mShaderFile, true, defines, source, errorMsg), "preprocessing failed: " + errorMsg);
+
+    uint32_t format;
+    std::vector<uint8_t> binary;
+    check(ShaderCache::loadBinary(0, format, binary) == false, "a binary was found in a disabled cache");
+
+    ShaderCache::Stats stats = ShaderCache::getStats();
+    check(stats.sourceHits == 0 && stats.sourceMisses == 0 && stats.binaryMisses == 0, "a disabled cache was used");
+}
+
+void ShaderCacheTest::onLoad()
+{
+    createCacheDirectory();
+    testSourceKeys();
+    testSourceCache();
+    testIncludeInvalidation();
+    testTouchedFiles();
+    testProgramKeys();
+    testBinaryCache();
+    testDisabledCache();
+
+    finishTests("shader cache");
+}
+
+int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPSTR lpCmdLine, _In_ int nShowCmd)
+{
+    ShaderCacheTest shaderCacheTest;
+    SampleConfig config;
+    shaderCacheTest.run(config);
+}
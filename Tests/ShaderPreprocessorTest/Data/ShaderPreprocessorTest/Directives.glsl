@@ -0,0 +1,19 @@
+#version 440
+#expect LIGHT_COUNT The number of lights
+#include "PreprocA.h"
+#expect _SHADOWS Whether to sample the shadow map
+
+#foreach (name, value) in (red, 1), (green, 2)
+const float $(name) = $(value) * getA();
+#endforeach
+
+#for (int i = 0; i < LIGHT_COUNT; ++i)
+uniform vec3 gLight$(i);
+#endfor
+
+void main()
+{
+#ifdef _SHADOWS
+    gl_Position = vec4(red, green, 0, 1);
+#endif
+}
@@ -0,0 +1,21 @@
+#version 440
+// Root shader of the include golden test
+#include "PreprocA.h"
+#include "Sub/PreprocB.h"
+// #include "Missing.h" is commented out
+/* So is this one
+#include "Missing.h"
+*/
+#include "PreprocA.h"
+
+float repeated = 0.0
+#include "PreprocRepeated.h"
+#include "PreprocRepeated.h"
+    ;
+
+    #include "Sub/../PreprocC.h"
+
+void main()
+{
+    gl_Position = vec4(getA() + getB() + getC() + repeated, 0, 0, 1);
+}
@@ -0,0 +1,9 @@
+#pragma once
+/* Included first, includes B.
+*/
+#include "Sub/PreprocB.h"
+
+float getA()
+{
+    return getB() * 2.0; // #include "Missing.h"
+}
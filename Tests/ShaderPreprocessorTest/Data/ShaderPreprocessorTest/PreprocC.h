@@ -0,0 +1,3 @@
+#pragma once
+// No newline at the end of this file
+float getC() { return 0.5; }
\ No newline at end of file
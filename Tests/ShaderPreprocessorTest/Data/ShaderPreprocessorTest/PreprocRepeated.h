@@ -0,0 +1,2 @@
+    // No pragma once, included twice
+    + 1.0
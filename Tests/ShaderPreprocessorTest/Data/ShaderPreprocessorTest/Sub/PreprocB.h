@@ -0,0 +1,7 @@
+#pragma once
+#include "../PreprocC.h"
+
+float getB()
+{
+    return getC() + 1.0;
+}
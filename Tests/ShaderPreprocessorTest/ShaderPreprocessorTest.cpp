@@ -0,0 +1,175 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "ShaderPreprocessorTest.h"
+#include <fstream>
+#include "Utils/ShaderPreprocessor.h"
+#include <algorithm>
+#include "Utils/StringUtils.h"
+#include "Utils/CpuTimer.h"
+
+static const uint32_t kBenchmarkIncludeCount = 500;
+
+void ShaderPreprocessorTest::writeFile(const std::string& filename, const std::string& content)
+{
+    std::ofstream file(filename);
+    file << content;
+    check(file.good(), "can't write " + filename);
+}
+
+bool ShaderPreprocessorTest::preprocess(const std::string& filename, const Program::DefineList& defines, std::string& shader, std::vector<std::string>& includedFiles)
+{
+    std::string fullpath;
+    if(findFileInDataDirectories(filename, fullpath) == false)
+    {
+        check(false, "can't find " + filename);
+        return false;
+    }
+
+    std::string errorMsg;
+    readFileToString(fullpath, shader);
+    bool result = ShaderPreprocessor::parseShader(fullpath, shader, errorMsg, defines, &includedFiles);
+    check(result, "preprocessing " + filename + " failed. " + errorMsg);
+    return result;
+}
+
+void ShaderPreprocessorTest::testGoldenOutput(const std::string& shaderName, const Program::DefineList& defines, uint32_t expectedIncludeCount)
+{
+    // The golden files were written by the preprocessor which spliced the includes into the shader one by one. The single-pass preprocessor must produce the same code.
+    const std::string filename = "ShaderPreprocessorTest\\" + shaderName + ".glsl";
+    std::string shader;
+    std::vector<std::string> includedFiles;
+    if(preprocess(filename, defines, shader, includedFiles) == false)
+    {
+        return;
+    }
+    check(includedFiles.size() == expectedIncludeCount, shaderName + " included " + std::to_string(includedFiles.size()) + " files instead of " + std::to_string(expectedIncludeCount));
+
+    // Line directives contain absolute paths, which the golden files replace with <DIR>
+    std::string fullpath;
+    findFileInDataDirectories(filename, fullpath);
+    const std::string directory = replaceSubstring(getDirectoryFromFile(fullpath), "\\", "/");
+    shader = replaceSubstring(shader, directory, "<DIR>");
+
+    std::string goldenFile, golden;
+    check(findFileInDataDirectories("ShaderPreprocessorTest\\" + shaderName + ".golden", goldenFile) && readFileToString(goldenFile, golden), "can't read the golden output of " + shaderName);
+
+    if(shader != golden)
+    {
+        // Report the first line which is different
+        size_t offset = 0;
+        while(offset < shader.size() && offset < golden.size() && shader[offset] == golden[offset])
+        {
+            offset++;
+        }
+        const size_t lineStart = (offset == 0) ? 0 : shader.rfind('\n', offset - 1) + 1;
+        const size_t line = std::count(shader.begin(), shader.begin() + lineStart, '\n') + 1;
+        auto getLine = [lineStart](const std::string& code) { return code.substr(lineStart, code.find('\n', lineStart) - lineStart); };
+        check(false, shaderName + " line " + std::to_string(line) + " is different from the golden output. Expected '" + getLine(golden) + "', got '" + getLine(shader) + "'");
+    }
+}
+
+void ShaderPreprocessorTest::testFileChange()
+{
+    // Parsed files are cached between calls. Changing a file, even without changing its size, must be picked up.
+    const std::string shaderFile = mTempDirectory + "\\ChangedRoot.glsl";
+    const std::string includeFile = mTempDirectory + "\\Changed.h";
+    writeFile(shaderFile, "#version 440\n#include \"Changed.h\"\n");
+
+    std::string shader;
+    std::vector<std::string> includedFiles;
+    writeFile(includeFile, "float value = 1.0;\n");
+    preprocess(shaderFile, Program::DefineList(), shader, includedFiles);
+    check(shader.find("value = 1.0;") != std::string::npos, "the include wasn't added to the shader");
+
+    writeFile(includeFile, "float value = 2.0;\n");
+    preprocess(shaderFile, Program::DefineList(), shader, includedFiles);
+    check(shader.find("value = 2.0;") != std::string::npos, "a change to an included file was ignored");
+}
+
+void ShaderPreprocessorTest::benchmarkIncludeTree()
+{
+    // A shader which includes many files, which all include the same header
+    std::string body;
+    for(uint32_t i = 0; i < 40; i++)
+    {
+        body += "    vec4 value" + std::to_string(i) + " = vec4(" + std::to_string(i) + ".0); // Filler line\n";
+    }
+    writeFile(mTempDirectory + "\\Common.h", "#pragma once\n/* Shared by all the includes */\nfloat common() { return 1.0; }\n");
+
+    std::string root = "#version 440\n";
+    for(uint32_t i = 0; i < kBenchmarkIncludeCount; i++)
+    {
+        const std::string name = "Include" + std::to_string(i) + ".h";
+        writeFile(mTempDirectory + "\\" + name, "#pragma once\n#include \"Common.h\"\nvoid func" + std::to_string(i) + "()\n{\n" + body + "}\n");
+        root += "#include \"" + name + "\"\n";
+    }
+    root += "void main() {}\n";
+    const std::string rootFile = mTempDirectory + "\\IncludeTree.glsl";
+    writeFile(rootFile, root);
+
+    // The first run parses all the files, the next ones find them in the cache
+    float duration[3];
+    std::string shader;
+    std::vector<std::string> includedFiles;
+    for(uint32_t i = 0; i < arraysize(duration); i++)
+    {
+        auto start = CpuTimer::getCurrentTimePoint();
+        preprocess(rootFile, Program::DefineList(), shader, includedFiles);
+        duration[i] = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+    }
+
+    check(includedFiles.size() == kBenchmarkIncludeCount + 1, "the include tree included " + std::to_string(includedFiles.size()) + " files");
+    check(shader.find("void func" + std::to_string(kBenchmarkIncludeCount - 1) + "()") != std::string::npos, "the last include is missing");
+
+    std::string msg = "Preprocessing a shader with " + std::to_string(kBenchmarkIncludeCount) + " includes (" + std::to_string(shader.size() / 1024) + "KB): ";
+    msg += std::to_string(duration[0]) + "ms for the first run, " + std::to_string(std::min(duration[1], duration[2])) + "ms with parsed files cached.";
+    Logger::log(Logger::Level::Info, msg);
+}
+
+void ShaderPreprocessorTest::onLoad()
+{
+    mTempDirectory = getExecutableDirectory() + "\\ShaderPreprocessorTest";
+    check(createDirectory(mTempDirectory), "can't create " + mTempDirectory);
+
+    Program::DefineList defines;
+    testGoldenOutput("Includes", defines, 4);
+    defines.add("LIGHT_COUNT", "2");
+    defines.add("_SHADOWS");
+    testGoldenOutput("Directives", defines, 3);
+    testFileChange();
+    benchmarkIncludeTree();
+
+    finishTests("shader preprocessor");
+}
+
+int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPSTR lpCmdLine, _In_ int nShowCmd)
+{
+    ShaderPreprocessorTest shaderPreprocessorTest;
+    SampleConfig config;
+    shaderPreprocessorTest.run(config);
+}
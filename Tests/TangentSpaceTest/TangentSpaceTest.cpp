@@ -0,0 +1,238 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "TangentSpaceTest.h"
+#include "Graphics/Model/TangentSpace.h"
+#include "Utils/CpuTimer.h"
+
+static std::string toString(const glm::vec3& v)
+{
+    return "(" + std::to_string(v.x) + ", " + std::to_string(v.y) + ", " + std::to_string(v.z) + ")";
+}
+
+static bool isClose(const glm::vec3& a, const glm::vec3& b, float minCos)
+{
+    return glm::dot(a, b) >= minCos && std::abs(glm::length(a) - 1) < 1e-4f;
+}
+
+void TangentSpaceTest::createGrid(uint32_t size, bool mirrorU, TestMesh& mesh)
+{
+    // A plane in XY facing +Z. When mirroring, the right half of the grid reuses the UVs of the left half.
+    for(uint32_t y = 0; y <= size; y++)
+    {
+        for(uint32_t x = 0; x <= size; x++)
+        {
+            float u = float(x) / float(size);
+            if(mirrorU && (x * 2 > size))
+            {
+                u = 1 - u;
+            }
+            mesh.positions.push_back(glm::vec3(float(x), float(y), 0));
+            mesh.normals.push_back(glm::vec3(0, 0, 1));
+            mesh.texCrds.push_back(glm::vec2(u, float(y) / float(size)));
+        }
+    }
+
+    for(uint32_t y = 0; y < size; y++)
+    {
+        for(uint32_t x = 0; x < size; x++)
+        {
+            uint32_t v0 = y * (size + 1) + x;
+            uint32_t v1 = v0 + 1;
+            uint32_t v2 = v0 + size + 1;
+            uint32_t v3 = v2 + 1;
+            uint32_t quad[6] = {v0, v1, v2, v2, v1, v3};
+            mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+        }
+    }
+}
+
+void TangentSpaceTest::createSphere(uint32_t rings, uint32_t segments, TestMesh& mesh)
+{
+    // A unit UV-sphere. U follows the longitude, V follows the latitude from the north pole. The seam vertices are duplicated.
+    for(uint32_t r = 0; r <= rings; r++)
+    {
+        for(uint32_t s = 0; s <= segments; s++)
+        {
+            float u = float(s) / float(segments);
+            float v = float(r) / float(rings);
+            float phi = u * 2 * glm::pi<float>();
+            float theta = v * glm::pi<float>();
+            glm::vec3 p(sin(theta) * cos(phi), sin(theta) * sin(phi), cos(theta));
+            mesh.positions.push_back(p);
+            mesh.normals.push_back(p);
+            mesh.texCrds.push_back(glm::vec2(u, v));
+        }
+    }
+
+    for(uint32_t r = 0; r < rings; r++)
+    {
+        for(uint32_t s = 0; s < segments; s++)
+        {
+            uint32_t v0 = r * (segments + 1) + s;
+            uint32_t v1 = v0 + 1;
+            uint32_t v2 = v0 + segments + 1;
+            uint32_t v3 = v2 + 1;
+            uint32_t quad[6] = {v0, v2, v1, v1, v2, v3};
+            mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+        }
+    }
+}
+
+void TangentSpaceTest::generate(TestMesh& mesh, bool runInParallel)
+{
+    TangentSpaceInput input;
+    input.pPositions = mesh.positions.data();
+    input.positionStride = sizeof(glm::vec3);
+    input.pNormals = mesh.normals.data();
+    input.normalStride = sizeof(glm::vec3);
+    input.pTexCrds = mesh.texCrds.data();
+    input.texCrdStride = sizeof(glm::vec2);
+    input.pIndices = mesh.indices.data();
+    input.indexCount = (uint32_t)mesh.indices.size();
+    input.vertexCount = (uint32_t)mesh.positions.size();
+
+    mesh.tangents.resize(mesh.positions.size());
+    mesh.bitangents.resize(mesh.positions.size());
+    generateTangentSpace(input, mesh.tangents.data(), mesh.bitangents.data(), runInParallel);
+}
+
+void TangentSpaceTest::testPlane()
+{
+    TestMesh mesh;
+    createGrid(7, false, mesh);
+    generate(mesh, true);
+
+    for(size_t i = 0; i < mesh.positions.size(); i++)
+    {
+        check(isClose(mesh.tangents[i], glm::vec3(1, 0, 0), 0.9999f), "plane tangent " + std::to_string(i) + " is " + toString(mesh.tangents[i]));
+        check(isClose(mesh.bitangents[i], glm::vec3(0, 1, 0), 0.9999f), "plane bitangent " + std::to_string(i) + " is " + toString(mesh.bitangents[i]));
+    }
+}
+
+void TangentSpaceTest::testMirroredUVs()
+{
+    // The mirrored half must get a flipped tangent and keep the bitangent, so the frame's handedness flips
+    const uint32_t kSize = 8;
+    TestMesh mesh;
+    createGrid(kSize, true, mesh);
+    generate(mesh, true);
+
+    for(size_t i = 0; i < mesh.positions.size(); i++)
+    {
+        uint32_t x = uint32_t(mesh.positions[i].x);
+        if(x * 2 == kSize)
+        {
+            // The seam is shared by both halves
+            continue;
+        }
+
+        glm::vec3 expectedTangent = (x * 2 > kSize) ? glm::vec3(-1, 0, 0) : glm::vec3(1, 0, 0);
+        check(isClose(mesh.tangents[i], expectedTangent, 0.9999f), "mirrored tangent " + std::to_string(i) + " is " + toString(mesh.tangents[i]));
+        check(isClose(mesh.bitangents[i], glm::vec3(0, 1, 0), 0.9999f), "mirrored bitangent " + std::to_string(i) + " is " + toString(mesh.bitangents[i]));
+
+        float handedness = glm::dot(glm::cross(mesh.normals[i], mesh.tangents[i]), mesh.bitangents[i]);
+        check((handedness < 0) == (x * 2 > kSize), "mirrored handedness " + std::to_string(i));
+    }
+}
+
+void TangentSpaceTest::testSphere()
+{
+    // Compare against the analytic derivatives of the sphere's parameterization. The poles are singular, so skip them.
+    // The seam vertices only see the triangles on one side, which tilts their frame by half a segment. Skip them as well.
+    const uint32_t kRings = 32;
+    const uint32_t kSegments = 64;
+    TestMesh mesh;
+    createSphere(kRings, kSegments, mesh);
+    generate(mesh, true);
+
+    for(uint32_t r = 1; r < kRings; r++)
+    {
+        for(uint32_t s = 1; s < kSegments; s++)
+        {
+            uint32_t i = r * (kSegments + 1) + s;
+            float phi = mesh.texCrds[i].x * 2 * glm::pi<float>();
+            float theta = mesh.texCrds[i].y * glm::pi<float>();
+            glm::vec3 dPdU(-sin(phi), cos(phi), 0);
+            glm::vec3 dPdV(cos(theta) * cos(phi), cos(theta) * sin(phi), -sin(theta));
+
+            check(isClose(mesh.tangents[i], dPdU, 0.999f), "sphere tangent " + std::to_string(i) + " is " + toString(mesh.tangents[i]) + ", expected " + toString(dPdU));
+            check(isClose(mesh.bitangents[i], dPdV, 0.999f), "sphere bitangent " + std::to_string(i) + " is " + toString(mesh.bitangents[i]) + ", expected " + toString(dPdV));
+            check(std::abs(glm::dot(mesh.tangents[i], mesh.normals[i])) < 1e-4f, "sphere tangent " + std::to_string(i) + " isn't perpendicular to the normal");
+        }
+    }
+}
+
+void TangentSpaceTest::testParallel()
+{
+    // The result must not depend on the way the work is split between threads
+    TestMesh serial;
+    createSphere(200, 300, serial);
+    TestMesh parallel = serial;
+    generate(serial, false);
+    generate(parallel, true);
+
+    check(serial.tangents == parallel.tangents, "parallel tangents don't match the serial result");
+    check(serial.bitangents == parallel.bitangents, "parallel bitangents don't match the serial result");
+}
+
+void TangentSpaceTest::benchmark()
+{
+    TestMesh mesh;
+    createGrid(1500, false, mesh);
+
+    float duration[2];
+    for(uint32_t i = 0; i < 2; i++)
+    {
+        bool runInParallel = (i == 1);
+        auto start = CpuTimer::getCurrentTimePoint();
+        generate(mesh, runInParallel);
+        duration[i] = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+    }
+
+    std::string msg = "Tangent space generation for " + std::to_string(mesh.indices.size() / 3) + " triangles: ";
+    msg += std::to_string(duration[0]) + "ms serial, " + std::to_string(duration[1]) + "ms parallel";
+    Logger::log(Logger::Level::Info, msg);
+}
+
+void TangentSpaceTest::onLoad()
+{
+    testPlane();
+    testMirroredUVs();
+    testSphere();
+    testParallel();
+    benchmark();
+
+    finishTests("tangent space");
+}
+
+int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPSTR lpCmdLine, _In_ int nShowCmd)
+{
+    TangentSpaceTest tangentSpaceTest;
+    SampleConfig config;
+    tangentSpaceTest.run(config);
+}
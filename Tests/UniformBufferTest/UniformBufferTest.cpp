@@ -26,6 +26,79 @@
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ***************************************************************************/
 #include "UniformBufferTest.h"
+#include <cstring>
+#include <random>
+
+using namespace ShaderReflection;
+
+// Creates variables laid out like a large std140 buffer: scalars, vectors, matrices and arrays of them
+static VariableDescMap createVariables(uint32_t count, size_t& bufferSize)
+{
+    std::mt19937 rng(1234);
+    VariableDescMap variables;
+    size_t offset = 0;
+    for(uint32_t i = 0; i < count; i++)
+    {
+        VariableDesc desc;
+        size_t size;
+        switch(rng() % 4)
+        {
+        case 0:
+            desc.type = VariableDesc::Type::Float;
+            size = 4;
+            break;
+        case 1:
+            desc.type = VariableDesc::Type::Float4;
+            size = 16;
+            break;
+        case 2:
+            desc.type = VariableDesc::Type::Float4x4;
+            size = 64;
+            break;
+        default:
+            // Array elements are aligned to 16 bytes
+            desc.type = (rng() % 2) ? VariableDesc::Type::Float : VariableDesc::Type::Float4x4;
+            desc.arraySize = 1 + rng() % 8;
+            desc.arrayStride = (desc.type == VariableDesc::Type::Float) ? 16 : 64;
+            size = desc.arraySize * desc.arrayStride;
+            break;
+        }
+
+        size_t alignment = (size < 16) ? 4 : 16;
+        offset = (offset + alignment - 1) / alignment * alignment;
+        desc.offset = offset;
+        variables["var" + std::to_string(i)] = desc;
+        offset += size;
+    }
+    bufferSize = offset;
+    return variables;
+}
+
+// The linear search which the offset index replaced
+static const std::string* findVariableLinear(const VariableDescMap& variables, size_t offset, uint32_t& arrayIndex)
+{
+    for(const auto& a : variables)
+    {
+        const auto& data = a.second;
+        size_t index = 0;
+        bool match = (data.offset == offset);
+        if(data.arrayStride > 0 && offset > data.offset)
+        {
+            size_t stride = offset - data.offset;
+            if((stride % data.arrayStride) == 0)
+            {
+                index = stride / data.arrayStride;
+                match = match || (index < data.arraySize);
+            }
+        }
+        if(match)
+        {
+            arrayIndex = (uint32_t)index;
+            return &a.first;
+        }
+    }
+    return nullptr;
+}
 
 template <bool shouldFail>
 void UniformBufferTest::test(const std::string& var)
@@ -131,9 +204,231 @@ void UniformBufferTest::onLoad()
     success("st2[0][0].st[2][1].F");
     success("st2[0][0].v3[1][1][1]");
 
+    testOffsetIndex();
+    benchmarkSetters();
+    testDirtyRanges();
+    testPartialUpload();
+
     shutdownApp();
 }
 
+void UniformBufferTest::testOffsetIndex()
+{
+    size_t bufferSize;
+    VariableDescMap variables = createVariables(500, bufferSize);
+    VariableOffsetIndex index;
+    index.build(variables);
+
+    // Every offset, including the ones inside variables and past the end, must give the same result as the linear search
+    uint32_t errorCount = 0;
+    for(size_t offset = 0; offset < bufferSize + 64; offset++)
+    {
+        uint32_t expectedIndex = 0;
+        uint32_t arrayIndex = 0;
+        const std::string* pExpected = findVariableLinear(variables, offset, expectedIndex);
+        const VariableOffsetIndex::Entry* pEntry = index.find(offset, arrayIndex);
+        bool same = (pExpected == nullptr) ? (pEntry == nullptr) : (pEntry && (pEntry->name == *pExpected) && (arrayIndex == expectedIndex));
+        if(same == false)
+        {
+            errorCount++;
+        }
+    }
+    if(errorCount)
+    {
+        Logger::log(Logger::Level::Error, "Test failed for the variable offset index. " + std::to_string(errorCount) + " offsets were resolved differently than by the linear search.");
+    }
+
+    // The predicate can skip a variable which shares its offset with another one
+    VariableDescMap shared;
+    shared["a"].offset = 16;
+    shared["b"].offset = 16;
+    shared["b"].type = VariableDesc::Type::Resource;
+    index.build(shared);
+    uint32_t arrayIndex;
+    const VariableOffsetIndex::Entry* pEntry = index.find(16, arrayIndex, [](const VariableOffsetIndex::Entry& e) { return e.desc.type != VariableDesc::Type::Resource; });
+    if((pEntry == nullptr) || (pEntry->name != "a") || index.find(0, arrayIndex) || index.find(17, arrayIndex))
+    {
+        Logger::log(Logger::Level::Error, "Test failed for the variable offset index predicate");
+    }
+}
+
+void UniformBufferTest::benchmarkSetters()
+{
+    const uint32_t kIterations = 1000000;
+
+    // Validating an offset, using the index and using the linear search
+    size_t bufferSize;
+    VariableDescMap variables = createVariables(1000, bufferSize);
+    VariableOffsetIndex index;
+    index.build(variables);
+    std::vector<size_t> offsets;
+    for(const auto& v : variables)
+    {
+        offsets.push_back(v.second.offset);
+    }
+
+    size_t found = 0;
+    uint32_t arrayIndex;
+    auto start = CpuTimer::getCurrentTimePoint();
+    for(uint32_t i = 0; i < kIterations; i++)
+    {
+        found += index.find(offsets[i % offsets.size()], arrayIndex) ? 1 : 0;
+    }
+    float indexDuration = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+    const uint32_t kLinearIterations = kIterations / 100;
+    start = CpuTimer::getCurrentTimePoint();
+    for(uint32_t i = 0; i < kLinearIterations; i++)
+    {
+        found += findVariableLinear(variables, offsets[i % offsets.size()], arrayIndex) ? 1 : 0;
+    }
+    float linearDuration = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+    if(found != kIterations + kLinearIterations)
+    {
+        Logger::log(Logger::Level::Error, "Test failed for the variable offset index benchmark. Some of the variables weren't found.");
+    }
+
+    // The setters of the test buffer. setBlob() doesn't validate the variable.
+    size_t offset = mpBuffer->getVariableOffset("st2[1][3].st[2][4].F");
+    float value = 1;
+    start = CpuTimer::getCurrentTimePoint();
+    for(uint32_t i = 0; i < kIterations; i++)
+    {
+        mpBuffer->setVariable(offset, value);
+    }
+    float setVariableDuration = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+    start = CpuTimer::getCurrentTimePoint();
+    for(uint32_t i = 0; i < kIterations; i++)
+    {
+        mpBuffer->setBlob(&value, offset, sizeof(value));
+    }
+    float setBlobDuration = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+    auto nsPerCall = [](float durationMs, uint32_t iterations) { return std::to_string(durationMs * 1e6f / iterations) + "ns"; };
+    std::string msg = "Finding a variable by offset among " + std::to_string(variables.size()) + " variables: " + nsPerCall(indexDuration, kIterations) + " with the index, " + nsPerCall(linearDuration, kLinearIterations) + " with a linear search.\n";
+    msg += "setVariable() by offset " + std::string(_LOG_ENABLED ? "with" : "without") + " validation: " + nsPerCall(setVariableDuration, kIterations) + ", setBlob(): " + nsPerCall(setBlobDuration, kIterations) + ".";
+    Logger::log(Logger::Level::Info, msg);
+}
+
+static bool compareRanges(const DirtyRangeList& list, const std::vector<DirtyRangeList::Range>& expected, size_t expectedBytes)
+{
+    const auto& ranges = list.getRanges();
+    if((ranges.size() != expected.size()) || (list.getDirtyBytes() != expectedBytes))
+    {
+        return false;
+    }
+
+    for(size_t i = 0; i < ranges.size(); i++)
+    {
+        if((ranges[i].offset != expected[i].offset) || (ranges[i].size != expected[i].size))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void UniformBufferTest::testDirtyRanges()
+{
+    auto check = [](bool result, const std::string& testName)
+    {
+        if(result == false)
+        {
+            Logger::log(Logger::Level::Error, "Test failed for the dirty range list - " + testName);
+        }
+    };
+
+    DirtyRangeList list;
+    check(list.isEmpty() && (list.getDirtyBytes() == 0), "empty list");
+
+    // Disjoint ranges are kept sorted
+    list.add(64, 16);
+    list.add(0, 4);
+    list.add(128, 8);
+    list.add(32, 0);
+    check(compareRanges(list, { { 0, 4 }, { 64, 16 }, { 128, 8 } }, 28), "disjoint ranges");
+
+    // Overlapping and adjacent ranges are merged
+    list.add(60, 8);
+    list.add(80, 4);
+    list.add(120, 8);
+    check(compareRanges(list, { { 0, 4 }, { 60, 24 }, { 120, 16 } }, 44), "overlapping ranges");
+
+    // A range covering several ranges replaces them
+    list.add(2, 130);
+    check(compareRanges(list, { { 0, 136 } }, 136), "covering range");
+
+    // Removing the middle of a range splits it, removing its edges trims it
+    list.remove(16, 16);
+    check(compareRanges(list, { { 0, 16 }, { 32, 104 } }, 120), "split range");
+    list.remove(8, 32);
+    check(compareRanges(list, { { 0, 8 }, { 40, 96 } }, 104), "trimmed ranges");
+    list.remove(0, 8);
+    list.remove(200, 16);
+    check(compareRanges(list, { { 40, 96 } }, 96), "removed range");
+    list.clear();
+    check(list.isEmpty() && (list.getDirtyBytes() == 0), "cleared list");
+
+    // Ranges separated by up to the merge distance are merged, including the gap
+    DirtyRangeList merged(16);
+    merged.add(0, 4);
+    merged.add(20, 4);
+    merged.add(48, 4);
+    check(compareRanges(merged, { { 0, 24 }, { 48, 4 } }, 28), "merge distance");
+    merged.add(32, 4);
+    check(compareRanges(merged, { { 0, 52 } }, 52), "merge distance bridge");
+}
+
+void UniformBufferTest::testPartialUpload()
+{
+    size_t bufferSize = mpBuffer->getBuffer()->getSize();
+    std::vector<uint8_t> zeros(bufferSize, 0);
+    mpBuffer->setBlob(zeros.data(), 0, bufferSize);
+    mpBuffer->uploadToGPU();
+
+    // Setting a single variable should only upload it
+    size_t offset = mpBuffer->getVariableOffset("st2[1][3].st[2][4].F");
+    UniformBuffer::resetUploadStats();
+    mpBuffer->setVariable(offset, 1.0f);
+    mpBuffer->uploadToGPU();
+    const UniformBuffer::UploadStats& stats = UniformBuffer::getUploadStats();
+#ifndef FALCOR_DX11
+    if((stats.uploadCount != 1) || (stats.discardCount != 0) || (stats.rangeCount != 1) || (stats.bytesUploaded != sizeof(float)))
+    {
+        Logger::log(Logger::Level::Error, "Test failed for partial upload. Setting a single variable uploaded " + std::to_string(stats.bytesUploaded) + " bytes.");
+    }
+
+    // The GPU buffer must contain the new value, and the rest of the buffer must be unchanged
+    std::vector<uint8_t> expected(zeros);
+    const float one = 1.0f;
+    memcpy(expected.data() + offset, &one, sizeof(one));
+    std::vector<uint8_t> gpuData(bufferSize);
+    mpBuffer->getBuffer()->readData(gpuData.data(), 0, bufferSize);
+    if(gpuData != expected)
+    {
+        Logger::log(Logger::Level::Error, "Test failed for partial upload. The GPU buffer doesn't match the CPU copy.");
+    }
+#endif
+
+    // Nothing changed, so nothing should be uploaded
+    UniformBuffer::resetUploadStats();
+    mpBuffer->uploadToGPU();
+    if((stats.uploadCount != 0) || (stats.bytesUploaded != 0))
+    {
+        Logger::log(Logger::Level::Error, "Test failed for partial upload. An unmodified buffer was uploaded.");
+    }
+
+    // Modifying the entire buffer should discard it
+    UniformBuffer::resetUploadStats();
+    mpBuffer->setBlob(zeros.data(), 0, bufferSize);
+    mpBuffer->uploadToGPU();
+    if((stats.uploadCount != 1) || (stats.discardCount != 1) || (stats.bytesUploaded != bufferSize))
+    {
+        Logger::log(Logger::Level::Error, "Test failed for partial upload. Modifying the entire buffer didn't discard it.");
+    }
+}
+
 int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPSTR lpCmdLine, _In_ int nShowCmd)
 {
     UniformBufferTest UniformBufferTest;
@@ -40,4 +40,9 @@ private:
 
     template<bool shouldFail>
     void test(const std::string& var);
+
+    void testOffsetIndex();
+    void benchmarkSetters();
+    void testDirtyRanges();
+    void testPartialUpload();
 };
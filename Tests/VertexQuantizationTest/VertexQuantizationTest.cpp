@@ -0,0 +1,142 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "VertexQuantizationTest.h"
+#include "Graphics/Model/VertexQuantization.h"
+
+void VertexQuantizationTest::testHalf()
+{
+    // Every finite half must survive a round-trip through float
+    for(uint32_t h = 0; h < 0x10000; h++)
+    {
+        bool isFinite = (h & 0x7C00) != 0x7C00;
+        if(isFinite)
+        {
+            uint16_t result = floatToHalf(halfToFloat((uint16_t)h));
+            check(result == h, "half round-trip of " + std::to_string(h));
+        }
+    }
+
+    // float->half conversion error must be bounded by half an ULP for normal halfs
+    const float kMaxRelError = 1.0f / 2048.0f;
+    for(float f = 6.2e-5f; f < 65000.0f; f *= 1.0137f)
+    {
+        float result = halfToFloat(floatToHalf(f));
+        check(std::abs(result - f) <= f * kMaxRelError, "half conversion of " + std::to_string(f));
+        check(halfToFloat(floatToHalf(-f)) == -result, "half sign of " + std::to_string(f));
+    }
+
+    check(halfToFloat(floatToHalf(1e6f)) == std::numeric_limits<float>::infinity(), "half overflow");
+    check(halfToFloat(floatToHalf(0)) == 0, "half zero");
+}
+
+void VertexQuantizationTest::testNormalized()
+{
+    const float kSnormStep = 1.0f / 32767.0f;
+    const float kUnormStep = 1.0f / 65535.0f;
+    for(int32_t i = -10000; i <= 10000; i++)
+    {
+        float f = float(i) / 10000.0f;
+        check(std::abs(decodeSnorm16(encodeSnorm16(f)) - f) <= kSnormStep * 0.5f, "snorm16 conversion of " + std::to_string(f));
+
+        float u = std::abs(f);
+        check(std::abs(decodeUnorm16(encodeUnorm16(u)) - u) <= kUnormStep * 0.5f, "unorm16 conversion of " + std::to_string(u));
+    }
+
+    check(decodeSnorm16(encodeSnorm16(2.0f)) == 1.0f, "snorm16 clamp");
+    check(decodeSnorm16(encodeSnorm16(-2.0f)) == -1.0f, "snorm16 clamp");
+    check(decodeUnorm16(encodeUnorm16(-1.0f)) == 0.0f, "unorm16 clamp");
+    check(decodeUnorm16(encodeUnorm16(2.0f)) == 1.0f, "unorm16 clamp");
+}
+
+void VertexQuantizationTest::testOctahedral()
+{
+    const float kMaxAngle = 2e-4f;
+    const uint32_t kSteps = 200;
+    for(uint32_t t = 0; t <= kSteps; t++)
+    {
+        for(uint32_t p = 0; p < kSteps * 2; p++)
+        {
+            float theta = glm::pi<float>() * float(t) / float(kSteps);
+            float phi = glm::pi<float>() * float(p) / float(kSteps);
+            glm::vec3 v(sin(theta) * cos(phi), sin(theta) * sin(phi), cos(theta));
+
+            int16_t encoded[2];
+            encodeOctahedral(v, encoded);
+            glm::vec3 result = decodeOctahedral(encoded);
+
+            // Measure the angle using the cross product. acos() isn't accurate enough for small angles
+            float angle = asin(std::min(1.0f, glm::length(glm::cross(v, result))));
+            check(angle <= kMaxAngle && glm::dot(v, result) > 0, "octahedral encoding of (" + std::to_string(v.x) + ", " + std::to_string(v.y) + ", " + std::to_string(v.z) + ")");
+            check(std::abs(glm::length(result) - 1) < 1e-5f, "octahedral decoding isn't normalized");
+        }
+    }
+}
+
+void VertexQuantizationTest::testPositions()
+{
+    // Positions are stored as SNORM16 relative to the mesh's bounding box. The error must be bounded by the quantization step
+    const glm::vec3 boxMin(-103.5f, 2.25f, 1000.0f);
+    const glm::vec3 boxMax(17.0f, 2.75f, 1250.0f);
+    const glm::vec3 center = (boxMin + boxMax) * 0.5f;
+    const glm::vec3 halfExtent = (boxMax - boxMin) * 0.5f;
+
+    for(uint32_t i = 0; i <= 1000; i++)
+    {
+        glm::vec3 t = glm::fract(glm::vec3(float(i) * 0.618034f, float(i) * 0.754878f, float(i) * 0.569840f));
+        if(i == 1000)
+        {
+            t = glm::vec3(1);
+        }
+        glm::vec3 pos = boxMin + t * (boxMax - boxMin);
+
+        for(int c = 0; c < 3; c++)
+        {
+            int16_t encoded = encodeSnorm16((pos[c] - center[c]) / halfExtent[c]);
+            float result = center[c] + halfExtent[c] * decodeSnorm16(encoded);
+            float maxError = (boxMax[c] - boxMin[c]) / 32767.0f;
+            check(std::abs(result - pos[c]) <= maxError, "position quantization of " + std::to_string(pos[c]));
+        }
+    }
+}
+
+void VertexQuantizationTest::onLoad()
+{
+    testHalf();
+    testNormalized();
+    testOctahedral();
+    testPositions();
+
+    finishTests("vertex quantization");
+}
+
+int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPSTR lpCmdLine, _In_ int nShowCmd)
+{
+    VertexQuantizationTest vertexQuantizationTest;
+    SampleConfig config;
+    vertexQuantizationTest.run(config);
+}